@@ -15,6 +15,8 @@
 // wxWidgets headers
 #include <wx/dynarray.h>
 
+#include <vector>
+
 // wxPdfDocument headers
 #include "wx/pdfdocdef.h"
 
@@ -25,4 +27,126 @@ WX_DEFINE_USER_EXPORTED_ARRAY_LONG(wxUint32, wxPdfArrayUint32, class WXDLLIMPEXP
 /// Sorted array types
 WX_DEFINE_SORTED_USER_EXPORTED_ARRAY_INT(int, wxPdfSortedArrayInt, WXDLLIMPEXP_PDFDOC);
 
+/// Class representing a set of glyph numbers
+/**
+* The set is implemented as a two-level bitmap: the glyph space is divided into
+* pages of 256 glyphs, and a page is only allocated when the first glyph within
+* its range is added. Insertion and lookup are constant time operations, and
+* iteration visits the glyphs in ascending order.
+*/
+class WXDLLIMPEXP_PDFDOC wxPdfGlyphSet
+{
+public:
+  /// Default constructor
+  wxPdfGlyphSet() : m_count(0) {}
+
+  /// Add a glyph to the set
+  /**
+  * \param glyph the glyph number
+  * \return TRUE if the glyph was not yet contained in the set, FALSE otherwise
+  */
+  bool Add(wxUint32 glyph)
+  {
+    size_t page = glyph >> PAGE_SHIFT;
+    if (page >= m_pages.size())
+    {
+      m_pages.resize(page + 1);
+    }
+    std::vector<wxUint32>& words = m_pages[page];
+    if (words.empty())
+    {
+      words.resize(PAGE_WORDS, 0);
+    }
+    wxUint32& word = words[(glyph & PAGE_MASK) >> 5];
+    wxUint32 mask = 1U << (glyph & 31);
+    bool added = (word & mask) == 0;
+    if (added)
+    {
+      word |= mask;
+      ++m_count;
+    }
+    return added;
+  }
+
+  /// Check whether a glyph is contained in the set
+  /**
+  * \param glyph the glyph number
+  * \return TRUE if the glyph is contained in the set, FALSE otherwise
+  */
+  bool Contains(wxUint32 glyph) const
+  {
+    size_t page = glyph >> PAGE_SHIFT;
+    if (page >= m_pages.size() || m_pages[page].empty())
+    {
+      return false;
+    }
+    return (m_pages[page][(glyph & PAGE_MASK) >> 5] & (1U << (glyph & 31))) != 0;
+  }
+
+  /// Get the number of glyphs in the set
+  size_t GetCount() const { return m_count; }
+
+  /// Check whether the set is empty
+  bool IsEmpty() const { return m_count == 0; }
+
+  /// Remove all glyphs from the set
+  void Clear()
+  {
+    m_pages.clear();
+    m_count = 0;
+  }
+
+  /// Get the smallest glyph number in the set
+  /**
+  * \return the smallest glyph number, or wxNOT_FOUND if the set is empty
+  */
+  int GetFirst() const { return Find(0); }
+
+  /// Get the next glyph number in ascending order
+  /**
+  * \param glyph the glyph number returned by the previous call to GetFirst or GetNext
+  * \return the smallest glyph number greater than glyph, or wxNOT_FOUND if there is none
+  */
+  int GetNext(int glyph) const { return Find((wxUint32) glyph + 1); }
+
+private:
+  /// Find the smallest glyph number greater than or equal to the given start value
+  int Find(wxUint32 start) const
+  {
+    size_t page = start >> PAGE_SHIFT;
+    size_t wordIndex = (start & PAGE_MASK) >> 5;
+    wxUint32 mask = ~0U << (start & 31);
+    for (; page < m_pages.size(); ++page, wordIndex = 0, mask = ~0U)
+    {
+      const std::vector<wxUint32>& words = m_pages[page];
+      if (words.empty())
+      {
+        continue;
+      }
+      for (; wordIndex < PAGE_WORDS; ++wordIndex, mask = ~0U)
+      {
+        wxUint32 word = words[wordIndex] & mask;
+        if (word != 0)
+        {
+          int bit = 0;
+          while ((word & 1) == 0)
+          {
+            word >>= 1;
+            ++bit;
+          }
+          return (int) ((page << PAGE_SHIFT) + (wordIndex << 5) + bit);
+        }
+      }
+    }
+    return wxNOT_FOUND;
+  }
+
+  static const wxUint32 PAGE_SHIFT = 8;                        ///< Number of bits addressing a glyph within a page
+  static const wxUint32 PAGE_MASK  = (1U << PAGE_SHIFT) - 1;   ///< Mask for the glyph offset within a page
+  static const size_t   PAGE_WORDS = (1U << PAGE_SHIFT) / 32;  ///< Number of 32-bit words per page
+
+  std::vector< std::vector<wxUint32> > m_pages; ///< Bitmap pages, allocated on demand
+  size_t                               m_count; ///< Number of glyphs in the set
+};
+
 #endif
@@ -39,11 +39,11 @@ public:
   /// Constructor
   /**
   * \param globalSubrIndex the global subroutine index
-  * \param hGlobalSubrsUsed sorted list of used global subroutines
+  * \param hGlobalSubrsUsed set of used global subroutines
   * \param lGlobalSubrsUsed unordered list of used global subroutines
   */
   wxPdfCffDecoder(wxPdfCffIndexArray* globalSubrIndex,
-                  wxPdfSortedArrayInt* hGlobalSubrsUsed,
+                  wxPdfGlyphSet* hGlobalSubrsUsed,
                   wxArrayInt* lGlobalSubrsUsed);
 
   /// Default destructor
@@ -60,6 +60,17 @@ public:
   */
   bool GetCharWidthAndComposite(wxPdfCffIndexElement& charstring, int& width, bool& isComposite, int& bchar, int& achar);
 
+  /// Get width and composition of a glyph from a decrypted charstring
+  /**
+  * \param[in] data the charstring data; only the leading commands are examined
+  * \param[in] length the length of the charstring data
+  * \param[out] width the character width
+  * \param[out] isComposite flag whether the charstring describes a composite
+  * \param[out] bchar the base character of the composite
+  * \param[out] achar the accent character of the composite
+  */
+  bool GetCharWidthAndComposite(const unsigned char* data, int length, int& width, bool& isComposite, int& bchar, int& achar);
+
   /// Calculate the bias
   /**
   * \param nSubrs the number of subroutines
@@ -67,31 +78,26 @@ public:
   */
   int CalcBias(int nSubrs);
 
-  /// Read a subroutine from an input stream
+  /// Read a subroutine from the CFF data
   /**
-  * \param stream the input stream
-  * \param begin start position of the subroutine in the input stream
-  * \param end end position of the subroutine in the input stream
+  * All subroutine index elements have to refer to the same CFF data.
+  * \param data the CFF data
+  * \param begin start position of the subroutine in the CFF data
+  * \param end end position of the subroutine in the CFF data
   * \param globalBias value of the global bias
   * \param localBias value of the local bias
-  * \param hSubrsUsed sorted list of used subroutines
+  * \param hSubrsUsed set of used subroutines
   * \param lSubrsUsed unordered list of used subroutines
   * \param localSubIndex the local subroutine index
   */
-  void ReadASubr(wxInputStream* stream, int begin, int end,
+  void ReadASubr(const unsigned char* data, int begin, int end,
                  int globalBias, int localBias,
-                 wxPdfSortedArrayInt& hSubrsUsed, wxArrayInt& lSubrsUsed,
+                 wxPdfGlyphSet& hSubrsUsed, wxArrayInt& lSubrsUsed,
                  wxPdfCffIndexArray& localSubIndex);
 
 protected:
-  /// Read a byte from an input stream
-  unsigned char ReadByte(wxInputStream* stream);
-
-  /// Read a short integer from an input stream
-  short ReadShort(wxInputStream* stream);
-
-  /// Read an integer from an input stream
-  int ReadInt(wxInputStream* stream);
+  /// Push an argument onto the argument stack
+  void PushArgument(int value);
 
   /// Handle the stack based on the last operator on stack
   void HandleStack();
@@ -108,27 +114,28 @@ protected:
   /// Push an entry on the stack
   void PushStack();
 
-  /// Read a command from the input stream
-  void ReadCommand(wxInputStream* stream);
+  /// Read a command from the CFF data, advancing the position
+  void ReadCommand(const unsigned char* data, int& pos, int end);
 
   /// Calculate the hints
-  int CalcHints(wxInputStream* stream, int begin, int end, int globalBias, int localBias, wxPdfCffIndexArray& localSubIndex);
+  int CalcHints(const unsigned char* data, int begin, int end, int globalBias, int localBias, wxPdfCffIndexArray& localSubIndex);
 
-private:
-  wxInputStream*        m_stream;              ///< the input stream
+  /// Calculate the hints of a called subroutine
+  void CalcSubrHints(const unsigned char* data, wxPdfCffIndexElement& subr, int globalBias, int localBias, wxPdfCffIndexArray& localSubIndex);
 
+private:
   wxPdfCffIndexArray*   m_globalSubrIndex;     ///< index of the global subroutines
 
   int                   m_charstringType;      ///< charstring type (distinguishes type 1 and type 2 font formats)
 
-  wxString              m_key;                 ///< command key word
+  int                   m_op;                  ///< command operator (escaped operators have 0x0c in the high byte)
   wxPdfCffFontObject*   m_args;                ///< argument stack
   int                   m_argCount;            ///< argument count
 
   int                   m_globalBias;          ///< The bias for the global subroutines
   int                   m_numHints;            ///< Number of arguments to the stem operators in a subroutine calculated recursively
 
-  wxPdfSortedArrayInt*  m_hGlobalSubrsUsed;    ///< A HashMap for keeping the Global subroutines used in the font
+  wxPdfGlyphSet*        m_hGlobalSubrsUsed;    ///< Set of the global subroutines used in the font
   wxArrayInt*           m_lGlobalSubrsUsed;    ///< The Global SubroutinesUsed HashMaps as ArrayLists
 };
 
@@ -21,7 +21,7 @@ typedef struct _wxPdfCjkFontDesc
   const wxStringCharType* ordering;           ///< registry ordering
   const wxStringCharType* supplement;         ///< registry supplement
   const wxStringCharType* cmap;               ///< font cmap
-  short*                  cwArray;            ///< array of character widths
+  const short*            cwArray;            ///< array of character widths
   const wxStringCharType* bbox;               ///< bounding box
   int                     ascent;             ///< ascender
   int                     descent;            ///< descender
@@ -27,7 +27,7 @@ typedef struct _wxPdfCoreFontDesc
   const wxStringCharType*  family;             ///< font family
   const wxStringCharType*  alias;              ///< font family alias
   const wxStringCharType*  name;               ///< font name
-  short*                   cwArray;            ///< array of character widths
+  const short*             cwArray;            ///< array of character widths
   const wxPdfKernPairDesc* kpArray;            ///< array of kerning pairs
   const wxStringCharType*  bbox;               ///< bounding box
   int                      ascent;             ///< ascender
@@ -815,6 +815,7 @@ of a specific method the following alphabetical list shows all available methods
 \li wxPdfDocument::Write - print flowing text
 \li wxPdfDocument::WriteCell - print flowing text with cell attributes
 \li wxPdfDocument::WriteGlyphArray - print array of glyphs
+\li wxPdfDocument::WriteGlyphRun - print a run of shaped glyphs
 \li wxPdfDocument::WriteXml - print flowing text containing simple XML markup
 
 \li wxPdfDocument::wxPdfDocument - constructor
@@ -838,8 +839,10 @@ of a specific method the following alphabetical list shows all available methods
 \li wxPdfFontManager::RegisterFontDirectory - register all fonts located in a directory
 \li wxPdfFontManager::RegisterSystemFonts - register the fonts known to the operating system
 
+\li wxPdfFontManager::SaveFontRegistryIndex - save the font registry index
 \li wxPdfFontManager::SetDefaultEmbed - set the default embedding mode
 \li wxPdfFontManager::SetDefaultSubset - set the default subsetting mode
+\li wxPdfFontManager::SetFontRegistryIndex - set the font registry index file
 
 \section refpdfbarcode wxPdfBarCodeCreator
 
@@ -976,6 +979,15 @@ For <b>Unicode TrueType</b> fonts a file with extension <tt>.ctg.z</tt> is creat
 the character to glyph mapping.You may rename these files, too, but in this case you have to
 alter the file name(s) in the file tag in the <tt>.xml</tt> file accordingly.
 
+Unless VOLT data are included, <tt>makefont</tt> additionally generates a binary font metrics
+file with extension <tt>.wfm</tt>. It holds the same information as the <tt>.xml</tt> file
+(plus the kerning pairs of fonts created with option <tt>-i</tt>), but can be loaded without
+any XML parsing. When a <tt>.xml</tt> font metrics file is registered, a <tt>.wfm</tt> file with
+the same name in the same directory is used instead, provided it is not older than the
+<tt>.xml</tt> file; an outdated or invalid <tt>.wfm</tt> file is silently ignored and the
+<tt>.xml</tt> file is loaded. If you rename or edit the <tt>.xml</tt> file, delete or rename the
+<tt>.wfm</tt> file as well.
+
 You have to copy the generated file(s) to the font directory.
 
 \section mkfontdecl Declaration of the font in the script
@@ -41,6 +41,7 @@ class WXDLLIMPEXP_FWD_PDFDOC wxPdfCoonsPatchMesh;
 class WXDLLIMPEXP_FWD_PDFDOC wxPdfFont;
 class WXDLLIMPEXP_FWD_PDFDOC wxPdfFontDescription;
 class WXDLLIMPEXP_FWD_PDFDOC wxPdfFontDetails;
+class WXDLLIMPEXP_FWD_PDFDOC wxPdfFontArray;
 
 class WXDLLIMPEXP_FWD_PDFDOC wxPdfExtGState;
 class WXDLLIMPEXP_FWD_PDFDOC wxPdfGradient;
@@ -391,6 +392,82 @@ public:
   */
   virtual void SetCompression(bool compress);
 
+  /// Activates or deactivates PNG predictors for images given as wxImage objects.
+  /**
+  * The pixel data of wxImage objects are compressed directly. Applying PNG predictors
+  * usually reduces the size of the compressed data considerably, especially for charts
+  * and other synthetic images, at the cost of additional processing time.
+  * Predictors are on by default.
+  * \param predictor Boolean indicating if PNG predictors should be applied.
+  */
+  virtual void SetImagePredictor(bool predictor);
+
+  /// Checks whether PNG predictors are applied to images given as wxImage objects.
+  /**
+  * \return TRUE if PNG predictors are applied, FALSE otherwise
+  */
+  virtual bool GetImagePredictor() const;
+
+  /// Activates or deactivates the reduction of 16-bit PNG images to 8-bit depth.
+  /**
+  * PNG images with 16 bits per component are embedded with their full depth by default,
+  * which requires PDF 1.5. If depth reduction is activated, only the high order byte of
+  * each component is kept.
+  * \param reduce Boolean indicating if 16-bit images should be reduced to 8-bit depth.
+  */
+  virtual void SetImageDepthReduction(bool reduce);
+
+  /// Checks whether 16-bit PNG images are reduced to 8-bit depth.
+  /**
+  * \return TRUE if 16-bit images are reduced to 8-bit depth, FALSE otherwise
+  */
+  virtual bool GetImageDepthReduction() const;
+
+  /// Sets the resampling policy for images.
+  /**
+  * Images exceeding the given resolution at the largest size they are placed in the document
+  * are resampled on closing the document. Only 8-bit gray scale and RGB images placed outside
+  * of templates and transformations (including those set up by wxPdfDC) are resampled, and only
+  * if the resampled image data are smaller than the original data.
+  * Resampling is off by default.
+  * \param maxResolution the maximal image resolution in dots per inch, 0 disables resampling
+  * \param quality the filter used for resampling
+  * \param jpegQuality the quality for recompressing JPEG images (1..100), or 0 for lossless compression
+  */
+  virtual void SetImageResampling(double maxResolution, wxImageResizeQuality quality = wxIMAGE_QUALITY_HIGH,
+                                  int jpegQuality = 85);
+
+  /// Activates or deactivates deferred preparation of images given as wxImage objects.
+  /**
+  * If activated, the methods Image and ImageMask only determine the size of images given
+  * as wxImage objects and keep a copy of the pixel data. The images are converted and
+  * compressed in parallel when the document is closed. The resulting document is identical
+  * to the document created with immediate preparation, but the uncompressed pixel data are
+  * held in memory until the document is closed.
+  * Deferred preparation is off by default.
+  * \param async Boolean indicating if the preparation of images should be deferred.
+  */
+  virtual void SetAsyncImagePreparation(bool async);
+
+  /// Checks whether the preparation of images given as wxImage objects is deferred.
+  /**
+  * \return TRUE if the preparation of images is deferred, FALSE otherwise
+  */
+  virtual bool GetAsyncImagePreparation() const;
+
+  /// Gets the maximal image resolution used for resampling images.
+  /**
+  * \return the maximal image resolution in dots per inch, 0 if resampling is disabled
+  */
+  virtual double GetImageMaxResolution() const;
+
+  /// Gets the number of bytes saved by resampling images.
+  /**
+  * The value is available after closing the document.
+  * \return the number of bytes saved
+  */
+  virtual size_t GetImageResamplingSavings() const;
+
   /// Defines the viewer preferences.
   /**
   * \param preferences A set of viewer preferences options.
@@ -1562,6 +1639,51 @@ public:
   */
   virtual bool WriteGlyphArray(wxPdfArrayDouble& x, wxPdfArrayDouble& y, wxPdfArrayUint32& glyphs);
 
+  /// Prints a run of shaped glyphs from the current position.
+  /**
+  * This method is intended for text shaped by an external shaping engine. All glyphs of the run
+  * are written in a single text object, using a single TJ operator with positioning adjustments
+  * as long as the glyphs have no vertical offsets. After writing the run the current x position
+  * is advanced by the sum of the glyph advances.
+  * \param count the number of glyphs in the run
+  * \param glyphs array of glyph numbers (count elements)
+  * \param advances array of horizontal glyph advances in user units (count elements).
+  * If NULL, the natural glyph widths of the font are used.
+  * \param offsets array of glyph offsets relative to the pen position in user units
+  * (2*count elements, horizontal and vertical offset for each glyph).
+  * If NULL, no offsets are applied.
+  * \return TRUE if the run could be written, FALSE otherwise. FALSE is also returned if glyphs
+  * of the run are not available in the font; these glyphs are written as glyph 0.
+  * \note This method only works for dynamically loaded TrueType and OpenType Unicode fonts.
+  */
+  virtual bool WriteGlyphRun(size_t count, const wxUint32* glyphs,
+                             const double* advances = NULL, const double* offsets = NULL);
+
+  /// Sets the chain of fallback fonts
+  /**
+  * If a fallback chain is set, Text() and Write() split the text into runs of characters
+  * and print each run with the first font covering its characters: the current font, or else
+  * the fallback fonts in the given order. Characters not covered by any font are printed
+  * with the font of the surrounding run. The current font size is used for all fonts,
+  * and the current font is restored afterwards.
+  * \param fonts list of fallback fonts. An empty list disables the font fallback.
+  * \see SplitTextByFont(), wxPdfFont::GetCoverage()
+  */
+  virtual void SetFallbackFonts(const wxPdfFontArray& fonts);
+
+  /// Splits a text into runs of characters covered by the same font
+  /**
+  * The text is split in a single pass based on the coverage sets of the current font
+  * and the fallback fonts.
+  * \param txt the text to be split
+  * \param[out] runs the text runs
+  * \param[out] fontIndices for each run the index of the font: 0 for the current font,
+  * k for the k-th font of the fallback chain
+  * \return the number of runs
+  * \see SetFallbackFonts()
+  */
+  virtual size_t SplitTextByFont(const wxString& txt, wxArrayString& runs, wxArrayInt& fontIndices);
+
   /// Puts an image in the page.
   /**
   * The upper-left corner must be given. The dimensions can be specified in different ways:
@@ -1682,6 +1804,14 @@ public:
   */
   virtual int ImageMask(const wxString& name, wxInputStream& stream, const wxString& mimeType);
 
+  /// Gets the number of image requests resolved to an already embedded image by content
+  /**
+  * Images are identified not only by name, but also by content. An image used under a new name,
+  * but with the same content as an image used before, refers to the existing image object.
+  * \return the number of image requests for which no new image object was created
+  */
+  virtual int GetImageDuplicateCount() const;
+
   /// Puts a rotated image in the page.
   /**
   * The upper-left corner must be given.
@@ -1771,7 +1901,9 @@ public:
   /**
   * The method first calls Close() if necessary to terminate the document.
   * \param name The name of the file. If not given, the document will be named 'doc.pdf'
-  * \return true if successful, false otherwise
+  * \return true if successful, false otherwise. The method fails as well, if the data of an image
+  * could not be written correctly, for example because an image file was changed after it was added,
+  * or because the deferred conversion of an image failed.
   * \see Close()
   */
   virtual bool SaveAsFile(const wxString& name = wxEmptyString);
@@ -2723,6 +2855,56 @@ protected:
   */
   virtual double DoGetStringWidth(const wxString& s, double charSpacing = 0);
 
+  /// Prints a character string with the current font only
+  /**
+  * \param x abscissa of the origin
+  * \param y ordinate of the origin
+  * \param voText string to print, already in visual order
+  */
+  virtual void DoText(double x, double y, const wxString& voText);
+
+  /// Prints text with cell attributes from the current position
+  /**
+  * Lines are wrapped on whole words, even if a word consists of characters shown with different fonts.
+  * \param h line height
+  * \param s string to print, already in visual order and without carriage returns
+  * \param charFonts font index of each character of the string as used by SelectRunFont(),
+  * or an empty array if the whole string is shown with the current font
+  * \param baseFont the font selected before splitting the text
+  * \param baseStyle the style of the base font including decorations
+  * \param border indicates if borders must be drawn around the cell
+  * \param fill indicates if the cell background must be painted
+  * \param link link identifier
+  */
+  virtual void DoWriteCell(double h, const wxString& s, const wxArrayInt& charFonts,
+                           const wxPdfFont& baseFont, int baseStyle,
+                           int border, int fill, const wxPdfLink& link);
+
+  /// Returns the width of the characters first to last of a string whose characters may be shown with different fonts
+  /**
+  * The fonts are not selected for measuring the width.
+  * \see DoWriteCell()
+  */
+  double GetRunsWidth(const wxString& s, const wxArrayInt& charFonts, int first, int last);
+
+  /// Prints the characters first to last of a string whose characters may be shown with different fonts in a cell
+  /**
+  * The cell is output piece by piece, selecting the font of each piece, and the base font is selected afterwards.
+  * \see DoWriteCell()
+  */
+  void DoRunsCell(double w, double h, const wxString& s, const wxArrayInt& charFonts,
+                  int first, int last, const wxPdfFont& baseFont, int baseStyle,
+                  int border, int ln, int fill, const wxPdfLink& link);
+
+  /// Selects the font of a text run
+  /**
+  * \param fontIndex index of the font: 0 for the base font, k for the k-th fallback font
+  * \param baseFont the font selected before splitting the text
+  * \param baseStyle the style of the base font including decorations
+  * \param size the font size in points
+  */
+  void SelectRunFont(int fontIndex, const wxPdfFont& baseFont, int baseStyle, double size);
+
   /// Prints a cell (rectangular area) with optional borders, background colour and character string.
   /**
   * \note This method expects the text already to be preprocessed in respect to visual layout.
@@ -2861,6 +3043,13 @@ protected:
   /// Show a single glyph
   void ShowGlyph(wxUint32 glyph);
 
+  /// Show a run of glyphs
+  /**
+  * \return the total advance of the run in user units
+  */
+  double ShowGlyphRun(size_t count, const wxUint32* glyphs, const wxUint32* cids,
+                      const double* advances, const double* offsets);
+
   /// Format a text string
   void TextEscape(const wxString& s, bool newline = true);
 
@@ -2924,10 +3113,49 @@ protected:
   /// Add an indirect object to the document
   void OutIndirectObject(wxPdfIndirectObject* object);
 
+  /// Convert images whose preparation was deferred
+  /**
+  * If the conversion of an image fails, the document is flagged as erroneous,
+  * so that SaveAsFile() reports the failure.
+  */
+  void PrepareImages();
+
+  /// Resample images exceeding the maximal image resolution
+  void ResampleImages();
+
   /// Add an image object to the document
   void OutImage(wxPdfImage* currentImage,
                 double x, double y, double w, double h, const wxPdfLink& link);
 
+  /// Find an image by name, including names of images with identical content
+  wxPdfImage* FindImage(const wxString& name) const;
+
+  /// Find an image by name and image mask
+  /**
+  * Images may be shared by several names, therefore the image mask of an existing image
+  * is never changed. An image requested with a different image mask is registered under
+  * a name including the index of the image mask.
+  * \param name the name of the image
+  * \param maskImage the index of the requested image mask, or 0 if none is requested
+  * \param[out] imageName the name under which the image is (to be) registered
+  * \return the image found, or NULL if the image needs to be created
+  */
+  wxPdfImage* FindImage(const wxString& name, int maskImage, wxString& imageName) const;
+
+  /// Find an image by content digest and register the name as an alias of the image found
+  wxPdfImage* FindImageByDigest(const wxString& name, const wxString& digest);
+
+  /// Register a new image by name and content digest
+  void RegisterImage(const wxString& name, wxPdfImage* image, const wxString& digest);
+
+  /// Register a parsed image, or replace it by an existing image with identical content
+  /**
+  * An alpha channel of the image is embedded as soft mask, unless an image mask is given.
+  * If the alpha channel can't be processed, the image is deleted.
+  * \return the image to be used, or NULL if the image could not be added
+  */
+  wxPdfImage* AddParsedImage(const wxString& name, wxPdfImage* image, int maskImage);
+
   /// Write XML using XML node
   void WriteXml(wxXmlNode* node);
 
@@ -2984,6 +3212,13 @@ private:
 
   bool                 m_kerning;             ///< kerning flag
   bool                 m_compress;            ///< compression flag
+  bool                 m_imagePredictor;      ///< flag whether PNG predictors are applied to wxImage pixel data
+  bool                 m_imageDepthReduction; ///< flag whether 16-bit images are reduced to 8-bit depth
+  double               m_imageMaxResolution;  ///< maximal image resolution for resampling
+  wxImageResizeQuality m_imageResizeQuality;  ///< filter used for resampling images
+  int                  m_imageJpegQuality;    ///< quality for recompressing resampled JPEG images
+  size_t               m_imageBytesSaved;     ///< number of bytes saved by resampling images
+  bool                 m_asyncImagePreparation; ///< flag whether the preparation of wxImage objects is deferred
   int                  m_defOrientation;      ///< default orientation
   int                  m_curOrientation;      ///< current orientation
   wxPdfBoolHashMap*    m_orientationChanges;  ///< array indicating orientation changes
@@ -3024,6 +3259,10 @@ private:
   wxPdfStringHashMap*  m_diffs;               ///> array of encoding differences
   wxPdfBoolHashMap*    m_winansi;             ///> array of flags whether encoding differences are based on WinAnsi
   wxPdfImageHashMap*   m_images;              ///< array of used images
+  wxPdfImageHashMap*   m_imageAliases;        ///< array of image names referring to images with identical content
+  wxPdfImageHashMap*   m_imageDigests;        ///< array of used images by content digest
+  int                  m_imageDuplicates;     ///< number of image requests resolved by content digest
+  bool                 m_imageDataError;      ///< flag whether image data could not be written correctly
   wxPdfPageLinksMap*   m_pageLinks;           ///< array of links in pages
   wxPdfLinkHashMap*    m_links;               ///< array of internal links
   wxPdfNamedLinksMap*  m_namedLinks;          ///< array of named internal links
@@ -3050,6 +3289,8 @@ private:
   bool                 m_fontSubsetting;      ///< flag whether to use font subsetting
 
   wxPdfFontDetails*    m_currentFont;         ///< current font info
+  wxPdfFontArray*      m_fallbackFonts;       ///< chain of fallback fonts
+  wxPdfArrayUint32     m_glyphRunCids;        ///< buffer for the character ids of a glyph run
 
   double               m_fontSizePt;          ///< current font size in points
   double               m_fontSize;            ///< current font size in user unit
@@ -13,6 +13,7 @@
 #define _PDF_ENCODING_H_
 
 // wxWidgets headers
+#include <wx/strconv.h>
 #include <wx/string.h>
 
 // wxPdfDocument headers
@@ -20,6 +21,75 @@
 #include "wx/pdfarraytypes.h"
 #include "wx/pdffontdata.h"
 
+/// Class representing a table-driven converter for single-byte encodings
+/**
+* The conversion from Unicode to the single-byte encoding uses a two-level lookup table
+* indexed by the high and the low byte of a BMP character. Only pages actually
+* populated by the encoding are allocated. Runs of ASCII characters are copied
+* directly if the encoding maps ASCII to itself.
+*/
+class WXDLLIMPEXP_PDFDOC wxPdfEncodingConv : public wxMBConv
+{
+public:
+  /// Constructor
+  /**
+  * \param cmap array of 256 Unicode characters indexed by the code of the encoding.
+  * Codes other than 0 mapped to 0x0000 are treated as undefined.
+  */
+  wxPdfEncodingConv(const wxPdfArrayUint32& cmap);
+
+  /// Copy constructor
+  wxPdfEncodingConv(const wxPdfEncodingConv& conv);
+
+  /// Destructor
+  virtual ~wxPdfEncodingConv();
+
+  /// Create a table-driven converter for a character set
+  /**
+  * \param charset the name of the character set
+  * \return the converter, or NULL if the character set is unknown or is not a single-byte character set
+  */
+  static wxPdfEncodingConv* Create(const wxString& charset);
+
+  /// Convert a Unicode character to a code of the encoding
+  /**
+  * \param[in] unicode the Unicode character
+  * \param[out] code the code of the character in the encoding
+  * \return TRUE if the character is part of the encoding, FALSE otherwise
+  */
+  bool Map(wxUint32 unicode, wxUint32& code) const
+  {
+    if (unicode > 0xFFFF)
+    {
+      return false;
+    }
+    code = m_pages[m_pageIndex[unicode >> 8] * 256 + (unicode & 0xFF)];
+    return (code != 0 || unicode == 0);
+  }
+
+  /// Convert a single-byte string to a wide character string
+  virtual size_t ToWChar(wchar_t* dst, size_t dstLen, const char* src, size_t srcLen = wxNO_LEN) const;
+
+  /// Convert a wide character string to a single-byte string
+  virtual size_t FromWChar(char* dst, size_t dstLen, const wchar_t* src, size_t srcLen = wxNO_LEN) const;
+
+  /// Create a copy of the converter
+  virtual wxMBConv* Clone() const { return new wxPdfEncodingConv(*this); }
+
+private:
+  /// Build the lookup tables from a character map
+  void Initialize(const wxUint32* cmap);
+
+  wxUint32  m_cmap[256];        ///< Unicode characters indexed by code
+  wxUint16  m_pageIndex[256];   ///< Page numbers indexed by the high byte of a character
+  wxUint8*  m_pages;            ///< Codes of all populated pages, page 0 is empty
+  size_t    m_pageCount;        ///< Number of allocated pages
+  bool      m_asciiIdentity;    ///< Flag whether ASCII characters map to themselves
+
+  /// Assignment operator (not implemented)
+  wxPdfEncodingConv& operator=(const wxPdfEncodingConv&);
+};
+
 /// Class representing a font encoding
 class WXDLLIMPEXP_PDFDOC wxPdfEncoding
 {
@@ -81,6 +151,13 @@ public:
   */
   const wxPdfChar2GlyphMap* GetEncodingMap() const;
 
+  /// Get the table-driven converter of the encoding
+  /**
+  * The converter is available after the encoding map has been initialized.
+  * \return the converter, or NULL if the encoding map was not initialized
+  */
+  const wxPdfEncodingConv* GetEncodingConv() const;
+
   /// Get the list of glyph names supported by the encoding
   /**
   * \return a list of glyph names
@@ -123,6 +200,7 @@ private:
   int                 m_firstChar;        ///< number of the first valid character
   int                 m_lastChar;         ///< number of the last valid character
   wxPdfChar2GlyphMap* m_encodingMap;      ///< Encoding conversion map
+  wxPdfEncodingConv*  m_encodingConv;     ///< Table-driven encoding converter
 };
 
 /// Class representing a font encoding checker
@@ -155,6 +155,9 @@ public:
   */
   static wxString CreateDocumentId();
 
+  /// Calculate the binary MD5 message digest of the given data
+  static void GetMD5Binary(const unsigned char* data, unsigned int length, unsigned char* digest);
+
 protected:
   /// Pad a password to 32 characters
   std::string PadPassword(const wxString& password);
@@ -196,9 +199,6 @@ protected:
                    unsigned char* textin, unsigned int textlen,
                    unsigned char* textout);
 
-  /// Calculate the binary MD5 message digest of the given data
-  static void GetMD5Binary(const unsigned char* data, unsigned int length, unsigned char* digest);
-
   /// Generate initial vector
   static void GenerateInitialVector(unsigned char iv[16]);
 
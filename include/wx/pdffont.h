@@ -176,6 +176,13 @@ public :
   */
   bool GetSupportedUnicodeCharacters(wxPdfArrayUint32& unicodeCharacters) const;
 
+  /// Get the set of Unicode characters the font can show
+  /**
+  * The set is created on first request and shared by all references to the same font.
+  * \return the set of Unicode characters covered by the font, or NULL if the font could not be initialized
+  */
+  const wxPdfGlyphSet* GetCoverage() const;
+
   /// Force string to valid string in respect of the current font encoding
   /**
   * The given string is converted in such a way that it contains only characters
@@ -208,4 +215,6 @@ private:
   friend class wxPdfFontManagerBase;
 };
 
+WX_DECLARE_USER_EXPORTED_OBJARRAY(wxPdfFont, wxPdfFontArray, WXDLLIMPEXP_PDFDOC);
+
 #endif
@@ -19,6 +19,8 @@
 #include <wx/object.h>
 #include <wx/xml/xml.h>
 
+#include <atomic>
+
 // wxPdfDocument headers
 #include "wx/pdfdocdef.h"
 #include "wx/pdfarraytypes.h"
@@ -26,6 +28,9 @@
 
 class WXDLLIMPEXP_FWD_PDFDOC wxPdfEncoding;
 class WXDLLIMPEXP_FWD_PDFDOC wxPdfEncodingChecker;
+class WXDLLIMPEXP_FWD_PDFDOC wxPdfEncodingConv;
+
+class wxPdfFontCoverage;
 
 WX_DECLARE_HASH_MAP_WITH_DECL(wxUint32, int, wxIntegerHash, wxIntegerEqual, wxPdfKernWidthMap, class WXDLLIMPEXP_PDFDOC);
 WX_DECLARE_HASH_MAP_WITH_DECL(wxUint32, wxPdfKernWidthMap*, wxIntegerHash, wxIntegerEqual, wxPdfKernPairMap, class WXDLLIMPEXP_PDFDOC);
@@ -63,7 +68,7 @@ public:
   /**
   * \return TRUE if the font data are initialized, FALSE otherwise
   */
-  bool IsInitialized() const { return m_initialized; }
+  bool IsInitialized() const { return m_initialized.load(std::memory_order_acquire); }
 
   /// Set initialization state
   /**
@@ -71,6 +76,17 @@ public:
   */
   void SetInitialized(bool initialized);
 
+  /// Initialize the font data on first use
+  /**
+  * Identification data of a font are available as soon as the font is registered,
+  * and the font program is read only on writing it to a document. The remaining font data
+  * (description, glyph mapping and widths, kerning pairs) are loaded together on first use
+  * in a single pass over the font file. Since font data are shared by all documents,
+  * the font file is parsed only once. This method is thread safe.
+  * \return TRUE if the font data are available, FALSE otherwise
+  */
+  bool InitializeOnce();
+
   /// Set font type
   /**
   * \param type type of the font
@@ -505,7 +521,7 @@ public:
   * \param s the string which's width is to be calculated
   * \return the width of the string with kerning taken into account
   */
-  int GetKerningWidth(const wxString& s) const;
+  virtual int GetKerningWidth(const wxString& s) const;
 
   /// Get kerning width array
   /**
@@ -515,7 +531,7 @@ public:
   * of the first character of a kerning pair within the string and the second item (odd indices)
   * represents the kerning value.
   */
-  wxArrayInt GetKerningWidthArray(const wxString& s) const;
+  virtual wxArrayInt GetKerningWidthArray(const wxString& s) const;
 
   /// Set subset flag if font subsetting is supported
   /**
@@ -570,6 +586,14 @@ public:
   */
   virtual wxString ConvertToValid(const wxString& s, wxUniChar replace = wxS('?')) const;
 
+  /// Get the set of Unicode characters the font can show
+  /**
+  * The set is created on first request and kept for the lifetime of the font data.
+  * \param encoding the character to glyph mapping
+  * \return the set of Unicode characters covered by the font, or NULL if the font data are not initialized
+  */
+  const wxPdfGlyphSet* GetCoverage(const wxPdfEncoding* encoding = NULL) const;
+
   /// Convert character codes to glyph numbers
   /**
   * \param s the string to be converted
@@ -579,7 +603,7 @@ public:
   * \return the converted string
   */
   virtual wxString ConvertCID2GID(const wxString& s, const wxPdfEncoding* encoding = NULL,
-                                  wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                  wxPdfGlyphSet* usedGlyphs = NULL,
                                   wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
   /// Convert glyph number to string
@@ -591,9 +615,31 @@ public:
   * \return the converted string
   */
   virtual wxString ConvertGlyph(wxUint32 glyph, const wxPdfEncoding* encoding = NULL,
-                                wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                wxPdfGlyphSet* usedGlyphs = NULL,
                                 wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
+  /// Convert an array of glyph numbers to character ids
+  /**
+  * \param glyphs the glyph numbers to be converted
+  * \param count the number of glyphs
+  * \param[out] cids the resulting character ids; glyphs not available in the font are converted to 0
+  * \param encoding the character to glyph mapping
+  * \param usedGlyphs the list of used glyphs
+  * \param subsetGlyphs the mapping of glyphs to subset glyphs
+  * \return TRUE if all glyphs are available in the font, FALSE otherwise
+  */
+  virtual bool ConvertGlyphs(const wxUint32* glyphs, size_t count, wxUint32* cids,
+                             const wxPdfEncoding* encoding = NULL,
+                             wxPdfGlyphSet* usedGlyphs = NULL,
+                             wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
+
+  /// Get the width of a glyph
+  /**
+  * \param glyph the glyph number
+  * \return the width of the glyph in units of 1/1000 of the font size, 0 if the glyph is not available
+  */
+  virtual int GetGlyphWidth(wxUint32 glyph) const;
+
   /// Get the character width array as string
   /**
   * \param subset flag whether subsetting is enabled
@@ -602,7 +648,7 @@ public:
   * \return the string representation of the character widths
   */
   virtual wxString GetWidthsAsString(bool subset = false,
-                                     wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                     wxPdfGlyphSet* usedGlyphs = NULL,
                                      wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
   /// Get list of glyph names supported by this font
@@ -620,7 +666,7 @@ public:
   * \return the size of the written font data
   */
   virtual size_t WriteFontData(wxOutputStream* fontData,
-                               wxPdfSortedArrayInt* usedGlyphs = NULL,
+                               wxPdfGlyphSet* usedGlyphs = NULL,
                                wxPdfChar2GlyphMap* subsetGlyphs = NULL);
 
   /// Write character/glyph to unicode mapping
@@ -633,7 +679,7 @@ public:
   */
   virtual size_t WriteUnicodeMap(wxOutputStream* mapData,
                                  const wxPdfEncoding* encoding = NULL,
-                                 wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                 wxPdfGlyphSet* usedGlyphs = NULL,
                                  wxPdfChar2GlyphMap* subsetGlyphs = NULL);
 
   /// Write CID to GID mapping
@@ -646,7 +692,7 @@ public:
   */
   virtual size_t WriteCIDToGIDMap(wxOutputStream* mapData,
                                   const wxPdfEncoding* encoding = NULL,
-                                  wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                  wxPdfGlyphSet* usedGlyphs = NULL,
                                   wxPdfChar2GlyphMap* subsetGlyphs = NULL);
 
   /// Write CID set
@@ -659,7 +705,7 @@ public:
   */
   virtual size_t WriteCIDSet(wxOutputStream* setData,
                              const wxPdfEncoding* encoding = NULL,
-                             wxPdfSortedArrayInt* usedGlyphs = NULL,
+                             wxPdfGlyphSet* usedGlyphs = NULL,
                              wxPdfChar2GlyphMap* subsetGlyphs = NULL);
 
   /// Set the font description
@@ -681,6 +727,34 @@ public:
   */
   virtual bool LoadFontMetrics(wxXmlNode* root);
 
+  /// Load the font metrics from binary font metrics data
+  /**
+  * The binary font metrics format is a versioned little-endian format holding
+  * the same information as the XML font metrics file plus the kerning pairs.
+  * \param data the content of a binary font metrics file
+  * \param length the length of the binary font metrics data
+  * \return TRUE if the metric data could be processed successfully, FALSE otherwise
+  */
+  bool LoadBinaryFontMetrics(const unsigned char* data, size_t length);
+
+  /// Write the font metrics in binary format
+  /**
+  * \param stream the output stream
+  * \param includeGlyphInfo flag whether subsetting is enabled and the glyph numbers should be included
+  * \param includeSubsetting flag whether the subsetting state should be recorded; on loading it is
+  * applied like the subsetting attribute of the widths in XML font metrics files of TrueType and OpenType fonts
+  * \return TRUE if the metric data could be written successfully, FALSE otherwise
+  */
+  bool WriteBinaryFontMetrics(wxOutputStream& stream, bool includeGlyphInfo, bool includeSubsetting) const;
+
+  /// Get the font type of binary font metrics data
+  /**
+  * \param data the content of a binary font metrics file
+  * \param length the length of the binary font metrics data
+  * \return the font type, or an empty string if the data are not valid binary font metrics data
+  */
+  static wxString GetBinaryFontMetricsType(const unsigned char* data, size_t length);
+
 #if wxUSE_UNICODE
   /// Get the associated encoding converter
   /**
@@ -723,6 +797,9 @@ protected:
   /// Find the encoding map to be used for character to glyph conversion
   const wxPdfChar2GlyphMap* FindEncodingMap(const wxPdfEncoding* encoding) const;
 
+  /// Find the table-driven converter to be used for character to code conversion
+  const wxPdfEncodingConv* FindEncodingConv(const wxPdfEncoding* encoding) const;
+
   /// Determine font style from font name
   static int FindStyleFromName(const wxString& name);
 
@@ -735,6 +812,29 @@ protected:
   /// Write a mapping from glyphs to unicode to a stream
   static void WriteToUnicode(wxPdfGlyphList& glyphs, wxMemoryOutputStream& toUnicode, bool simple = false);
 
+  /// Complete loading of the font metrics
+  /**
+  * Called after the font metrics have been read from an XML or binary font metrics file.
+  * \param complete flag whether all required font metrics were found
+  * \return TRUE if the font is usable, FALSE otherwise
+  */
+  virtual bool CompleteFontMetrics(bool complete);
+
+  /// Create the set of Unicode characters the font can show
+  /**
+  * The set has to be consistent with the method CanShow.
+  * \param encoding the character to glyph mapping
+  * \param[out] coverage the set of Unicode characters covered by the font
+  */
+  virtual void CreateCoverage(const wxPdfEncoding* encoding, wxPdfGlyphSet& coverage) const;
+
+  /// Add all characters of the Basic Multilingual Plane to a coverage set
+  /**
+  * Used for fonts which do not restrict the characters they can show.
+  * \param[out] coverage the set of Unicode characters covered by the font
+  */
+  static void CreateFullCoverage(wxPdfGlyphSet& coverage);
+
   wxString              m_type;      ///< Font type
   wxString              m_family;    ///< Font family
   wxString              m_alias;     ///< Font family alias
@@ -742,7 +842,7 @@ protected:
   wxArrayString         m_fullNames; ///< List of full font names
   int                   m_style;     ///< Font style flags
 
-  bool                  m_initialized;     ///< Flag whether the font has been initialized
+  std::atomic<bool>     m_initialized;     ///< Flag whether the font has been initialized
   bool                  m_embedRequired;   ///< Flag whether embedding of the font is allowed and supported
   bool                  m_embedSupported;  ///< Flag whether embedding of the font is allowed and supported
   bool                  m_subsetSupported; ///< Flag whether subsetting of the font is allowed and supported
@@ -778,6 +878,7 @@ protected:
 
   wxPdfEncoding*        m_encoding;        ///< Encoding
   wxPdfEncodingChecker* m_encodingChecker; ///< Encoding checker
+  mutable wxPdfFontCoverage* m_coverage;   ///< Cached coverage sets, one per encoding
   static wxMBConv*      ms_winEncoding;    ///< WinAnsi converter
 
 private:
@@ -40,11 +40,13 @@ public :
   * \param name the font name
   * \param alias the alias name of the font or an empty string
   * \param cwArray an array with the character widths
-  * \param kpArray an array with kerning pairs
+  * \param kpArray an array with kerning pairs, sorted by first and second character
   * \param desc a font description
+  *
+  * The arrays are static tables; they are referenced, not copied.
   */
   wxPdfFontDataCore(const wxString& family, const wxString& name, const wxString& alias,
-                    short* cwArray, const wxPdfKernPairDesc* kpArray,
+                    const short* cwArray, const wxPdfKernPairDesc* kpArray,
                     const wxPdfFontDescription& desc);
 
   /// Default destructor
@@ -57,7 +59,7 @@ public :
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the string representation of the character widths
   */
-  virtual wxString GetWidthsAsString(bool subset = false, wxPdfSortedArrayInt* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
+  virtual wxString GetWidthsAsString(bool subset = false, wxPdfGlyphSet* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
   /// Get the width of a string
   /**
@@ -77,6 +79,20 @@ public :
   */
   virtual bool CanShow(const wxString& s, const wxPdfEncoding* encoding = NULL) const;
 
+  /// Get width of string taking kerning into account
+  /**
+  * \param s the string which's width is to be calculated
+  * \return the width of the string with kerning taken into account
+  */
+  virtual int GetKerningWidth(const wxString& s) const;
+
+  /// Get kerning width array
+  /**
+  * \param s the string for which kerning information should be provided
+  * \return an array with indices and kerning width of the found kerning pairs.
+  */
+  virtual wxArrayInt GetKerningWidthArray(const wxString& s) const;
+
   /// Convert character codes to glyph numbers
   /**
   * \param s the string to be converted
@@ -86,7 +102,7 @@ public :
   * \return the converted string
   */
   virtual wxString ConvertCID2GID(const wxString& s, const wxPdfEncoding* encoding = NULL,
-                                  wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                  wxPdfGlyphSet* usedGlyphs = NULL,
                                   wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
 #if wxUSE_UNICODE
@@ -98,9 +114,22 @@ public :
 #endif
 
 protected:
+  /// Find the kerning value of a character pair in the kerning table
+  /**
+  * \param ch1 the first character of the pair
+  * \param ch2 the second character of the pair
+  * \param kerning the kerning value of the pair
+  * \return TRUE if the pair has a kerning value, FALSE otherwise
+  */
+  bool FindKerningPair(wxUint32 ch1, wxUint32 ch2, int& kerning) const;
 
-private:
+  /// Create the set of Unicode characters the font can show
+  virtual void CreateCoverage(const wxPdfEncoding* encoding, wxPdfGlyphSet& coverage) const;
 
+private:
+  const short*             m_cwArray; ///< Static table of the character widths
+  const wxPdfKernPairDesc* m_kpArray; ///< Static table of the kerning pairs
+  size_t                   m_kpCount; ///< Number of kerning pairs
 };
 
 #endif
@@ -69,7 +69,7 @@ public:
   * \return the converted string
   */
   virtual wxString ConvertCID2GID(const wxString& s, const wxPdfEncoding* encoding = NULL,
-                                  wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                  wxPdfGlyphSet* usedGlyphs = NULL,
                                   wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
   /// Convert glyph number to string
@@ -81,9 +81,31 @@ public:
   * \return the converted string
   */
   virtual wxString ConvertGlyph(wxUint32 glyph, const wxPdfEncoding* encoding = NULL,
-                                wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                wxPdfGlyphSet* usedGlyphs = NULL,
                                 wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
+  /// Convert an array of glyph numbers to character ids
+  /**
+  * \param glyphs the glyph numbers to be converted
+  * \param count the number of glyphs
+  * \param[out] cids the resulting character ids; glyphs not available in the font are converted to 0
+  * \param encoding the character to glyph mapping
+  * \param usedGlyphs the list of used glyphs
+  * \param subsetGlyphs the mapping of glyphs to subset glyphs
+  * \return TRUE if all glyphs are available in the font, FALSE otherwise
+  */
+  virtual bool ConvertGlyphs(const wxUint32* glyphs, size_t count, wxUint32* cids,
+                             const wxPdfEncoding* encoding = NULL,
+                             wxPdfGlyphSet* usedGlyphs = NULL,
+                             wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
+
+  /// Get the width of a glyph
+  /**
+  * \param glyph the glyph number
+  * \return the width of the glyph in units of 1/1000 of the font size, 0 if the glyph is not available
+  */
+  virtual int GetGlyphWidth(wxUint32 glyph) const;
+
   /// Get the character width array as string
   /**
   * \param subset flag whether subsetting is enabled
@@ -91,7 +113,7 @@ public:
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the string representation of the character widths
   */
-  virtual wxString GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
+  virtual wxString GetWidthsAsString(bool subset, wxPdfGlyphSet* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
   /// Load the font metrics XML file
   /**
@@ -108,7 +130,7 @@ public:
   * \return the size of the written font data
   */
   virtual size_t WriteFontData(wxOutputStream* fontData,
-                               wxPdfSortedArrayInt* usedGlyphs = NULL,
+                               wxPdfGlyphSet* usedGlyphs = NULL,
                                wxPdfChar2GlyphMap* subsetGlyphs = NULL);
 
   /// Write character/glyph to unicode mapping
@@ -121,7 +143,7 @@ public:
   */
   virtual size_t WriteUnicodeMap(wxOutputStream* mapData,
                                  const wxPdfEncoding* encoding = NULL,
-                                 wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                 wxPdfGlyphSet* usedGlyphs = NULL,
                                  wxPdfChar2GlyphMap* subsetGlyphs = NULL);
 
   /// Write CID set
@@ -134,7 +156,7 @@ public:
   */
   virtual size_t WriteCIDSet(wxOutputStream* setData,
                              const wxPdfEncoding* encoding = NULL,
-                             wxPdfSortedArrayInt* usedGlyphs = NULL,
+                             wxPdfGlyphSet* usedGlyphs = NULL,
                              wxPdfChar2GlyphMap* subsetGlyphs = NULL);
 
   /// Get the associated encoding converter
@@ -165,6 +187,12 @@ public:
   virtual void SetGlyphWidths(const wxPdfArrayUint16& glyphWidths);
 
 protected:
+  /// Complete loading of the font metrics
+  virtual bool CompleteFontMetrics(bool complete);
+
+  /// Create the set of Unicode characters the font can show
+  virtual void CreateCoverage(const wxPdfEncoding* encoding, wxPdfGlyphSet& coverage) const;
+
   wxPdfArrayUint16*   m_gw;           ///< Array of glyph widths
   wxMBConv*           m_conv;         ///< Associated encoding converter
 };
@@ -62,7 +62,7 @@ public:
   * \return the converted string
   */
   virtual wxString ConvertCID2GID(const wxString& s, const wxPdfEncoding* encoding = NULL,
-                                  wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                  wxPdfGlyphSet* usedGlyphs = NULL,
                                   wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
   /// Get the character width array as string
@@ -72,7 +72,7 @@ public:
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the string representation of the character widths
   */
-  virtual wxString GetWidthsAsString(bool subset = false, wxPdfSortedArrayInt* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
+  virtual wxString GetWidthsAsString(bool subset = false, wxPdfGlyphSet* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
   /// Load the font metrics XML file
   /**
@@ -88,7 +88,7 @@ public:
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the size of the written font data
   */
-  virtual size_t WriteFontData(wxOutputStream* fontData, wxPdfSortedArrayInt* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL);
+  virtual size_t WriteFontData(wxOutputStream* fontData, wxPdfGlyphSet* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL);
 
 #if wxUSE_UNICODE
   /// Get the associated encoding converter
@@ -163,7 +163,7 @@ public:
   * \return the converted string
   */
   virtual wxString ConvertCID2GID(const wxString& s, const wxPdfEncoding* encoding = NULL,
-                                  wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                  wxPdfGlyphSet* usedGlyphs = NULL,
                                   wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
   /// Convert glyph number to string
@@ -175,9 +175,31 @@ public:
   * \return the converted string
   */
   virtual wxString ConvertGlyph(wxUint32 glyph, const wxPdfEncoding* encoding = NULL,
-                                wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                wxPdfGlyphSet* usedGlyphs = NULL,
                                 wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
+  /// Convert an array of glyph numbers to character ids
+  /**
+  * \param glyphs the glyph numbers to be converted
+  * \param count the number of glyphs
+  * \param[out] cids the resulting character ids; glyphs not available in the font are converted to 0
+  * \param encoding the character to glyph mapping
+  * \param usedGlyphs the list of used glyphs
+  * \param subsetGlyphs the mapping of glyphs to subset glyphs
+  * \return TRUE if all glyphs are available in the font, FALSE otherwise
+  */
+  virtual bool ConvertGlyphs(const wxUint32* glyphs, size_t count, wxUint32* cids,
+                             const wxPdfEncoding* encoding = NULL,
+                             wxPdfGlyphSet* usedGlyphs = NULL,
+                             wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
+
+  /// Get the width of a glyph
+  /**
+  * \param glyph the glyph number
+  * \return the width of the glyph in units of 1/1000 of the font size, 0 if the glyph is not available
+  */
+  virtual int GetGlyphWidth(wxUint32 glyph) const;
+
   /// Get the character width array as string
   /**
   * \param subset flag whether subsetting is enabled
@@ -185,7 +207,7 @@ public:
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the string representation of the character widths
   */
-  virtual wxString GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
+  virtual wxString GetWidthsAsString(bool subset, wxPdfGlyphSet* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
   /// Load the font metrics XML file
   /**
@@ -201,7 +223,7 @@ public:
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the size of the written font data
   */
-  virtual size_t WriteFontData(wxOutputStream* fontData, wxPdfSortedArrayInt* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL);
+  virtual size_t WriteFontData(wxOutputStream* fontData, wxPdfGlyphSet* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL);
 
   /// Write character/glyph to unicode mapping
   /**
@@ -213,7 +235,7 @@ public:
   */
   virtual size_t WriteUnicodeMap(wxOutputStream* mapData,
                                  const wxPdfEncoding* encoding = NULL,
-                                 wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                 wxPdfGlyphSet* usedGlyphs = NULL,
                                  wxPdfChar2GlyphMap* subsetGlyphs = NULL);
 
   /// Write CID to GID mapping
@@ -226,7 +248,7 @@ public:
   */
   virtual size_t WriteCIDToGIDMap(wxOutputStream* mapData,
                                   const wxPdfEncoding* encoding = NULL,
-                                  wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                  wxPdfGlyphSet* usedGlyphs = NULL,
                                   wxPdfChar2GlyphMap* subsetGlyphs = NULL);
 
   /// Write CID set
@@ -239,7 +261,7 @@ public:
   */
   virtual size_t WriteCIDSet(wxOutputStream* setData,
                              const wxPdfEncoding* encoding = NULL,
-                             wxPdfSortedArrayInt* usedGlyphs = NULL,
+                             wxPdfGlyphSet* usedGlyphs = NULL,
                              wxPdfChar2GlyphMap* subsetGlyphs = NULL);
 
   /// Get the associated encoding converter
@@ -258,6 +280,12 @@ public:
   virtual void SetGlyphWidths(const wxPdfArrayUint16& glyphWidths);
 
 protected:
+  /// Complete loading of the font metrics
+  virtual bool CompleteFontMetrics(bool complete);
+
+  /// Create the set of Unicode characters the font can show
+  virtual void CreateCoverage(const wxPdfEncoding* encoding, wxPdfGlyphSet& coverage) const;
+
   wxPdfArrayUint16*   m_gw;           ///< Array of glyph widths
   wxMBConv*           m_conv;         ///< Associated encoding converter
   wxPdfVolt*          m_volt;         ///< VOLT data
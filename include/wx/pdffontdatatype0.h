@@ -46,7 +46,7 @@ public:
   wxPdfFontDataType0(const wxString& family, const wxString& name,
                      const wxString& encoding, const wxString& ordering,
                      const wxString& supplement, const wxString& cmap,
-                     short* cwArray, const wxPdfFontDescription& desc);
+                     const short* cwArray, const wxPdfFontDescription& desc);
 
   /// Default destructor
   virtual ~wxPdfFontDataType0();
@@ -58,7 +58,7 @@ public:
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the string representation of the character widths
   */
-  virtual wxString GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
+  virtual wxString GetWidthsAsString(bool subset, wxPdfGlyphSet* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
   /// Get the width of a string
   /**
@@ -87,7 +87,7 @@ public:
   * \return the converted string
   */
   virtual wxString ConvertCID2GID(const wxString& s, const wxPdfEncoding* encoding = NULL,
-                                  wxPdfSortedArrayInt* usedGlyphs = NULL,
+                                  wxPdfGlyphSet* usedGlyphs = NULL,
                                   wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
 
   /// Load the font metrics XML file
@@ -115,6 +115,12 @@ public:
   void SetHalfWidthRanges(bool hwRange, wxUniChar hwFirst, wxUniChar hwLast);
 
 protected:
+  /// Complete loading of the font metrics
+  virtual bool CompleteFontMetrics(bool complete);
+
+  /// Create the set of Unicode characters the font can show
+  virtual void CreateCoverage(const wxPdfEncoding* encoding, wxPdfGlyphSet& coverage) const;
+
   /// Check whether the font has a half width range
   bool HasHalfWidthRange() const { return m_hwRange; }
 
@@ -129,6 +135,8 @@ protected:
   wxUniChar m_hwLast;   ///< CID of the last half width character
 
   wxMBConv* m_conv;     ///< Associated encoding converter
+
+  const short* m_cwArray; ///< Static width table of the characters 32 to 126 of built-in fonts
 };
 
 #endif // wxUSE_UNICODE
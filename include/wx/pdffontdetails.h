@@ -13,6 +13,7 @@
 #define _PDF_FONT_DETAILS_H_
 
 // wxWidgets headers
+#include <wx/mstream.h>
 
 // wxPdfDocument headers
 #include "wx/pdfdocdef.h"
@@ -189,6 +190,25 @@ public:
   */
   wxString ConvertGlyph(wxUint32 glyph);
 
+  /// Convert an array of glyph numbers to character ids
+  /**
+  * The glyphs are registered as used glyphs in bulk. Additionally, the widths of
+  * the glyphs are included in the width array of the font, even if the glyphs
+  * are not reachable through the character map of the font.
+  * \param glyphs the glyph numbers to be converted
+  * \param count the number of glyphs
+  * \param[out] cids the resulting character ids; glyphs not available in the font are converted to 0
+  * \return TRUE if all glyphs are available in the font, FALSE otherwise
+  */
+  bool ConvertGlyphs(const wxUint32* glyphs, size_t count, wxUint32* cids);
+
+  /// Get the width of a glyph
+  /**
+  * \param glyph the glyph number
+  * \return the width of the glyph in units of 1/1000 of the font size, 0 if the glyph is not available
+  */
+  int GetGlyphWidth(wxUint32 glyph) const;
+
   /// Get the character width array as string
   /**
   * \return the string representation of the character widths
@@ -223,6 +243,16 @@ public:
   */
   size_t WriteCIDSet(wxOutputStream* setData);
 
+  /// Prepare the font program and the mapping streams
+  /**
+  * Creates the embedded font program (including subsetting) and the ToUnicode,
+  * CIDToGIDMap and CIDSet streams as required by the font type. The streams are
+  * kept until they are requested by WriteFontData, WriteUnicodeMap, WriteCIDToGIDMap
+  * or WriteCIDSet. This method only accesses the state of this font, therefore it
+  * may be called for different fonts concurrently.
+  */
+  void PrepareFontData();
+
 #if wxUSE_UNICODE
   /// Get the associated encoding converter
   /**
@@ -232,14 +262,28 @@ public:
 #endif
 
 protected:
+  /// Write the CID to GID mapping of the font data
+  /**
+  * \param mapData the output stream
+  * \return the size of the written data
+  */
+  size_t WriteFontCIDToGIDMap(wxOutputStream* mapData);
+
   int                  m_index; ///< Index number of this font
   int                  m_n;     ///< Font object index
   int                  m_fn;    ///< Font file index
   int                  m_ndiff; ///< Index of encoding differences object
 
   wxPdfFontExtended    m_font;         ///< Extended font for accessing font data
-  wxPdfSortedArrayInt* m_usedGlyphs;   ///< Array of used characters
+  wxPdfGlyphSet*       m_usedGlyphs;   ///< Set of used glyphs
   wxPdfChar2GlyphMap*  m_subsetGlyphs; ///< Glyph substitution map for font subsets
+  wxPdfGlyphSet        m_runGlyphs;    ///< Glyphs written by glyph number, if the font is not subsetted
+
+  wxMemoryOutputStream* m_preparedFontData;    ///< Prepared font program
+  wxMemoryOutputStream* m_preparedUnicodeMap;  ///< Prepared ToUnicode map
+  wxMemoryOutputStream* m_preparedCIDToGIDMap; ///< Prepared CIDToGID map
+  wxMemoryOutputStream* m_preparedCIDSet;      ///< Prepared CID set
+  size_t                m_preparedFontSize1;   ///< Length of the prepared font program
 
 private:
   /// Default constructor not available
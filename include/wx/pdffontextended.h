@@ -176,7 +176,13 @@ public:
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the string representation of the character widths
   */
-  wxString GetWidthsAsString(bool subset = false, wxPdfSortedArrayInt* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
+  wxString GetWidthsAsString(bool subset = false, wxPdfGlyphSet* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL) const;
+
+  /// Get the glyphs reachable through the character map of the font
+  /**
+  * \param[out] glyphs the set to which the glyph numbers are added
+  */
+  void GetMappedGlyphs(wxPdfGlyphSet& glyphs) const;
 
   /// Get the width of a string
   /**
@@ -204,6 +210,12 @@ public:
   */
   bool CanShow(const wxString& s) const;
 
+  /// Get the set of Unicode characters the font can show
+  /**
+  * \return the set of Unicode characters covered by the font, or NULL if the font is undefined
+  */
+  const wxPdfGlyphSet* GetCoverage() const;
+
   /// Convert character codes to glyph numbers
   /**
   * \param s the string to be converted
@@ -211,7 +223,7 @@ public:
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the converted string
   */
-  wxString ConvertCID2GID(const wxString& s, wxPdfSortedArrayInt* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL);
+  wxString ConvertCID2GID(const wxString& s, wxPdfGlyphSet* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL);
 
   /// Convert glyph number to string
   /**
@@ -220,7 +232,26 @@ public:
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the converted string
   */
-  wxString ConvertGlyph(wxUint32 glyph, wxPdfSortedArrayInt* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL);
+  wxString ConvertGlyph(wxUint32 glyph, wxPdfGlyphSet* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL);
+
+  /// Convert an array of glyph numbers to character ids
+  /**
+  * \param glyphs the glyph numbers to be converted
+  * \param count the number of glyphs
+  * \param[out] cids the resulting character ids; glyphs not available in the font are converted to 0
+  * \param usedGlyphs the list of used glyphs
+  * \param subsetGlyphs the mapping of glyphs to subset glyphs
+  * \return TRUE if all glyphs are available in the font, FALSE otherwise
+  */
+  bool ConvertGlyphs(const wxUint32* glyphs, size_t count, wxUint32* cids,
+                     wxPdfGlyphSet* usedGlyphs = NULL, wxPdfChar2GlyphMap* subsetGlyphs = NULL);
+
+  /// Get the width of a glyph
+  /**
+  * \param glyph the glyph number
+  * \return the width of the glyph in units of 1/1000 of the font size, 0 if the glyph is not available
+  */
+  int GetGlyphWidth(wxUint32 glyph) const;
 
   /// Check whether the font will be embedded
   /**
@@ -241,7 +272,7 @@ public:
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the size of the written font data
   */
-  size_t WriteFontData(wxOutputStream* fontData, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs);
+  size_t WriteFontData(wxOutputStream* fontData, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs);
 
   /// Write character/glyph to unicode mapping
   /**
@@ -250,7 +281,7 @@ public:
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the size of the written data
   */
-  size_t WriteUnicodeMap(wxOutputStream* mapData, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs);
+  size_t WriteUnicodeMap(wxOutputStream* mapData, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs);
 
   /// Write CID to GID mapping
   /**
@@ -259,7 +290,7 @@ public:
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the size of the written data
   */
-  size_t WriteCIDToGIDMap(wxOutputStream* mapData, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs);
+  size_t WriteCIDToGIDMap(wxOutputStream* mapData, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs);
 
   /// Write CID set
   /**
@@ -268,7 +299,7 @@ public:
   * \param subsetGlyphs the mapping of glyphs to subset glyphs
   * \return the size of the written data
   */
-  size_t WriteCIDSet(wxOutputStream* setData, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs);
+  size_t WriteCIDSet(wxOutputStream* setData, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs);
 
   /// Get the font description
   const wxPdfFontDescription& GetDescription() const;
@@ -165,6 +165,45 @@ public:
   */
   int RegisterFontDirectory(const wxString& directory, bool recursive = false);
 
+  /// Set the font registry index file
+  /**
+  * The font registry index stores the identification data (font type, names, family and style)
+  * of TrueType and OpenType fonts registered from font files, keyed by file path and font index.
+  * Fonts found in the index are registered without opening and parsing the font file, as long as
+  * size and modification time of the font file are unchanged. Entries of changed files are
+  * discarded and rebuilt on registering the font.
+  *
+  * The index is saved automatically at the end of RegisterSystemFonts and RegisterFontDirectory,
+  * if it was modified. After registering fonts individually it has to be saved explicitly
+  * by calling SaveFontRegistryIndex.
+  *
+  * \param indexFileName the name of the index file. The file is created if it does not exist yet.
+  * An empty file name disables the use of the index.
+  * \return TRUE if the index could be loaded or was created, FALSE otherwise
+  * \note An index file written by an incompatible version of wxPdfDocument is silently discarded.
+  */
+  bool SetFontRegistryIndex(const wxString& indexFileName);
+
+  /// Save the font registry index
+  /**
+  * Entries for font files which no longer exist are removed from the index.
+  * \return TRUE if the index was saved successfully or did not need to be saved, FALSE otherwise
+  */
+  bool SaveFontRegistryIndex();
+
+  /// Set the cache directory for decoded WOFF/WOFF2 fonts
+  /**
+  * WOFF and WOFF2 font files are decoded only once per process; the decoded font data
+  * are shared by font registration, font parsing and font subsetting. If a cache directory
+  * is set, the decoded font data are additionally stored in this directory and reused
+  * by later processes, as long as size and modification time of the font file are unchanged.
+  *
+  * \param cacheDirectory the cache directory. The directory is created if it does not exist yet.
+  * An empty directory name disables the disk cache.
+  * \return TRUE if the cache directory could be set, FALSE otherwise
+  */
+  bool SetDecodedFontCacheDirectory(const wxString& cacheDirectory);
+
   /// Get a font by name and style
   /**
   * Based on the given name and style the list of registered fonts is searched for a matching font.
@@ -212,7 +251,9 @@ public:
   /**
   * On registering a font the associated font data are not completely loaded into memory
   * to save time and memory resources, but as soon as the font is actually used it must
-  * be fully initialized. Usually this method is called automatically.
+  * be initialized. Usually this method is called automatically.
+  * \note For TrueType and OpenType fonts the kerning data are not loaded by this method,
+  * but separately on first use.
   * \param font the font to be initialized
   * \return TRUE if the font could be initialized successfully, FALSE otherwise
   */
@@ -177,11 +177,20 @@ protected:
 
   /// Read font maps
   /**
-  * Reads the tables 'head', 'hhea', 'OS/2' and 'post' filling several variables.
+  * Reads the font description, the glyph widths and the table 'cmap'.
   * \return TRUE if the font maps could be read successfully, FALSE otherwise
   */
   bool ReadMaps();
 
+  /// Read the font description
+  /**
+  * Reads the tables 'head', 'hhea', 'OS/2' and 'post' filling several variables.
+  * \param[out] unitsPerEm the number of units per em
+  * \param[out] numberOfHMetrics the number of horizontal metrics
+  * \return TRUE if the font description could be read successfully, FALSE otherwise
+  */
+  bool ReadFontDescription(int& unitsPerEm, int& numberOfHMetrics);
+
   /// Read the glyph widths
   /**
   * Reads the glyphs widths. The widths are extracted from the table 'hmtx'.
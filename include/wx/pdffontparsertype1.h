@@ -14,6 +14,7 @@
 
 // wxWidgets headers
 #include <wx/arrstr.h>
+#include <wx/buffer.h>
 #include <wx/string.h>
 #include <wx/stream.h>
 
@@ -24,8 +25,6 @@
 #include "wx/pdffontdescription.h"
 #include "wx/pdffontparser.h"
 
-class wxPdfCffIndexArray;
-
 /// Class representing a Type1 font parser
 class WXDLLIMPEXP_PDFDOC wxPdfFontParserType1 : public wxPdfFontParser
 {
@@ -107,65 +106,81 @@ private:
   /// Check whether the font's use is restricted
   void CheckRestrictions(long fsType);
 
-  /// Skip a PostScript comment in the font stream
-  void SkipComment(wxInputStream* stream);
+  /// Skip a PostScript comment
+  void SkipComment();
 
-  /// Skip white space in the font stream
-  void SkipSpaces(wxInputStream* stream);
+  /// Skip white space
+  void SkipSpaces();
 
-  /// Skip a literal string in the font stream
-  void SkipLiteralString(wxInputStream* stream);
+  /// Skip a literal string
+  void SkipLiteralString();
 
-  /// Skip a string in the font stream
-  void SkipString(wxInputStream* stream);
+  /// Skip a string
+  void SkipString();
 
-  /// Skip a PostScript procedure in the font stream
-  void SkipProcedure(wxInputStream* stream);
+  /// Skip a PostScript procedure
+  void SkipProcedure();
 
-  /// Skip a PostScript array in the font stream
-  void SkipArray(wxInputStream* stream);
+  /// Skip a PostScript array
+  void SkipArray();
 
-  /// Skip all bytes in the stream up to the next token
-  void SkipToNextToken(wxInputStream* stream);
+  /// Skip all bytes up to the next token
+  void SkipToNextToken();
 
-  /// Get the next token from the font stream
-  wxString GetToken(wxInputStream* stream);
+  /// Get the next token
+  wxString GetToken();
 
-  /// Get a literal string from the font stream
-  wxString GetLiteralString(wxInputStream* stream);
+  /// Get a literal string
+  wxString GetLiteralString();
 
-  /// Get a value array from the font stream
-  wxString GetArray(wxInputStream* stream);
+  /// Get a value array
+  wxString GetArray();
 
   /// Parse a PostScript dictionary
-  bool ParseDict(wxInputStream* stream, int start, int length, bool onlyNames);
+  /**
+  * \param data the font data containing the dictionary
+  * \param length the length of the font data
+  * \param onlyNames flag whether only the font names should be parsed
+  * \return TRUE if the parsing was successful, FALSE otherwise
+  */
+  bool ParseDict(const unsigned char* data, int length, bool onlyNames);
 
   /// Check whether a character represents a valid hexadecimal digit
   bool IsHexDigit(char digit);
 
   /// Decode a hexadecimal coded string
-  void DecodeHex(wxInputStream* inStream, wxOutputStream* outStream);
+  /**
+  * \param data the hexadecimal coded data
+  * \param length the length of the coded data
+  * \param buffer the buffer receiving the decoded bytes
+  * \return the number of decoded bytes
+  */
+  int DecodeHex(const unsigned char* data, int length, unsigned char* buffer);
 
-  /// Decode the EExec section
-  void DecodeEExec(wxMemoryOutputStream* eexecStream, wxOutputStream* outStream, unsigned short seed, int lenIV);
+  /// Decrypt eexec or charstring encrypted data in place
+  /**
+  * \param data the encrypted data, replaced by the decrypted data
+  * \param length the length of the encrypted data
+  * \param key the decryption key, updated for decrypting subsequent data
+  * \param skip the number of leading bytes to be dropped, updated accordingly
+  * \return the number of decrypted bytes
+  */
+  int DecodeEExec(unsigned char* data, int length, unsigned int& key, int& skip);
 
   /// Get the private dictionary
   bool GetPrivateDict(wxInputStream* stream, int start);
 
-  /// Parse the font matrix from the font stream
-  void ParseFontMatrix(wxInputStream* stream);
+  /// Parse the font matrix
+  void ParseFontMatrix();
 
-  /// Parse the font encoding from the font stream
-  void ParseEncoding(wxInputStream* stream);
+  /// Parse the font encoding
+  void ParseEncoding();
 
-  /// Parse the array of subroutines from the font stream
-  void ParseSubrs(wxInputStream* stream);
+  /// Parse the array of subroutines
+  void ParseSubrs();
 
-  /// Parse the charstrings from the font stream
-  void ParseCharStrings(wxInputStream* stream);
-
-  /// Parse the private dictionary
-  void ParsePrivate(wxInputStream* stream);
+  /// Parse the charstrings
+  void ParseCharStrings();
 
   /// Read a binary section from the font stream
   void ReadBinary(wxInputStream& inStream, int start, int size, wxOutputStream& outStream);
@@ -181,15 +196,17 @@ private:
   bool                         m_embedAllowed;         ///< Flag whether embedding is allowed
   bool                         m_subsetAllowed;        ///< Flag whether subsetting is allowed
 
-  wxInputStream*               m_privateDict;          ///< Private dictionary stream
+  wxMemoryBuffer               m_fontBuffer;           ///< Clear text part of the font
+  wxMemoryBuffer               m_privateDict;          ///< Decrypted private dictionary
+  const unsigned char*         m_data;                 ///< Data of the dictionary being parsed
+  int                          m_length;               ///< Length of the dictionary being parsed
+  int                          m_position;             ///< Parse position in the dictionary
+  int                          m_eexecPosition;        ///< Position after the keyword 'eexec' in the clear text part
   bool                         m_isPFB;                ///< Flag whether the font data are in PFB format
   bool                         m_privateFound;         ///< Flag whether the private dictionary has been found
   bool                         m_fontDirAfterPrivate;  ///< Flag whether the font directory is located before or after the private dictionary
   wxString                     m_encoding;             ///< name of the encoding
   long                         m_lenIV;                ///< initial vector length (decoding)
-
-  wxPdfCffIndexArray*          m_charStringsIndex;     ///< charstring index
-  wxPdfCffIndexArray*          m_subrsIndex;           ///< subroutine index
 };
 
 #endif // wxUSE_UNICODE
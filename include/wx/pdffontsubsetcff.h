@@ -13,6 +13,7 @@
 #define _PDF_FONT_SUBSET_CFF_H_
 
 // wxWidgets headers
+#include <wx/buffer.h>
 #include <wx/dynarray.h>
 #include <wx/mstream.h>
 #include <wx/string.h>
@@ -230,18 +231,22 @@ protected:
   void FindLocalAndGlobalSubrsUsed();
 
   /// Build the subset of the subroutines
-  void SubsetSubrs(wxPdfCffIndexArray& subrIndex, wxPdfSortedArrayInt& subrsUsed);
+  void SubsetSubrs(wxPdfCffIndexArray& subrIndex, const wxPdfGlyphSet& subrsUsed);
 
   /// Find the subroutines used
   void FindSubrsUsed(int fd, wxPdfCffIndexArray& localSubIndex,
-                     wxPdfSortedArrayInt& hSubrsUsed, wxArrayInt& lSubrsUsed);
+                     wxPdfGlyphSet& hSubrsUsed, wxArrayInt& lSubrsUsed);
 
   /// Find the global subroutines use
   void FindGlobalSubrsUsed();
 
 private:
   wxString              m_fileName;                ///< File name of the font file
-  wxInputStream*        m_inFont;                  ///< Font file input stream
+  wxMemoryBuffer        m_cffBuffer;               ///< Copy of the CFF font data
+  const unsigned char*  m_cffData;                 ///< CFF font data
+  int                   m_cffLength;               ///< Length of the CFF font data
+  int                   m_cffPosition;             ///< Current read position in the CFF font data
+  wxInputStream*        m_inFont;                  ///< Input stream on the CFF font data
   wxMemoryOutputStream* m_outFont;                 ///< Subset output stream
 
   wxPdfCffDecoder*      m_decoder;                 ///< Decoder for CFF format
@@ -281,9 +286,9 @@ private:
   int                   m_globalBias;              ///< The bias for the global subroutines
   int                   m_numHints;                ///< Number of arguments to the stem operators in a subroutine calculated recursively
 
-  wxPdfSortedArrayInt*  m_hGlobalSubrsUsed;        ///< A HashMap for keeping the Global subroutines used in the font
+  wxPdfGlyphSet*        m_hGlobalSubrsUsed;        ///< Set of the global subroutines used in the font
   wxArrayInt            m_lGlobalSubrsUsed;        ///< The Global SubroutinesUsed HashMaps as ArrayLists
-  wxPdfSortedArrayInt*  m_hLocalSubrsUsed;         ///< A HashMap for keeping the subroutines used in a non-cid font
+  wxPdfGlyphSet*        m_hLocalSubrsUsed;         ///< Set of the subroutines used in a non-cid font
   wxArrayInt            m_lLocalSubrsUsed;         ///< The SubroutinesUsed HashMap as ArrayList
 };
 
@@ -40,7 +40,7 @@ public:
   * \return the stream containing the font subset
   */
   wxMemoryOutputStream* CreateSubset(wxInputStream* inFont,
-                                     wxPdfSortedArrayInt* glyphsUsed,
+                                     wxPdfGlyphSet* glyphsUsed,
                                      bool includeCmap = false);
 #if defined(__WXMAC__)
 #if wxPDFMACOSX_HAS_CORE_TEXT
@@ -83,7 +83,8 @@ protected:
 private:
   wxMemoryOutputStream* m_outFont;    ///< Subset output stream
 
-  wxPdfSortedArrayInt*  m_usedGlyphs; ///< list of used glyphs
+  wxPdfGlyphSet*        m_usedGlyphs; ///< set of used glyphs
+  wxArrayInt            m_pendingGlyphs; ///< glyphs not yet checked for components
 
   int    m_fontIndex;                 ///< Index of font in font collection
   bool   m_includeCmap;               ///< Flag whether to include the CMap
@@ -22,7 +22,15 @@
 #include "wx/pdfarraytypes.h"
 #include "wx/pdffontdata.h"
 
-/// Class representing the Adobe core fonts. (For internal use only)
+class wxPdfVoltIndex;
+
+/// Class representing the VOLT rules of a font. (For internal use only)
+/**
+* On loading the rules are compiled into an index, which maps each character to the rules
+* that can only match if the text contains that character. On processing a text only the
+* rules triggered by the characters of the text are applied. The results for recently
+* processed texts are cached.
+*/
 class WXDLLIMPEXP_PDFDOC wxPdfVolt
 {
 public :
@@ -39,9 +47,12 @@ public :
   wxString ProcessRules(const wxString& text);
 
 protected:
+  /// Apply the VOLT rules to a text
+  wxString ApplyRules(const wxString& text) const;
 
 private:
-  wxArrayPtrVoid m_rules; ///< Array of VOLT rules
+  wxArrayPtrVoid  m_rules; ///< Array of VOLT rules
+  wxPdfVoltIndex* m_index; ///< Character index and result cache of the VOLT rules
 };
 
 #endif
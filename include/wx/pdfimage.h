@@ -13,11 +13,15 @@
 #define _PDF_IMAGE_H_
 
 // wxWidgets headers
+#include <wx/datetime.h>
 #include <wx/filesys.h>
 #include <wx/image.h>
+#include <wx/longlong.h>
 #include <wx/stream.h>
 #include <wx/string.h>
 
+#include <vector>
+
 // wxPdfDocument headers
 #include "wx/pdfdocdef.h"
 
@@ -32,12 +36,19 @@ public:
   wxPdfImage(wxPdfDocument* document, int index, const wxString& name, const wxString& type);
 
   /// Constructor
+  /**
+  * If the conversion is deferred, a copy of the image is kept until Prepare is called.
+  */
   wxPdfImage(wxPdfDocument* document, int index, const wxString& name, const wxImage& image,
-             bool jpegFormat = false);
+             bool jpegFormat = false, bool deferred = false);
 
   /// Constructor
   wxPdfImage(wxPdfDocument* document, int index, const wxString& name, wxInputStream& stream, const wxString& mimeType);
 
+  /// Constructor for a gray scale image given by a single channel of pixel data (e.g. the alpha channel of a wxImage)
+  wxPdfImage(wxPdfDocument* document, int index, const wxString& name, const unsigned char* channel, int width, int height,
+             int bitsPerComponent = 8, bool deferred = false);
+
   /// Destructor
   virtual ~wxPdfImage();
 
@@ -116,13 +127,125 @@ public:
   /// Get image data
   char* GetData() { return m_data; }
 
+  /// Check whether the image data are read from the image file only on output
+  bool IsDataDeferred() { return !m_dataFileName.IsEmpty(); }
+
+  /// Get the name of the file the image data are read from on output (if deferred)
+  wxString GetDataFileName() { return m_dataFileName; }
+
+  /// Get the digest of the image data calculated on parsing (if deferred)
+  wxString GetDataDigest() { return m_dataDigest; }
+
+  /// Check whether the file of deferred image data is unchanged since parsing
+  /**
+  * \return TRUE if the image data are not deferred, or if size and modification time
+  * of the image file are unchanged, FALSE otherwise
+  */
+  bool IsDataFileUnchanged();
+
+  /// Write the image data to a stream
+  /**
+  * If loading of the image data was deferred, the data are copied from the image file.
+  * If the image file was changed since parsing, the image data are replaced by zeros,
+  * and the method fails.
+  * \param stream the stream the image data are written to
+  * \return TRUE if all image data could be written, FALSE otherwise
+  */
+  bool WriteData(wxOutputStream& stream);
+
+  /// Check whether the image has an alpha channel to be embedded as soft mask
+  bool HasAlphaChannel() { return m_alpha != NULL; }
+
+  /// Get the alpha channel data (one component per pixel)
+  const unsigned char* GetAlphaChannel() { return m_alpha; }
+
+  /// Get the size of the alpha channel data
+  size_t GetAlphaChannelSize() { return m_alphaSize; }
+
+  /// Get the bits per component of the alpha channel data (8 or 16)
+  int GetAlphaBitsPerComponent() { return m_alphaBpc; }
+
+  /// Release the alpha channel data
+  void FreeAlphaChannel();
+
+  /// Record a placement of the image
+  /**
+  * \param width the width of the placed image in points
+  * \param height the height of the placed image in points
+  */
+  void AddPlacement(double width, double height);
+
+  /// Mark the size of the placed image as unknown (e.g. for images used in templates)
+  void SetPlacementUnknown() { m_placementUnknown = true; }
+
+  /// Check whether the size of the placed image is unknown
+  bool IsPlacementUnknown() { return m_placementUnknown; }
+
+  /// Get the maximal width of the placed image in points
+  double GetPlacedWidth() { return m_placedWidth; }
+
+  /// Get the maximal height of the placed image in points
+  double GetPlacedHeight() { return m_placedHeight; }
+
+  /// Resample the image according to the size of its placements
+  /**
+  * Only 8-bit gray scale and RGB images are resampled. The resampled image is used only,
+  * if its image data are smaller than the original image data.
+  * \param maxResolution the maximal resolution in dots per inch
+  * \param quality the filter used for resampling
+  * \param jpegQuality the quality for recompressing JPEG images (1..100), or 0 for lossless compression
+  * \return the number of bytes saved
+  */
+  size_t Resample(double maxResolution, wxImageResizeQuality quality, int jpegQuality);
+
   /// Parse image file
   bool Parse();
 
+  /// Check whether the conversion of the image data is still pending
+  bool IsPending() { return m_pending; }
+
+  /// Convert the image data, if the conversion was deferred on construction
+  /**
+  * Different images may be prepared concurrently.
+  * \return TRUE if the image data are valid, FALSE otherwise
+  */
+  bool Prepare();
+
 protected:
   /// Extract info from a wxImage
   bool ConvertWxImage(const wxImage& image, bool jpegFormat);
 
+  /// Compress raw pixel data
+  /**
+  * \param pixels the pixel data, row by row without padding
+  * \param width the image width in pixels
+  * \param height the image height in pixels
+  * \param colours the number of colour components to be embedded (1 = gray, 3 = RGB)
+  * \param pixelSize the number of bytes per pixel in the pixel data; only the bytes of the first colours components are used
+  * \param bitsPerComponent the number of bits per colour component (8 or 16, big endian)
+  * \return TRUE if the pixel data could be compressed, FALSE otherwise
+  */
+  bool ConvertPixels(const unsigned char* pixels, int width, int height, int colours, int pixelSize,
+                     int bitsPerComponent = 8);
+
+  /// Compress RGB pixel data with at most 256 distinct colours as palette based image
+  /**
+  * \param pixels the RGB pixel data, row by row without padding
+  * \param width the image width in pixels
+  * \param height the image height in pixels
+  * \return TRUE if the image was converted, FALSE if it has too many colours
+  */
+  bool ConvertIndexed(const unsigned char* pixels, int width, int height);
+
+  /// Compress black and white 8-bit pixel data as 1-bit image
+  bool ConvertBilevel(const unsigned char* pixels, int width, int height, int pixelSize);
+
+  /// Replace the image data by CCITT Group 4 encoded data of the given 1-bit rows if that is smaller
+  bool ApplyCcittG4(const unsigned char* packed, size_t rowBytes, int width, int height);
+
+  /// Decode the PNG image data, separating colour and alpha channel
+  bool DecodePNG(int width, int height, int bpc, int colours, bool hasAlpha, bool reduceDepth);
+
   /// Extract info from a JPEG file
   bool ParseJPG(wxInputStream* imageStream);
 
@@ -182,6 +305,19 @@ protected:
   char*          m_trns;      ///< Transparency colour data
   unsigned int   m_dataSize;  ///< Image data size
   char*          m_data;      ///< Image data
+  size_t         m_alphaSize; ///< Alpha channel size
+  unsigned char* m_alpha;     ///< Alpha channel data (for use as soft mask)
+  int            m_alphaBpc;  ///< Bits per component of alpha channel
+
+  double         m_placedWidth;      ///< Maximal width of the placed image in points
+  double         m_placedHeight;     ///< Maximal height of the placed image in points
+  bool           m_placementUnknown; ///< Flag whether the size of the placed image is unknown
+
+  bool           m_pending;        ///< Flag whether the conversion of the image data is pending
+  wxImage        m_pendingImage;   ///< Image to be converted
+  bool           m_pendingJpeg;    ///< Flag whether the pending image is to be converted to JPEG format
+  unsigned char* m_pendingChannel; ///< Gray scale channel to be converted
+  int            m_pendingBpc;     ///< Bits per component of the pending channel
 
   bool           m_isFormObj; ///< Flag whether image must be treated as form object
   int            m_x;         ///< Offset in X direction
@@ -190,6 +326,13 @@ protected:
   bool           m_fromWxImage;  ///< Flag whether image originated from wxImage
   bool           m_validWxImage; ///< Flag whether wxImage conversion went ok
 
+  wxString                  m_dataFileName;    ///< Local image file for deferred loading of the image data
+  wxULongLong               m_dataFileSize;    ///< Size of the image file on parsing
+  wxDateTime                m_dataFileTime;    ///< Modification time of the image file on parsing
+  wxString                  m_dataDigest;      ///< Digest of the deferred image data
+  std::vector<wxFileOffset> m_dataOffsets;     ///< Offsets of the image data segments in the image file
+  std::vector<unsigned int> m_dataLengths;     ///< Lengths of the image data segments in the image file
+
   wxFSFile*      m_imageFile;    ///< File system file of image
   wxInputStream* m_imageStream;  ///< Stream containing the image data
 
@@ -13,6 +13,7 @@
 #define _PDF_PARSER_H_
 
 // wxWidgets headers
+#include <wx/buffer.h>
 #include <wx/dynarray.h>
 #include <wx/filesys.h>
 #include <wx/mstream.h>
@@ -52,8 +53,24 @@ class WXDLLIMPEXP_PDFDOC wxPdfTokenizer
 {
 public:
   /// Constructor
+  /**
+  * If the input stream is seekable and its size is known, the tokenizer scans
+  * a window of at most 64 KiB of the stream data held in memory; the window is
+  * refilled from the stream whenever the scan position leaves it. The window is
+  * enlarged temporarily while scanning a token longer than the window. Otherwise
+  * the tokenizer reads from the stream byte by byte.
+  * \param inputStream the stream of document data
+  */
   wxPdfTokenizer(wxInputStream* inputStream);
 
+  /// Constructor
+  /**
+  * The tokenizer scans the data of the memory stream in place without copying it.
+  * The memory stream must not be modified while the tokenizer is in use.
+  * \param memoryStream the memory stream holding the document data
+  */
+  wxPdfTokenizer(wxMemoryOutputStream* memoryStream);
+
   /// Destructor
   virtual ~wxPdfTokenizer();
 
@@ -121,12 +138,45 @@ public:
   static int GetHex(int v);
 
 private:
-  wxInputStream* m_inputStream; ///< Stream of document data
-  int            m_type;        ///< Type of last token
-  wxString       m_stringValue; ///< Value of last token
-  int            m_reference;   ///< Reference number of object
-  int            m_generation;  ///< Generation number of object
-  bool           m_hexString;   ///< Flag for hexadeciaml strings
+  /// Make sure that the byte at the given position is held in the window
+  /**
+  * \param pos position in the document data
+  * \return TRUE if the byte is available, FALSE otherwise
+  */
+  bool FillWindow(size_t pos);
+
+  /// Load the window starting at the given position from the stream
+  /**
+  * \param pos position in the document data
+  * \return TRUE if the window could be loaded completely, FALSE otherwise
+  */
+  bool LoadWindow(size_t pos);
+
+  /// Scan a name, number or keyword token, refilling the window as needed
+  /**
+  * \param start position of the first byte of the token
+  * \param isNumber flag whether the token is a number
+  * \return the token string
+  */
+  wxString ScanBufferToken(size_t start, bool isNumber);
+
+  /// Get a string from the window
+  wxString GetBufferString(size_t start, size_t end) const;
+
+  wxInputStream*       m_inputStream;  ///< Stream of document data
+  bool                 m_buffered;     ///< Flag whether the document data are scanned through the window
+  const unsigned char* m_data;         ///< Window of document data
+  unsigned char*       m_windowBuffer; ///< Buffer of the window owned by the tokenizer
+  size_t               m_windowSize;   ///< Capacity of the window
+  size_t               m_windowStart;  ///< Position of the first byte of the window in the document data
+  size_t               m_windowLength; ///< Number of bytes held in the window
+  size_t               m_length;       ///< Length of the document data
+  size_t               m_position;     ///< Current position in the document data
+  int                  m_type;        ///< Type of last token
+  wxString             m_stringValue; ///< Value of last token
+  int                  m_reference;   ///< Reference number of object
+  int                  m_generation;  ///< Generation number of object
+  bool                 m_hexString;   ///< Flag for hexadeciaml strings
 
 };
 
@@ -177,6 +227,13 @@ public:
   wxPdfObjectMap* GetObjectMap() { return m_objectMap; }
 
   /// Append a referenced object to the queue
+  /**
+  * The queue does not keep the given object, but only a reference to it.
+  * The object is resolved again via the cross reference, when it is written.
+  * \param originalObjectId the object number in the parsed document
+  * \param actualObjectId the object number in the created document
+  * \param obj the indirect reference to the object
+  */
   void AppendObject(int originalObjectId, int actualObjectId, wxPdfObject* obj);
 
   /// Get the resources of a specific page
@@ -212,9 +269,47 @@ public:
   /// Get flag whether a stream should be decoded or not
   bool GetUseRawStream() const { return m_useRawStream; }
 
+  /// Decode the content of a stream object read without decoding
+  /**
+  * All filters of the stream are applied to the stream buffer,
+  * and the stream buffer is replaced by the decoded data.
+  * \param stream the stream object
+  */
+  void DecodeStreamBytes(wxPdfStream* stream);
+
+  /// Get a stream delivering the decoded content of a stream object
+  /**
+  * The filters of the stream object are chained as filter streams, which decode
+  * the content incrementally while it is read. The returned stream reads directly
+  * from the stream buffer, which must not be modified or deleted while the returned
+  * stream is in use. The caller is responsible for deleting the returned stream.
+  * \param stream the stream object read without decoding
+  * \return the stream delivering the decoded content, or NULL if the stream has no filters
+  */
+  wxInputStream* GetDecodedStream(wxPdfStream* stream);
+
 protected:
+  /// Get the page dictionary of a specific page
+  /**
+  * Only the most recently used page dictionary is kept in memory.
+  * The returned object is owned by the parser, it is valid only until the next call.
+  */
+  wxPdfDictionary* GetPage(unsigned int pageno);
+
+  /// Add an object stream to the object stream cache
+  /**
+  * If the size of the cached object streams exceeds the cache limit,
+  * the least recently used object streams are removed from the cache.
+  */
+  void CacheObjectStream(int objIndex, wxPdfStream* objStm);
+
   /// Get the resources of a specific page identified by a page object
-  wxPdfObject* GetPageResources(wxPdfObject* page);
+  /**
+  * \param page the page object
+  * \param[out] detached TRUE if direct resources were detached from the page dictionary, FALSE otherwise
+  * \return the resources of the page
+  */
+  wxPdfObject* GetPageResources(wxPdfObject* page, bool& detached);
 
   /// Get the content stream collection of a specific page
   void GetPageContent(wxPdfObject* contentRef, wxArrayPtrVoid& contents);
@@ -267,36 +362,14 @@ protected:
   /// Parse the raw content of a stream object
   void GetStreamBytesRaw(wxPdfStream* stream);
 
-  /// Decode a stream predictor
-  wxMemoryOutputStream* DecodePredictor(wxMemoryOutputStream* in, wxPdfObject* dicPar);
-
-  /// Decode a stream that has the FlateDecode filter.
-  /**
-   * \param osIn the input data
-   * \return the decoded data
-   */
-  wxMemoryOutputStream* FlateDecode(wxMemoryOutputStream* osIn);
-
-  /// Decode a stream that has the ASCIIHexDecode filter.
-  /**
-   * \param osIn the input data
-   * \return the decoded data
-   */
-  wxMemoryOutputStream* ASCIIHexDecode(wxMemoryOutputStream* osIn);
-
-  /// Decode a stream that has the ASCII85Decode filter.
+  /// Create a decoding filter stream for a single filter
   /**
-   * \param osIn the input data
-   * \return the decoded data
+   * \param in the stream delivering the encoded data; the filter stream takes ownership
+   * \param filterName the name of the filter
+   * \param decodeParms the decode parameters of the filter (may be NULL)
+   * \return the filter stream, or NULL if the filter is not supported
    */
-  wxMemoryOutputStream* ASCII85Decode(wxMemoryOutputStream* osIn);
-
-  /// Decode a stream that has the ASCII85Decode filter.
-  /**
-   * \param osIn the input data
-   * \return the decoded data
-   */
-  wxMemoryOutputStream* LZWDecode(wxMemoryOutputStream* osIn);
+  wxInputStream* CreateFilterStream(wxInputStream* in, const wxString& filterName, wxPdfObject* decodeParms);
 
   /// Get wxWidgets file system
   static wxFileSystem* GetFileSystem();
@@ -314,8 +387,9 @@ private:
   wxPdfTokenizer*   m_tokens;          ///< Tokenizer
   wxPdfDictionary*  m_trailer;         ///< Trailer dictionary
   wxPdfDictionary*  m_root;            ///< Root object
-  wxArrayPtrVoid    m_pages;           ///< Array of page objects
+  wxArrayPtrVoid    m_pages;           ///< Array of page references
   unsigned int      m_currentPage;     ///< Number of current page
+  wxPdfDictionary*  m_currentPageDict; ///< Dictionary of current page
   bool              m_useRawStream;    ///< Flag whether to use raw stream data (without decoding)
 
   bool              m_encrypted;       ///< Flag whether the document is encrypted
@@ -326,6 +400,8 @@ private:
   wxPdfObjectQueue* m_objectQueueLast; ///< Pointer to last queue element
   wxPdfObjectMap*   m_objectMap;       ///< Map for object queue elements
   wxPdfObjStmMap*   m_objStmCache;     ///< Cache for object streams
+  wxArrayInt        m_objStmCacheLru;  ///< Object streams in cache ordered by last use
+  size_t            m_objStmCacheSize; ///< Size of the cached object streams
   bool              m_cacheObjects;    ///< Flag whether object streams should be cached
 
   int               m_objNum;          ///< Number of current object
@@ -336,47 +412,178 @@ private:
   static wxFileSystem* ms_fileSystem; ///< wxWidgets file system
 };
 
-#define WXPDF_LZW_STRINGTABLE_SIZE 8192
+/// Maximal size of the decoded object streams kept in the object stream cache
+#define WXPDF_OBJSTM_CACHE_SIZE (16*1024*1024)
+
+/// Size of the buffers of the decoding filter streams
+#define WXPDF_DECODE_BUFFER_SIZE 16384
+
+/// Size of the LZW string table
+#define WXPDF_LZW_TABLE_SIZE 4096
 
-/// Class representing an LZW decoder. (For internal use only)
-class WXDLLIMPEXP_PDFDOC wxPdfLzwDecoder
+/// Base class of the decoding filter streams used by the PDF parser. (For internal use only)
+/**
+* A decoding filter stream pulls the encoded data from its parent stream and
+* decodes them on demand into a bounded output buffer. Filter streams can be
+* chained to decode streams with multiple filters incrementally.
+*/
+class WXDLLIMPEXP_PDFDOC wxPdfDecodeInputStream : public wxFilterInputStream
 {
 public:
   /// Constructor
-  wxPdfLzwDecoder();
+  /**
+  * \param stream the stream delivering the encoded data; the filter stream takes ownership
+  */
+  wxPdfDecodeInputStream(wxInputStream* stream);
 
   /// Destructor
-  virtual ~wxPdfLzwDecoder();
+  virtual ~wxPdfDecodeInputStream();
 
-  /// Get next code
-  int GetNextCode();
+protected:
+  /// Read decoded data
+  virtual size_t OnSysRead(void* buffer, size_t size);
+
+  /// Decode the next portion of the encoded data into the output buffer
+  /**
+  * \return false if the end of the encoded data is reached or an error occurred, true otherwise
+  */
+  virtual bool DecodeNext() = 0;
 
-  /// Decode a byte stream
-  bool Decode(wxMemoryInputStream* dataIn, wxMemoryOutputStream* dataOut);
+  /// Get the next byte of encoded data
+  /**
+  * \return the next byte, or -1 at the end of the encoded data
+  */
+  int GetInputChar();
+
+  /// Get a block of encoded data
+  /**
+  * \return the number of bytes read
+  */
+  size_t GetInputBlock(unsigned char* buffer, size_t size);
+
+  /// Peek at the buffered encoded data
+  /**
+  * \param length the number of buffered bytes
+  * \return a pointer to the buffered bytes
+  */
+  const unsigned char* PeekInput(size_t& length);
+
+  /// Flag a decoding error
+  void SetDecodeError(const wxString& message);
+
+  wxMemoryBuffer m_outBuffer;  ///< Buffer of decoded data
+
+private:
+  unsigned char* m_inBuffer;   ///< Buffer of encoded data
+  size_t         m_inPos;      ///< Position in the buffer of encoded data
+  size_t         m_inLen;      ///< Length of the buffered encoded data
+  size_t         m_outPos;     ///< Position in the buffer of decoded data
+  bool           m_eod;        ///< Flag whether the end of the encoded data is reached
+  bool           m_error;      ///< Flag whether a decoding error occurred
+};
+
+/// Class representing an ASCIIHexDecode filter stream. (For internal use only)
+class WXDLLIMPEXP_PDFDOC wxPdfASCIIHexInputStream : public wxPdfDecodeInputStream
+{
+public:
+  /// Constructor
+  wxPdfASCIIHexInputStream(wxInputStream* stream);
+
+protected:
+  /// Decode the next portion of the encoded data
+  virtual bool DecodeNext();
+};
+
+/// Class representing an ASCII85Decode filter stream. (For internal use only)
+class WXDLLIMPEXP_PDFDOC wxPdfASCII85InputStream : public wxPdfDecodeInputStream
+{
+public:
+  /// Constructor
+  wxPdfASCII85InputStream(wxInputStream* stream);
+
+protected:
+  /// Decode the next portion of the encoded data
+  virtual bool DecodeNext();
+};
+
+/// Class representing a RunLengthDecode filter stream. (For internal use only)
+class WXDLLIMPEXP_PDFDOC wxPdfRunLengthInputStream : public wxPdfDecodeInputStream
+{
+public:
+  /// Constructor
+  wxPdfRunLengthInputStream(wxInputStream* stream);
+
+protected:
+  /// Decode the next portion of the encoded data
+  virtual bool DecodeNext();
+};
+
+/// Class representing an LZWDecode filter stream. (For internal use only)
+class WXDLLIMPEXP_PDFDOC wxPdfLzwInputStream : public wxPdfDecodeInputStream
+{
+public:
+  /// Constructor
+  /**
+  * \param stream the stream delivering the encoded data
+  * \param earlyChange the code length is increased one code early (1) or not (0)
+  */
+  wxPdfLzwInputStream(wxInputStream* stream, int earlyChange = 1);
+
+protected:
+  /// Decode the next portion of the encoded data
+  virtual bool DecodeNext();
+
+private:
+  /// Get the next code
+  int GetNextCode();
 
   /// Initialize the string table
   void InitializeStringTable();
 
-  /// Write decoded string into output buffer
+  /// Append the string of a code to the output buffer
   void WriteString(int code);
 
-  /// Add string to string table
-  void AddStringToTable(int oldCode, char newString);
+  /// Add a string to the string table
+  void AddStringToTable(int oldCode, unsigned char newChar);
+
+  int           m_earlyChange;                    ///< Early change of code length
+  int           m_tableIndex;                     ///< Current string table index
+  int           m_bitsToGet;                      ///< Number of bits to get from stream
+  int           m_nextData;                       ///< Next data item
+  int           m_nextBits;                       ///< Next bits
+  int           m_oldCode;                        ///< Previous code
+  bool          m_started;                        ///< Flag whether decoding has started
+  int           m_prefix[WXPDF_LZW_TABLE_SIZE];   ///< Prefix codes of the string table
+  unsigned char m_suffix[WXPDF_LZW_TABLE_SIZE];   ///< Last characters of the string table
+  unsigned char m_first[WXPDF_LZW_TABLE_SIZE];    ///< First characters of the string table
+  int           m_length[WXPDF_LZW_TABLE_SIZE];   ///< String lengths of the string table
+};
+
+/// Class representing a PNG predictor filter stream. (For internal use only)
+class WXDLLIMPEXP_PDFDOC wxPdfPredictorInputStream : public wxPdfDecodeInputStream
+{
+public:
+  /// Constructor
+  /**
+  * \param stream the stream delivering the predicted data
+  * \param colours the number of colour components per pixel
+  * \param bitsPerComponent the number of bits per colour component
+  * \param columns the number of pixels per row
+  */
+  wxPdfPredictorInputStream(wxInputStream* stream, int colours, int bitsPerComponent, int columns);
+
+  /// Destructor
+  virtual ~wxPdfPredictorInputStream();
+
+protected:
+  /// Decode the next row
+  virtual bool DecodeNext();
 
 private:
-  wxMemoryInputStream*  m_dataIn;       ///< Encoded data stream
-  wxMemoryOutputStream* m_dataOut;      ///< Decoded data stream
-  size_t                m_dataSize;     ///< Length of encoded data stream
-  wxArrayInt            m_stringTable[WXPDF_LZW_STRINGTABLE_SIZE]; ///< Table of decoded strings
-
-  int                   m_tableIndex;   ///< Current string table index
-  int                   m_bitsToGet;    ///< Number of bits to get from stream
-  int                   m_bytePointer;  ///< Offset in encoded data stream
-  int                   m_bitPointer;   ///< Bit offset
-  int                   m_nextData;     ///< Next data item
-  int                   m_nextBits;     ///< Next bits
-
-  static int            ms_andTable[4]; ///< Static array of string table offsets
+  int            m_bytesPerPixel; ///< Number of bytes per pixel
+  int            m_bytesPerRow;   ///< Number of bytes per row
+  unsigned char* m_curr;          ///< Current row
+  unsigned char* m_prior;         ///< Prior row
 };
 
 #endif
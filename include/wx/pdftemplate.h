@@ -67,6 +67,20 @@ public:
   /// Get the array of page resource objects
   wxPdfObject* GetResources() { return m_resources; }
 
+  /// Set the filter of imported page content copied without decoding
+  /**
+  * The template takes ownership of the filter and decode parameter objects.
+  * \param filter the filter name or array of filter names
+  * \param decodeParms the decode parameters (may be NULL)
+  */
+  void SetContentFilter(wxPdfObject* filter, wxPdfObject* decodeParms);
+
+  /// Get the filter of imported page content copied without decoding
+  wxPdfObject* GetContentFilter() { return m_contentFilter; }
+
+  /// Get the decode parameters of imported page content copied without decoding
+  wxPdfObject* GetContentDecodeParms() { return m_contentParms; }
+
 private:
   int                  m_templateId;        ///< Index of template
   int                  m_n;                 ///< Object number of template
@@ -85,6 +99,8 @@ private:
 
   wxPdfParser*         m_parser;            ///< Associated parser
   wxPdfObject*         m_resources;         ///< Array of page resource objects
+  wxPdfObject*         m_contentFilter;     ///< Filter of encoded template content
+  wxPdfObject*         m_contentParms;      ///< Decode parameters of encoded template content
 
   int                  m_stateSave;         ///< Saved document state
   double               m_xSave;             ///< Saved X position
@@ -15,6 +15,8 @@
 // wxWidgets headers
 #include <wx/string.h>
 
+#include <functional>
+
 // wxPdfDocument headers
 #include "wx/pdfdocdef.h"
 
@@ -77,6 +79,17 @@ public:
   */
   static wxString RGB2String(const wxColour& colour);
 
+  /// Executes a number of independent tasks in parallel
+  /**
+  * The tasks are distributed over a pool of worker threads, the calling thread takes part
+  * in processing the tasks. The method returns after all tasks have been completed.
+  * If thread support is not available, the tasks are executed sequentially.
+  * \param count the number of tasks
+  * \param task the function to be called for each task; its argument is the task index (0 to count-1)
+  * \param maxThreads the maximum number of threads to be used; 0 means the number of available CPUs
+  */
+  static void RunParallel(size_t count, const std::function<void(size_t)>& task, int maxThreads = 0);
+
 private:
   static bool ms_seeded;  ///< flag whether random number generator is seeded
   static int  ms_s1;      ///< Random number generator seed 1
@@ -456,6 +456,25 @@ MakeFont::CreateFontMetricsFile(const wxString& xmlFileName, wxPdfFontData& font
   {
     rootNode->RemoveChild(voltRoot);
   }
+  else
+  {
+    // Create binary font metrics file (VOLT data are only supported in XML format)
+    // The subsetting attribute and the glyph numbers are only evaluated for TrueType and OpenType fonts
+    wxFileName binaryFileName(xmlFileName);
+    binaryFileName.SetExt(wxS("wfm"));
+    bool binarySubsetting = (fontType == wxS("TrueType") || fontType == wxS("OpenTypeUnicode"));
+    bool binaryGlyphInfo = includeGlyphInfo && binarySubsetting;
+    wxFileOutputStream binaryFile(binaryFileName.GetFullPath());
+    if (binaryFile.IsOk() && font.WriteBinaryFontMetrics(binaryFile, binaryGlyphInfo, binarySubsetting))
+    {
+      binaryFile.Close();
+      wxLogMessage(wxS("Binary font metrics file generated (") + binaryFileName.GetFullName() + wxS(")."));
+    }
+    else
+    {
+      wxLogMessage(wxS("Warning: Binary font metrics file '") + binaryFileName.GetFullName() + wxS("' could not be written."));
+    }
+  }
 }
 
 /// Make wxPdfDocument font metrics file based on AFM file
@@ -1430,6 +1449,7 @@ MakeFont::MakeFontImmediate(const wxString& fontFileName)
   wxPdfFontData* loadedFont = fontParser.IdentifyFont(fileName.GetFullName(), 0);
   if (loadedFont != NULL && fontParser.LoadFontData(loadedFont))
   {
+    // The kerning pairs kept in the binary font metrics file are loaded in the same pass
     wxString baseName = fileName.GetName();
     if (loadedFont->EmbedSupported())
     {
@@ -145,32 +145,48 @@ static const wxStringCharType* gs_standardStrings[] = {
 static int gs_standardStringsCount = sizeof(gs_standardStrings) / sizeof(wxStringCharType*);
 #endif
 
-// The Strings in this array represent Type1/Type2 operator names
-static const wxStringCharType* gs_subrsFunctions[] = {
-    wxS("RESERVED_0"),  wxS("hstem"),       wxS("RESERVED_2"),  wxS("vstem"),          wxS("vmoveto"),
-    wxS("rlineto"),     wxS("hlineto"),     wxS("vlineto"),     wxS("rrcurveto"),      wxS("RESERVED_9"),
-    wxS("callsubr"),    wxS("return"),      wxS("escape"),      wxS("hsbw"),/*RES_13*/ wxS("endchar"),
-    wxS("RESERVED_15"), wxS("RESERVED_16"), wxS("RESERVED_17"), wxS("hstemhm"),        wxS("hintmask"),
-    wxS("cntrmask"),    wxS("rmoveto"),     wxS("hmoveto"),     wxS("vstemhm"),        wxS("rcurveline"),
-    wxS("rlinecurve"),  wxS("vvcurveto"),   wxS("hhcurveto"),   wxS("shortint"),       wxS("callgsubr"),
-    wxS("vhcurveto"),   wxS("hvcurveto")
-  };
-#if 0
-static int gs_subrsFunctionsCount = sizeof(gs_subrsFunctions) / sizeof(wxStringCharType*);
-#endif
+// Type1/Type2 charstring operators (as named in the Type 1 and Type 2 charstring specifications).
+// Escape operators carry the escape byte 12 in the high byte.
 
-// The Strings in this array represent Type1/Type2 escape operator names
-static const wxStringCharType* gs_subrsEscapeFuncs[] = {
-    wxS("RESERVED_0"),  wxS("RESERVED_1"),    wxS("RESERVED_2"),   wxS("and"),           wxS("or"),
-    wxS("not"),         wxS("seac"),/*RES_6*/ wxS("sbw"),/*RES_7*/ wxS("RESERVED_8"),    wxS("abs"),
-    wxS("add"),         wxS("sub"),           wxS("div"),          wxS("RESERVED_13"),   wxS("neg"),
-    wxS("eq"),          wxS("RESERVED_16"),   wxS("RESERVED_17"),  wxS("drop"),          wxS("RESERVED_19"),
-    wxS("put"),         wxS("get"),           wxS("ifelse"),       wxS("random"),        wxS("mul"),
-    wxS("RESERVED_25"), wxS("sqrt"),          wxS("dup"),          wxS("exch"),          wxS("index"),
-    wxS("roll"),        wxS("RESERVED_31"),   wxS("RESERVED_32"),  wxS("RESERVED_33"),   wxS("hflex"),
-    wxS("flex"),        wxS("hflex1"),        wxS("flex1"),        wxS("RESERVED_REST")
-  };
-static int gs_subrsEscapeFuncsCount = sizeof(gs_subrsEscapeFuncs) / sizeof(wxStringCharType*);
+enum {
+  HSTEM_OP     = 0x0001,
+  VSTEM_OP     = 0x0003,
+  CALLSUBR_OP  = 0x000a,
+  RETURN_OP    = 0x000b,
+  ESCAPE_OP    = 0x000c,
+  HSBW_OP      = 0x000d,
+  HSTEMHM_OP   = 0x0012,
+  HINTMASK_OP  = 0x0013,
+  CNTRMASK_OP  = 0x0014,
+  VSTEMHM_OP   = 0x0017,
+  CALLGSUBR_OP = 0x001d,
+  AND_OP       = 0x0c03,
+  OR_OP        = 0x0c04,
+  NOT_OP       = 0x0c05,
+  SEAC_OP      = 0x0c06,
+  SBW_OP       = 0x0c07,
+  ABS_OP       = 0x0c09,
+  ADD_OP       = 0x0c0a,
+  SUB_OP       = 0x0c0b,
+  DIV_OP       = 0x0c0c,
+  NEG_OP       = 0x0c0e,
+  EQ_OP        = 0x0c0f,
+  DROP_OP      = 0x0c12,
+  PUT_OP       = 0x0c14,
+  GET_OP       = 0x0c15,
+  IFELSE_OP    = 0x0c16,
+  RANDOM_OP    = 0x0c17,
+  MUL_OP       = 0x0c18,
+  SQRT_OP      = 0x0c1a,
+  DUP_OP       = 0x0c1b,
+  EXCH_OP      = 0x0c1c,
+  INDEX_OP     = 0x0c1d,
+  ROLL_OP      = 0x0c1e,
+  NO_OP        = -1
+};
+
+// Maximum number of arguments on the argument stack
+static const int gs_maxArgs = 48;
 
 #if 0
 static wxStringCharType* gs_operatorNames[] = {
@@ -210,12 +226,13 @@ wxPdfCffDecoder::wxPdfCffDecoder()
   m_hGlobalSubrsUsed = NULL;
   m_lGlobalSubrsUsed = NULL;
 
-  m_args = new wxPdfCffFontObject[48];
+  m_op = NO_OP;
+  m_args = new wxPdfCffFontObject[gs_maxArgs];
   m_argCount = 0;
 }
 
 wxPdfCffDecoder::wxPdfCffDecoder(wxPdfCffIndexArray* globalSubrIndex,
-                                 wxPdfSortedArrayInt* hGlobalSubrsUsed,
+                                 wxPdfGlyphSet* hGlobalSubrsUsed,
                                  wxArrayInt* lGlobalSubrsUsed)
 {
   m_charstringType = 2;
@@ -224,7 +241,8 @@ wxPdfCffDecoder::wxPdfCffDecoder(wxPdfCffIndexArray* globalSubrIndex,
   m_hGlobalSubrsUsed = hGlobalSubrsUsed;
   m_lGlobalSubrsUsed = lGlobalSubrsUsed;
 
-  m_args = new wxPdfCffFontObject[48];
+  m_op = NO_OP;
+  m_args = new wxPdfCffFontObject[gs_maxArgs];
   m_argCount = 0;
 }
 
@@ -233,34 +251,6 @@ wxPdfCffDecoder::~wxPdfCffDecoder()
   delete [] m_args;
 }
 
-// --- Read original CFF stream
-
-unsigned char
-wxPdfCffDecoder::ReadByte(wxInputStream* stream)
-{
-  unsigned char card8;
-  stream->Read(&card8, 1);
-  return card8;
-}
-
-short
-wxPdfCffDecoder::ReadShort(wxInputStream* stream)
-{
-  // Read a 2-byte integer from file (big endian)
-  short i16;
-  stream->Read(&i16, 2);
-  return wxINT16_SWAP_ON_LE(i16);
-}
-
-int
-wxPdfCffDecoder::ReadInt(wxInputStream* stream)
-{
-  // Read a 4-byte integer from file (big endian)
-  int i32;
-  stream->Read(&i32, 4);
-  return wxINT32_SWAP_ON_LE(i32);
-}
-
 // -- Subset global and local subroutines
 
 int
@@ -289,27 +279,44 @@ wxPdfCffDecoder::CalcBias(int nSubrs)
 
 bool
 wxPdfCffDecoder::GetCharWidthAndComposite(wxPdfCffIndexElement& charstring, int& width, bool& isComposite, int& bchar, int& achar)
+{
+  // Copy the charstring into a contiguous buffer
+  int end = charstring.GetLength();
+  wxMemoryBuffer buffer;
+  if (end > 0)
+  {
+    wxInputStream* stream = charstring.GetBuffer();
+    stream->SeekI(charstring.GetOffset());
+    stream->Read(buffer.GetWriteBuf(end), end);
+    buffer.UngetWriteBuf(stream->LastRead());
+  }
+  return GetCharWidthAndComposite((const unsigned char*) buffer.GetData(), (int) buffer.GetDataLen(),
+                                  width, isComposite, bchar, achar);
+}
+
+bool
+wxPdfCffDecoder::GetCharWidthAndComposite(const unsigned char* data, int end, int& width, bool& isComposite, int& bchar, int& achar)
 {
   bool ok = false;
   width = -1;
   isComposite = false;
   bchar = -1;
   achar = -1;
-
-  wxInputStream* stream = charstring.GetBuffer();
-  int begin = charstring.GetOffset();
-  int end   = begin + charstring.GetLength();
+  if (end <= 0)
+  {
+    return false;
+  }
+  int pos = 0;
 
   // Clear the stack
   EmptyStack();
   m_numHints = 0;
 
-  stream->SeekI(begin);
-  ReadCommand(stream);
+  ReadCommand(data, pos, end);
   wxPdfCffFontObject* element = NULL;
   int numArgs = m_argCount;
   HandleStack();
-  if (m_key == wxS("hsbw"))
+  if (m_op == HSBW_OP)
   {
     if (numArgs == 2)
     {
@@ -318,7 +325,7 @@ wxPdfCffDecoder::GetCharWidthAndComposite(wxPdfCffIndexElement& charstring, int&
       width = element->m_intValue;
     }
   }
-  else if (m_key == wxS("sbw"))
+  else if (m_op == SBW_OP)
   {
     if (numArgs == 4)
     {
@@ -327,13 +334,13 @@ wxPdfCffDecoder::GetCharWidthAndComposite(wxPdfCffIndexElement& charstring, int&
       width = element->m_intValue;
     }
   }
-  if (ok && (stream->TellI() < end))
+  if (ok && (pos < end))
   {
-    ReadCommand(stream);
+    ReadCommand(data, pos, end);
     numArgs = m_argCount;
     // Check the modification needed on the Argument Stack according to key;
     HandleStack();
-    if (m_key == wxS("seac"))
+    if (m_op == SEAC_OP)
     {
       if (numArgs == 5)
       {
@@ -350,12 +357,11 @@ wxPdfCffDecoder::GetCharWidthAndComposite(wxPdfCffIndexElement& charstring, int&
 }
 
 void
-wxPdfCffDecoder::ReadASubr(wxInputStream* stream, int begin, int end,
+wxPdfCffDecoder::ReadASubr(const unsigned char* data, int begin, int end,
                            int globalBias, int localBias,
-                           wxPdfSortedArrayInt& hSubrsUsed, wxArrayInt& lSubrsUsed,
+                           wxPdfGlyphSet& hSubrsUsed, wxArrayInt& lSubrsUsed,
                            wxPdfCffIndexArray& localSubrIndex)
 {
-  int beginSubr, endSubr;
 #if 0
   wxLogDebug(wxS("ReadAsubr %d %d %d %d"), begin, end, globalBias, localBias);
 #endif
@@ -363,89 +369,81 @@ wxPdfCffDecoder::ReadASubr(wxInputStream* stream, int begin, int end,
   EmptyStack();
   m_numHints = 0;
   // Goto begining of the subr
-  stream->SeekI(begin);
-  while (stream->TellI() < end)
+  int pos = begin;
+  while (pos < end)
   {
     // Read the next command
-    ReadCommand(stream);
-    int pos = stream->TellI();
-    wxPdfCffFontObject* topElement = NULL;
-    if (m_argCount > 0)
-    {
-      topElement = &m_args[m_argCount-1];
-    }
+    ReadCommand(data, pos, end);
+    int topValue = (m_argCount > 0) ? m_args[m_argCount-1].m_intValue : 0;
     int numArgs = m_argCount;
     // Check the modification needed on the Argument Stack according to key;
     HandleStack();
-    // a call to a Lsubr
-    if (m_key == wxS("callsubr"))
+    switch (m_op)
     {
-      // Verify that arguments are passed
-      if (numArgs > 0)
-      {
-        // Calc the index of the Subrs
-        int subr = topElement->m_intValue + localBias;
-        // If the subr isn't in the HashMap -> Put in
-        if (hSubrsUsed.Index(subr) == wxNOT_FOUND)
+      // a call to a Lsubr
+      case CALLSUBR_OP:
+        // Verify that arguments are passed
+        if (numArgs > 0)
         {
-#if 0
-          wxLogDebug(wxS("Add hSubr: %s %d"), m_key.c_str(), subr);
-#endif
-          hSubrsUsed.Add(subr);
-          lSubrsUsed.Add(subr);
+          // Calc the index of the Subrs
+          int subr = topValue + localBias;
+          if (subr >= 0 && subr < (int) localSubrIndex.GetCount())
+          {
+            // If the subr isn't in the set -> Put in
+            if (hSubrsUsed.Add(subr))
+            {
+              lSubrsUsed.Add(subr);
+            }
+            CalcSubrHints(data, localSubrIndex[subr], globalBias, localBias, localSubrIndex);
+          }
         }
-        wxPdfCffIndexElement& localSubr = localSubrIndex[subr];
-        beginSubr = localSubr.GetOffset();
-        endSubr = beginSubr + localSubr.GetLength();
-        CalcHints(localSubr.GetBuffer(), beginSubr, endSubr, globalBias, localBias, localSubrIndex);
-        stream->SeekI(pos);
-      }
-    }
-    // a call to a Gsubr
-    else if (m_key == wxS("callgsubr"))
-    {
-      // Verify that arguments are passed
-      if (numArgs > 0)
-      {
-        // Calc the index of the Subrs
-        int subr = topElement->m_intValue + globalBias;
-        // If the subr isn't in the HashMap -> Put in
-        if (m_hGlobalSubrsUsed->Index(subr) == wxNOT_FOUND)
+        break;
+
+      // a call to a Gsubr
+      case CALLGSUBR_OP:
+        // Verify that arguments are passed
+        if (numArgs > 0)
         {
-#if 0
-          wxLogDebug(wxS("Add hGSubr: %s %d"), m_key.c_str(), subr);
-#endif
-          m_hGlobalSubrsUsed->Add(subr);
-          m_lGlobalSubrsUsed->Add(subr);
+          // Calc the index of the Subrs
+          int subr = topValue + globalBias;
+          if (subr >= 0 && subr < (int) m_globalSubrIndex->GetCount())
+          {
+            // If the subr isn't in the set -> Put in
+            if (m_hGlobalSubrsUsed->Add(subr))
+            {
+              m_lGlobalSubrsUsed->Add(subr);
+            }
+            CalcSubrHints(data, (*m_globalSubrIndex)[subr], globalBias, localBias, localSubrIndex);
+          }
         }
-        wxPdfCffIndexElement& globalSubr = (*m_globalSubrIndex)[subr];
-        beginSubr = globalSubr.GetOffset();
-        endSubr = beginSubr + globalSubr.GetLength();
-        CalcHints(globalSubr.GetBuffer(), beginSubr, endSubr, globalBias, localBias, localSubrIndex);
-        stream->SeekI(pos);
-      }
-    }
-    // A call to "stem"
-    else if (m_key == wxS("hstem") || m_key == wxS("vstem") || m_key == wxS("hstemhm") || m_key == wxS("vstemhm"))
-    {
-      // Increment the NumOfHints by the number couples of of arguments
-      m_numHints += numArgs / 2;
-    }
-          // A call to "mask"
-    else if (m_key == wxS("hintmask") || m_key == wxS("cntrmask"))
-    {
-      // Compute the size of the mask
-      int sizeOfMask = m_numHints / 8;
-      if (m_numHints % 8 != 0 || sizeOfMask == 0)
-      {
-        sizeOfMask++;
-      }
-      // Continue the pointer in SizeOfMask steps
-      int i;
-      for (i = 0; i < sizeOfMask; i++)
-      {
-        ReadByte(stream);
-      }
+        break;
+
+      // A call to "stem"
+      case HSTEM_OP:
+      case VSTEM_OP:
+      case HSTEMHM_OP:
+      case VSTEMHM_OP:
+        // Increment the NumOfHints by the number couples of of arguments
+        m_numHints += numArgs / 2;
+        break;
+
+      // A call to "mask"
+      case HINTMASK_OP:
+      case CNTRMASK_OP:
+        {
+          // Compute the size of the mask
+          int sizeOfMask = m_numHints / 8;
+          if (m_numHints % 8 != 0 || sizeOfMask == 0)
+          {
+            sizeOfMask++;
+          }
+          // Skip the mask bytes
+          pos += sizeOfMask;
+        }
+        break;
+
+      default:
+        break;
     }
   }
 #if 0
@@ -488,34 +486,44 @@ int
 wxPdfCffDecoder::StackOpp()
 {
   int op;
-  if (m_key == wxS("ifelse"))
-  {
-    op = -3;
-  }
-  else if (m_key == wxS("roll") || m_key == wxS("put"))
-  {
-    op = -2;
-  }
-  else if (m_key == wxS("callsubr") || m_key == wxS("callgsubr") || m_key == wxS("add")  ||
-           m_key == wxS("sub")      || m_key == wxS("div")       || m_key == wxS("mul")  ||
-           m_key == wxS("drop")     || m_key == wxS("and")       || m_key == wxS("or")   ||
-           m_key == wxS("eq"))
-  {
-    op = -1;
-  }
-  else if (m_key == wxS("abs")  || m_key == wxS("neg")   || m_key == wxS("sqrt") ||
-           m_key == wxS("exch") || m_key == wxS("index") || m_key == wxS("get")  ||
-           m_key == wxS("not")  || m_key == wxS("return"))
-  {
-    op = 0;
-  }
-  else if (m_key == wxS("random") || m_key == wxS("dup"))
+  switch (m_op)
   {
-    op = 1;
-  }
-  else
-  {
-    op = 2;
+    case IFELSE_OP:
+      op = -3;
+      break;
+    case ROLL_OP:
+    case PUT_OP:
+      op = -2;
+      break;
+    case CALLSUBR_OP:
+    case CALLGSUBR_OP:
+    case ADD_OP:
+    case SUB_OP:
+    case DIV_OP:
+    case MUL_OP:
+    case DROP_OP:
+    case AND_OP:
+    case OR_OP:
+    case EQ_OP:
+      op = -1;
+      break;
+    case ABS_OP:
+    case NEG_OP:
+    case SQRT_OP:
+    case EXCH_OP:
+    case INDEX_OP:
+    case GET_OP:
+    case NOT_OP:
+    case RETURN_OP:
+      op = 0;
+      break;
+    case RANDOM_OP:
+    case DUP_OP:
+      op = 1;
+      break;
+    default:
+      op = 2;
+      break;
   }
   return op;
 }
@@ -538,151 +546,163 @@ wxPdfCffDecoder::PopStack()
 void
 wxPdfCffDecoder::PushStack()
 {
-  m_argCount++;
+  if (m_argCount < gs_maxArgs)
+  {
+    m_argCount++;
+  }
 }
 
 void
-wxPdfCffDecoder::ReadCommand(wxInputStream* stream)
+wxPdfCffDecoder::PushArgument(int value)
 {
-  m_key = wxEmptyString;
-  bool gotKey = false;
-  // Until a key is found
-  while (!gotKey)
+  // Excess arguments of malformed charstrings are dropped
+  if (m_argCount < gs_maxArgs)
+  {
+    m_args[m_argCount].m_type = 0;
+    m_args[m_argCount].m_intValue = value;
+    m_argCount++;
+  }
+}
+
+void
+wxPdfCffDecoder::ReadCommand(const unsigned char* data, int& pos, int end)
+{
+  m_op = NO_OP;
+  // Until a key is found or the end of the charstring is reached
+  while (pos < end)
   {
     // Read the first Char
-    unsigned char b0 = ReadByte(stream);
+    int b0 = data[pos++];
     // decode according to the type1/type2 format
     if (b0 == 28) // the two next bytes represent a short int;
     {
-      int first = ReadByte(stream) & 0xff;
-      int second = ReadByte(stream) & 0xff;
-      m_args[m_argCount].m_type = 0;
-      m_args[m_argCount].m_intValue = first << 8 | second;
-      m_argCount++;
-      continue;
+      int first  = (pos < end) ? data[pos] : 0;
+      int second = (pos + 1 < end) ? data[pos + 1] : 0;
+      pos += 2;
+      PushArgument((short) (first << 8 | second));
     }
-    if (b0 >= 32 && b0 <= 246) // The byte read is the byte;
+    else if (b0 >= 32 && b0 <= 246) // The byte read is the byte;
     {
-      m_args[m_argCount].m_type = 0;
-      m_args[m_argCount].m_intValue = (int) (b0 - 139);
-      m_argCount++;
-      continue;
+      PushArgument(b0 - 139);
     }
-    if (b0 >= 247 && b0 <= 250) // The byte read and the next byte constetute a short int
+    else if (b0 >= 247 && b0 <= 250) // The byte read and the next byte constetute a short int
     {
-      unsigned char b1 = ReadByte(stream);
-      short item = (short) ((b0-247)*256 + b1 + 108);
-      m_args[m_argCount].m_type = 0;
-      m_args[m_argCount].m_intValue = item;
-      m_argCount++;
-      continue;
+      int b1 = (pos < end) ? data[pos] : 0;
+      pos++;
+      PushArgument((short) ((b0-247)*256 + b1 + 108));
     }
-    if (b0 >= 251 && b0 <= 254)// Same as above except negative
+    else if (b0 >= 251 && b0 <= 254)// Same as above except negative
     {
-      unsigned char b1 = ReadByte(stream);
-      short item = (short) (-(b0-251)*256-b1-108);
-      m_args[m_argCount].m_type = 0;
-      m_args[m_argCount].m_intValue = item;
-      m_argCount++;
-      continue;
+      int b1 = (pos < end) ? data[pos] : 0;
+      pos++;
+      PushArgument((short) (-(b0-251)*256-b1-108));
     }
-    if (b0 == 255)// The next for bytes represent a double.
+    else if (b0 == 255)// The next for bytes represent a double.
     {
-      int item = ReadInt(stream);
-      m_args[m_argCount].m_type = 0;
-      m_args[m_argCount].m_intValue = item;
-      m_argCount++;
-      continue;
+      wxUint32 item = 0;
+      int j;
+      for (j = 0; j < 4; ++j, ++pos)
+      {
+        item = (item << 8) | ((pos < end) ? data[pos] : 0);
+      }
+      PushArgument((int) (wxInt32) item);
     }
-    if (b0 <= 31 && b0 != 28) // An operator was found.. Set Key.
+    else // An operator was found.. Set Key.
     {
-      gotKey = true;
       // 12 is an escape command therefor the next byte is a part
       // of this command
-      if (b0 == 12)
+      if (b0 == ESCAPE_OP)
       {
-        unsigned char b1 = ReadByte(stream);
-        if (b1 > gs_subrsEscapeFuncsCount-1)
-        {
-          b1 = gs_subrsEscapeFuncsCount-1;
-        }
-        m_key = gs_subrsEscapeFuncs[b1];
+        int b1 = (pos < end) ? data[pos] : 0;
+        pos++;
+        m_op = (ESCAPE_OP << 8) | b1;
       }
       else
       {
-        m_key = gs_subrsFunctions[b0];
+        m_op = b0;
       }
-      continue;
+      break;
     }
   }
 }
 
+void
+wxPdfCffDecoder::CalcSubrHints(const unsigned char* data, wxPdfCffIndexElement& subr, int globalBias, int localBias, wxPdfCffIndexArray& localSubrIndex)
+{
+  // Subroutines already replaced by a subset stub are not part of the CFF data
+  if (!subr.IsCopy())
+  {
+    int beginSubr = subr.GetOffset();
+    int endSubr = beginSubr + subr.GetLength();
+    CalcHints(data, beginSubr, endSubr, globalBias, localBias, localSubrIndex);
+  }
+}
+
 int
-wxPdfCffDecoder::CalcHints(wxInputStream* stream, int begin, int end, int globalBias, int localBias, wxPdfCffIndexArray& localSubrIndex)
+wxPdfCffDecoder::CalcHints(const unsigned char* data, int begin, int end, int globalBias, int localBias, wxPdfCffIndexArray& localSubrIndex)
 {
-  int beginSubr, endSubr;
   // Goto begining of the subr
-  stream->SeekI(begin);
-  while (stream->TellI() < end)
+  int pos = begin;
+  while (pos < end)
   {
     // Read the next command
-    ReadCommand(stream);
-    int pos = stream->TellI();
-    wxPdfCffFontObject* topElement = NULL;
-    if (m_argCount > 0)
-    {
-      topElement = &m_args[m_argCount-1];
-    }
+    ReadCommand(data, pos, end);
+    int topValue = (m_argCount > 0) ? m_args[m_argCount-1].m_intValue : 0;
     int numArgs = m_argCount;
     //Check the modification needed on the Argument Stack according to key;
     HandleStack();
-    // a call to a Lsubr
-    if (m_key == wxS("callsubr"))
-    {
-      if (numArgs > 0)
-      {
-        int subr = topElement->m_intValue + localBias;
-        wxPdfCffIndexElement& localSubr = localSubrIndex[subr];
-        beginSubr = localSubr.GetOffset();
-        endSubr = beginSubr + localSubr.GetLength();
-        CalcHints(localSubr.GetBuffer(), beginSubr, endSubr, globalBias, localBias, localSubrIndex);
-        stream->SeekI(pos);
-      }
-    }
-    // a call to a Gsubr
-    else if (m_key == wxS("callgsubr"))
-    {
-      if (numArgs > 0)
-      {
-        int subr = topElement->m_intValue + globalBias;
-        wxPdfCffIndexElement& globalSubr = (*m_globalSubrIndex)[subr];
-        beginSubr = globalSubr.GetOffset();
-        endSubr = beginSubr + globalSubr.GetLength();
-        CalcHints(globalSubr.GetBuffer(), beginSubr, endSubr, globalBias, localBias, localSubrIndex);
-        stream->SeekI(pos);
-      }
-    }
-    // A call to "stem"
-    else if (m_key == wxS("hstem") || m_key == wxS("vstem") || m_key == wxS("hstemhm") || m_key == wxS("vstemhm"))
-    {
-      // Increment the NumOfHints by the number couples of of arguments
-      m_numHints += numArgs / 2;
-    }
-    // A call to "mask"
-    else if (m_key == wxS("hintmask") || m_key == wxS("cntrmask"))
+    switch (m_op)
     {
-      // Compute the size of the mask
-      int sizeOfMask = m_numHints / 8;
-      if (m_numHints % 8 != 0 || sizeOfMask == 0)
-      {
-        sizeOfMask++;
-      }
-      // Continue the pointer in SizeOfMask steps
-      int i;
-      for (i = 0; i < sizeOfMask; i++)
-      {
-        ReadByte(stream);
-      }
+      // a call to a Lsubr
+      case CALLSUBR_OP:
+        if (numArgs > 0)
+        {
+          int subr = topValue + localBias;
+          if (subr >= 0 && subr < (int) localSubrIndex.GetCount())
+          {
+            CalcSubrHints(data, localSubrIndex[subr], globalBias, localBias, localSubrIndex);
+          }
+        }
+        break;
+
+      // a call to a Gsubr
+      case CALLGSUBR_OP:
+        if (numArgs > 0)
+        {
+          int subr = topValue + globalBias;
+          if (subr >= 0 && subr < (int) m_globalSubrIndex->GetCount())
+          {
+            CalcSubrHints(data, (*m_globalSubrIndex)[subr], globalBias, localBias, localSubrIndex);
+          }
+        }
+        break;
+
+      // A call to "stem"
+      case HSTEM_OP:
+      case VSTEM_OP:
+      case HSTEMHM_OP:
+      case VSTEMHM_OP:
+        // Increment the NumOfHints by the number couples of of arguments
+        m_numHints += numArgs / 2;
+        break;
+
+      // A call to "mask"
+      case HINTMASK_OP:
+      case CNTRMASK_OP:
+        {
+          // Compute the size of the mask
+          int sizeOfMask = m_numHints / 8;
+          if (m_numHints % 8 != 0 || sizeOfMask == 0)
+          {
+            sizeOfMask++;
+          }
+          // Skip the mask bytes
+          pos += sizeOfMask;
+        }
+        break;
+
+      default:
+        break;
     }
   }
   return m_numHints;
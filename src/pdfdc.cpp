@@ -994,6 +994,7 @@ wxPdfDCImpl::DoDrawBitmap(const wxBitmap& bitmap, wxCoord x, wxCoord y, bool use
   const double xx = ScaleLogicalToPdfX(x);
   const double yy = ScaleLogicalToPdfY(y);
 
+  // Bitmaps drawn repeatedly are embedded only once, since the document identifies images by content
   int imageCount = IncreaseImageCounter();
   wxString imgName = wxString::Format(wxS("pdfdcimg%d"), imageCount);
 
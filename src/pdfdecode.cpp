@@ -27,62 +27,173 @@
 #include "wx/pdfobjects.h"
 #include "wx/pdfparser.h"
 
-// --- Flate Decode method
+// --- Decoding filter stream base class
+
+wxPdfDecodeInputStream::wxPdfDecodeInputStream(wxInputStream* stream)
+  : wxFilterInputStream(stream)
+{
+  m_inBuffer = new unsigned char[WXPDF_DECODE_BUFFER_SIZE];
+  m_inPos  = 0;
+  m_inLen  = 0;
+  m_outPos = 0;
+  m_eod    = false;
+  m_error  = false;
+}
+
+wxPdfDecodeInputStream::~wxPdfDecodeInputStream()
+{
+  delete [] m_inBuffer;
+}
+
+size_t
+wxPdfDecodeInputStream::OnSysRead(void* buffer, size_t size)
+{
+  unsigned char* data = (unsigned char*) buffer;
+  size_t count = 0;
+  while (count < size)
+  {
+    if (m_outPos >= m_outBuffer.GetDataLen())
+    {
+      // Refill the output buffer, keeping its size bounded
+      m_outBuffer.SetDataLen(0);
+      m_outPos = 0;
+      while (!m_eod && m_outBuffer.GetDataLen() < WXPDF_DECODE_BUFFER_SIZE)
+      {
+        m_eod = !DecodeNext();
+      }
+      if (m_outBuffer.GetDataLen() == 0)
+      {
+        break;
+      }
+    }
+    size_t available = m_outBuffer.GetDataLen() - m_outPos;
+    size_t n = (size - count < available) ? size - count : available;
+    memcpy(data + count, (const char*) m_outBuffer.GetData() + m_outPos, n);
+    m_outPos += n;
+    count += n;
+  }
+  if (count == 0)
+  {
+    m_lasterror = (m_error) ? wxSTREAM_READ_ERROR : wxSTREAM_EOF;
+  }
+  return count;
+}
 
-wxMemoryOutputStream*
-wxPdfParser::FlateDecode(wxMemoryOutputStream* osIn)
+int
+wxPdfDecodeInputStream::GetInputChar()
 {
-  wxMemoryInputStream in(*osIn);
-  wxZlibInputStream zin(in);
-  wxMemoryOutputStream* osOut = new wxMemoryOutputStream();;
-  osOut->Write(zin);
-  osOut->Close();
-  return osOut;
+  if (m_inPos >= m_inLen)
+  {
+    m_inPos = 0;
+    m_inLen = 0;
+    if (m_parent_i_stream->Eof())
+    {
+      return -1;
+    }
+    m_parent_i_stream->Read(m_inBuffer, WXPDF_DECODE_BUFFER_SIZE);
+    m_inLen = m_parent_i_stream->LastRead();
+    if (m_inLen == 0)
+    {
+      return -1;
+    }
+  }
+  return m_inBuffer[m_inPos++];
 }
 
+size_t
+wxPdfDecodeInputStream::GetInputBlock(unsigned char* buffer, size_t size)
+{
+  size_t count = 0;
+  while (count < size)
+  {
+    if (m_inPos < m_inLen)
+    {
+      size_t n = (size - count < m_inLen - m_inPos) ? size - count : m_inLen - m_inPos;
+      memcpy(buffer + count, m_inBuffer + m_inPos, n);
+      m_inPos += n;
+      count += n;
+    }
+    else
+    {
+      int ch = GetInputChar();
+      if (ch < 0)
+      {
+        break;
+      }
+      buffer[count++] = (unsigned char) ch;
+    }
+  }
+  return count;
+}
+
+const unsigned char*
+wxPdfDecodeInputStream::PeekInput(size_t& length)
+{
+  if (m_inPos >= m_inLen)
+  {
+    int ch = GetInputChar();
+    if (ch >= 0)
+    {
+      m_inPos--;
+    }
+  }
+  length = m_inLen - m_inPos;
+  return m_inBuffer + m_inPos;
+}
+
+void
+wxPdfDecodeInputStream::SetDecodeError(const wxString& message)
+{
+  wxLogError(message);
+  m_error = true;
+}
+
+// --- Flate Decode method
+
+// The FlateDecode filter is handled by wxZlibInputStream
+
 // --- ASCII Hexadecimal Decode method
 
-wxMemoryOutputStream*
-wxPdfParser::ASCIIHexDecode(wxMemoryOutputStream* osIn)
+wxPdfASCIIHexInputStream::wxPdfASCIIHexInputStream(wxInputStream* stream)
+  : wxPdfDecodeInputStream(stream)
 {
-  wxMemoryInputStream in(*osIn);
-  wxMemoryOutputStream* osOut = new wxMemoryOutputStream();
-  size_t inLength = in.GetSize();
-  size_t k;
-  bool first = true;
-  int n1 = 0;
-  for (k = 0; k < inLength; ++k)
-  {
-    int ch = in.GetC() & 0xff;
-    if (ch == '>')
-      break;
+}
+
+bool
+wxPdfASCIIHexInputStream::DecodeNext()
+{
+  int n1 = -1;
+  while (true)
+  {
+    int ch = GetInputChar();
+    if (ch < 0 || ch == '>')
+    {
+      // A missing last digit is assumed to be zero
+      if (n1 >= 0)
+      {
+        m_outBuffer.AppendByte((char) ((n1 << 4) & 0xff));
+      }
+      return false;
+    }
     if (wxPdfTokenizer::IsWhitespace(ch))
       continue;
     int n = wxPdfTokenizer::GetHex(ch);
     if (n == -1)
     {
-      wxLogError(wxString(wxS("wxPdfParser::ASCIIHexDecode: ")) +
-                 wxString(_("Illegal character.")));
-      osOut->Close();
-      delete osOut;
-      return NULL;
+      SetDecodeError(wxString(wxS("wxPdfASCIIHexInputStream::DecodeNext: ")) +
+                     wxString(_("Illegal character.")));
+      return false;
     }
-    if (first)
+    if (n1 < 0)
     {
       n1 = n;
     }
     else
     {
-      osOut->PutC((char)(((n1 << 4) + n) & 0xff));
+      m_outBuffer.AppendByte((char) (((n1 << 4) + n) & 0xff));
+      return true;
     }
-    first = !first;
   }
-  if (!first)
-  {
-    osOut->PutC((char)((n1 << 4) & 0xff));
-  }
-  osOut->Close();
-  return osOut;
 }
 
 // --- ASCII 85 Decode method
@@ -90,415 +201,520 @@ wxPdfParser::ASCIIHexDecode(wxMemoryOutputStream* osIn)
 //  Test case:
 //  wxMemoryOutputStream ascii85Test("9jqo^BlbD-BleB1DJ+*+F(f,q/0JhKF<GL>Cj@.4Gp$d7F!,L7@<6@)/0JDEF<G%<+EV:2F!,O<DJ+*.@<*K0@<6L(Df-\\\\0Ec5e;DffZ(EZee.Bl.9pF\"AGXBPCsi+DGm>@3BB/F*&OCAfu2/AKYi(DIb:@FD,*)+C]U=@3BN#EcYf8ATD3s@q?d$AftVqCh[NqF<G:8+EV:.+Cf>-FD5W8ARlolDIal(DId<j@<?3r@:F%a+D58'ATD4$Bl@l3De:,-DJs`8ARoFb/0JMK@qB4^F!,R<AKZ&-DfTqBG%G>uD.RTpAKYo'+CT/5+Cei#DII?(E,9)oF*2M7/c         ", 340);
 //  char ascii85_originalText[] = "Man is distinguished, not only by his reason, but by this singular passion from other animals, which is a lust of the mind, that by a perseverance of delight in the continued and indefatigable generation of knowledge, exceeds the short vehemence of any carnal pleasure.";
-//  wxMemoryOutputStream* out = ASCII85Decode(&ascii85Test);
+//  wxPdfASCII85InputStream out(new wxMemoryInputStream(ascii85Test));
 
-wxMemoryOutputStream*
-wxPdfParser::ASCII85Decode(wxMemoryOutputStream* osIn)
+wxPdfASCII85InputStream::wxPdfASCII85InputStream(wxInputStream* stream)
+  : wxPdfDecodeInputStream(stream)
+{
+}
+
+bool
+wxPdfASCII85InputStream::DecodeNext()
 {
-  wxMemoryInputStream in(*osIn);
-  wxMemoryOutputStream* osOut = new wxMemoryOutputStream();
   int state = 0;
   int chn[5];
-  size_t inLength = in.GetSize();
-  size_t k;
-  for (k = 0; k < inLength; k++)
+  int ch;
+  while (true)
   {
-    int ch = in.GetC() & 0xff;
-    if (ch == '~')
+    ch = GetInputChar();
+    if (ch < 0 || ch == '~')
       break;
     if (wxPdfTokenizer::IsWhitespace(ch))
       continue;
     if (ch == 'z' && state == 0)
     {
-      osOut->PutC(0);
-      osOut->PutC(0);
-      osOut->PutC(0);
-      osOut->PutC(0);
-      continue;
+      m_outBuffer.AppendData("\0\0\0\0", 4);
+      return true;
     }
     if (ch < '!' || ch > 'u')
     {
-      wxLogError(wxString(wxS("wxPdfParser::ASCII85Decode: ")) +
-                 wxString(_("Illegal character.")));
-      osOut->Close();
-      delete osOut;
-      return NULL;
+      SetDecodeError(wxString(wxS("wxPdfASCII85InputStream::DecodeNext: ")) +
+                     wxString(_("Illegal character.")));
+      return false;
     }
     chn[state] = ch - '!';
     ++state;
     if (state == 5)
     {
-      state = 0;
       int r = 0;
       for (int j = 0; j < 5; ++j)
       {
         r = r * 85 + chn[j];
       }
-      osOut->PutC((char)((r >> 24) & 0xff));
-      osOut->PutC((char)((r >> 16) & 0xff));
-      osOut->PutC((char)((r >>  8) & 0xff));
-      osOut->PutC((char)( r        & 0xff));
+      m_outBuffer.AppendByte((char)((r >> 24) & 0xff));
+      m_outBuffer.AppendByte((char)((r >> 16) & 0xff));
+      m_outBuffer.AppendByte((char)((r >>  8) & 0xff));
+      m_outBuffer.AppendByte((char)( r        & 0xff));
+      return true;
     }
   }
+
+  // Handle the final partial group
   int r = 0;
   if (state == 1)
   {
-    wxLogError(wxString(wxS("wxPdfParser::ASCII85Decode: ")) +
-               wxString(_("Illegal length.")));
-    osOut->Close();
-    delete osOut;
-    return NULL;
+    SetDecodeError(wxString(wxS("wxPdfASCII85InputStream::DecodeNext: ")) +
+                   wxString(_("Illegal length.")));
+    return false;
   }
   if (state == 2)
   {
     r = chn[0] * 85 * 85 * 85 * 85 + chn[1] * 85 * 85 * 85;
-    osOut->PutC((char)((r >> 24) & 0xff));
+    m_outBuffer.AppendByte((char)((r >> 24) & 0xff));
   }
   else if (state == 3)
   {
     r = chn[0] * 85 * 85 * 85 * 85 + chn[1] * 85 * 85 * 85  + chn[2] * 85 * 85;
-    osOut->PutC((char)((r >> 24) & 0xff));
-    osOut->PutC((char)((r >> 16) & 0xff));
+    m_outBuffer.AppendByte((char)((r >> 24) & 0xff));
+    m_outBuffer.AppendByte((char)((r >> 16) & 0xff));
   }
   else if (state == 4)
   {
     r = chn[0] * 85 * 85 * 85 * 85 + chn[1] * 85 * 85 * 85  + chn[2] * 85 * 85  + chn[3] * 85 ;
-    osOut->PutC((char)((r >> 24) & 0xff));
-    osOut->PutC((char)((r >> 16) & 0xff));
-    osOut->PutC((char)((r >>  8) & 0xff));
+    m_outBuffer.AppendByte((char)((r >> 24) & 0xff));
+    m_outBuffer.AppendByte((char)((r >> 16) & 0xff));
+    m_outBuffer.AppendByte((char)((r >>  8) & 0xff));
   }
-
-  osOut->Close();
-  return osOut;
+  return false;
 }
 
-// --- Predictor Decode method
+// --- Run Length Decode method
 
-wxMemoryOutputStream*
-wxPdfParser::DecodePredictor(wxMemoryOutputStream* osIn, wxPdfObject* dicPar)
+wxPdfRunLengthInputStream::wxPdfRunLengthInputStream(wxInputStream* stream)
+  : wxPdfDecodeInputStream(stream)
 {
-  if (dicPar == NULL || dicPar->GetType() != OBJTYPE_DICTIONARY)
-  {
-    return osIn;
-  }
+}
 
-  wxPdfDictionary* dic = (wxPdfDictionary*) dicPar;
-  wxPdfObject* obj = ResolveObject(dic->Get(wxS("Predictor")));
-  if (obj == NULL || obj->GetType() != OBJTYPE_NUMBER)
+bool
+wxPdfRunLengthInputStream::DecodeNext()
+{
+  int length = GetInputChar();
+  if (length < 0 || length == 128)
   {
-    return osIn;
+    // End of data
+    return false;
   }
-  int predictor = ((wxPdfNumber*)obj)->GetInt();
-  if (predictor < 10)
+  if (length < 128)
   {
-    return osIn;
+    // Copy the next length+1 bytes literally
+    size_t count = length + 1;
+    unsigned char literal[128];
+    size_t n = GetInputBlock(literal, count);
+    m_outBuffer.AppendData(literal, n);
+    return (n == count);
   }
 
-  int width = 1;
-  obj = ResolveObject(dic->Get(wxS("Columns")));
-  if (obj != NULL && obj->GetType() == OBJTYPE_NUMBER)
+  // Repeat the next byte 257-length times
+  int ch = GetInputChar();
+  if (ch < 0)
   {
-    width = ((wxPdfNumber*) obj)->GetInt();
+    return false;
   }
-  int colours = 1;
-  obj = ResolveObject(dic->Get(wxS("Colors")));
-  if (obj != NULL && obj->GetType() == OBJTYPE_NUMBER)
+  size_t count = 257 - length;
+  char* run = (char*) m_outBuffer.GetAppendBuf(count);
+  memset(run, ch, count);
+  m_outBuffer.UngetAppendBuf(count);
+  return true;
+}
+
+// --- Predictor Decode method
+
+wxPdfPredictorInputStream::wxPdfPredictorInputStream(wxInputStream* stream, int colours, int bitsPerComponent, int columns)
+  : wxPdfDecodeInputStream(stream)
+{
+  m_bytesPerPixel = (colours * bitsPerComponent + 7) / 8;
+  m_bytesPerRow = (colours * columns * bitsPerComponent + 7) / 8;
+  if (m_bytesPerRow < 1) m_bytesPerRow = 1;
+  m_curr = new unsigned char[m_bytesPerRow];
+  m_prior = new unsigned char[m_bytesPerRow];
+  memset(m_prior, 0, m_bytesPerRow);
+}
+
+wxPdfPredictorInputStream::~wxPdfPredictorInputStream()
+{
+  delete [] m_curr;
+  delete [] m_prior;
+}
+
+bool
+wxPdfPredictorInputStream::DecodeNext()
+{
+  // Read the filter type byte and a row of data
+  int filter = GetInputChar();
+  if (filter < 0)
   {
-    colours = ((wxPdfNumber*) obj)->GetInt();
+    return false;
   }
-  int bpc = 8;
-  obj = ResolveObject(dic->Get(wxS("BitsPerComponent")));
-  if (obj != NULL && obj->GetType() == OBJTYPE_NUMBER)
+  if (GetInputBlock(m_curr, m_bytesPerRow) != (size_t) m_bytesPerRow)
   {
-    bpc = ((wxPdfNumber*) obj)->GetInt();
+    return false;
   }
 
-  wxMemoryInputStream dataStream(*osIn);
-  wxMemoryOutputStream* osOut = new wxMemoryOutputStream();;
-
-  int bytesPerPixel = colours * bpc / 8;
-  int bytesPerRow = (colours * width * bpc + 7) / 8;
-  char* curr = new char[bytesPerRow];
-  char* prior = new char[bytesPerRow];
-
+  unsigned char* curr = m_curr;
+  unsigned char* prior = m_prior;
+  int bytesPerPixel = m_bytesPerPixel;
+  int bytesPerRow = m_bytesPerRow;
   int i;
-  for (i = 0; i < bytesPerRow; i++)
+  switch (filter)
   {
-    prior[i] = 0;
-  }
-  // Decode the (sub)image row-by-row
-  while (true)
-  {
-    // Read the filter type byte and a row of data
-    int filter = 0;
-    filter = dataStream.GetC();
-    if (dataStream.LastRead() == 0)
-    {
+    case 0: //PNG_FILTER_NONE
       break;
-    }
-    dataStream.Read(curr, bytesPerRow);
-    if (dataStream.LastRead() != (size_t) bytesPerRow)
-    {
+    case 1: //PNG_FILTER_SUB
+      for (i = bytesPerPixel; i < bytesPerRow; i++)
+      {
+        curr[i] += curr[i - bytesPerPixel];
+      }
       break;
-    }
+    case 2: //PNG_FILTER_UP
+      for (i = 0; i < bytesPerRow; i++)
+      {
+        curr[i] += prior[i];
+      }
+      break;
+    case 3: //PNG_FILTER_AVERAGE
+      for (i = 0; i < bytesPerPixel; i++)
+      {
+        curr[i] += prior[i] / 2;
+      }
+      for (i = bytesPerPixel; i < bytesPerRow; i++)
+      {
+        curr[i] += (curr[i - bytesPerPixel] + prior[i]) / 2;
+      }
+      break;
+    case 4: //PNG_FILTER_PAETH
+      for (i = 0; i < bytesPerPixel; i++)
+      {
+        curr[i] += prior[i];
+      }
 
-    switch (filter)
-    {
-      case 0: //PNG_FILTER_NONE
-        break;
-      case 1: //PNG_FILTER_SUB
-        for (i = bytesPerPixel; i < bytesPerRow; i++)
-        {
-          curr[i] += curr[i - bytesPerPixel];
-        }
-        break;
-      case 2: //PNG_FILTER_UP
-        for (i = 0; i < bytesPerRow; i++)
-        {
-          curr[i] += prior[i];
-        }
-        break;
-      case 3: //PNG_FILTER_AVERAGE
-        for (i = 0; i < bytesPerPixel; i++)
-        {
-          curr[i] += prior[i] / 2;
-        }
-        for (i = bytesPerPixel; i < bytesPerRow; i++)
+      for (i = bytesPerPixel; i < bytesPerRow; i++)
+      {
+        int a = curr[i - bytesPerPixel];
+        int b = prior[i];
+        int c = prior[i - bytesPerPixel];
+
+        int p = a + b - c;
+        int pa = (p > a) ? p - a : a - p;
+        int pb = (p > b) ? p - b : b - p;
+        int pc = (p > c) ? p - c : c - p;
+
+        int ret;
+
+        if ((pa <= pb) && (pa <= pc))
         {
-          curr[i] += ((curr[i - bytesPerPixel] & 0xff) + (prior[i] & 0xff))/2;
+          ret = a;
         }
-        break;
-      case 4: //PNG_FILTER_PAETH
-        for (i = 0; i < bytesPerPixel; i++)
+        else if (pb <= pc)
         {
-          curr[i] += prior[i];
+          ret = b;
         }
-
-        for (i = bytesPerPixel; i < bytesPerRow; i++)
+        else
         {
-          int a = curr[i - bytesPerPixel] & 0xff;
-          int b = prior[i] & 0xff;
-          int c = prior[i - bytesPerPixel] & 0xff;
-
-          int p = a + b - c;
-          int pa = (p > a) ? p - a : a - p;
-          int pb = (p > b) ? p - b : b - p;
-          int pc = (p > c) ? p - c : c - p;
-
-          int ret;
-
-          if ((pa <= pb) && (pa <= pc))
-          {
-            ret = a;
-          }
-          else if (pb <= pc)
-          {
-            ret = b;
-          }
-          else
-          {
-            ret = c;
-          }
-          curr[i] += (char)(ret);
+          ret = c;
         }
-        break;
-      default:
-        wxLogError(wxString(wxS("wxPdfParser::DecodePredictor: ")) +
-                   wxString(_("PNG filter unknown.")));
-        // TODO: Should set error flag and abort method
-        break;
-    }
-    osOut->Write(curr, bytesPerRow);
-
-    // Swap curr and prior
-    char* tmp = prior;
-    prior = curr;
-    curr = tmp;
+        curr[i] += (unsigned char) ret;
+      }
+      break;
+    default:
+      SetDecodeError(wxString(wxS("wxPdfPredictorInputStream::DecodeNext: ")) +
+                     wxString(_("PNG filter unknown.")));
+      return false;
   }
-  delete [] curr;
-  delete [] prior;
+  m_outBuffer.AppendData(curr, bytesPerRow);
 
-  return osOut;
+  // Swap curr and prior
+  m_curr = prior;
+  m_prior = curr;
+  return true;
 }
 
 // --- LZW Decode method
 
-wxMemoryOutputStream*
-wxPdfParser::LZWDecode(wxMemoryOutputStream* osIn)
+wxPdfLzwInputStream::wxPdfLzwInputStream(wxInputStream* stream, int earlyChange)
+  : wxPdfDecodeInputStream(stream)
 {
-  wxMemoryInputStream in(*osIn);
-  wxMemoryOutputStream* osOut = new wxMemoryOutputStream();
-  wxPdfLzwDecoder lzw;
-  if (!lzw.Decode(&in, osOut))
+  m_earlyChange = (earlyChange != 0) ? 1 : 0;
+  m_nextData = 0;
+  m_nextBits = 0;
+  m_oldCode  = -1;
+  m_started  = false;
+  InitializeStringTable();
+}
+
+int
+wxPdfLzwInputStream::GetNextCode()
+{
+  // Returns the next 9, 10, 11 or 12 bits
+  while (m_nextBits < m_bitsToGet)
   {
-    delete osOut;
-    osOut = osIn;
+    int ch = GetInputChar();
+    if (ch < 0)
+    {
+      return 257;
+    }
+    m_nextData = ((m_nextData << 8) | ch) & 0xffffff;
+    m_nextBits += 8;
   }
-  return osOut;
+  int code = (m_nextData >> (m_nextBits - m_bitsToGet)) & ((1 << m_bitsToGet) - 1);
+  m_nextBits -= m_bitsToGet;
+  return code;
 }
 
-int wxPdfLzwDecoder::ms_andTable[4] = { 511, 1023, 2047, 4095 };
-
-wxPdfLzwDecoder::wxPdfLzwDecoder()
+void
+wxPdfLzwInputStream::InitializeStringTable()
 {
+  int j;
+  for (j = 0; j < 256; j++)
+  {
+    m_prefix[j] = -1;
+    m_suffix[j] = (unsigned char) j;
+    m_first[j]  = (unsigned char) j;
+    m_length[j] = 1;
+  }
+  m_tableIndex = 258;
   m_bitsToGet = 9;
-  m_nextData  = 0;
-  m_nextBits  = 0;
 }
 
-wxPdfLzwDecoder::~wxPdfLzwDecoder()
+void
+wxPdfLzwInputStream::WriteString(int code)
 {
-  size_t j;
-  for (j = 0; j < WXPDF_LZW_STRINGTABLE_SIZE; j++)
+  // Strings are stored as linked lists of prefix codes, which are written backwards
+  size_t length = m_length[code];
+  char* str = (char*) m_outBuffer.GetAppendBuf(length);
+  size_t j = length;
+  while (j > 0 && code >= 0)
   {
-    m_stringTable[j].Clear();
+    str[--j] = (char) m_suffix[code];
+    code = m_prefix[code];
   }
+  m_outBuffer.UngetAppendBuf(length);
 }
 
-int
-wxPdfLzwDecoder::GetNextCode()
+void
+wxPdfLzwInputStream::AddStringToTable(int oldCode, unsigned char newChar)
 {
-  // Returns the next 9, 10, 11 or 12 bits
-  int ch;
-  int code = 257;
-
-  if ((size_t) m_bytePointer < m_dataSize)
+  if (m_tableIndex < WXPDF_LZW_TABLE_SIZE)
   {
-    ch = m_dataIn->GetC() & 0xff;
-    m_bytePointer++;
-    m_nextData = (m_nextData << 8) | ch;
-    m_nextBits += 8;
-
-    if (m_nextBits < m_bitsToGet)
-    {
-      ch = m_dataIn->GetC() & 0xff;
-      m_bytePointer++;
-      m_nextData = (m_nextData << 8) | ch;
-      m_nextBits += 8;
-    }
-
-    code = (m_nextData >> (m_nextBits - m_bitsToGet)) & ms_andTable[m_bitsToGet-9];
-    m_nextBits -= m_bitsToGet;
+    m_prefix[m_tableIndex] = oldCode;
+    m_suffix[m_tableIndex] = newChar;
+    m_first[m_tableIndex]  = m_first[oldCode];
+    m_length[m_tableIndex] = m_length[oldCode] + 1;
+    m_tableIndex++;
   }
 
-  return code;
+  int tableLimit = m_tableIndex + m_earlyChange;
+  if (tableLimit >= 2048)
+  {
+    m_bitsToGet = 12;
+  }
+  else if (tableLimit >= 1024)
+  {
+    m_bitsToGet = 11;
+  }
+  else if (tableLimit >= 512)
+  {
+    m_bitsToGet = 10;
+  }
 }
 
 bool
-wxPdfLzwDecoder::Decode(wxMemoryInputStream* dataIn, wxMemoryOutputStream* dataOut)
+wxPdfLzwInputStream::DecodeNext()
 {
-  m_dataOut  = dataOut;
-  m_dataIn   = dataIn;
-  m_dataSize = m_dataIn->GetSize();
-  int ch1 = m_dataIn->GetC() & 0xff;
-  int ch2 = m_dataIn->GetC() & 0xff;
-  m_dataIn->SeekI(0);
-  if (ch1 == 0 && ch2 == 1)
-  {
-    wxLogError(wxString(wxS("wxPdfLzwDecoder::Decode: ")) +
-               wxString(_("LZW flavour not supported.")));
-    return false;
+  if (!m_started)
+  {
+    m_started = true;
+    size_t length;
+    const unsigned char* data = PeekInput(length);
+    if (length >= 2 && data[0] == 0 && data[1] == 1)
+    {
+      SetDecodeError(wxString(wxS("wxPdfLzwInputStream::DecodeNext: ")) +
+                     wxString(_("LZW flavour not supported.")));
+      return false;
+    }
   }
 
-  InitializeStringTable();
-
-  // Initialize pointers
-  m_bytePointer = 0;
-  m_bitPointer = 0;
-
-  m_nextData = 0;
-  m_nextBits = 0;
+  int code = GetNextCode();
+  if (code == 257)
+  {
+    return false;
+  }
+  if (code == 256)
+  {
+    InitializeStringTable();
+    m_oldCode = -1;
+    return true;
+  }
+  if (m_oldCode < 0)
+  {
+    if (code >= 256)
+    {
+      SetDecodeError(wxString(wxS("wxPdfLzwInputStream::DecodeNext: ")) +
+                     wxString(_("Invalid LZW code.")));
+      return false;
+    }
+    WriteString(code);
+  }
+  else if (code < m_tableIndex)
+  {
+    WriteString(code);
+    AddStringToTable(m_oldCode, m_first[code]);
+  }
+  else if (code == m_tableIndex)
+  {
+    AddStringToTable(m_oldCode, m_first[m_oldCode]);
+    WriteString(code);
+  }
+  else
+  {
+    SetDecodeError(wxString(wxS("wxPdfLzwInputStream::DecodeNext: ")) +
+                   wxString(_("Invalid LZW code.")));
+    return false;
+  }
+  m_oldCode = code;
+  return true;
+}
 
-  int code;
-  int oldCode = 0;
+// --- Filter chain
 
-  while ((code = GetNextCode()) != 257)
+wxInputStream*
+wxPdfParser::CreateFilterStream(wxInputStream* in, const wxString& filterName, wxPdfObject* decodeParms)
+{
+  wxInputStream* out = NULL;
+  bool usesPredictor = false;
+  if (filterName == wxS("FlateDecode") || filterName == wxS("Fl"))
+  {
+    out = new wxZlibInputStream(in);
+    usesPredictor = true;
+  }
+  else if (filterName == wxS("ASCIIHexDecode") || filterName == wxS("AHx"))
   {
-    if (code == 256)
+    out = new wxPdfASCIIHexInputStream(in);
+  }
+  else if (filterName == wxS("ASCII85Decode") || filterName == wxS("A85"))
+  {
+    out = new wxPdfASCII85InputStream(in);
+  }
+  else if (filterName == wxS("RunLengthDecode") || filterName == wxS("RL"))
+  {
+    out = new wxPdfRunLengthInputStream(in);
+  }
+  else if (filterName == wxS("LZWDecode") || filterName == wxS("LZW"))
+  {
+    int earlyChange = 1;
+    if (decodeParms != NULL && decodeParms->GetType() == OBJTYPE_DICTIONARY)
     {
-      InitializeStringTable();
-      code = GetNextCode();
-
-      if (code == 257)
+      wxPdfObject* obj = ResolveObject(((wxPdfDictionary*) decodeParms)->Get(wxS("EarlyChange")));
+      if (obj != NULL && obj->GetType() == OBJTYPE_NUMBER)
       {
-        break;
+        earlyChange = ((wxPdfNumber*) obj)->GetInt();
       }
-
-      WriteString(code);
-      oldCode = code;
     }
-    else
+    out = new wxPdfLzwInputStream(in, earlyChange);
+    usesPredictor = true;
+  }
+
+  if (out != NULL && usesPredictor && decodeParms != NULL && decodeParms->GetType() == OBJTYPE_DICTIONARY)
+  {
+    // Append a predictor stage, if the decode parameters ask for a PNG predictor
+    wxPdfDictionary* dic = (wxPdfDictionary*) decodeParms;
+    wxPdfObject* obj = ResolveObject(dic->Get(wxS("Predictor")));
+    int predictor = (obj != NULL && obj->GetType() == OBJTYPE_NUMBER) ? ((wxPdfNumber*) obj)->GetInt() : 1;
+    if (predictor >= 10)
     {
-      if (code < m_tableIndex)
+      int width = 1;
+      obj = ResolveObject(dic->Get(wxS("Columns")));
+      if (obj != NULL && obj->GetType() == OBJTYPE_NUMBER)
+      {
+        width = ((wxPdfNumber*) obj)->GetInt();
+      }
+      int colours = 1;
+      obj = ResolveObject(dic->Get(wxS("Colors")));
+      if (obj != NULL && obj->GetType() == OBJTYPE_NUMBER)
       {
-        WriteString(code);
-        AddStringToTable(oldCode, m_stringTable[code][0]);
-        oldCode = code;
+        colours = ((wxPdfNumber*) obj)->GetInt();
       }
-      else
+      int bpc = 8;
+      obj = ResolveObject(dic->Get(wxS("BitsPerComponent")));
+      if (obj != NULL && obj->GetType() == OBJTYPE_NUMBER)
       {
-        int index = m_tableIndex;
-        AddStringToTable(oldCode, m_stringTable[oldCode][0]);
-        WriteString(index);
-        oldCode = code;
+        bpc = ((wxPdfNumber*) obj)->GetInt();
       }
+      out = new wxPdfPredictorInputStream(out, colours, bpc, width);
     }
   }
-  return true;
+  return out;
 }
 
-void
-wxPdfLzwDecoder::InitializeStringTable()
+wxInputStream*
+wxPdfParser::GetDecodedStream(wxPdfStream* stream)
 {
-  unsigned int j;
-  for (j = 0; j < WXPDF_LZW_STRINGTABLE_SIZE; j++)
+  wxMemoryOutputStream* osIn = stream->GetBuffer();
+  wxPdfObject* filter = ResolveObject(stream->Get(wxS("Filter")));
+  if (osIn == NULL || filter == NULL)
   {
-    m_stringTable[j].Empty();
+    return NULL;
   }
 
-  for (j = 0; j < 256; j++)
+  size_t j;
+  wxArrayPtrVoid filters;
+  int type = filter->GetType();
+  if (type == OBJTYPE_NAME)
   {
-    m_stringTable[j].Add(j);
+    filters.Add(filter);
   }
-
-  m_tableIndex = 258;
-  m_bitsToGet = 9;
-}
-
-void
-wxPdfLzwDecoder::WriteString(int code)
-{
-  size_t length = m_stringTable[code].GetCount();
-  size_t j;
-  for (j = 0; j < length; j++)
+  else if (type == OBJTYPE_ARRAY)
   {
-    m_dataOut->PutC((char) m_stringTable[code][j]);
+    wxPdfArray* filterArray = (wxPdfArray*) filter;
+    size_t size = filterArray->GetSize();
+    for (j = 0; j < size; j++)
+    {
+      filters.Add(filterArray->Get(j));
+    }
   }
-}
-
-void
-wxPdfLzwDecoder::AddStringToTable(int oldCode, char newString)
-{
-  size_t j;
-  size_t length = m_stringTable[oldCode].GetCount();
-  m_stringTable[m_tableIndex].Empty();
-  for (j = 0; j < length; j++)
+  if (filters.IsEmpty())
   {
-    m_stringTable[m_tableIndex].Add(m_stringTable[oldCode][j]);
+    return NULL;
   }
-  m_stringTable[m_tableIndex].Add(newString);
-  m_tableIndex++;
 
-  if (m_tableIndex == 511)
+  // Read decode parameters if available
+  wxArrayPtrVoid dp;
+  wxPdfObject* dpo = ResolveObject(stream->Get(wxS("DecodeParms")));
+  if (dpo == NULL || (dpo->GetType() != OBJTYPE_DICTIONARY && dpo->GetType() != OBJTYPE_ARRAY))
   {
-    m_bitsToGet = 10;
+    dpo = ResolveObject(stream->Get(wxS("DP")));
   }
-  else if (m_tableIndex == 1023)
+  if (dpo != NULL)
   {
-    m_bitsToGet = 11;
+    if (dpo->GetType() == OBJTYPE_DICTIONARY)
+    {
+      dp.Add(dpo);
+    }
+    else if (dpo->GetType() == OBJTYPE_ARRAY)
+    {
+      wxPdfArray* dpArray = (wxPdfArray*) dpo;
+      size_t size = dpArray->GetSize();
+      for (j = 0; j < size; j++)
+      {
+        dp.Add(dpArray->Get(j));
+      }
+    }
   }
-  else if (m_tableIndex == 2047)
+
+  // Chain the filter streams, reading the encoded data in place
+  wxStreamBuffer* buffer = osIn->GetOutputStreamBuffer();
+  wxInputStream* in = new wxMemoryInputStream(buffer->GetBufferStart(), (size_t) osIn->GetLength());
+  for (j = 0; j < filters.GetCount(); j++)
   {
-    m_bitsToGet = 12;
+    wxPdfName* name = (wxPdfName*) filters[j];
+    wxPdfObject* dicParam = (j < dp.GetCount()) ? (wxPdfObject*) dp[j] : NULL;
+    wxInputStream* out = CreateFilterStream(in, name->GetName(), dicParam);
+    if (out == NULL)
+    {
+      wxLogError(wxString(wxS("wxPdfParser::GetDecodedStream: ")) +
+                 wxString::Format(_("Filter '%s' not supported."), name->GetName().c_str()));
+      break;
+    }
+    in = out;
   }
+  return in;
 }
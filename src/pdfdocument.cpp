@@ -33,8 +33,10 @@
 
 #include "wx/pdfbookmark.h"
 #include "wx/pdfdocument.h"
+#include "wx/pdfencrypt.h"
 #include "wx/pdffont.h"
 #include "wx/pdffontdetails.h"
+#include "wx/pdffontextended.h"
 #include "wx/pdffontmanager.h"
 #include "wx/pdfform.h"
 #include "wx/pdfgradient.h"
@@ -156,7 +158,12 @@ wxPdfDocument::Initialize(int orientation)
 
   m_state            = 0;
   m_fonts            = new wxPdfFontHashMap();
+  m_fallbackFonts    = new wxPdfFontArray();
   m_images           = new wxPdfImageHashMap();
+  m_imageAliases     = new wxPdfImageHashMap();
+  m_imageDigests     = new wxPdfImageHashMap();
+  m_imageDuplicates  = 0;
+  m_imageDataError   = false;
   m_pageLinks        = new wxPdfPageLinksMap();
   m_links            = new wxPdfLinkHashMap();
   m_namedLinks       = new wxPdfNamedLinksMap();
@@ -261,6 +268,11 @@ wxPdfDocument::Initialize(int orientation)
 
   // Enable compression
   SetCompression(true);
+  SetImagePredictor(true);
+  SetImageDepthReduction(false);
+  SetImageResampling(0);
+  SetAsyncImagePreparation(false);
+  m_imageBytesSaved = 0;
 
   // Set default PDF version number
   m_PDFVersion = wxS("1.3");
@@ -296,6 +308,7 @@ wxPdfDocument::~wxPdfDocument()
     }
   }
   delete m_fonts;
+  delete m_fallbackFonts;
 
   wxPdfImageHashMap::iterator image = m_images->begin();
   for (image = m_images->begin(); image != m_images->end(); image++)
@@ -306,6 +319,8 @@ wxPdfDocument::~wxPdfDocument()
     }
   }
   delete m_images;
+  delete m_imageAliases;
+  delete m_imageDigests;
 
   wxPdfPageHashMap::iterator page = m_pages->begin();
   for (page = m_pages->begin(); page != m_pages->end(); page++)
@@ -1001,9 +1016,35 @@ wxPdfDocument::DoGetStringWidth(const wxString& s, double charSpacing)
 void
 wxPdfDocument::Text(double x, double y, const wxString& txt)
 {
-  // Output a string
+  // Visual ordering is applied to the whole string before splitting it into font runs
   wxString voText = ApplyVisualOrdering(txt);
+  wxArrayString runs;
+  wxArrayInt fontIndices;
+  size_t nRuns = SplitTextByFont(voText, runs, fontIndices);
+  if (nRuns > 1 || (nRuns == 1 && fontIndices[0] != 0))
+  {
+    wxPdfFont baseFont = m_currentFont->GetUserFont();
+    int baseStyle = m_fontStyle | m_decoration;
+    double size = m_fontSizePt;
+    size_t j;
+    for (j = 0; j < nRuns; ++j)
+    {
+      SelectRunFont(fontIndices[j], baseFont, baseStyle, size);
+      DoText(x, y, runs[j]);
+      x += DoGetStringWidth(runs[j], m_charSpacing);
+    }
+    SelectRunFont(0, baseFont, baseStyle, size);
+  }
+  else
+  {
+    DoText(x, y, voText);
+  }
+}
 
+void
+wxPdfDocument::DoText(double x, double y, const wxString& voText)
+{
+  // Output a string
   if (m_colourFlag)
   {
     Out("q ", false);
@@ -1531,10 +1572,229 @@ wxPdfDocument::Write(double h, const wxString& txt, const wxPdfLink& link)
 void
 wxPdfDocument::WriteCell(double h, const wxString& txt, int border, int fill, const wxPdfLink& link)
 {
-  // Output text in flowing mode
+  // Visual ordering is applied to the whole string before splitting it into font runs
   wxString s = ApplyVisualOrdering(txt);
-
   s.Replace(wxS("\r"),wxS("")); // remove carriage returns
+
+  wxArrayString runs;
+  wxArrayInt fontIndices;
+  size_t nRuns = SplitTextByFont(s, runs, fontIndices);
+  if (nRuns > 1 || (nRuns == 1 && fontIndices[0] != 0))
+  {
+    // Assign the font of its run to each character, so that lines are wrapped
+    // on whole words across font runs
+    wxArrayInt charFonts;
+    size_t j;
+    for (j = 0; j < nRuns; ++j)
+    {
+      charFonts.Add(fontIndices[j], runs[j].Length());
+    }
+    DoWriteCell(h, s, charFonts, m_currentFont->GetUserFont(), m_fontStyle | m_decoration, border, fill, link);
+  }
+  else
+  {
+    DoWriteCell(h, s, wxArrayInt(), wxPdfFont(), m_fontStyle | m_decoration, border, fill, link);
+  }
+}
+
+void
+wxPdfDocument::SetFallbackFonts(const wxPdfFontArray& fonts)
+{
+  *m_fallbackFonts = fonts;
+}
+
+size_t
+wxPdfDocument::SplitTextByFont(const wxString& txt, wxArrayString& runs, wxArrayInt& fontIndices)
+{
+  runs.Empty();
+  fontIndices.Empty();
+  if (m_currentFont == NULL || txt.IsEmpty())
+  {
+    return 0;
+  }
+  if (m_fallbackFonts->IsEmpty())
+  {
+    runs.Add(txt);
+    fontIndices.Add(0);
+    return 1;
+  }
+
+  // Coverage sets of the current font and the fallback fonts
+  int nFonts = (int) m_fallbackFonts->GetCount() + 1;
+  wxArrayPtrVoid coverage;
+  coverage.Add((void*) m_currentFont->GetUserFont().GetCoverage());
+  size_t k;
+  for (k = 0; k < m_fallbackFonts->GetCount(); ++k)
+  {
+    coverage.Add((void*) (*m_fallbackFonts)[k].GetCoverage());
+  }
+
+  wxString run;
+  int runFont = -1;
+  wxString::const_iterator ch = txt.begin();
+  while (ch != txt.end())
+  {
+    wxString chars(*ch);
+    wxUint32 cc = (wxUint32) *ch;
+    ++ch;
+    // Keep surrogate pairs together
+    if (cc >= 0xd800 && cc <= 0xdbff && ch != txt.end() &&
+        (wxUint32) *ch >= 0xdc00 && (wxUint32) *ch <= 0xdfff)
+    {
+      cc = 0x10000 + ((cc - 0xd800) << 10) + ((wxUint32) *ch - 0xdc00);
+      chars.Append(*ch);
+      ++ch;
+    }
+    // Stay with the font of the current run as long as it covers the characters
+    const wxPdfGlyphSet* runCoverage = (runFont >= 0) ? (const wxPdfGlyphSet*) coverage[runFont] : NULL;
+    int charFont = runFont;
+    if (runCoverage == NULL || !runCoverage->Contains(cc))
+    {
+      int j;
+      for (j = 0; j < nFonts; ++j)
+      {
+        const wxPdfGlyphSet* fontCoverage = (const wxPdfGlyphSet*) coverage[j];
+        if (fontCoverage != NULL && fontCoverage->Contains(cc))
+        {
+          charFont = j;
+          break;
+        }
+      }
+      if (charFont < 0)
+      {
+        charFont = 0;
+      }
+    }
+    if (charFont != runFont)
+    {
+      if (!run.IsEmpty())
+      {
+        runs.Add(run);
+        fontIndices.Add(runFont);
+        run.Empty();
+      }
+      runFont = charFont;
+    }
+    run += chars;
+  }
+  if (!run.IsEmpty())
+  {
+    runs.Add(run);
+    fontIndices.Add(runFont);
+  }
+  return runs.GetCount();
+}
+
+void
+wxPdfDocument::SelectRunFont(int fontIndex, const wxPdfFont& baseFont, int baseStyle, double size)
+{
+  if (fontIndex > 0 && fontIndex <= (int) m_fallbackFonts->GetCount())
+  {
+    const wxPdfFont& font = (*m_fallbackFonts)[fontIndex-1];
+    SelectFont(font, font.GetStyle() | (baseStyle & wxPDF_FONTSTYLE_DECORATION_MASK), size);
+  }
+  else
+  {
+    SelectFont(baseFont, baseStyle, size);
+  }
+}
+
+double
+wxPdfDocument::GetRunsWidth(const wxString& s, const wxArrayInt& charFonts, int first, int last)
+{
+  if (charFonts.IsEmpty())
+  {
+    return DoGetStringWidth(s.SubString(first, last), m_charSpacing);
+  }
+  double width = 0;
+  int j = first;
+  while (j <= last)
+  {
+    int fontIndex = charFonts[j];
+    int k = j;
+    while (k < last && charFonts[k+1] == fontIndex)
+    {
+      ++k;
+    }
+    wxString piece = s.SubString(j, k);
+    if (fontIndex > 0 && fontIndex <= (int) m_fallbackFonts->GetCount())
+    {
+      // Measure without selecting the fallback font
+      wxPdfFontExtended font((*m_fallbackFonts)[fontIndex-1]);
+      width += font.GetStringWidth(piece, m_kerning, m_charSpacing / m_fontSize) * m_fontSize;
+    }
+    else
+    {
+      width += DoGetStringWidth(piece, m_charSpacing);
+    }
+    j = k + 1;
+  }
+  return width;
+}
+
+void
+wxPdfDocument::DoRunsCell(double w, double h, const wxString& s, const wxArrayInt& charFonts,
+                          int first, int last, const wxPdfFont& baseFont, int baseStyle,
+                          int border, int ln, int fill, const wxPdfLink& link)
+{
+  if (charFonts.IsEmpty() || last < first)
+  {
+    DoCell(w, h, s.SubString(first, last), border, ln, wxPDF_ALIGN_LEFT, fill, link);
+    return;
+  }
+
+  // Output the line piece by piece, each piece with the font of its run
+  double x = m_x;
+  double size = m_fontSizePt;
+  double remaining = w;
+  int j = first;
+  while (j <= last)
+  {
+    int fontIndex = charFonts[j];
+    int k = j;
+    while (k < last && charFonts[k+1] == fontIndex)
+    {
+      ++k;
+    }
+    int pieceBorder = border;
+    if (j > first)
+    {
+      pieceBorder &= ~wxPDF_BORDER_LEFT;
+    }
+    if (k < last)
+    {
+      pieceBorder &= ~wxPDF_BORDER_RIGHT;
+    }
+    // The last piece takes the remaining width of the cell
+    double pieceWidth = (k < last) ? GetRunsWidth(s, charFonts, j, k) : remaining;
+    SelectRunFont(fontIndex, baseFont, baseStyle, size);
+    DoCell(pieceWidth, h, s.SubString(j, k), pieceBorder, 0, wxPDF_ALIGN_LEFT, fill, link);
+    remaining -= pieceWidth;
+    j = k + 1;
+  }
+  SelectRunFont(0, baseFont, baseStyle, size);
+
+  if (ln > 0)
+  {
+    // Go to the next line
+    if (m_yAxisOriginTop)
+    {
+      m_y += h;
+    }
+    else
+    {
+      m_y -= h;
+    }
+    m_x = (ln == 1) ? m_lMargin : x;
+  }
+}
+
+void
+wxPdfDocument::DoWriteCell(double h, const wxString& s, const wxArrayInt& charFonts,
+                           const wxPdfFont& baseFont, int baseStyle,
+                           int border, int fill, const wxPdfLink& link)
+{
+  // Output text in flowing mode
   int nb = (int) s.Length();
 
   // handle single space character
@@ -1563,7 +1823,7 @@ wxPdfDocument::WriteCell(double h, const wxString& txt, int border, int fill, co
     if (c == wxS('\n'))
     {
       // Explicit line break
-      DoCell(w, h, s.SubString(j,i-1), border, 2, wxPDF_ALIGN_LEFT, fill, link);
+      DoRunsCell(w, h, s, charFonts, j, i-1, baseFont, baseStyle, border, 2, fill, link);
       i++;
       sep = -1;
       j = i;
@@ -1581,7 +1841,7 @@ wxPdfDocument::WriteCell(double h, const wxString& txt, int border, int fill, co
     {
       sep = i;
     }
-    len = DoGetStringWidth(s.SubString(j, i), m_charSpacing);
+    len = GetRunsWidth(s, charFonts, j, i);
     if (len > wmax)
     {
       // Automatic line break
@@ -1609,11 +1869,11 @@ wxPdfDocument::WriteCell(double h, const wxString& txt, int border, int fill, co
         {
           i++;
         }
-        DoCell(w, h,s.SubString(j, i-1), border, 2, wxPDF_ALIGN_LEFT, fill, link);
+        DoRunsCell(w, h, s, charFonts, j, i-1, baseFont, baseStyle, border, 2, fill, link);
       }
       else
       {
-        DoCell(w, h, s.SubString(j, sep-1), border, 2, wxPDF_ALIGN_LEFT, fill, link);
+        DoRunsCell(w, h, s, charFonts, j, sep-1, baseFont, baseStyle, border, 2, fill, link);
         i = sep + 1;
       }
       sep = -1;
@@ -1635,7 +1895,7 @@ wxPdfDocument::WriteCell(double h, const wxString& txt, int border, int fill, co
   // Last chunk
   if (i != j)
   {
-    DoCell(len, h, s.SubString(j,i-1), border, 0, wxPDF_ALIGN_LEFT, fill, link);
+    DoRunsCell(len, h, s, charFonts, j, i-1, baseFont, baseStyle, border, 0, fill, link);
   }
 
   // Following statement was in PHP code, but seems to be in error.
@@ -1710,6 +1970,79 @@ wxPdfDocument::WriteGlyphArray(wxPdfArrayDouble& x, wxPdfArrayDouble& y, wxPdfAr
   return ok;
 }
 
+bool
+wxPdfDocument::WriteGlyphRun(size_t count, const wxUint32* glyphs, const double* advances, const double* offsets)
+{
+  bool ok = m_currentFont != NULL;
+#if wxUSE_UNICODE
+  if (ok)
+  {
+    // Check whether the current font is valid for this method
+    wxString fontType = m_currentFont->GetType();
+    if (fontType.IsSameAs(wxS("TrueTypeUnicode")) || fontType.IsSameAs(wxS("OpenTypeUnicode")))
+    {
+      if (count > 0)
+      {
+        // Convert all glyphs at once, updating the list of used glyphs in bulk
+        if (m_glyphRunCids.GetCount() < count)
+        {
+          m_glyphRunCids.SetCount(count);
+        }
+        wxUint32* cids = &m_glyphRunCids[0];
+        ok = m_currentFont->ConvertGlyphs(glyphs, count, cids);
+
+        if (m_yAxisOriginTop)
+        {
+          Out("BT 1 0 0 -1 ", false);
+        }
+        else
+        {
+          Out("BT ", false);
+        }
+        OutAscii(wxPdfUtility::Double2String(m_x*m_k,2), false);
+        Out(" ", false);
+        OutAscii(wxPdfUtility::Double2String(m_y*m_k,2), false);
+        if (m_yAxisOriginTop)
+        {
+          Out(" Tm ", false);
+        }
+        else
+        {
+          Out(" Td ", false);
+        }
+        m_x += ShowGlyphRun(count, glyphs, cids, advances, offsets);
+        Out(" ET");
+        if (!ok)
+        {
+          wxLogError(wxString(wxS("wxPdfDocument::WriteGlyphRun: ")) +
+                     wxString::Format(_("Glyphs not available in font '%s' were replaced by glyph 0."),
+                                      m_currentFont->GetOriginalName().c_str()));
+        }
+      }
+    }
+    else
+    {
+      ok = false;
+      wxLogError(wxString(wxS("wxPdfDocument::WriteGlyphRun: ")) +
+                 wxString::Format(_("Font type '%s' not supported."), fontType.c_str()));
+    }
+  }
+  else
+  {
+    wxLogError(wxString(wxS("wxPdfDocument::WriteGlyphRun: ")) +
+               wxString(_("No font selected.")));
+  }
+#else
+  wxUnusedVar(count);
+  wxUnusedVar(glyphs);
+  wxUnusedVar(advances);
+  wxUnusedVar(offsets);
+  wxLogError(wxString(wxS("wxPdfDocument::WriteGlyphRun: ")) +
+             wxString(_("Supported in Unicode build only.")));
+#endif // wxUSE_UNICODE
+  return ok;
+}
+
 wxSize
 wxPdfDocument::GetImageSize(const wxString& fileName, const wxString& mimeType)
 {
@@ -1751,14 +2084,98 @@ wxPdfDocument::GetImageSize(const wxString& fileName, const wxString& mimeType)
   return imageSize;
 }
 
+static wxString
+GetDataDigest(const unsigned char* data, size_t length)
+{
+  unsigned char md5[16];
+  wxPdfEncrypt::GetMD5Binary(data, (unsigned int) length, md5);
+  wxString digest;
+  int j;
+  for (j = 0; j < 16; ++j)
+  {
+    digest += wxString::Format(wxS("%02x"), md5[j]);
+  }
+  return digest;
+}
+
+static wxString
+GetImageDigest(const wxImage& image, int maskImage, bool jpegFormat, int jpegQuality)
+{
+  size_t pixels = (size_t) image.GetWidth() * (size_t) image.GetHeight();
+  wxString digest = wxString::Format(wxS("image:%dx%d:%d:"), image.GetWidth(), image.GetHeight(), maskImage);
+  if (jpegFormat)
+  {
+    digest += wxString::Format(wxS("jpeg%d:"), jpegQuality);
+  }
+  digest += GetDataDigest(image.GetData(), 3 * pixels);
+  if (image.HasAlpha())
+  {
+    digest += wxString(wxS(":alpha:")) + GetDataDigest(image.GetAlpha(), pixels);
+  }
+  else if (image.HasMask())
+  {
+    digest += wxString::Format(wxS(":mask:%d,%d,%d"), image.GetMaskRed(), image.GetMaskGreen(), image.GetMaskBlue());
+  }
+  return digest;
+}
+
+static wxString
+GetImageMaskDigest(const wxImage& image)
+{
+  size_t pixels = (size_t) image.GetWidth() * (size_t) image.GetHeight();
+  wxString digest = wxString::Format(wxS("imagemask:%dx%d:"), image.GetWidth(), image.GetHeight());
+  if (image.HasAlpha())
+  {
+    digest += wxString(wxS("alpha:")) + GetDataDigest(image.GetAlpha(), pixels);
+  }
+  else
+  {
+    digest += GetDataDigest(image.GetData(), 3 * pixels);
+  }
+  return digest;
+}
+
+static wxString
+GetImageDigest(wxPdfImage* image, int maskImage, bool isMask)
+{
+  // Images used as image masks are distinguished from regular images
+  wxString digest = wxString::Format(wxS("%s:%dx%d+%d+%d:%d:%d:%d:"), (isMask) ? wxS("pdfmask") : wxS("pdf"),
+                                     image->GetWidth(), image->GetHeight(), image->GetX(), image->GetY(),
+                                     image->GetBitsPerComponent(), maskImage, (image->IsFormObject()) ? 1 : 0);
+  digest += image->GetColourSpace() + wxS(":") + image->GetF() + wxS(":") + image->GetParms() + wxS(":");
+  if (image->HasAlphaChannel())
+  {
+    digest += wxString(wxS("alpha:")) + GetDataDigest(image->GetAlphaChannel(), image->GetAlphaChannelSize()) + wxS(":");
+  }
+  if (image->IsDataDeferred())
+  {
+    // The image data are not loaded, their digest was calculated on parsing
+    digest += wxString::Format(wxS("%u:"), image->GetDataSize()) + image->GetDataDigest();
+  }
+  else
+  {
+    digest += GetDataDigest((const unsigned char*) image->GetData(), image->GetDataSize());
+  }
+  if (image->GetPaletteSize() > 0)
+  {
+    digest += wxString(wxS(":palette:")) + GetDataDigest((const unsigned char*) image->GetPalette(), image->GetPaletteSize());
+  }
+  if (image->GetTransparencySize() > 0)
+  {
+    digest += wxString(wxS(":trns:")) + GetDataDigest((const unsigned char*) image->GetTransparency(), image->GetTransparencySize());
+  }
+  return digest;
+}
+
 bool
 wxPdfDocument::Image(const wxString& file, double x, double y, double w, double h,
                      const wxString& type, const wxPdfLink& link, int maskImage)
 {
   wxPdfImage* currentImage = NULL;
   // Put an image on the page
-  wxPdfImageHashMap::iterator image = (*m_images).find(file);
-  if (image == (*m_images).end())
+  wxString imageName;
+  currentImage = FindImage(file, maskImage, imageName);
+  if (currentImage == NULL)
   {
     // First use of image, get info
     int i = (int) (*m_images).size() + 1;
@@ -1780,18 +2197,10 @@ wxPdfDocument::Image(const wxString& file, double x, double y, double w, double
       }
       return isValid;
     }
-    if (maskImage > 0)
+    currentImage = AddParsedImage(imageName, currentImage, maskImage);
+    if (currentImage == NULL)
     {
-      currentImage->SetMaskImage(maskImage);
-    }
-    (*m_images)[file] = currentImage;
-  }
-  else
-  {
-    currentImage = image->second;
-    if (maskImage > 0 && currentImage->GetMaskImage() != maskImage)
-    {
-      currentImage->SetMaskImage(maskImage);
+      return false;
     }
   }
   OutImage(currentImage, x, y, w, h, link);
@@ -1803,19 +2212,114 @@ wxPdfDocument::Image(const wxString& name, const wxImage& img, double x, double
                      const wxPdfLink& link, int maskImage, bool jpegFormat, int jpegQuality)
 {
   bool isValid = false;
-  if (img.Ok())
+  wxString digest;
+  if (img.Ok() && !jpegFormat)
+  {
+    wxPdfImage* currentImage = NULL;
+    // Put an image on the page
+    wxString imageName;
+    currentImage = FindImage(name, maskImage, imageName);
+    if (currentImage == NULL)
+    {
+      // Look for an image with identical content
+      digest = GetImageDigest(img, maskImage, jpegFormat, jpegQuality);
+      currentImage = FindImageByDigest(imageName, digest);
+    }
+    if (currentImage == NULL)
+    {
+      // The pixel data are compressed directly. If the image has an alpha channel,
+      // the soft mask is created from it in parallel to the colour image.
+      wxString maskName = imageName + wxString(wxS(".mask"));
+      bool createAlphaMask = false;
+      if (img.HasAlpha())
+      {
+        if (maskImage <= 0)
+        {
+          wxPdfImageHashMap::iterator mask = (*m_images).find(maskName);
+          if (mask != (*m_images).end())
+          {
+            maskImage = mask->second->GetIndex();
+          }
+          else
+          {
+            createAlphaMask = true;
+          }
+        }
+      }
+      else if (img.HasMask() && maskImage <= 0)
+      {
+        // Extract the mask
+        wxImage mask = img.ConvertToMono(img.GetMaskRed(), img.GetMaskGreen(), img.GetMaskBlue());
+        // Invert the mask
+        mask = mask.ConvertToMono(0, 0, 0);
+        maskImage = ImageMask(maskName, mask);
+      }
+
+      int maskIndex = (createAlphaMask) ? (int) (*m_images).size() + 1 : 0;
+      int i = (int) (*m_images).size() + ((createAlphaMask) ? 2 : 1);
+      wxPdfImage* alphaImage = NULL;
+      wxPdfUtility::RunParallel((createAlphaMask) ? 2 : 1,
+                                [&](size_t task)
+                                {
+                                  if (task == 0)
+                                  {
+                                    currentImage = new wxPdfImage(this, i, imageName, img, false, m_asyncImagePreparation);
+                                  }
+                                  else
+                                  {
+                                    alphaImage = new wxPdfImage(this, maskIndex, maskName, img.GetAlpha(), img.GetWidth(), img.GetHeight(),
+                                                                8, m_asyncImagePreparation);
+                                  }
+                                });
+      if (alphaImage != NULL)
+      {
+        if (!alphaImage->Parse())
+        {
+          delete alphaImage;
+          delete currentImage;
+          return false;
+        }
+        (*m_images)[maskName] = alphaImage;
+        maskImage = maskIndex;
+        if (m_PDFVersion < wxS("1.4"))
+        {
+          m_PDFVersion = wxS("1.4");
+        }
+      }
+      if (!currentImage->Parse())
+      {
+        delete currentImage;
+        return false;
+      }
+      if (maskImage > 0)
+      {
+        currentImage->SetMaskImage(maskImage);
+      }
+      RegisterImage(imageName, currentImage, digest);
+    }
+    OutImage(currentImage, x, y, w, h, link);
+    isValid = true;
+  }
+  else if (img.Ok())
   {
     wxImage tempImage = img.Copy();
     wxPdfImage* currentImage = NULL;
     // Put an image on the page
-    wxPdfImageHashMap::iterator image = (*m_images).find(name);
-    if (image == (*m_images).end())
+    wxString imageName;
+    currentImage = FindImage(name, maskImage, imageName);
+    if (currentImage == NULL)
+    {
+      // Look for an image with identical content
+      digest = GetImageDigest(img, maskImage, jpegFormat, jpegQuality);
+      currentImage = FindImageByDigest(imageName, digest);
+    }
+    if (currentImage == NULL)
     {
       if (tempImage.HasAlpha())
       {
         if (maskImage <= 0)
         {
-          maskImage = ImageMask(name+wxString(wxS(".mask")), tempImage);
+          maskImage = ImageMask(imageName+wxString(wxS(".mask")), tempImage);
         }
         if(!tempImage.ConvertAlphaToMask(0))
         {
@@ -1828,7 +2332,7 @@ wxPdfDocument::Image(const wxString& name, const wxImage& img, double x, double
         wxImage mask = tempImage.ConvertToMono(tempImage.GetMaskRed(), tempImage.GetMaskGreen(), tempImage.GetMaskBlue());
         // Invert the mask
         mask = mask.ConvertToMono(0, 0, 0);
-        maskImage = ImageMask(name+wxString(wxS(".mask")), mask);
+        maskImage = ImageMask(imageName+wxString(wxS(".mask")), mask);
       }
       // First use of image, get info
       tempImage.SetMask(false);
@@ -1837,7 +2341,7 @@ wxPdfDocument::Image(const wxString& name, const wxImage& img, double x, double
         tempImage.SetOption(wxIMAGE_OPTION_QUALITY, jpegQuality);
       }
       int i = (int) (*m_images).size() + 1;
-      currentImage = new wxPdfImage(this, i, name, tempImage, jpegFormat);
+      currentImage = new wxPdfImage(this, i, imageName, tempImage, jpegFormat, m_asyncImagePreparation);
       if (!currentImage->Parse())
       {
         delete currentImage;
@@ -1847,15 +2351,7 @@ wxPdfDocument::Image(const wxString& name, const wxImage& img, double x, double
       {
         currentImage->SetMaskImage(maskImage);
       }
-      (*m_images)[name] = currentImage;
-    }
-    else
-    {
-      currentImage = image->second;
-      if (maskImage > 0 && currentImage->GetMaskImage() != maskImage)
-      {
-        currentImage->SetMaskImage(maskImage);
-      }
+      RegisterImage(imageName, currentImage, digest);
     }
     OutImage(currentImage, x, y, w, h, link);
     isValid = true;
@@ -1872,12 +2368,13 @@ wxPdfDocument::Image(const wxString& name, wxInputStream& stream,
   bool isValid = false;
   wxPdfImage* currentImage = NULL;
   // Put an image on the page
-  wxPdfImageHashMap::iterator image = (*m_images).find(name);
-  if (image == (*m_images).end())
+  wxString imageName;
+  currentImage = FindImage(name, maskImage, imageName);
+  if (currentImage == NULL)
   {
     // First use of image, get info
     int i = (int) (*m_images).size() + 1;
-    currentImage = new wxPdfImage(this, i, name, stream, mimeType);
+    currentImage = new wxPdfImage(this, i, imageName, stream, mimeType);
     if (!currentImage->Parse())
     {
       delete currentImage;
@@ -1894,18 +2391,10 @@ wxPdfDocument::Image(const wxString& name, wxInputStream& stream,
       return isValid;
 
     }
-    if (maskImage > 0)
-    {
-      currentImage->SetMaskImage(maskImage);
-    }
-    (*m_images)[name] = currentImage;
-  }
-  else
-  {
-    currentImage = image->second;
-    if (maskImage > 0 && currentImage->GetMaskImage() != maskImage)
+    currentImage = AddParsedImage(imageName, currentImage, maskImage);
+    if (currentImage == NULL)
     {
-      currentImage->SetMaskImage(maskImage);
+      return false;
     }
   }
   OutImage(currentImage, x, y, w, h, link);
@@ -1919,8 +2408,8 @@ wxPdfDocument::ImageMask(const wxString& file, const wxString& type)
   int n = 0;
   wxPdfImage* currentImage = NULL;
   // Put an image on the page
-  wxPdfImageHashMap::iterator image = (*m_images).find(file);
-  if (image == (*m_images).end())
+  currentImage = FindImage(file);
+  if (currentImage == NULL)
   {
     // First use of image, get info
     n = (int) (*m_images).size() + 1;
@@ -1936,13 +2425,19 @@ wxPdfDocument::ImageMask(const wxString& file, const wxString& type)
       delete currentImage;
       return 0;
     }
-    (*m_images)[file] = currentImage;
-  }
-  else
-  {
-    currentImage = image->second;
-    n = currentImage->GetIndex();
+    wxString digest = GetImageDigest(currentImage, 0, true);
+    wxPdfImage* sameImage = FindImageByDigest(file, digest);
+    if (sameImage != NULL)
+    {
+      delete currentImage;
+      currentImage = sameImage;
+    }
+    else
+    {
+      RegisterImage(file, currentImage, digest);
+    }
   }
+  n = currentImage->GetIndex();
   if (m_PDFVersion < wxS("1.4"))
   {
     m_PDFVersion = wxS("1.4");
@@ -1958,48 +2453,39 @@ wxPdfDocument::ImageMask(const wxString& name, const wxImage& img)
   {
     wxPdfImage* currentImage = NULL;
     // Put an image on the page
-    wxPdfImageHashMap::iterator image = (*m_images).find(name);
-    if (image == (*m_images).end())
+    currentImage = FindImage(name);
+    wxString digest;
+    if (currentImage == NULL)
     {
-      wxImage tempImage;
+      // Look for a mask with identical content
+      digest = GetImageMaskDigest(img);
+      currentImage = FindImageByDigest(name, digest);
+    }
+    if (currentImage == NULL)
+    {
+      // First use of image, get info
+      n = (int) (*m_images).size() + 1;
       if (img.HasAlpha())
       {
-        int x, y;
-        int w = img.GetWidth();
-        int h = img.GetHeight();
-        tempImage = wxImage(w, h);
-        unsigned char alpha;
-        for (x = 0; x < w; x++)
-        {
-          for (y = 0; y < h; y++)
-          {
-            alpha = img.GetAlpha(x, y);
-            tempImage.SetRGB(x, y, alpha, alpha, alpha);
-          }
-        }
-        tempImage.SetOption(wxIMAGE_OPTION_PNG_FORMAT, wxPNG_TYPE_GREY_RED);
+        // The alpha channel is used directly as gray scale image
+        currentImage = new wxPdfImage(this, n, name, img.GetAlpha(), img.GetWidth(), img.GetHeight(),
+                                      8, m_asyncImagePreparation);
       }
       else
       {
-        tempImage = img.ConvertToGreyscale();
+        wxImage tempImage = img.ConvertToGreyscale();
         tempImage.SetOption(wxIMAGE_OPTION_PNG_FORMAT, wxPNG_TYPE_GREY_RED);
+        tempImage.SetMask(false);
+        currentImage = new wxPdfImage(this, n, name, tempImage, false, m_asyncImagePreparation);
       }
-      tempImage.SetMask(false);
-      // First use of image, get info
-      n = (int) (*m_images).size() + 1;
-      currentImage = new wxPdfImage(this, n, name, tempImage);
       if (!currentImage->Parse())
       {
         delete currentImage;
         return 0;
       }
-      (*m_images)[name] = currentImage;
-    }
-    else
-    {
-      currentImage = image->second;
-      n = currentImage->GetIndex();
+      RegisterImage(name, currentImage, digest);
     }
+    n = currentImage->GetIndex();
     if (m_PDFVersion < wxS("1.4"))
     {
       m_PDFVersion = wxS("1.4");
@@ -2008,14 +2494,135 @@ wxPdfDocument::ImageMask(const wxString& name, const wxImage& img)
   return n;
 }
 
+wxPdfImage*
+wxPdfDocument::FindImage(const wxString& name) const
+{
+  wxPdfImage* image = NULL;
+  wxPdfImageHashMap::const_iterator imageIter = m_images->find(name);
+  if (imageIter != m_images->end())
+  {
+    image = imageIter->second;
+  }
+  else
+  {
+    imageIter = m_imageAliases->find(name);
+    if (imageIter != m_imageAliases->end())
+    {
+      image = imageIter->second;
+    }
+  }
+  return image;
+}
+
+wxPdfImage*
+wxPdfDocument::FindImage(const wxString& name, int maskImage, wxString& imageName) const
+{
+  imageName = name;
+  wxPdfImage* image = FindImage(name);
+  if (image != NULL && maskImage > 0 && image->GetMaskImage() != maskImage)
+  {
+    // Shared images are never changed, use a separate image with the requested mask
+    imageName = name + wxString::Format(wxS("#mask%d"), maskImage);
+    image = FindImage(imageName);
+  }
+  return image;
+}
+
+wxPdfImage*
+wxPdfDocument::FindImageByDigest(const wxString& name, const wxString& digest)
+{
+  wxPdfImage* image = NULL;
+  wxPdfImageHashMap::const_iterator imageIter = m_imageDigests->find(digest);
+  if (imageIter != m_imageDigests->end())
+  {
+    // Use the existing image object under the new name, too
+    image = imageIter->second;
+    (*m_imageAliases)[name] = image;
+    ++m_imageDuplicates;
+  }
+  return image;
+}
+
+void
+wxPdfDocument::RegisterImage(const wxString& name, wxPdfImage* image, const wxString& digest)
+{
+  (*m_images)[name] = image;
+  if (!digest.IsEmpty())
+  {
+    (*m_imageDigests)[digest] = image;
+  }
+}
+
+wxPdfImage*
+wxPdfDocument::AddParsedImage(const wxString& name, wxPdfImage* image, int maskImage)
+{
+  wxString digest = GetImageDigest(image, maskImage, false);
+  wxPdfImage* sameImage = FindImageByDigest(name, digest);
+  if (sameImage != NULL)
+  {
+    delete image;
+    return sameImage;
+  }
+
+  if (image->HasAlphaChannel())
+  {
+    if (maskImage <= 0)
+    {
+      // The alpha channel is embedded as soft mask; the mask takes the index reserved for the image
+      int maskIndex = image->GetIndex();
+      wxString maskName = name + wxString(wxS(".mask"));
+      if (FindImage(maskName) != NULL)
+      {
+        maskName += wxString::Format(wxS("#%d"), maskIndex);
+      }
+      wxPdfImage* alphaImage = new wxPdfImage(this, maskIndex, maskName, image->GetAlphaChannel(),
+                                              image->GetWidth(), image->GetHeight(), image->GetAlphaBitsPerComponent());
+      if (!alphaImage->Parse())
+      {
+        // The image is not embedded without its transparency
+        wxLogError(wxString(wxS("wxPdfDocument::AddParsedImage: ")) +
+                   wxString::Format(_("Alpha channel of image '%s' could not be processed."), name.c_str()));
+        delete alphaImage;
+        delete image;
+        return NULL;
+      }
+      (*m_images)[maskName] = alphaImage;
+      image->SetIndex(maskIndex + 1);
+      maskImage = maskIndex;
+      if (m_PDFVersion < wxS("1.4"))
+      {
+        m_PDFVersion = wxS("1.4");
+      }
+    }
+    image->FreeAlphaChannel();
+  }
+  if (maskImage > 0)
+  {
+    image->SetMaskImage(maskImage);
+  }
+  if (image->GetBitsPerComponent() > 8 && m_PDFVersion < wxS("1.5"))
+  {
+    // 16-bit images require PDF 1.5
+    m_PDFVersion = wxS("1.5");
+  }
+  RegisterImage(name, image, digest);
+  return image;
+}
+
+int
+wxPdfDocument::GetImageDuplicateCount() const
+{
+  return m_imageDuplicates;
+}
+
 int
 wxPdfDocument::ImageMask(const wxString& name, wxInputStream& stream, const wxString& mimeType)
 {
   int n = 0;
   wxPdfImage* currentImage = NULL;
   // Put an image on the page
-  wxPdfImageHashMap::iterator image = (*m_images).find(name);
-  if (image == (*m_images).end())
+  currentImage = FindImage(name);
+  if (currentImage == NULL)
   {
     // First use of image, get info
     n = (int) (*m_images).size() + 1;
@@ -2031,13 +2638,19 @@ wxPdfDocument::ImageMask(const wxString& name, wxInputStream& stream, const wxSt
       delete currentImage;
       return 0;
     }
-    (*m_images)[name] = currentImage;
-  }
-  else
-  {
-    currentImage = image->second;
-    n = currentImage->GetIndex();
+    wxString digest = GetImageDigest(currentImage, 0, true);
+    wxPdfImage* sameImage = FindImageByDigest(name, digest);
+    if (sameImage != NULL)
+    {
+      delete currentImage;
+      currentImage = sameImage;
+    }
+    else
+    {
+      RegisterImage(name, currentImage, digest);
+    }
   }
+  n = currentImage->GetIndex();
   if (m_PDFVersion < wxS("1.4"))
   {
     m_PDFVersion = wxS("1.4");
@@ -2119,6 +2732,7 @@ wxPdfDocument::SaveAsFile(const wxString& name)
       outfile.Write(tmp);
     }
     outfile.Close();
+    ok = !m_imageDataError;
   }
   return ok;
 }
@@ -2452,6 +3066,62 @@ wxPdfDocument::SetCompression(bool compress)
   m_compress = compress;
 }
 
+void
+wxPdfDocument::SetImagePredictor(bool predictor)
+{
+  m_imagePredictor = predictor;
+}
+
+bool
+wxPdfDocument::GetImagePredictor() const
+{
+  return m_imagePredictor;
+}
+
+void
+wxPdfDocument::SetImageDepthReduction(bool reduce)
+{
+  m_imageDepthReduction = reduce;
+}
+
+bool
+wxPdfDocument::GetImageDepthReduction() const
+{
+  return m_imageDepthReduction;
+}
+
+void
+wxPdfDocument::SetImageResampling(double maxResolution, wxImageResizeQuality quality, int jpegQuality)
+{
+  m_imageMaxResolution = maxResolution;
+  m_imageResizeQuality = quality;
+  m_imageJpegQuality = (jpegQuality < 0) ? 0 : ((jpegQuality > 100) ? 100 : jpegQuality);
+}
+
+void
+wxPdfDocument::SetAsyncImagePreparation(bool async)
+{
+  m_asyncImagePreparation = async;
+}
+
+bool
+wxPdfDocument::GetAsyncImagePreparation() const
+{
+  return m_asyncImagePreparation;
+}
+
+double
+wxPdfDocument::GetImageMaxResolution() const
+{
+  return m_imageMaxResolution;
+}
+
+size_t
+wxPdfDocument::GetImageResamplingSavings() const
+{
+  return m_imageBytesSaved;
+}
+
 void
 wxPdfDocument::AppendJavascript(const wxString& javascript)
 {
@@ -149,6 +149,7 @@ wxPdfEncoding::wxPdfEncoding()
   m_cmapBase.Insert(0, 0, 256);
   m_glyphNames.Insert(wxString(wxS(".notdef")), 0, 256);
   m_encodingMap = NULL;
+  m_encodingConv = NULL;
 }
 
 wxPdfEncoding::~wxPdfEncoding()
@@ -157,6 +158,10 @@ wxPdfEncoding::~wxPdfEncoding()
   {
     delete m_encodingMap;
   }
+  if (m_encodingConv != NULL)
+  {
+    delete m_encodingConv;
+  }
 }
 
 wxPdfEncoding::wxPdfEncoding(const wxPdfEncoding &encoding)
@@ -170,6 +175,7 @@ wxPdfEncoding::wxPdfEncoding(const wxPdfEncoding &encoding)
   m_cmapBase = encoding.m_cmapBase;
   m_glyphNames = encoding.m_glyphNames;
   m_encodingMap = NULL;
+  m_encodingConv = NULL;
 }
 
 wxPdfEncoding&
@@ -183,7 +189,16 @@ wxPdfEncoding::operator=(const wxPdfEncoding& encoding)
   m_cmap = encoding.m_cmap;
   m_cmapBase = encoding.m_cmapBase;
   m_glyphNames = encoding.m_glyphNames;
+  if (m_encodingMap != NULL)
+  {
+    delete m_encodingMap;
+  }
   m_encodingMap = NULL;
+  if (m_encodingConv != NULL)
+  {
+    delete m_encodingConv;
+  }
+  m_encodingConv = NULL;
   return *this;
 }
 
@@ -332,6 +347,12 @@ wxPdfEncoding::GetEncodingMap() const
   return m_encodingMap;
 }
 
+const wxPdfEncodingConv*
+wxPdfEncoding::GetEncodingConv() const
+{
+  return m_encodingConv;
+}
+
 wxArrayString
 wxPdfEncoding::GetGlyphNames() const
 {
@@ -351,6 +372,181 @@ wxPdfEncoding::CreateEncodingConvMap()
       (*m_encodingMap)[m_cmap[j]] = j;
     }
   }
+  if (m_encodingConv == NULL)
+  {
+    m_encodingConv = new wxPdfEncodingConv(m_cmap);
+  }
+}
+
+// --- Table-driven single-byte converter
+
+wxPdfEncodingConv::wxPdfEncodingConv(const wxPdfArrayUint32& cmap)
+{
+  wxUint32 codes[256];
+  size_t n = cmap.GetCount();
+  size_t j;
+  for (j = 0; j < 256; ++j)
+  {
+    codes[j] = (j < n) ? cmap[j] : 0;
+  }
+  Initialize(codes);
+}
+
+wxPdfEncodingConv::wxPdfEncodingConv(const wxPdfEncodingConv& conv)
+  : wxMBConv()
+{
+  Initialize(conv.m_cmap);
+}
+
+wxPdfEncodingConv::~wxPdfEncodingConv()
+{
+  delete [] m_pages;
+}
+
+void
+wxPdfEncodingConv::Initialize(const wxUint32* cmap)
+{
+  size_t j;
+  memset(m_pageIndex, 0, sizeof(m_pageIndex));
+
+  // Number the pages populated by the encoding, page 0 is the shared empty page
+  m_pageCount = 1;
+  for (j = 0; j < 256; ++j)
+  {
+    m_cmap[j] = cmap[j];
+    if (j != 0 && cmap[j] != 0 && cmap[j] <= 0xFFFF && m_pageIndex[cmap[j] >> 8] == 0)
+    {
+      m_pageIndex[cmap[j] >> 8] = (wxUint16) m_pageCount++;
+    }
+  }
+  m_pages = new wxUint8[m_pageCount * 256];
+  memset(m_pages, 0, m_pageCount * 256);
+
+  // In case of duplicates the highest code wins, like in the encoding map
+  for (j = 1; j < 256; ++j)
+  {
+    if (cmap[j] != 0 && cmap[j] <= 0xFFFF)
+    {
+      m_pages[m_pageIndex[cmap[j] >> 8] * 256 + (cmap[j] & 0xFF)] = (wxUint8) j;
+    }
+  }
+
+  m_asciiIdentity = true;
+  for (j = 0; m_asciiIdentity && j < 128; ++j)
+  {
+    m_asciiIdentity = (cmap[j] == j);
+  }
+}
+
+wxPdfEncodingConv*
+wxPdfEncodingConv::Create(const wxString& charset)
+{
+  wxCSConv conv(charset);
+  if (!conv.IsOk())
+  {
+    return NULL;
+  }
+
+  // A single-byte character set never needs more than one byte per character
+  static const wchar_t probe[] = { 0x00E9, 0x0416, 0x05D0, 0x3042, 0x4E00, 0xAC00 };
+  size_t j;
+  for (j = 0; j < WXSIZEOF(probe); ++j)
+  {
+    size_t len = conv.FromWChar(NULL, 0, &probe[j], 1);
+    if (len != wxCONV_FAILED && len > 1)
+    {
+      return NULL;
+    }
+  }
+
+  wxPdfArrayUint32 cmap;
+  cmap.Insert(0, 0, 256);
+  for (j = 1; j < 256; ++j)
+  {
+    char code = (char) j;
+    wchar_t unicode[2];
+    if (conv.ToWChar(unicode, 2, &code, 1) == 1)
+    {
+      cmap[j] = (wxUint32) unicode[0];
+    }
+  }
+  return new wxPdfEncodingConv(cmap);
+}
+
+size_t
+wxPdfEncodingConv::ToWChar(wchar_t* dst, size_t dstLen, const char* src, size_t srcLen) const
+{
+  if (srcLen == wxNO_LEN)
+  {
+    srcLen = strlen(src) + 1;
+  }
+  if (dst != NULL && dstLen < srcLen)
+  {
+    return wxCONV_FAILED;
+  }
+  size_t j;
+  for (j = 0; j < srcLen; ++j)
+  {
+    wxUint8 code = (wxUint8) src[j];
+    if (code != 0 && m_cmap[code] == 0)
+    {
+      return wxCONV_FAILED;
+    }
+    if (dst != NULL)
+    {
+      dst[j] = (wchar_t) m_cmap[code];
+    }
+  }
+  return srcLen;
+}
+
+size_t
+wxPdfEncodingConv::FromWChar(char* dst, size_t dstLen, const wchar_t* src, size_t srcLen) const
+{
+  if (srcLen == wxNO_LEN)
+  {
+    srcLen = wxWcslen(src) + 1;
+  }
+  if (dst != NULL && dstLen < srcLen)
+  {
+    return wxCONV_FAILED;
+  }
+  size_t j = 0;
+  while (j < srcLen)
+  {
+    if (m_asciiIdentity)
+    {
+      // Copy a run of ASCII characters without table lookups
+      size_t k = j;
+      while (k < srcLen && (wxUint32) src[k] < 0x80)
+      {
+        ++k;
+      }
+      if (dst != NULL)
+      {
+        for (; j < k; ++j)
+        {
+          dst[j] = (char) src[j];
+        }
+      }
+      j = k;
+      if (j >= srcLen)
+      {
+        break;
+      }
+    }
+    wxUint32 code;
+    if (!Map((wxUint32) src[j], code))
+    {
+      return wxCONV_FAILED;
+    }
+    if (dst != NULL)
+    {
+      dst[j] = (char) code;
+    }
+    ++j;
+  }
+  return srcLen;
 }
 
 // --- Encoding Checker
@@ -29,6 +29,9 @@
 #include "wx/pdffontdatatype1.h"
 #include "wx/pdffontmanager.h"
 
+#include <wx/arrimpl.cpp>
+WX_DEFINE_USER_EXPORTED_OBJARRAY(wxPdfFontArray);
+
 wxPdfFont::wxPdfFont()
   : m_embed(false), m_subset(false), m_fontStyle(wxPDF_FONTSTYLE_REGULAR),
     m_fontData(NULL), m_encoding(NULL)
@@ -224,6 +227,17 @@ wxPdfFont::GetSupportedUnicodeCharacters(wxPdfArrayUint32& unicodeCharacters) co
   return ok;
 }
 
+const wxPdfGlyphSet*
+wxPdfFont::GetCoverage() const
+{
+  const wxPdfGlyphSet* coverage = NULL;
+  if (m_fontData != NULL && wxPdfFontManager::GetFontManager()->InitializeFontData(*this))
+  {
+    coverage = m_fontData->GetCoverage(m_encoding);
+  }
+  return coverage;
+}
+
 wxString
 wxPdfFont::ConvertToValid(const wxString& s, wxUniChar replace) const
 {
@@ -288,7 +302,7 @@ const wxPdfFontDescription
 wxPdfFont::GetDescription() const
 {
   wxPdfFontDescription fontDesc;
-  if (m_fontData != NULL && wxPdfFontManager::GetFontManager()->InitializeFontData(*this))
+  if (m_fontData != NULL && m_fontData->InitializeOnce())
   {
     fontDesc = m_fontData->GetDescription();
   }
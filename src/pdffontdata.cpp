@@ -21,8 +21,14 @@
 #endif
 
 // includes
+#include <wx/datstrm.h>
+#include <wx/filename.h>
+#include <wx/thread.h>
 #include <wx/tokenzr.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "wx/pdfencoding.h"
 #include "wx/pdffontdata.h"
 #include "wx/pdffont.h"
@@ -171,6 +177,24 @@ wxPdfFontData::GetFontDescription(const wxXmlNode *node, wxPdfFontDescription& f
           bUnderlinePosition && bUnderlineThickness);
 }
 
+// Cached set of Unicode characters covered by a font for a specific encoding
+class wxPdfFontCoverage
+{
+public:
+  wxPdfFontCoverage(const wxPdfEncoding* encoding, wxPdfFontCoverage* next)
+    : m_encoding(encoding), m_next(next)
+  {
+  }
+
+  const wxPdfEncoding* m_encoding;   ///< Encoding the coverage was created for
+  wxPdfGlyphSet        m_characters; ///< Set of covered Unicode characters
+  wxPdfFontCoverage*   m_next;       ///< Next cached coverage
+};
+
+#if wxUSE_THREADS
+static wxCriticalSection gs_csFontCoverage;
+#endif
+
 wxPdfFontData::wxPdfFontData()
 {
   m_refCount = 0;
@@ -207,10 +231,17 @@ wxPdfFontData::wxPdfFontData()
 
   m_encoding = NULL;
   m_encodingChecker = NULL;
+  m_coverage = NULL;
 }
 
 wxPdfFontData::~wxPdfFontData()
 {
+  while (m_coverage != NULL)
+  {
+    wxPdfFontCoverage* next = m_coverage->m_next;
+    delete m_coverage;
+    m_coverage = next;
+  }
   if (m_kp != NULL)
   {
     wxPdfKernPairMap::iterator kp;
@@ -251,6 +282,21 @@ wxPdfFontData::FindEncodingMap(const wxPdfEncoding* encoding) const
   return convMap;
 }
 
+const wxPdfEncodingConv*
+wxPdfFontData::FindEncodingConv(const wxPdfEncoding* encoding) const
+{
+  const wxPdfEncodingConv* conv = NULL;
+  if (encoding != NULL)
+  {
+    conv = encoding->GetEncodingConv();
+  }
+  if (conv == NULL && m_encoding != NULL)
+  {
+    conv = m_encoding->GetEncodingConv();
+  }
+  return conv;
+}
+
 void
 wxPdfFontData::SetEncodingChecker(wxPdfEncodingChecker* encodingChecker)
 {
@@ -698,11 +744,11 @@ wxPdfFontData::Initialize()
 void
 wxPdfFontData::SetInitialized(bool initialized)
 {
-  m_initialized = initialized;
+  m_initialized.store(initialized, std::memory_order_release);
 }
 
 wxString
-wxPdfFontData::GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
+wxPdfFontData::GetWidthsAsString(bool subset, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(subset);
   wxUnusedVar(usedGlyphs);
@@ -728,7 +774,7 @@ wxPdfFontData::GetGlyphNames(wxArrayString& glyphNames) const
 }
 
 size_t
-wxPdfFontData::WriteFontData(wxOutputStream* fontData, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+wxPdfFontData::WriteFontData(wxOutputStream* fontData, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxUnusedVar(fontData);
   wxUnusedVar(usedGlyphs);
@@ -738,7 +784,7 @@ wxPdfFontData::WriteFontData(wxOutputStream* fontData, wxPdfSortedArrayInt* used
 
 size_t
 wxPdfFontData::WriteUnicodeMap(wxOutputStream* mapData,
-                               const wxPdfEncoding* encoding, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+                               const wxPdfEncoding* encoding, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxUnusedVar(mapData);
   wxUnusedVar(encoding);
@@ -749,7 +795,7 @@ wxPdfFontData::WriteUnicodeMap(wxOutputStream* mapData,
 
 size_t
 wxPdfFontData::WriteCIDToGIDMap(wxOutputStream* mapData,
-                                const wxPdfEncoding* encoding, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+                                const wxPdfEncoding* encoding, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxUnusedVar(mapData);
   wxUnusedVar(encoding);
@@ -760,7 +806,7 @@ wxPdfFontData::WriteCIDToGIDMap(wxOutputStream* mapData,
 
 size_t
 wxPdfFontData::WriteCIDSet(wxOutputStream* setData,
-                           const wxPdfEncoding* encoding, wxPdfSortedArrayInt* usedGlyphs,  wxPdfChar2GlyphMap* subsetGlyphs)
+                           const wxPdfEncoding* encoding, wxPdfGlyphSet* usedGlyphs,  wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxUnusedVar(setData);
   wxUnusedVar(encoding);
@@ -788,6 +834,352 @@ wxPdfFontData::LoadFontMetrics(wxXmlNode* root)
   return false;
 };
 
+// Binary font metrics format (all numbers are 32-bit little-endian):
+//
+//   signature "wxPdfFM" + 0x1A, version
+//   strings (byte length + UTF-8): type, name, encoding, diffs, file, ctg,
+//   cmap, ordering, supplement
+//   size1, size2, flags (bit 0: glyph numbers included, bit 1: subsetting state
+//   recorded, bit 2: subsetting enabled)
+//   ascent, descent, cap height, flags, italic angle, stem v, missing width,
+//   x height, underline position, underline thickness, string font bbox
+//   char count, records (char, width, glyph number)
+//   kerning pair count, records (first char, second char, kerning width)
+//
+// Records are fixed-size, so the file is read sequentially without any
+// text parsing. The loader decodes every record into the width, glyph and
+// kerning hash maps of the font data.
+
+static const unsigned char gs_binaryFontMetricsSignature[8] = { 'w', 'x', 'P', 'd', 'f', 'F', 'M', 0x1A };
+static const wxUint32 gs_binaryFontMetricsVersion = 2;
+static const wxUint32 gs_binaryFontMetricsGlyphInfo = 1;
+static const wxUint32 gs_binaryFontMetricsSubsettingInfo = 2;
+static const wxUint32 gs_binaryFontMetricsSubsetting = 4;
+
+/// Sequential reader for binary font metrics data (for internal use only)
+class wxPdfBinaryFontMetricsReader
+{
+public:
+  wxPdfBinaryFontMetricsReader(const unsigned char* data, size_t length)
+    : m_data(data), m_length(length), m_pos(0), m_ok(true)
+  {
+  }
+
+  bool IsOk() const { return m_ok; }
+
+  bool ReadSignature()
+  {
+    m_ok = m_ok && m_length >= sizeof(gs_binaryFontMetricsSignature) &&
+           memcmp(m_data, gs_binaryFontMetricsSignature, sizeof(gs_binaryFontMetricsSignature)) == 0;
+    if (m_ok)
+    {
+      m_pos = sizeof(gs_binaryFontMetricsSignature);
+    }
+    return m_ok;
+  }
+
+  static wxUint32 GetUint32(const unsigned char* p)
+  {
+    return ((wxUint32) p[0]) | ((wxUint32) p[1] << 8) | ((wxUint32) p[2] << 16) | ((wxUint32) p[3] << 24);
+  }
+
+  wxUint32 ReadUint32()
+  {
+    wxUint32 value = 0;
+    const unsigned char* p = ReadRecords(1, 4);
+    if (p != NULL)
+    {
+      value = GetUint32(p);
+    }
+    return value;
+  }
+
+  int ReadInt32()
+  {
+    return (int) (wxInt32) ReadUint32();
+  }
+
+  wxString ReadString()
+  {
+    wxString value;
+    wxUint32 length = ReadUint32();
+    const unsigned char* p = ReadRecords(length, 1);
+    if (p != NULL && length > 0)
+    {
+      value = wxString::FromUTF8((const char*) p, length);
+    }
+    return value;
+  }
+
+  /// Get a pointer to an array of fixed-size records, or NULL if the data are too short
+  const unsigned char* ReadRecords(wxUint32 count, size_t recordSize)
+  {
+    const unsigned char* p = NULL;
+    if (m_ok && count <= (m_length - m_pos) / recordSize)
+    {
+      p = m_data + m_pos;
+      m_pos += count * recordSize;
+    }
+    else
+    {
+      m_ok = false;
+    }
+    return p;
+  }
+
+private:
+  const unsigned char* m_data;
+  size_t               m_length;
+  size_t               m_pos;
+  bool                 m_ok;
+};
+
+static void
+WriteBinaryFontMetricsString(wxOutputStream& stream, wxDataOutputStream& data, const wxString& s)
+{
+  const wxScopedCharBuffer utf8 = s.utf8_str();
+  size_t length = utf8.length();
+  data.Write32((wxUint32) length);
+  if (length > 0)
+  {
+    stream.Write(utf8.data(), length);
+  }
+}
+
+wxString
+wxPdfFontData::GetBinaryFontMetricsType(const unsigned char* data, size_t length)
+{
+  wxString fontType;
+  wxPdfBinaryFontMetricsReader reader(data, length);
+  if (reader.ReadSignature() && reader.ReadUint32() == gs_binaryFontMetricsVersion)
+  {
+    fontType = reader.ReadString();
+  }
+  return fontType;
+}
+
+bool
+wxPdfFontData::LoadBinaryFontMetrics(const unsigned char* data, size_t length)
+{
+  wxPdfBinaryFontMetricsReader reader(data, length);
+  if (!reader.ReadSignature() || reader.ReadUint32() != gs_binaryFontMetricsVersion)
+  {
+    return false;
+  }
+  if (!reader.ReadString().IsSameAs(m_type))
+  {
+    return false;
+  }
+
+  m_name = reader.ReadString();
+  m_style = FindStyleFromName(m_name);
+  m_enc = reader.ReadString();
+  m_diffs = reader.ReadString();
+  m_file = reader.ReadString();
+  m_ctg = reader.ReadString();
+  m_cmap = reader.ReadString();
+  m_ordering = reader.ReadString();
+  m_supplement = reader.ReadString();
+  m_size1 = reader.ReadUint32();
+  m_size2 = reader.ReadUint32();
+  wxUint32 flags = reader.ReadUint32();
+
+  m_desc.SetAscent(reader.ReadInt32());
+  m_desc.SetDescent(reader.ReadInt32());
+  m_desc.SetCapHeight(reader.ReadInt32());
+  m_desc.SetFlags(reader.ReadInt32());
+  m_desc.SetItalicAngle(reader.ReadInt32());
+  m_desc.SetStemV(reader.ReadInt32());
+  m_desc.SetMissingWidth(reader.ReadInt32());
+  m_desc.SetXHeight(reader.ReadInt32());
+  m_desc.SetUnderlinePosition(reader.ReadInt32());
+  m_desc.SetUnderlineThickness(reader.ReadInt32());
+  m_desc.SetFontBBox(reader.ReadString());
+
+  wxUint32 j;
+  const unsigned char* p;
+  wxUint32 charCount = reader.ReadUint32();
+  const unsigned char* chars = reader.ReadRecords(charCount, 12);
+  wxUint32 kernCount = reader.ReadUint32();
+  const unsigned char* kerns = reader.ReadRecords(kernCount, 12);
+  if (!reader.IsOk())
+  {
+    return false;
+  }
+
+  // The subsetting state corresponds to the subsetting attribute of XML font metrics files
+  bool glyphInfo = (flags & gs_binaryFontMetricsGlyphInfo) != 0;
+  bool subsetting = (flags & gs_binaryFontMetricsSubsetting) != 0;
+  if ((flags & gs_binaryFontMetricsSubsettingInfo) != 0)
+  {
+    m_subsetSupported = subsetting;
+  }
+  m_cw = new wxPdfGlyphWidthMap(charCount);
+  if (glyphInfo || subsetting)
+  {
+    m_gn = new wxPdfChar2GlyphMap(charCount);
+  }
+  for (j = 0, p = chars; j < charCount; ++j, p += 12)
+  {
+    wxUint32 charId = wxPdfBinaryFontMetricsReader::GetUint32(p);
+    (*m_cw)[charId] = (wxUint16) wxPdfBinaryFontMetricsReader::GetUint32(p + 4);
+    if (m_gn != NULL)
+    {
+      (*m_gn)[charId] = (glyphInfo) ? wxPdfBinaryFontMetricsReader::GetUint32(p + 8) : 0;
+    }
+  }
+
+  if (kernCount > 0)
+  {
+    m_kp = new wxPdfKernPairMap();
+    wxPdfKernWidthMap* kwMap = NULL;
+    wxUint32 prevFirst = 0;
+    for (j = 0, p = kerns; j < kernCount; ++j, p += 12)
+    {
+      wxUint32 first = wxPdfBinaryFontMetricsReader::GetUint32(p);
+      if (kwMap == NULL || first != prevFirst)
+      {
+        wxPdfKernPairMap::iterator kpIter = m_kp->find(first);
+        if (kpIter != m_kp->end())
+        {
+          kwMap = kpIter->second;
+        }
+        else
+        {
+          kwMap = new wxPdfKernWidthMap();
+          (*m_kp)[first] = kwMap;
+        }
+        prevFirst = first;
+      }
+      (*kwMap)[wxPdfBinaryFontMetricsReader::GetUint32(p + 4)] = (int) (wxInt32) wxPdfBinaryFontMetricsReader::GetUint32(p + 8);
+    }
+  }
+  return CompleteFontMetrics(m_name.Length() > 0);
+}
+
+bool
+wxPdfFontData::WriteBinaryFontMetrics(wxOutputStream& stream, bool includeGlyphInfo, bool includeSubsetting) const
+{
+  wxDataOutputStream data(stream);
+  data.BigEndianOrdered(false);
+  const wxPdfFontDescription& fd = GetDescription();
+  const wxPdfChar2GlyphMap* glyphs = GetChar2GlyphMap();
+  bool glyphInfo = includeGlyphInfo && glyphs != NULL;
+  wxUint32 flags = (glyphInfo) ? gs_binaryFontMetricsGlyphInfo : 0;
+  if (includeSubsetting)
+  {
+    flags |= gs_binaryFontMetricsSubsettingInfo;
+    if (includeGlyphInfo)
+    {
+      flags |= gs_binaryFontMetricsSubsetting;
+    }
+  }
+
+  stream.Write(gs_binaryFontMetricsSignature, sizeof(gs_binaryFontMetricsSignature));
+  data.Write32(gs_binaryFontMetricsVersion);
+  WriteBinaryFontMetricsString(stream, data, GetType());
+  WriteBinaryFontMetricsString(stream, data, GetName());
+  WriteBinaryFontMetricsString(stream, data, GetEncoding());
+  WriteBinaryFontMetricsString(stream, data, GetDiffs());
+  WriteBinaryFontMetricsString(stream, data, GetFontFile());
+  WriteBinaryFontMetricsString(stream, data, GetCtgFile());
+  WriteBinaryFontMetricsString(stream, data, m_cmap);
+  WriteBinaryFontMetricsString(stream, data, m_ordering);
+  WriteBinaryFontMetricsString(stream, data, m_supplement);
+  data.Write32((wxUint32) GetSize1());
+  data.Write32((wxUint32) GetSize2());
+  data.Write32(flags);
+
+  data.Write32((wxUint32) fd.GetAscent());
+  data.Write32((wxUint32) fd.GetDescent());
+  data.Write32((wxUint32) fd.GetCapHeight());
+  data.Write32((wxUint32) fd.GetFlags());
+  data.Write32((wxUint32) fd.GetItalicAngle());
+  data.Write32((wxUint32) fd.GetStemV());
+  data.Write32((wxUint32) fd.GetMissingWidth());
+  data.Write32((wxUint32) fd.GetXHeight());
+  data.Write32((wxUint32) fd.GetUnderlinePosition());
+  data.Write32((wxUint32) fd.GetUnderlineThickness());
+  WriteBinaryFontMetricsString(stream, data, fd.GetFontBBox());
+
+  std::vector<wxUint32> keys;
+  size_t j;
+  if (m_cw != NULL)
+  {
+    wxPdfGlyphWidthMap::const_iterator cwIter;
+    for (cwIter = m_cw->begin(); cwIter != m_cw->end(); ++cwIter)
+    {
+      keys.push_back(cwIter->first);
+    }
+  }
+  std::sort(keys.begin(), keys.end());
+  data.Write32((wxUint32) keys.size());
+  for (j = 0; j < keys.size(); ++j)
+  {
+    wxUint32 glyph = 0;
+    if (glyphInfo)
+    {
+      wxPdfChar2GlyphMap::const_iterator glyphIter = glyphs->find(keys[j]);
+      if (glyphIter != glyphs->end())
+      {
+        glyph = glyphIter->second;
+      }
+    }
+    data.Write32(keys[j]);
+    data.Write32((wxUint32) m_cw->find(keys[j])->second);
+    data.Write32(glyph);
+  }
+
+  keys.clear();
+  wxUint32 kernCount = 0;
+  if (m_kp != NULL)
+  {
+    wxPdfKernPairMap::const_iterator kpIter;
+    for (kpIter = m_kp->begin(); kpIter != m_kp->end(); ++kpIter)
+    {
+      keys.push_back(kpIter->first);
+      kernCount += (wxUint32) kpIter->second->size();
+    }
+  }
+  std::sort(keys.begin(), keys.end());
+  data.Write32(kernCount);
+  for (j = 0; j < keys.size(); ++j)
+  {
+    const wxPdfKernWidthMap* kwMap = m_kp->find(keys[j])->second;
+    std::vector<wxUint32> seconds;
+    wxPdfKernWidthMap::const_iterator kwIter;
+    for (kwIter = kwMap->begin(); kwIter != kwMap->end(); ++kwIter)
+    {
+      seconds.push_back(kwIter->first);
+    }
+    std::sort(seconds.begin(), seconds.end());
+    size_t k;
+    for (k = 0; k < seconds.size(); ++k)
+    {
+      data.Write32(keys[j]);
+      data.Write32(seconds[k]);
+      data.Write32((wxUint32) kwMap->find(seconds[k])->second);
+    }
+  }
+  return stream.IsOk();
+}
+
+bool
+wxPdfFontData::CompleteFontMetrics(bool complete)
+{
+#if wxUSE_UNICODE
+  CreateDefaultEncodingConv();
+#endif
+
+  m_initialized = complete;
+  if (m_initialized)
+  {
+    wxFileName fileName(m_file);
+    m_initialized = fileName.MakeAbsolute(m_path) && fileName.FileExists() && fileName.IsFileReadable();
+  }
+  return m_initialized;
+}
+
 bool
 wxPdfFontData::CanShow(const wxString& s, const wxPdfEncoding* encoding) const
 {
@@ -831,10 +1223,82 @@ wxPdfFontData::ConvertToValid(const wxString& s, wxUniChar replace) const
   return  t;
 }
 
+const wxPdfGlyphSet*
+wxPdfFontData::GetCoverage(const wxPdfEncoding* encoding) const
+{
+#if wxUSE_THREADS
+  wxCriticalSectionLocker locker(gs_csFontCoverage);
+#endif
+  if (!IsInitialized())
+  {
+    // An empty set must not be cached for font data not yet loaded
+    return NULL;
+  }
+  wxPdfFontCoverage* coverage;
+  for (coverage = m_coverage; coverage != NULL; coverage = coverage->m_next)
+  {
+    if (coverage->m_encoding == encoding)
+    {
+      return &coverage->m_characters;
+    }
+  }
+  coverage = new wxPdfFontCoverage(encoding, m_coverage);
+  CreateCoverage(encoding, coverage->m_characters);
+  m_coverage = coverage;
+  return &coverage->m_characters;
+}
+
+void
+wxPdfFontData::CreateCoverage(const wxPdfEncoding* encoding, wxPdfGlyphSet& coverage) const
+{
+  // The coverage corresponds to the default implementation of CanShow
+  wxUnusedVar(encoding);
+#if wxUSE_UNICODE
+  // Probe the encoding converter character by character
+  wxMBConv* conv = GetEncodingConv();
+  wchar_t wc[1];
+  wxUint32 cc;
+  for (cc = 0; cc < 0x10000; ++cc)
+  {
+    if (cc < 0xd800 || cc > 0xdfff)
+    {
+      wc[0] = (wchar_t) cc;
+      if (conv->FromWChar(NULL, 0, wc, 1) != wxCONV_FAILED)
+      {
+        coverage.Add(cc);
+      }
+    }
+  }
+#else
+  CreateFullCoverage(coverage);
+#endif
+}
+
+void
+wxPdfFontData::CreateFullCoverage(wxPdfGlyphSet& coverage)
+{
+#if wxUSE_UNICODE
+  wxUint32 cc;
+  for (cc = 0; cc < 0x10000; ++cc)
+  {
+    if (cc < 0xd800 || cc > 0xdfff)
+    {
+      coverage.Add(cc);
+    }
+  }
+#else
+  wxUint32 cc;
+  for (cc = 0; cc < 0x100; ++cc)
+  {
+    coverage.Add(cc);
+  }
+#endif
+}
+
 wxString
 wxPdfFontData::ConvertCID2GID(const wxString& s,
                               const wxPdfEncoding* encoding,
-                              wxPdfSortedArrayInt* usedGlyphs,
+                              wxPdfGlyphSet* usedGlyphs,
                               wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   // No conversion from cid to gid
@@ -847,7 +1311,7 @@ wxPdfFontData::ConvertCID2GID(const wxString& s,
 wxString
 wxPdfFontData::ConvertGlyph(wxUint32 glyph,
                             const wxPdfEncoding* encoding,
-                            wxPdfSortedArrayInt* usedGlyphs,
+                            wxPdfGlyphSet* usedGlyphs,
                             wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(glyph);
@@ -857,6 +1321,37 @@ wxPdfFontData::ConvertGlyph(wxUint32 glyph,
   return wxEmptyString;
 }
 
+bool
+wxPdfFontData::ConvertGlyphs(const wxUint32* glyphs, size_t count, wxUint32* cids,
+                             const wxPdfEncoding* encoding,
+                             wxPdfGlyphSet* usedGlyphs,
+                             wxPdfChar2GlyphMap* subsetGlyphs) const
+{
+  bool ok = true;
+  size_t j;
+  for (j = 0; j < count; ++j)
+  {
+    wxString t = ConvertGlyph(glyphs[j], encoding, usedGlyphs, subsetGlyphs);
+    if (!t.IsEmpty())
+    {
+      cids[j] = (wxUint32) t[0].GetValue();
+    }
+    else
+    {
+      cids[j] = 0;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+int
+wxPdfFontData::GetGlyphWidth(wxUint32 glyph) const
+{
+  wxUnusedVar(glyph);
+  return 0;
+}
+
 #if wxUSE_UNICODE
 wxMBConv*
 wxPdfFontData::GetEncodingConv() const
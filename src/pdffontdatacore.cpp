@@ -28,7 +28,7 @@
 #include "wx/pdfencoding.h"
 
 wxPdfFontDataCore::wxPdfFontDataCore(const wxString& family, const wxString& alias, const wxString& name,
-                                     short* cwArray, const wxPdfKernPairDesc* kpArray,
+                                     const short* cwArray, const wxPdfKernPairDesc* kpArray,
                                      const wxPdfFontDescription& desc)
   : wxPdfFontData()
 {
@@ -40,42 +40,15 @@ wxPdfFontDataCore::wxPdfFontDataCore(const wxString& family, const wxString& ali
   m_desc  = desc;
   m_style = FindStyleFromName(name);
 
-  if (cwArray != NULL)
-  {
-    m_cw = new wxPdfGlyphWidthMap();
-    int j;
-    for (j = 0; j <256; j++)
-    {
-      (*m_cw)[j] = cwArray[j];
-    }
-  }
-
+  // Widths and kerning pairs are served directly from the static tables
+  m_cwArray = cwArray;
+  m_kpArray = kpArray;
+  m_kpCount = 0;
   if (kpArray != NULL)
   {
-    m_kp = new wxPdfKernPairMap();
-    wxPdfKernWidthMap* kwMap = NULL;
-    wxPdfKernWidthMap::iterator kw;
-    wxUint32 u1, u2;
-    wxUint32 u1prev = 0;
-    size_t k = 0;
-    while ((u1 = kpArray[k].unicode1) != 0 && (u2 = kpArray[k].unicode2) != 0)
+    while (kpArray[m_kpCount].unicode1 != 0 && kpArray[m_kpCount].unicode2 != 0)
     {
-      if (u1 != u1prev)
-      {
-        u1prev = u1;
-        wxPdfKernPairMap::iterator kp = (*m_kp).find(u1);
-        if (kp == (*m_kp).end())
-        {
-          kwMap = new wxPdfKernWidthMap();
-          (*m_kp)[u1] = kwMap;
-        }
-        else
-        {
-          kwMap = kp->second;
-        }
-      }
-      (*kwMap)[u2] = kpArray[k].kerning;
-      ++k;
+      ++m_kpCount;
     }
   }
 
@@ -87,7 +60,7 @@ wxPdfFontDataCore::~wxPdfFontDataCore()
 }
 
 wxString
-wxPdfFontDataCore::GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
+wxPdfFontDataCore::GetWidthsAsString(bool subset, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(subset);
   wxUnusedVar(usedGlyphs);
@@ -96,7 +69,7 @@ wxPdfFontDataCore::GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyph
   int i;
   for (i = 32; i <= 255; i++)
   {
-    s += wxString::Format(wxS("%u "), (*m_cw)[i]);
+    s += wxString::Format(wxS("%u "), m_cwArray[i]);
   }
   s += wxString(wxS("]"));
   return s;
@@ -123,7 +96,8 @@ wxPdfFontDataCore::GetStringWidth(const wxString& s, const wxPdfEncoding* encodi
   wxString::const_iterator ch;
   for (ch = t.begin(); ch != t.end(); ++ch)
   {
-    w += (*m_cw)[*ch];
+    wxUint32 c = (wxUint32) (*ch);
+    w += (c < 256) ? m_cwArray[c] : 0;
     ++glyphCount;
   }
   if (withKerning)
@@ -141,6 +115,80 @@ wxPdfFontDataCore::GetStringWidth(const wxString& s, const wxPdfEncoding* encodi
   return w / 1000;
 }
 
+bool
+wxPdfFontDataCore::FindKerningPair(wxUint32 ch1, wxUint32 ch2, int& kerning) const
+{
+  // Binary search in the kerning table sorted by first and second character
+  size_t lo = 0;
+  size_t hi = m_kpCount;
+  while (lo < hi)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    const wxPdfKernPairDesc& kp = m_kpArray[mid];
+    if (kp.unicode1 < ch1 || (kp.unicode1 == ch1 && kp.unicode2 < ch2))
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  bool found = lo < m_kpCount && m_kpArray[lo].unicode1 == ch1 && m_kpArray[lo].unicode2 == ch2;
+  if (found)
+  {
+    kerning = m_kpArray[lo].kerning;
+  }
+  return found;
+}
+
+int
+wxPdfFontDataCore::GetKerningWidth(const wxString& s) const
+{
+  int width = 0;
+  if (m_kpCount > 0 && s.length())
+  {
+    int kerning;
+    wxString::const_iterator ch = s.begin();
+    wxUint32 ch1 = (wxUint32) (*ch);
+    for (++ch; ch != s.end(); ++ch)
+    {
+      wxUint32 ch2 = (wxUint32) (*ch);
+      if (FindKerningPair(ch1, ch2, kerning))
+      {
+        width += kerning;
+      }
+      ch1 = ch2;
+    }
+  }
+  return width;
+}
+
+wxArrayInt
+wxPdfFontDataCore::GetKerningWidthArray(const wxString& s) const
+{
+  wxArrayInt widths;
+  int pos = 0;
+  if (m_kpCount > 0 && s.length())
+  {
+    int kerning;
+    wxString::const_iterator ch = s.begin();
+    wxUint32 ch1 = (wxUint32) (*ch);
+    for (++ch; ch != s.end(); ++ch)
+    {
+      wxUint32 ch2 = (wxUint32) (*ch);
+      if (FindKerningPair(ch1, ch2, kerning))
+      {
+        widths.Add(pos);
+        widths.Add(-kerning);
+      }
+      ch1 = ch2;
+      ++pos;
+    }
+  }
+  return widths;
+}
+
 bool
 wxPdfFontDataCore::CanShow(const wxString& s, const wxPdfEncoding* encoding) const
 {
@@ -166,28 +214,55 @@ wxPdfFontDataCore::CanShow(const wxString& s, const wxPdfEncoding* encoding) con
   return canShow;
 }
 
+void
+wxPdfFontDataCore::CreateCoverage(const wxPdfEncoding* encoding, wxPdfGlyphSet& coverage) const
+{
+  const wxPdfChar2GlyphMap* usedMap = NULL;
+  if (encoding != NULL)
+  {
+    usedMap = encoding->GetEncodingMap();
+  }
+  if (usedMap == NULL)
+  {
+    usedMap = m_encoding->GetEncodingMap();
+  }
+  if (usedMap != NULL)
+  {
+    wxPdfChar2GlyphMap::const_iterator charIter;
+    for (charIter = usedMap->begin(); charIter != usedMap->end(); ++charIter)
+    {
+      coverage.Add(charIter->first);
+    }
+  }
+  else
+  {
+    // Without encoding map all characters are accepted
+    CreateFullCoverage(coverage);
+  }
+}
+
 wxString
 wxPdfFontDataCore::ConvertCID2GID(const wxString& s,
                                   const wxPdfEncoding* encoding,
-                                  wxPdfSortedArrayInt* usedGlyphs,
+                                  wxPdfGlyphSet* usedGlyphs,
                                   wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   // No conversion from cid to gid
   wxUnusedVar(usedGlyphs);
   wxUnusedVar(subsetGlyphs);
 #if wxUSE_UNICODE
-  const wxPdfChar2GlyphMap* convMap = FindEncodingMap(encoding);
+  const wxPdfEncodingConv* conv = FindEncodingConv(encoding);
   wxString t;
-  if (convMap != NULL)
+  if (conv != NULL)
   {
-    wxPdfChar2GlyphMap::const_iterator charIter;
+    t.reserve(s.length());
+    wxUint32 code;
     wxString::const_iterator ch;
     for (ch = s.begin(); ch != s.end(); ++ch)
     {
-      charIter = (*convMap).find(*ch);
-      if (charIter != (*convMap).end())
+      if (conv->Map((wxUint32) (*ch).GetValue(), code))
       {
-        t.Append(wxUniChar(charIter->second));
+        t.Append(wxUniChar(code));
       }
       else
       {
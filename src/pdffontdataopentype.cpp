@@ -179,9 +179,17 @@ wxPdfFontDataOpenTypeUnicode::LoadFontMetrics(wxXmlNode* root)
     }
     child = child->GetNext();
   }
+  return CompleteFontMetrics(bName && bDesc && bFile && bSize && bWidth);
+}
+
+bool
+wxPdfFontDataOpenTypeUnicode::CompleteFontMetrics(bool complete)
+{
   CreateDefaultEncodingConv();
 
-  m_initialized = (bName && bDesc && bFile && bSize && bWidth);
+  // XML font metrics files of TrueType and OpenType fonts contain no kerning data,
+  // binary font metrics files contain all kerning pairs of the font
+  m_initialized = complete;
   if (m_initialized)
   {
     wxFileName fileName(m_file);
@@ -210,7 +218,7 @@ wxPdfFontDataOpenTypeUnicode::LoadFontMetrics(wxXmlNode* root)
     {
       m_initialized = false;
       // usually this should not happen since file accessability was already checked
-      wxLogError(wxString(wxS("wxPdfFontDataOpenTypeUnicode::LoadFontMetrics: ")) +
+      wxLogError(wxString(wxS("wxPdfFontDataOpenTypeUnicode::CompleteFontMetrics: ")) +
                  wxString::Format(_("CTG file '%s' not found."), fileName.GetFullPath().c_str()));
     }
     if (ctgStream)
@@ -328,10 +336,24 @@ wxPdfFontDataOpenTypeUnicode::CanShow(const wxString& s, const wxPdfEncoding* en
   return canShow;
 }
 
+void
+wxPdfFontDataOpenTypeUnicode::CreateCoverage(const wxPdfEncoding* encoding, wxPdfGlyphSet& coverage) const
+{
+  wxUnusedVar(encoding);
+  if (m_gn != NULL)
+  {
+    wxPdfChar2GlyphMap::const_iterator charIter;
+    for (charIter = m_gn->begin(); charIter != m_gn->end(); ++charIter)
+    {
+      coverage.Add(charIter->first);
+    }
+  }
+}
+
 wxString
 wxPdfFontDataOpenTypeUnicode::ConvertCID2GID(const wxString& s,
                                              const wxPdfEncoding* encoding,
-                                             wxPdfSortedArrayInt* usedGlyphs,
+                                             wxPdfGlyphSet* usedGlyphs,
                                              wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(encoding);
@@ -348,7 +370,7 @@ wxPdfFontDataOpenTypeUnicode::ConvertCID2GID(const wxString& s,
       glyph = charIter->second;
       if (doSubsetting)
       {
-        if (usedGlyphs->Index(glyph) != wxNOT_FOUND)
+        if (usedGlyphs->Contains(glyph))
         {
           glyph = (*subsetGlyphs)[glyph];
         }
@@ -373,7 +395,7 @@ wxPdfFontDataOpenTypeUnicode::ConvertCID2GID(const wxString& s,
 wxString
 wxPdfFontDataOpenTypeUnicode::ConvertGlyph(wxUint32 glyph,
                                            const wxPdfEncoding* encoding,
-                                           wxPdfSortedArrayInt* usedGlyphs,
+                                           wxPdfGlyphSet* usedGlyphs,
                                            wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(encoding);
@@ -384,7 +406,7 @@ wxPdfFontDataOpenTypeUnicode::ConvertGlyph(wxUint32 glyph,
     wxUint32 subsetGlyph;
     if (doSubsetting)
     {
-      if (usedGlyphs->Index(glyph) != wxNOT_FOUND)
+      if (usedGlyphs->Contains(glyph))
       {
         glyph = (*subsetGlyphs)[glyph];
       }
@@ -405,10 +427,72 @@ wxPdfFontDataOpenTypeUnicode::ConvertGlyph(wxUint32 glyph,
   return t;
 }
 
+bool
+wxPdfFontDataOpenTypeUnicode::ConvertGlyphs(const wxUint32* glyphs, size_t count, wxUint32* cids,
+                                            const wxPdfEncoding* encoding,
+                                            wxPdfGlyphSet* usedGlyphs,
+                                            wxPdfChar2GlyphMap* subsetGlyphs) const
+{
+  wxUnusedVar(encoding);
+  bool ok = true;
+  bool doSubsetting = usedGlyphs && subsetGlyphs;
+  size_t numGlyphs = (m_gw) ? m_gw->size() : 0;
+  size_t j;
+  for (j = 0; j < count; ++j)
+  {
+    wxUint32 glyph = glyphs[j];
+    if (glyph < numGlyphs)
+    {
+      if (doSubsetting)
+      {
+        if (usedGlyphs->Contains(glyph))
+        {
+          glyph = (*subsetGlyphs)[glyph];
+        }
+        else
+        {
+          wxUint32 subsetGlyph = (wxUint32) usedGlyphs->GetCount();
+          (*subsetGlyphs)[glyph] = subsetGlyph;
+          usedGlyphs->Add(glyph);
+          glyph = subsetGlyph;
+        }
+      }
+      cids[j] = glyph;
+    }
+    else
+    {
+      cids[j] = 0;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+int
+wxPdfFontDataOpenTypeUnicode::GetGlyphWidth(wxUint32 glyph) const
+{
+  return (m_gw && glyph < m_gw->size()) ? (*m_gw)[glyph] : 0;
+}
+
 wxString
-wxPdfFontDataOpenTypeUnicode::GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
+wxPdfFontDataOpenTypeUnicode::GetWidthsAsString(bool subset, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxString s = wxString(wxS("["));
+  if (subset && usedGlyphs && subsetGlyphs && SubsetSupported() && m_gw != NULL)
+  {
+    // Write the widths of all used glyphs, including glyphs without
+    // character mapping, which were used in glyph runs
+    int usedGlyph;
+    for (usedGlyph = usedGlyphs->GetFirst(); usedGlyph != wxNOT_FOUND; usedGlyph = usedGlyphs->GetNext(usedGlyph))
+    {
+      if (usedGlyph != 0)
+      {
+        s += wxString::Format(wxS("%u [%d] "), (*subsetGlyphs)[usedGlyph], GetGlyphWidth(usedGlyph));
+      }
+    }
+    s += wxString(wxS("]"));
+    return s;
+  }
   wxUint32 glyph;
   wxPdfChar2GlyphMap::const_iterator glyphIter;
   wxPdfGlyphWidthMap::iterator charIter;
@@ -424,7 +508,7 @@ wxPdfFontDataOpenTypeUnicode::GetWidthsAsString(bool subset, wxPdfSortedArrayInt
       glyph = 0;
     }
     if (glyph != 0 && (!subset || !usedGlyphs ||
-                       (subset && SubsetSupported() && (usedGlyphs->Index(glyph) != wxNOT_FOUND))))
+                       (subset && SubsetSupported() && usedGlyphs->Contains(glyph))))
     {
       if (subset)
       {
@@ -439,7 +523,7 @@ wxPdfFontDataOpenTypeUnicode::GetWidthsAsString(bool subset, wxPdfSortedArrayInt
 }
 
 size_t
-wxPdfFontDataOpenTypeUnicode::WriteFontData(wxOutputStream* fontData, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+wxPdfFontDataOpenTypeUnicode::WriteFontData(wxOutputStream* fontData, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
 {
 #if defined(__WXMAC__)
 #if wxPDFMACOSX_HAS_CORE_TEXT
@@ -506,15 +590,11 @@ wxPdfFontDataOpenTypeUnicode::WriteFontData(wxOutputStream* fontData, wxPdfSorte
         wxMemoryInputStream* woffStream = nullptr;
         fontFullPath = fileName.GetFullPath();
         fontStream = fontFile->GetStream();
-        if (fileName.GetExt().Lower().IsSameAs(wxS("woff")))
-        {
-          isWoff = true;
-          woffStream = WoffConverter::Convert(fontStream);
-        }
-        else if (fileName.GetExt().Lower().IsSameAs(wxS("woff2")))
+        if (fileName.GetExt().Lower().IsSameAs(wxS("woff")) ||
+            fileName.GetExt().Lower().IsSameAs(wxS("woff2")))
         {
           isWoff = true;
-          woffStream = Woff2Converter::Convert(fontStream);
+          woffStream = WoffFontCache::GetDecodedFont(fontFullPath, fontStream);
         }
         if (isWoff)
         {
@@ -621,7 +701,7 @@ wxPdfFontDataOpenTypeUnicode::WriteFontData(wxOutputStream* fontData, wxPdfSorte
 size_t
 wxPdfFontDataOpenTypeUnicode::WriteUnicodeMap(wxOutputStream* mapData,
                                               const wxPdfEncoding* encoding,
-                                              wxPdfSortedArrayInt* usedGlyphs,
+                                              wxPdfGlyphSet* usedGlyphs,
                                               wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxUnusedVar(encoding);
@@ -631,8 +711,7 @@ wxPdfFontDataOpenTypeUnicode::WriteUnicodeMap(wxOutputStream* mapData,
   {
     if (usedGlyphs)
     {
-      int usedGlyphIndex = usedGlyphs->Index(charIter->second);
-      if (usedGlyphIndex != wxNOT_FOUND)
+      if (usedGlyphs->Contains(charIter->second))
       {
         wxPdfGlyphListEntry* glEntry = new wxPdfGlyphListEntry();
         if (subsetGlyphs)
@@ -670,24 +749,33 @@ wxPdfFontDataOpenTypeUnicode::WriteUnicodeMap(wxOutputStream* mapData,
 size_t
 wxPdfFontDataOpenTypeUnicode::WriteCIDSet(wxOutputStream* setData,
   const wxPdfEncoding* encoding,
-  wxPdfSortedArrayInt* usedGlyphs,
+  wxPdfGlyphSet* usedGlyphs,
   wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxUnusedVar(encoding);
-  wxUnusedVar(usedGlyphs);
-  wxUnusedVar(subsetGlyphs);
 
-  size_t gCount = m_gn->size();
-  size_t gExtra = (gCount % 8) ? 1 : 0;
-  size_t gBytes = gCount / 8 + gExtra;
   unsigned char* cidSet = new unsigned char[8192];
   size_t j;
-  for (j = 0; j < gBytes; j++)
+  for (j = 0; j < 8192; j++)
   {
     cidSet[j] = 0x00;
   }
   cidSet[0] = 0x80;
 
+  // Glyphs used in glyph runs only have no character mapping, include their CIDs
+  if (usedGlyphs && subsetGlyphs)
+  {
+    int usedGlyph;
+    for (usedGlyph = usedGlyphs->GetFirst(); usedGlyph != wxNOT_FOUND; usedGlyph = usedGlyphs->GetNext(usedGlyph))
+    {
+      wxUint32 cid = (*subsetGlyphs)[usedGlyph];
+      if (cid < 0x10000)
+      {
+        cidSet[cid / 8] |= (0x80 >> (cid % 8));
+      }
+    }
+  }
+
   wxPdfChar2GlyphMap::const_iterator c2gMapIter;
   for (c2gMapIter = m_gn->begin(); c2gMapIter != m_gn->end(); ++c2gMapIter)
   {
@@ -26,6 +26,7 @@
 #include <wx/zstream.h>
 
 #include "wx/pdfarraytypes.h"
+#include "wx/pdfencoding.h"
 #include "wx/pdffontdatatruetype.h"
 #include "wx/pdffontparser.h"
 #include "wx/pdffontsubsettruetype.h"
@@ -62,13 +63,18 @@ wxPdfFontDataTrueType::CreateDefaultEncodingConv()
   // Unicode build needs charset conversion
   if (!m_conv)
   {
-    if (m_enc.Length() > 0)
+    // Prefer the table-driven converter for the single-byte font encoding
+    m_conv = wxPdfEncodingConv::Create((m_enc.Length() > 0) ? m_enc : wxString(wxS("iso-8859-1")));
+    if (!m_conv)
     {
-      m_conv = new wxCSConv(m_enc);
-    }
-    else
-    {
-      m_conv = new wxCSConv(wxFONTENCODING_ISO8859_1);
+      if (m_enc.Length() > 0)
+      {
+        m_conv = new wxCSConv(m_enc);
+      }
+      else
+      {
+        m_conv = new wxCSConv(wxFONTENCODING_ISO8859_1);
+      }
     }
   }
 }
@@ -171,17 +177,7 @@ wxPdfFontDataTrueType::LoadFontMetrics(wxXmlNode* root)
     child = child->GetNext();
   }
 
-#if wxUSE_UNICODE
-  CreateDefaultEncodingConv();
-#endif
-
-  m_initialized = (bName && bDesc && bFile && bSize && bWidth);
-  if (m_initialized)
-  {
-    wxFileName fileName(m_file);
-    m_initialized = fileName.MakeAbsolute(m_path) && fileName.FileExists() && fileName.IsFileReadable();
-  }
-  return m_initialized;
+  return CompleteFontMetrics(bName && bDesc && bFile && bSize && bWidth);
 }
 
 double
@@ -245,7 +241,7 @@ wxPdfFontDataTrueType::CanShow(const wxString& s, const wxPdfEncoding* encoding)
 wxString
 wxPdfFontDataTrueType::ConvertCID2GID(const wxString& s,
                                       const wxPdfEncoding* encoding,
-                                      wxPdfSortedArrayInt* usedGlyphs,
+                                      wxPdfGlyphSet* usedGlyphs,
                                       wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(encoding);
@@ -276,10 +272,7 @@ wxPdfFontDataTrueType::ConvertCID2GID(const wxString& s,
       glyphIter = m_gn->find(ch);
       if (glyphIter != m_gn->end())
       {
-        if (usedGlyphs->Index(glyphIter->second) == wxNOT_FOUND)
-        {
-          usedGlyphs->Add(glyphIter->second);
-        }
+        usedGlyphs->Add(glyphIter->second);
       }
     }
     delete [] mbstr;
@@ -288,7 +281,7 @@ wxPdfFontDataTrueType::ConvertCID2GID(const wxString& s,
 }
 
 wxString
-wxPdfFontDataTrueType::GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
+wxPdfFontDataTrueType::GetWidthsAsString(bool subset, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(subset);
   wxUnusedVar(usedGlyphs);
@@ -304,7 +297,7 @@ wxPdfFontDataTrueType::GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedG
 }
 
 size_t
-wxPdfFontDataTrueType::WriteFontData(wxOutputStream* fontData, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+wxPdfFontDataTrueType::WriteFontData(wxOutputStream* fontData, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxUnusedVar(subsetGlyphs);
   wxFSFile* fontFile = nullptr;
@@ -341,17 +334,11 @@ wxPdfFontDataTrueType::WriteFontData(wxOutputStream* fontData, wxPdfSortedArrayI
       bool isWoff = false;
       wxMemoryInputStream* woffStream = nullptr;
       fontStream = fontFile->GetStream();
-      if (fileName.GetExt().Lower().IsSameAs(wxS("woff")))
-      {
-        isWoff = true;
-        woffStream = Woff2Converter::Convert(fontStream);
-      }
-      else if (fileName.GetExt().Lower().IsSameAs(wxS("woff2")))
+      if (fileName.GetExt().Lower().IsSameAs(wxS("woff")) ||
+          fileName.GetExt().Lower().IsSameAs(wxS("woff2")))
       {
         isWoff = true;
-        woffStream = Woff2Converter::Convert(fontStream);
-        fontStream = woffStream;
-        deleteFontStream = true;
+        woffStream = WoffFontCache::GetDecodedFont(fileName.GetFullPath(), fontStream);
       }
       if (isWoff)
       {
@@ -572,9 +559,17 @@ wxPdfFontDataTrueTypeUnicode::LoadFontMetrics(wxXmlNode* root)
     }
     child = child->GetNext();
   }
+  return CompleteFontMetrics(bName && bDesc && bFile && bSize && bWidth);
+}
+
+bool
+wxPdfFontDataTrueTypeUnicode::CompleteFontMetrics(bool complete)
+{
   CreateDefaultEncodingConv();
 
-  m_initialized = (bName && bDesc && bFile && bSize && bWidth);
+  // XML font metrics files of TrueType and OpenType fonts contain no kerning data,
+  // binary font metrics files contain all kerning pairs of the font
+  m_initialized = complete;
   if (m_initialized)
   {
     wxFileName fileName(m_file);
@@ -603,7 +598,7 @@ wxPdfFontDataTrueTypeUnicode::LoadFontMetrics(wxXmlNode* root)
     {
       m_initialized = false;
       // usually this should not happen since file accessability was already checked
-      wxLogError(wxString(wxS("wxPdfFontDataTrueTypeUnicode::LoadFontMetrics: ")) +
+      wxLogError(wxString(wxS("wxPdfFontDataTrueTypeUnicode::CompleteFontMetrics: ")) +
                  wxString::Format(_("CTG file '%s' not found."), fileName.GetFullPath().c_str()));
     }
     if (ctgStream)
@@ -726,10 +721,24 @@ wxPdfFontDataTrueTypeUnicode::CanShow(const wxString& s, const wxPdfEncoding* en
   return canShow;
 }
 
+void
+wxPdfFontDataTrueTypeUnicode::CreateCoverage(const wxPdfEncoding* encoding, wxPdfGlyphSet& coverage) const
+{
+  wxUnusedVar(encoding);
+  if (m_gn != NULL)
+  {
+    wxPdfChar2GlyphMap::const_iterator charIter;
+    for (charIter = m_gn->begin(); charIter != m_gn->end(); ++charIter)
+    {
+      coverage.Add(charIter->first);
+    }
+  }
+}
+
 wxString
 wxPdfFontDataTrueTypeUnicode::ConvertCID2GID(const wxString& s,
                                              const wxPdfEncoding* encoding,
-                                             wxPdfSortedArrayInt* usedGlyphs,
+                                             wxPdfGlyphSet* usedGlyphs,
                                              wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(encoding);
@@ -775,10 +784,7 @@ wxPdfFontDataTrueTypeUnicode::ConvertCID2GID(const wxString& s,
       glyph = charIter->second;
       if (doSubsetting)
       {
-        if (usedGlyphs->Index(glyph) == wxNOT_FOUND)
-        {
-          usedGlyphs->Add(glyph);
-        }
+        usedGlyphs->Add(glyph);
       }
       t.Append(wxUniChar(glyph));
     }
@@ -793,7 +799,7 @@ wxPdfFontDataTrueTypeUnicode::ConvertCID2GID(const wxString& s,
 wxString
 wxPdfFontDataTrueTypeUnicode::ConvertGlyph(wxUint32 glyph,
                                            const wxPdfEncoding* encoding,
-                                           wxPdfSortedArrayInt* usedGlyphs,
+                                           wxPdfGlyphSet* usedGlyphs,
                                            wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(encoding);
@@ -804,10 +810,7 @@ wxPdfFontDataTrueTypeUnicode::ConvertGlyph(wxUint32 glyph,
     bool doSubsetting = usedGlyphs;
     if (doSubsetting)
     {
-      if (usedGlyphs->Index(glyph) == wxNOT_FOUND)
-      {
-        usedGlyphs->Add(glyph);
-      }
+      usedGlyphs->Add(glyph);
     }
     t.Append(wxUniChar(glyph));
   }
@@ -818,11 +821,63 @@ wxPdfFontDataTrueTypeUnicode::ConvertGlyph(wxUint32 glyph,
   return t;
 }
 
+bool
+wxPdfFontDataTrueTypeUnicode::ConvertGlyphs(const wxUint32* glyphs, size_t count, wxUint32* cids,
+                                            const wxPdfEncoding* encoding,
+                                            wxPdfGlyphSet* usedGlyphs,
+                                            wxPdfChar2GlyphMap* subsetGlyphs) const
+{
+  wxUnusedVar(encoding);
+  wxUnusedVar(subsetGlyphs);
+  bool ok = true;
+  size_t numGlyphs = (m_gw) ? m_gw->size() : 0;
+  size_t j;
+  for (j = 0; j < count; ++j)
+  {
+    wxUint32 glyph = glyphs[j];
+    if (glyph < numGlyphs)
+    {
+      if (usedGlyphs)
+      {
+        usedGlyphs->Add(glyph);
+      }
+      cids[j] = glyph;
+    }
+    else
+    {
+      cids[j] = 0;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+int
+wxPdfFontDataTrueTypeUnicode::GetGlyphWidth(wxUint32 glyph) const
+{
+  return (m_gw && glyph < m_gw->size()) ? (*m_gw)[glyph] : 0;
+}
+
 wxString
-wxPdfFontDataTrueTypeUnicode::GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
+wxPdfFontDataTrueTypeUnicode::GetWidthsAsString(bool subset, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(subsetGlyphs);
   wxString s = wxString(wxS("["));
+  if (subset && usedGlyphs && SubsetSupported() && m_gw != NULL)
+  {
+    // Write the widths of all used glyphs, including glyphs without
+    // character mapping, which were used in glyph runs
+    int usedGlyph;
+    for (usedGlyph = usedGlyphs->GetFirst(); usedGlyph != wxNOT_FOUND; usedGlyph = usedGlyphs->GetNext(usedGlyph))
+    {
+      if (usedGlyph != 0)
+      {
+        s += wxString::Format(wxS("%d [%d] "), usedGlyph, GetGlyphWidth(usedGlyph));
+      }
+    }
+    s += wxString(wxS("]"));
+    return s;
+  }
   wxUint32 glyph;
   wxPdfChar2GlyphMap::const_iterator glyphIter;
   wxPdfGlyphWidthMap::iterator charIter;
@@ -838,7 +893,7 @@ wxPdfFontDataTrueTypeUnicode::GetWidthsAsString(bool subset, wxPdfSortedArrayInt
       glyph = 0;
     }
     if (glyph != 0 && (!subset || !usedGlyphs ||
-                       (subset && SubsetSupported() && (usedGlyphs->Index(glyph) != wxNOT_FOUND))))
+                       (subset && SubsetSupported() && usedGlyphs->Contains(glyph))))
     {
       // define a specific width for each individual CID
       s += wxString::Format(wxS("%u [%u] "), glyph, charIter->second);
@@ -849,7 +904,7 @@ wxPdfFontDataTrueTypeUnicode::GetWidthsAsString(bool subset, wxPdfSortedArrayInt
 }
 
 size_t
-wxPdfFontDataTrueTypeUnicode::WriteFontData(wxOutputStream* fontData, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+wxPdfFontDataTrueTypeUnicode::WriteFontData(wxOutputStream* fontData, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
 {
   bool isMacCoreText = false;
   bool deleteFontStream = false;
@@ -913,15 +968,11 @@ wxPdfFontDataTrueTypeUnicode::WriteFontData(wxOutputStream* fontData, wxPdfSorte
         fontStream = fontFile->GetStream();
         deleteFontStream = false;
         fontFullPath = fileName.GetFullPath();
-        if (fileName.GetExt().Lower().IsSameAs(wxS("woff")))
+        if (fileName.GetExt().Lower().IsSameAs(wxS("woff")) ||
+            fileName.GetExt().Lower().IsSameAs(wxS("woff2")))
         {
           isWoff = true;
-          woffStream = Woff2Converter::Convert(fontStream);
-        }
-        else if (fileName.GetExt().Lower().IsSameAs(wxS("woff2")))
-        {
-          isWoff = true;
-          woffStream = Woff2Converter::Convert(fontStream);
+          woffStream = WoffFontCache::GetDecodedFont(fontFullPath, fontStream);
         }
         if (isWoff)
         {
@@ -1017,7 +1068,7 @@ wxPdfFontDataTrueTypeUnicode::WriteFontData(wxOutputStream* fontData, wxPdfSorte
 size_t
 wxPdfFontDataTrueTypeUnicode::WriteUnicodeMap(wxOutputStream* mapData,
                                               const wxPdfEncoding* encoding,
-                                              wxPdfSortedArrayInt* usedGlyphs,
+                                              wxPdfGlyphSet* usedGlyphs,
                                               wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxUnusedVar(encoding);
@@ -1028,7 +1079,7 @@ wxPdfFontDataTrueTypeUnicode::WriteUnicodeMap(wxOutputStream* mapData,
   {
     if (usedGlyphs)
     {
-      if (usedGlyphs->Index(charIter->second) != wxNOT_FOUND)
+      if (usedGlyphs->Contains(charIter->second))
       {
         wxPdfGlyphListEntry* glEntry = new wxPdfGlyphListEntry();
         glEntry->m_gid = charIter->second;
@@ -1059,7 +1110,7 @@ wxPdfFontDataTrueTypeUnicode::WriteUnicodeMap(wxOutputStream* mapData,
 size_t
 wxPdfFontDataTrueTypeUnicode::WriteCIDToGIDMap(wxOutputStream* mapData,
                                                const wxPdfEncoding* encoding,
-                                               wxPdfSortedArrayInt* usedGlyphs,
+                                               wxPdfGlyphSet* usedGlyphs,
                                                wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxUnusedVar(encoding);
@@ -1074,19 +1125,34 @@ wxPdfFontDataTrueTypeUnicode::WriteCIDToGIDMap(wxOutputStream* mapData,
     cc2gn[j] = '\0';
   }
 
-  wxPdfChar2GlyphMap::const_iterator c2gMapIter;
-  for (c2gMapIter = m_gn->begin(); c2gMapIter != m_gn->end(); ++c2gMapIter)
+  // Note: One would expect that CID is used to index the mapping array.
+  // However, wxPdfDocument already replaces CIDs by GIDs on adding text strings
+  // to PDF content. Therefore gid is used as the array index.
+  if (usedGlyphs)
   {
-    wxUint32 gid = c2gMapIter->second;
-    bool setMap = (usedGlyphs) ? (usedGlyphs->Index(gid) != wxNOT_FOUND) : true;
-    // Set GID
-    // Note: One would expect that CID is used to index the mapping array.
-    // However, wxPdfDocument already replaces CIDs by GIDs on adding text strings
-    // to PDF content. Therefore gid is used as the array index.
-    if (setMap && gid < 0xFFFF)
+    // All used glyphs are mapped, including glyphs without character
+    // mapping (ligatures, alternates), which were used in glyph runs
+    int gid;
+    for (gid = usedGlyphs->GetFirst(); gid != wxNOT_FOUND; gid = usedGlyphs->GetNext(gid))
     {
-      cc2gn[2 * gid] = (gid >> 8) & 0xFF;
-      cc2gn[2 * gid + 1] = gid & 0xFF;
+      if (gid < 0xFFFF)
+      {
+        cc2gn[2 * gid] = (gid >> 8) & 0xFF;
+        cc2gn[2 * gid + 1] = gid & 0xFF;
+      }
+    }
+  }
+  else
+  {
+    wxPdfChar2GlyphMap::const_iterator c2gMapIter;
+    for (c2gMapIter = m_gn->begin(); c2gMapIter != m_gn->end(); ++c2gMapIter)
+    {
+      wxUint32 gid = c2gMapIter->second;
+      if (gid < 0xFFFF)
+      {
+        cc2gn[2 * gid] = (gid >> 8) & 0xFF;
+        cc2gn[2 * gid + 1] = gid & 0xFF;
+      }
     }
   }
 
@@ -1102,38 +1168,45 @@ wxPdfFontDataTrueTypeUnicode::WriteCIDToGIDMap(wxOutputStream* mapData,
 size_t
 wxPdfFontDataTrueTypeUnicode::WriteCIDSet(wxOutputStream* setData,
                                           const wxPdfEncoding* encoding,
-                                          wxPdfSortedArrayInt* usedGlyphs,
+                                          wxPdfGlyphSet* usedGlyphs,
                                           wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxUnusedVar(encoding);
   wxUnusedVar(subsetGlyphs);
 
-  size_t gCount = m_gn->size();
-  size_t gExtra = (gCount % 8) ? 1 : 0;
-  size_t gBytes = gCount / 8 + gExtra;
   unsigned char* cidSet = new unsigned char[8192];
   size_t j;
-  for (j = 0; j < gBytes; j++)
+  for (j = 0; j < 8192; j++)
   {
     cidSet[j] = 0x00;
   }
   cidSet[0] = 0x80;
 
-  wxPdfChar2GlyphMap::const_iterator c2gMapIter;
-  for (c2gMapIter = m_gn->begin(); c2gMapIter != m_gn->end(); ++c2gMapIter)
+  // Note: One would expect that CID is used to index the mapping array.
+  // However, wxPdfDocument already replaces CIDs by GIDs on adding text strings
+  // to PDF content. Therefore gid is used as the array index.
+  if (usedGlyphs)
   {
-    wxUint32 gid = c2gMapIter->second;
-    bool setMap = (usedGlyphs) ? (usedGlyphs->Index(gid) != wxNOT_FOUND) : true;
-    // Set GID
-    // Note: One would expect that CID is used to index the mapping array.
-    // However, wxPdfDocument already replaces CIDs by GIDs on adding text strings
-    // to PDF content. Therefore gid is used as the array index.
-    if (setMap)
+    // All used glyphs are included, also those used in glyph runs only
+    int gid;
+    for (gid = usedGlyphs->GetFirst(); gid != wxNOT_FOUND; gid = usedGlyphs->GetNext(gid))
     {
-      size_t bytePos = gid / 8;
-      size_t bitPos = gid % 8;
-      unsigned char mask = (0x80 >> bitPos);
-      cidSet[bytePos] |= mask;
+      if (gid < 0x10000)
+      {
+        cidSet[gid / 8] |= (0x80 >> (gid % 8));
+      }
+    }
+  }
+  else
+  {
+    wxPdfChar2GlyphMap::const_iterator c2gMapIter;
+    for (c2gMapIter = m_gn->begin(); c2gMapIter != m_gn->end(); ++c2gMapIter)
+    {
+      wxUint32 gid = c2gMapIter->second;
+      if (gid < 0x10000)
+      {
+        cidSet[gid / 8] |= (0x80 >> (gid % 8));
+      }
     }
   }
 
@@ -37,12 +37,13 @@ wxPdfFontDataType0::wxPdfFontDataType0()
   m_type = wxS("Type0");
   m_conv = NULL;
   m_hwRange = false;
+  m_cwArray = NULL;
 }
 
 wxPdfFontDataType0::wxPdfFontDataType0(const wxString& family, const wxString& name,
                                        const wxString& encoding, const wxString& ordering,
                                        const wxString& supplement, const wxString& cmap,
-                                       short* cwArray, const wxPdfFontDescription& desc)
+                                       const short* cwArray, const wxPdfFontDescription& desc)
   : wxPdfFontData()
 {
   m_type   = wxS("Type0");
@@ -58,15 +59,8 @@ wxPdfFontDataType0::wxPdfFontDataType0(const wxString& family, const wxString& n
   m_supplement = supplement;
   m_cmap = cmap;
 
-  if (cwArray != NULL)
-  {
-    m_cw = new wxPdfGlyphWidthMap();
-    int j;
-    for (j = 32; j < 127; ++j)
-    {
-      (*m_cw)[j] = cwArray[j-32];
-    }
-  }
+  // The widths of built-in fonts are served directly from the static table
+  m_cwArray = cwArray;
 
   CreateDefaultEncodingConv();
   if (m_ordering == wxS("Japan1"))
@@ -194,6 +188,12 @@ wxPdfFontDataType0::LoadFontMetrics(wxXmlNode* root)
     }
     child = child->GetNext();
   }
+  return CompleteFontMetrics(bName && bDesc && bRegistry && bCmap && bWidth);
+}
+
+bool
+wxPdfFontDataType0::CompleteFontMetrics(bool complete)
+{
   CreateDefaultEncodingConv();
   if (m_ordering == wxS("Japan1"))
   {
@@ -201,12 +201,13 @@ wxPdfFontDataType0::LoadFontMetrics(wxXmlNode* root)
     m_hwFirst = 0xff61;
     m_hwLast  = 0xff9f;
   }
-  m_initialized = (bName && bDesc && bRegistry && bCmap && bWidth);
+  // Type0 fonts have no font file, but require the CMap and the registry
+  m_initialized = complete && m_cmap.Length() > 0 && m_ordering.Length() > 0 && m_supplement.Length() > 0;
   return m_initialized;
 }
 
 wxString
-wxPdfFontDataType0::GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
+wxPdfFontDataType0::GetWidthsAsString(bool subset, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(subset);
   wxUnusedVar(usedGlyphs);
@@ -215,7 +216,7 @@ wxPdfFontDataType0::GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyp
   int i;
   for (i = 32; i <= 126; i++)
   {
-    s += wxString::Format(wxS("%u "), (*m_cw)[i]);
+    s += wxString::Format(wxS("%u "), (m_cwArray != NULL) ? m_cwArray[i-32] : (*m_cw)[i]);
   }
   s += wxString(wxS("]"));
   if (HasHalfWidthRange())
@@ -240,8 +241,12 @@ wxPdfFontDataType0::GetStringWidth(const wxString& s, const wxPdfEncoding* encod
     const wxUniChar c = *ch;
     if (c >= 0 && c < 128)
     {
-      wxPdfGlyphWidthMap::iterator charIter = (*m_cw).find(c);
-      if (charIter != (*m_cw).end())
+      wxPdfGlyphWidthMap::iterator charIter;
+      if (m_cwArray != NULL)
+      {
+        w += (c >= 32 && c <= 126) ? m_cwArray[c - 32] : m_desc.GetMissingWidth();
+      }
+      else if ((charIter = (*m_cw).find(c)) != (*m_cw).end())
       {
         w += charIter->second;
       }
@@ -298,10 +303,32 @@ wxPdfFontDataType0::CanShow(const wxString& s, const wxPdfEncoding* encoding) co
   return canShow;
 }
 
+void
+wxPdfFontDataType0::CreateCoverage(const wxPdfEncoding* encoding, wxPdfGlyphSet& coverage) const
+{
+  wxUnusedVar(encoding);
+  if (m_encodingChecker != NULL)
+  {
+    wxUint32 cc;
+    for (cc = 0; cc < 0x10000; ++cc)
+    {
+      if (m_encodingChecker->IsIncluded(cc))
+      {
+        coverage.Add(cc);
+      }
+    }
+  }
+  else
+  {
+    // Without encoding checker all characters are accepted
+    CreateFullCoverage(coverage);
+  }
+}
+
 wxString
 wxPdfFontDataType0::ConvertCID2GID(const wxString& s,
                                    const wxPdfEncoding* encoding,
-                                   wxPdfSortedArrayInt* usedGlyphs,
+                                   wxPdfGlyphSet* usedGlyphs,
                                    wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   // No conversion from cid to gid
@@ -70,7 +70,11 @@ wxPdfFontDataType1::CreateDefaultEncodingConv()
   // Unicode build needs charset conversion
   if (m_conv == NULL)
   {
-    m_conv = new wxCSConv(wxFONTENCODING_ISO8859_1);
+    m_conv = wxPdfEncodingConv::Create(wxS("iso-8859-1"));
+    if (m_conv == NULL)
+    {
+      m_conv = new wxCSConv(wxFONTENCODING_ISO8859_1);
+    }
   }
 }
 #endif
@@ -156,17 +160,7 @@ wxPdfFontDataType1::LoadFontMetrics(wxXmlNode* root)
     child = child->GetNext();
   }
 
-#if wxUSE_UNICODE
-  CreateDefaultEncodingConv();
-#endif
-
-  m_initialized = (bName && bDesc && bFile && bSize && bWidth);
-  if (m_initialized)
-  {
-    wxFileName fileName(m_file);
-    m_initialized = fileName.MakeAbsolute(m_path) && fileName.FileExists() && fileName.IsFileReadable();
-  }
-  return m_initialized;
+  return CompleteFontMetrics(bName && bDesc && bFile && bSize && bWidth);
 }
 
 bool
@@ -284,27 +278,46 @@ wxPdfFontDataType1::CanShow(const wxString& s, const wxPdfEncoding* encoding) co
   return canShow;
 }
 
+void
+wxPdfFontDataType1::CreateCoverage(const wxPdfEncoding* encoding, wxPdfGlyphSet& coverage) const
+{
+  const wxPdfChar2GlyphMap* convMap = FindEncodingMap(encoding);
+  if (convMap != NULL)
+  {
+    wxPdfChar2GlyphMap::const_iterator charIter;
+    for (charIter = convMap->begin(); charIter != convMap->end(); ++charIter)
+    {
+      coverage.Add(charIter->first);
+    }
+  }
+  else
+  {
+    // Without encoding map all characters are accepted
+    CreateFullCoverage(coverage);
+  }
+}
+
 wxString
 wxPdfFontDataType1::ConvertCID2GID(const wxString& s,
                                    const wxPdfEncoding* encoding,
-                                   wxPdfSortedArrayInt* usedGlyphs,
+                                   wxPdfGlyphSet* usedGlyphs,
                                    wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(usedGlyphs);
   wxUnusedVar(subsetGlyphs);
 
   wxString t;
-  const wxPdfChar2GlyphMap* convMap = FindEncodingMap(encoding);
-  if (convMap != NULL)
+  const wxPdfEncodingConv* conv = FindEncodingConv(encoding);
+  if (conv != NULL)
   {
-    wxPdfChar2GlyphMap::const_iterator charIter;
+    t.reserve(s.length());
+    wxUint32 code;
     wxString::const_iterator ch;
     for (ch = s.begin(); ch != s.end(); ++ch)
     {
-      charIter = (*convMap).find(*ch);
-      if (charIter != (*convMap).end())
+      if (conv->Map((wxUint32) (*ch).GetValue(), code))
       {
-        t.Append(wxUniChar(charIter->second));
+        t.Append(wxUniChar(code));
       }
       else
       {
@@ -320,7 +333,7 @@ wxPdfFontDataType1::ConvertCID2GID(const wxString& s,
 }
 
 wxString
-wxPdfFontDataType1::GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
+wxPdfFontDataType1::GetWidthsAsString(bool subset, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(subset);
   wxUnusedVar(usedGlyphs);
@@ -337,7 +350,7 @@ wxPdfFontDataType1::GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyp
 
 #if wxUSE_UNICODE
 wxString
-wxPdfFontDataType1::GetWidthsAsString(const wxArrayString& glyphNames, bool subset, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
+wxPdfFontDataType1::GetWidthsAsString(const wxArrayString& glyphNames, bool subset, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxUnusedVar(subset);
   wxUnusedVar(usedGlyphs);
@@ -489,7 +502,7 @@ wxPdfFontDataType1::CompressFontData(wxOutputStream* fontData, wxInputStream* pf
 }
 
 size_t
-wxPdfFontDataType1::WriteFontData(wxOutputStream* fontData, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+wxPdfFontDataType1::WriteFontData(wxOutputStream* fontData, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxUnusedVar(usedGlyphs);
   wxUnusedVar(subsetGlyphs);
@@ -555,7 +568,7 @@ wxPdfFontDataType1::WriteFontData(wxOutputStream* fontData, wxPdfSortedArrayInt*
 size_t
 wxPdfFontDataType1::WriteUnicodeMap(wxOutputStream* mapData,
                                     const wxPdfEncoding* encoding,
-                                    wxPdfSortedArrayInt* usedGlyphs,
+                                    wxPdfGlyphSet* usedGlyphs,
                                     wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxUnusedVar(usedGlyphs);
@@ -26,18 +26,14 @@
 #include "wx/pdffont.h"
 #include "wx/pdffontdetails.h"
 
-static int
-CompareInts(int n1, int n2)
-{
-  return n1 - n2;
-}
-
 wxPdfFontDetails::wxPdfFontDetails(int index, const wxPdfFont& font)
-  : m_index(index), m_n(0), m_fn(0), m_ndiff(0), m_font(font)
+  : m_index(index), m_n(0), m_fn(0), m_ndiff(0), m_font(font),
+    m_preparedFontData(NULL), m_preparedUnicodeMap(NULL),
+    m_preparedCIDToGIDMap(NULL), m_preparedCIDSet(NULL), m_preparedFontSize1(0)
 {
   if (m_font.SubsetRequested())
   {
-    m_usedGlyphs = new wxPdfSortedArrayInt(CompareInts);
+    m_usedGlyphs = new wxPdfGlyphSet();
     m_usedGlyphs->Add(0);
     if (m_font.GetType().IsSameAs(wxS("TrueTypeUnicode")) ||
         m_font.GetType().IsSameAs(wxS("OpenTypeUnicode")))
@@ -67,6 +63,10 @@ wxPdfFontDetails::~wxPdfFontDetails()
   {
     delete m_subsetGlyphs;
   }
+  delete m_preparedFontData;
+  delete m_preparedUnicodeMap;
+  delete m_preparedCIDToGIDMap;
+  delete m_preparedCIDSet;
 }
 
 wxPdfFontDetails::wxPdfFontDetails(const wxPdfFontDetails&)
@@ -183,36 +183,164 @@ wxPdfFontDetails::ConvertGlyph(wxUint32 glyph)
   return m_font.ConvertGlyph(glyph, m_usedGlyphs, m_subsetGlyphs);
 }
 
+bool
+wxPdfFontDetails::ConvertGlyphs(const wxUint32* glyphs, size_t count, wxUint32* cids)
+{
+  bool ok = m_font.ConvertGlyphs(glyphs, count, cids, m_usedGlyphs, m_subsetGlyphs);
+  if (m_usedGlyphs == NULL)
+  {
+    // Without subsetting the glyphs are not tracked as used glyphs
+    size_t j;
+    for (j = 0; j < count; ++j)
+    {
+      if (cids[j] != 0)
+      {
+        m_runGlyphs.Add(glyphs[j]);
+      }
+    }
+  }
+  return ok;
+}
+
+int
+wxPdfFontDetails::GetGlyphWidth(wxUint32 glyph) const
+{
+  return m_font.GetGlyphWidth(glyph);
+}
+
 wxString
 wxPdfFontDetails::GetWidthsAsString() const
 {
-  return m_font.GetWidthsAsString(m_font.IsEmbedded(), m_usedGlyphs, m_subsetGlyphs);
+  // With subsetting the glyphs written by glyph number are contained in the set
+  // of used glyphs, and their widths are written by the font data
+  wxString widths = m_font.GetWidthsAsString(m_font.IsEmbedded(), m_usedGlyphs, m_subsetGlyphs);
+  if (!m_runGlyphs.IsEmpty() && widths.EndsWith(wxS("]")))
+  {
+    // Add the widths of the glyphs which are not reachable through the character map
+    wxPdfGlyphSet mappedGlyphs;
+    m_font.GetMappedGlyphs(mappedGlyphs);
+    widths.RemoveLast();
+    int glyph;
+    for (glyph = m_runGlyphs.GetFirst(); glyph != wxNOT_FOUND; glyph = m_runGlyphs.GetNext(glyph))
+    {
+      if (!mappedGlyphs.Contains(glyph))
+      {
+        widths += wxString::Format(wxS("%d [%d] "), glyph, m_font.GetGlyphWidth((wxUint32) glyph));
+      }
+    }
+    widths += wxS("]");
+  }
+  return widths;
+}
+
+// Copy a prepared stream to the output stream and release it
+static void
+WritePreparedStream(wxMemoryOutputStream*& prepared, wxOutputStream* outData)
+{
+  wxMemoryInputStream tmp(*prepared);
+  outData->Write(tmp);
+  delete prepared;
+  prepared = NULL;
 }
 
 size_t
 wxPdfFontDetails::WriteFontData(wxOutputStream* fontData)
 {
-  return m_font.WriteFontData(fontData, m_usedGlyphs, m_subsetGlyphs);
+  size_t fontSize1;
+  if (m_preparedFontData != NULL)
+  {
+    fontSize1 = m_preparedFontSize1;
+    WritePreparedStream(m_preparedFontData, fontData);
+  }
+  else
+  {
+    fontSize1 = m_font.WriteFontData(fontData, m_usedGlyphs, m_subsetGlyphs);
+  }
+  return fontSize1;
 }
 
 size_t
 wxPdfFontDetails::WriteUnicodeMap(wxOutputStream* mapData)
 {
+  if (m_preparedUnicodeMap != NULL)
+  {
+    WritePreparedStream(m_preparedUnicodeMap, mapData);
+    return 0;
+  }
   return m_font.WriteUnicodeMap(mapData, m_usedGlyphs, m_subsetGlyphs);
 }
 
 size_t
 wxPdfFontDetails::WriteCIDToGIDMap(wxOutputStream* mapData)
 {
+  if (m_preparedCIDToGIDMap != NULL)
+  {
+    WritePreparedStream(m_preparedCIDToGIDMap, mapData);
+    return 0;
+  }
+  return WriteFontCIDToGIDMap(mapData);
+}
+
+size_t
+wxPdfFontDetails::WriteFontCIDToGIDMap(wxOutputStream* mapData)
+{
+  if (m_usedGlyphs == NULL && !m_runGlyphs.IsEmpty())
+  {
+    // Without subsetting all glyphs of the character map are mapped;
+    // the glyphs written by glyph number are added
+    wxPdfGlyphSet glyphs;
+    m_font.GetMappedGlyphs(glyphs);
+    int glyph;
+    for (glyph = m_runGlyphs.GetFirst(); glyph != wxNOT_FOUND; glyph = m_runGlyphs.GetNext(glyph))
+    {
+      glyphs.Add(glyph);
+    }
+    return m_font.WriteCIDToGIDMap(mapData, &glyphs, NULL);
+  }
   return m_font.WriteCIDToGIDMap(mapData, m_usedGlyphs, m_subsetGlyphs);
 }
 
 size_t
 wxPdfFontDetails::WriteCIDSet(wxOutputStream* setData)
 {
+  if (m_preparedCIDSet != NULL)
+  {
+    WritePreparedStream(m_preparedCIDSet, setData);
+    return 0;
+  }
   return m_font.WriteCIDSet(setData, m_usedGlyphs, m_subsetGlyphs);
 }
 
+void
+wxPdfFontDetails::PrepareFontData()
+{
+  // The order of the steps is relevant, since subsetting the font program
+  // may add glyphs (i.e. components of composite glyphs) to the set of used glyphs
+  wxString type = m_font.GetType();
+  bool isUnicode = type.IsSameAs(wxS("TrueTypeUnicode")) || type.IsSameAs(wxS("OpenTypeUnicode"));
+  if (m_font.IsEmbedded() && m_preparedFontData == NULL)
+  {
+    m_preparedFontData = new wxMemoryOutputStream();
+    m_preparedFontSize1 = m_font.WriteFontData(m_preparedFontData, m_usedGlyphs, m_subsetGlyphs);
+  }
+  if (m_preparedUnicodeMap == NULL &&
+      (isUnicode || (type.IsSameAs(wxS("Type1")) && m_font.HasEncodingMap())))
+  {
+    m_preparedUnicodeMap = new wxMemoryOutputStream();
+    m_font.WriteUnicodeMap(m_preparedUnicodeMap, m_usedGlyphs, m_subsetGlyphs);
+  }
+  if (m_preparedCIDToGIDMap == NULL && type.IsSameAs(wxS("TrueTypeUnicode")))
+  {
+    m_preparedCIDToGIDMap = new wxMemoryOutputStream();
+    WriteFontCIDToGIDMap(m_preparedCIDToGIDMap);
+  }
+  if (m_preparedCIDSet == NULL && isUnicode && m_font.IsEmbedded() && m_font.SubsetRequested())
+  {
+    m_preparedCIDSet = new wxMemoryOutputStream();
+    m_font.WriteCIDSet(m_preparedCIDSet, m_usedGlyphs, m_subsetGlyphs);
+  }
+}
+
 #if wxUSE_UNICODE
 
 wxMBConv*
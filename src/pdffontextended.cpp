@@ -242,7 +242,7 @@ wxPdfFontExtended::GetSupplement() const
 }
 
 wxString
-wxPdfFontExtended::GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
+wxPdfFontExtended::GetWidthsAsString(bool subset, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs) const
 {
   wxString widths = wxEmptyString;
   if (m_fontData != NULL)
@@ -261,12 +261,30 @@ wxPdfFontExtended::GetWidthsAsString(bool subset, wxPdfSortedArrayInt* usedGlyph
   return widths;
 }
 
+void
+wxPdfFontExtended::GetMappedGlyphs(wxPdfGlyphSet& glyphs) const
+{
+  const wxPdfChar2GlyphMap* gn = (m_fontData != NULL) ? m_fontData->GetChar2GlyphMap() : NULL;
+  if (gn != NULL)
+  {
+    wxPdfChar2GlyphMap::const_iterator glyphIter;
+    for (glyphIter = gn->begin(); glyphIter != gn->end(); ++glyphIter)
+    {
+      glyphs.Add(glyphIter->second);
+    }
+  }
+}
+
 double
 wxPdfFontExtended::GetStringWidth(const wxString& s, bool withKerning, double charSpacing)
 {
   double width = 0;
   if (m_fontData != NULL)
   {
+    if (withKerning)
+    {
+      m_fontData->InitializeOnce();
+    }
     width = m_fontData->GetStringWidth(s, m_encoding, withKerning, charSpacing);
   }
   return width;
@@ -275,7 +293,12 @@ wxPdfFontExtended::GetStringWidth(const wxString& s, bool withKerning, double ch
 wxArrayInt
 wxPdfFontExtended::GetKerningWidthArray(const wxString& s) const
 {
-  return m_fontData->GetKerningWidthArray(s);
+  wxArrayInt widths;
+  if (m_fontData != NULL && m_fontData->InitializeOnce())
+  {
+    widths = m_fontData->GetKerningWidthArray(s);
+  }
+  return widths;
 }
 
 bool
@@ -289,8 +312,19 @@ wxPdfFontExtended::CanShow(const wxString& s) const
   return canShow;
 }
 
+const wxPdfGlyphSet*
+wxPdfFontExtended::GetCoverage() const
+{
+  const wxPdfGlyphSet* coverage = NULL;
+  if (m_fontData != NULL && m_fontData->InitializeOnce())
+  {
+    coverage = m_fontData->GetCoverage(m_encoding);
+  }
+  return coverage;
+}
+
 wxString
-wxPdfFontExtended::ConvertCID2GID(const wxString& s, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+wxPdfFontExtended::ConvertCID2GID(const wxString& s, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxString sConv = wxEmptyString;
   if (m_fontData != NULL)
@@ -301,7 +335,7 @@ wxPdfFontExtended::ConvertCID2GID(const wxString& s, wxPdfSortedArrayInt* usedGl
 }
 
 wxString
-wxPdfFontExtended::ConvertGlyph(wxUint32 glyph, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+wxPdfFontExtended::ConvertGlyph(wxUint32 glyph, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
 {
   wxString sConv = wxEmptyString;
   if (m_fontData != NULL)
@@ -311,6 +345,24 @@ wxPdfFontExtended::ConvertGlyph(wxUint32 glyph, wxPdfSortedArrayInt* usedGlyphs,
   return sConv;
 }
 
+bool
+wxPdfFontExtended::ConvertGlyphs(const wxUint32* glyphs, size_t count, wxUint32* cids,
+                                 wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+{
+  bool ok = false;
+  if (m_fontData != NULL)
+  {
+    ok = m_fontData->ConvertGlyphs(glyphs, count, cids, m_encoding, usedGlyphs, subsetGlyphs);
+  }
+  return ok;
+}
+
+int
+wxPdfFontExtended::GetGlyphWidth(wxUint32 glyph) const
+{
+  return (m_fontData != NULL) ? m_fontData->GetGlyphWidth(glyph) : 0;
+}
+
 bool
 wxPdfFontExtended::IsEmbedded() const
 {
@@ -324,13 +376,13 @@ wxPdfFontExtended::SupportsSubset() const
 }
 
 size_t
-wxPdfFontExtended::WriteFontData(wxOutputStream* fontData, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+wxPdfFontExtended::WriteFontData(wxOutputStream* fontData, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
 {
   return (m_fontData != NULL) ? m_fontData->WriteFontData(fontData, usedGlyphs, subsetGlyphs) : 0;
 }
 
 size_t
-wxPdfFontExtended::WriteUnicodeMap(wxOutputStream* mapData, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+wxPdfFontExtended::WriteUnicodeMap(wxOutputStream* mapData, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
 {
   size_t maplen = 0;
   if (m_fontData != NULL)
@@ -341,7 +393,7 @@ wxPdfFontExtended::WriteUnicodeMap(wxOutputStream* mapData, wxPdfSortedArrayInt*
 }
 
 size_t
-wxPdfFontExtended::WriteCIDToGIDMap(wxOutputStream* mapData, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+wxPdfFontExtended::WriteCIDToGIDMap(wxOutputStream* mapData, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
 {
   size_t maplen = 0;
   if (m_fontData != NULL)
@@ -352,7 +404,7 @@ wxPdfFontExtended::WriteCIDToGIDMap(wxOutputStream* mapData, wxPdfSortedArrayInt
 }
 
 size_t
-wxPdfFontExtended::WriteCIDSet(wxOutputStream* setData, wxPdfSortedArrayInt* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
+wxPdfFontExtended::WriteCIDSet(wxOutputStream* setData, wxPdfGlyphSet* usedGlyphs, wxPdfChar2GlyphMap* subsetGlyphs)
 {
   size_t maplen = 0;
   if (m_fontData != NULL)
@@ -23,6 +23,7 @@
 // includes
 #include <wx/dir.h>
 #include <wx/dynarray.h>
+#include <wx/file.h>
 #include <wx/filefn.h>
 #include <wx/filename.h>
 #include <wx/filesys.h>
@@ -41,6 +42,8 @@
 #include "wx/pdffontparsertruetype.h"
 #include "wx/pdffontparsertype1.h"
 
+#include "woff/woffconverter.h"
+
 #if defined(__WXMSW__)
   #include <wx/msw/registry.h>
 //  #include "wx/msw/private.h"
@@ -92,6 +95,22 @@ wxPdfFontData::GetWinEncodingConv()
   return ms_winEncoding;
 }
 
+bool
+wxPdfFontData::InitializeOnce()
+{
+  // The acquire load pairs with the store of the flag after the font data have been filled in
+  bool ok = IsInitialized();
+  if (!ok)
+  {
+#if wxUSE_THREADS
+    wxCriticalSectionLocker locker(gs_csFontManager);
+#endif
+    // Initialize checks the flag again under the lock
+    ok = Initialize();
+  }
+  return ok;
+}
+
 int
 wxPdfFontData::IncrementRefCount()
 {
@@ -175,6 +194,350 @@ private:
   wxPdfFontData* m_fontData;
 };
 
+// --- Font registry index
+
+/// Class representing the identification data of a font in the font registry index
+class wxPdfFontRegistryEntry
+{
+public:
+  wxPdfFontRegistryEntry()
+    : m_style(wxPDF_FONTSTYLE_REGULAR), m_embedSupported(false), m_subsetSupported(false),
+      m_cffOffset(0), m_cffLength(0)
+  {
+  }
+
+  wxString      m_type;            ///< Font type (empty if the font could not be identified)
+  wxString      m_name;            ///< PostScript name of the font
+  wxString      m_family;          ///< Font family
+  wxArrayString m_fullNames;       ///< Full names of the font
+  int           m_style;           ///< Font style
+  bool          m_embedSupported;  ///< Flag whether embedding is allowed
+  bool          m_subsetSupported; ///< Flag whether subsetting is allowed
+  size_t        m_cffOffset;       ///< Offset of the CFF table (OpenType fonts only)
+  size_t        m_cffLength;       ///< Length of the CFF table (OpenType fonts only)
+};
+
+/// Hashmap class for mapping font indices to font registry entries
+WX_DECLARE_HASH_MAP(long, wxPdfFontRegistryEntry, wxIntegerHash, wxIntegerEqual, wxPdfFontRegistryEntryMap);
+
+/// Class representing a font file in the font registry index
+class wxPdfFontRegistryFile
+{
+public:
+  wxPdfFontRegistryFile()
+    : m_size(0), m_modified(0), m_fontCount(-1), m_checked(false)
+  {
+  }
+
+  wxULongLong               m_size;      ///< Size of the font file
+  wxLongLong                m_modified;  ///< Modification time of the font file
+  int                       m_fontCount; ///< Number of fonts in a font collection (-1 if unknown)
+  bool                      m_checked;   ///< Flag whether the file was checked for modifications
+  wxPdfFontRegistryEntryMap m_fonts;     ///< Identified fonts of the file
+};
+
+/// Hashmap class for mapping font file names to font registry files
+WX_DECLARE_STRING_HASH_MAP(wxPdfFontRegistryFile, wxPdfFontRegistryFileMap);
+
+/// Class representing the persistent font registry index
+class wxPdfFontRegistryIndex
+{
+public:
+  wxPdfFontRegistryIndex(const wxString& fileName)
+    : m_fileName(fileName), m_modified(false)
+  {
+  }
+
+  /// Load the index file
+  bool Load();
+
+  /// Save the index file
+  bool Save();
+
+  /// Check whether the index was modified since it was loaded or saved
+  bool IsModified() const { return m_modified; }
+
+  /// Find the registry entry of a font
+  const wxPdfFontRegistryEntry* FindFont(const wxString& fontFileName, int fontIndex);
+
+  /// Add the identification data of a font (NULL if the font could not be identified)
+  void AddFont(const wxString& fontFileName, int fontIndex, const wxPdfFontData* fontData);
+
+  /// Get the number of fonts in a font collection (-1 if unknown)
+  int GetFontCount(const wxString& fontFileName);
+
+  /// Set the number of fonts in a font collection
+  void SetFontCount(const wxString& fontFileName, int fontCount);
+
+private:
+  /// Get the registry file, discarding outdated data
+  wxPdfFontRegistryFile* GetFile(const wxString& fontFileName, bool create);
+
+  wxString                 m_fileName; ///< Name of the index file
+  bool                     m_modified; ///< Flag whether the index was modified
+  wxPdfFontRegistryFileMap m_files;    ///< Font files in the index
+};
+
+// Version of the font registry index format
+static const wxString gs_fontRegistryVersion = wxS("1");
+
+bool
+wxPdfFontRegistryIndex::Load()
+{
+  bool ok = true;
+  m_files.clear();
+  m_modified = false;
+  if (wxFileName::FileExists(m_fileName))
+  {
+    wxXmlDocument registry;
+    bool loaded;
+    {
+      wxLogNull noLog;
+      loaded = registry.Load(m_fileName);
+    }
+    if (loaded && registry.IsOk() &&
+        registry.GetRoot()->GetName().IsSameAs(wxS("wxpdfdoc-font-registry")) &&
+        registry.GetRoot()->GetAttribute(wxS("version"), wxS("")).IsSameAs(gs_fontRegistryVersion))
+    {
+      wxXmlNode* fileNode = registry.GetRoot()->GetChildren();
+      while (fileNode)
+      {
+        wxString fileName;
+        wxULongLong_t size;
+        wxLongLong_t modified;
+        long fontCount;
+        if (fileNode->GetName().IsSameAs(wxS("file")) &&
+            fileNode->GetAttribute(wxS("name"), &fileName) &&
+            fileNode->GetAttribute(wxS("size"), wxS("")).ToULongLong(&size) &&
+            fileNode->GetAttribute(wxS("modified"), wxS("")).ToLongLong(&modified) &&
+            fileNode->GetAttribute(wxS("fonts"), wxS("-1")).ToLong(&fontCount))
+        {
+          wxPdfFontRegistryFile& file = m_files[fileName];
+          file.m_size = size;
+          file.m_modified = modified;
+          file.m_fontCount = fontCount;
+          wxXmlNode* fontNode = fileNode->GetChildren();
+          while (fontNode)
+          {
+            long fontIndex, style, cffOffset, cffLength;
+            if (fontNode->GetName().IsSameAs(wxS("font")) &&
+                fontNode->GetAttribute(wxS("index"), wxS("")).ToLong(&fontIndex))
+            {
+              wxPdfFontRegistryEntry& entry = file.m_fonts[fontIndex];
+              entry.m_type   = fontNode->GetAttribute(wxS("type"), wxS(""));
+              entry.m_name   = fontNode->GetAttribute(wxS("name"), wxS(""));
+              entry.m_family = fontNode->GetAttribute(wxS("family"), wxS(""));
+              if (fontNode->GetAttribute(wxS("style"), wxS("0")).ToLong(&style))
+              {
+                entry.m_style = style;
+              }
+              entry.m_embedSupported  = fontNode->GetAttribute(wxS("embed"), wxS("0")).IsSameAs(wxS("1"));
+              entry.m_subsetSupported = fontNode->GetAttribute(wxS("subset"), wxS("0")).IsSameAs(wxS("1"));
+              if (fontNode->GetAttribute(wxS("cff-offset"), wxS("0")).ToLong(&cffOffset) &&
+                  fontNode->GetAttribute(wxS("cff-length"), wxS("0")).ToLong(&cffLength))
+              {
+                entry.m_cffOffset = cffOffset;
+                entry.m_cffLength = cffLength;
+              }
+              wxXmlNode* nameNode = fontNode->GetChildren();
+              while (nameNode)
+              {
+                if (nameNode->GetName().IsSameAs(wxS("fullname")))
+                {
+                  entry.m_fullNames.Add(nameNode->GetNodeContent());
+                }
+                nameNode = nameNode->GetNext();
+              }
+            }
+            fontNode = fontNode->GetNext();
+          }
+        }
+        fileNode = fileNode->GetNext();
+      }
+    }
+    else
+    {
+      // The index is unusable, it will be rebuilt
+      m_modified = true;
+      wxLogDebug(wxString(wxS("wxPdfFontRegistryIndex::Load: ")) +
+                 wxString::Format(_("Font registry index '%s' is invalid or outdated and will be rebuilt."), m_fileName.c_str()));
+    }
+  }
+  else
+  {
+    // Create the index file on the next save
+    m_modified = true;
+    wxFileName indexFileName(m_fileName);
+    ok = indexFileName.IsOk() && !indexFileName.GetFullName().IsEmpty();
+  }
+  return ok;
+}
+
+bool
+wxPdfFontRegistryIndex::Save()
+{
+  wxXmlDocument registry;
+  wxXmlNode* root = new wxXmlNode(wxXML_ELEMENT_NODE, wxS("wxpdfdoc-font-registry"));
+  root->AddAttribute(wxS("version"), gs_fontRegistryVersion);
+  registry.SetRoot(root);
+
+  wxPdfFontRegistryFileMap::iterator file = m_files.begin();
+  while (file != m_files.end())
+  {
+    // Remove entries of font files which no longer exist
+    if (!wxFileName::FileExists(file->first))
+    {
+      wxPdfFontRegistryFileMap::iterator removeFile = file++;
+      m_files.erase(removeFile);
+      continue;
+    }
+    wxXmlNode* fileNode = new wxXmlNode(root, wxXML_ELEMENT_NODE, wxS("file"));
+    fileNode->AddAttribute(wxS("name"), file->first);
+    fileNode->AddAttribute(wxS("size"), file->second.m_size.ToString());
+    fileNode->AddAttribute(wxS("modified"), file->second.m_modified.ToString());
+    fileNode->AddAttribute(wxS("fonts"), wxString::Format(wxS("%d"), file->second.m_fontCount));
+
+    wxPdfFontRegistryEntryMap::const_iterator font;
+    for (font = file->second.m_fonts.begin(); font != file->second.m_fonts.end(); ++font)
+    {
+      const wxPdfFontRegistryEntry& entry = font->second;
+      wxXmlNode* fontNode = new wxXmlNode(fileNode, wxXML_ELEMENT_NODE, wxS("font"));
+      fontNode->AddAttribute(wxS("index"), wxString::Format(wxS("%ld"), font->first));
+      fontNode->AddAttribute(wxS("type"), entry.m_type);
+      if (!entry.m_type.IsEmpty())
+      {
+        fontNode->AddAttribute(wxS("name"), entry.m_name);
+        fontNode->AddAttribute(wxS("family"), entry.m_family);
+        fontNode->AddAttribute(wxS("style"), wxString::Format(wxS("%d"), entry.m_style));
+        fontNode->AddAttribute(wxS("embed"), (entry.m_embedSupported) ? wxS("1") : wxS("0"));
+        fontNode->AddAttribute(wxS("subset"), (entry.m_subsetSupported) ? wxS("1") : wxS("0"));
+        fontNode->AddAttribute(wxS("cff-offset"), wxString::Format(wxS("%lu"), (unsigned long) entry.m_cffOffset));
+        fontNode->AddAttribute(wxS("cff-length"), wxString::Format(wxS("%lu"), (unsigned long) entry.m_cffLength));
+        size_t j;
+        for (j = 0; j < entry.m_fullNames.GetCount(); ++j)
+        {
+          wxXmlNode* nameNode = new wxXmlNode(fontNode, wxXML_ELEMENT_NODE, wxS("fullname"));
+          new wxXmlNode(nameNode, wxXML_TEXT_NODE, wxEmptyString, entry.m_fullNames[j]);
+        }
+      }
+    }
+    ++file;
+  }
+
+  bool ok = registry.Save(m_fileName);
+  if (ok)
+  {
+    m_modified = false;
+  }
+  return ok;
+}
+
+wxPdfFontRegistryFile*
+wxPdfFontRegistryIndex::GetFile(const wxString& fontFileName, bool create)
+{
+  wxPdfFontRegistryFile* registryFile = NULL;
+  wxPdfFontRegistryFileMap::iterator file = m_files.find(fontFileName);
+  if (file != m_files.end() && file->second.m_checked)
+  {
+    registryFile = &file->second;
+  }
+  else if (file != m_files.end() || create)
+  {
+    // Size and modification time of the font file have to match the index
+    wxFileName fileName(fontFileName);
+    wxULongLong size = fileName.GetSize();
+    wxDateTime modified = fileName.GetModificationTime();
+    if (size != wxInvalidSize && modified.IsValid())
+    {
+      if (file != m_files.end() &&
+          file->second.m_size == size && file->second.m_modified == modified.GetValue())
+      {
+        file->second.m_checked = true;
+        registryFile = &file->second;
+      }
+      else if (create)
+      {
+        wxPdfFontRegistryFile& newFile = m_files[fontFileName];
+        newFile = wxPdfFontRegistryFile();
+        newFile.m_size = size;
+        newFile.m_modified = modified.GetValue();
+        newFile.m_checked = true;
+        registryFile = &newFile;
+        m_modified = true;
+      }
+      else
+      {
+        m_files.erase(file);
+        m_modified = true;
+      }
+    }
+    else if (file != m_files.end())
+    {
+      m_files.erase(file);
+      m_modified = true;
+    }
+  }
+  return registryFile;
+}
+
+const wxPdfFontRegistryEntry*
+wxPdfFontRegistryIndex::FindFont(const wxString& fontFileName, int fontIndex)
+{
+  const wxPdfFontRegistryEntry* entry = NULL;
+  wxPdfFontRegistryFile* file = GetFile(fontFileName, false);
+  if (file != NULL)
+  {
+    wxPdfFontRegistryEntryMap::const_iterator font = file->m_fonts.find(fontIndex);
+    if (font != file->m_fonts.end())
+    {
+      entry = &font->second;
+    }
+  }
+  return entry;
+}
+
+void
+wxPdfFontRegistryIndex::AddFont(const wxString& fontFileName, int fontIndex, const wxPdfFontData* fontData)
+{
+  wxPdfFontRegistryFile* file = GetFile(fontFileName, true);
+  if (file != NULL)
+  {
+    wxPdfFontRegistryEntry entry;
+    if (fontData != NULL)
+    {
+      entry.m_type            = fontData->GetType();
+      entry.m_name            = fontData->GetName();
+      entry.m_family          = fontData->GetFamily();
+      entry.m_fullNames       = fontData->GetFullNames();
+      entry.m_style           = fontData->GetStyle();
+      entry.m_embedSupported  = fontData->EmbedSupported();
+      entry.m_subsetSupported = fontData->SubsetSupported();
+      entry.m_cffOffset       = fontData->GetCffOffset();
+      entry.m_cffLength       = fontData->GetCffLength();
+    }
+    file->m_fonts[fontIndex] = entry;
+    m_modified = true;
+  }
+}
+
+int
+wxPdfFontRegistryIndex::GetFontCount(const wxString& fontFileName)
+{
+  wxPdfFontRegistryFile* file = GetFile(fontFileName, false);
+  return (file != NULL) ? file->m_fontCount : -1;
+}
+
+void
+wxPdfFontRegistryIndex::SetFontCount(const wxString& fontFileName, int fontCount)
+{
+  wxPdfFontRegistryFile* file = GetFile(fontFileName, true);
+  if (file != NULL)
+  {
+    file->m_fontCount = fontCount;
+    m_modified = true;
+  }
+}
+
 // --- Encoding checker
 
 // Include codepage data
@@ -326,6 +689,12 @@ public:
   int RegisterFontDirectory(const wxString& directory, bool recursive = false);
 #endif
 
+  bool SetFontRegistryIndex(const wxString& indexFileName);
+
+  bool SaveFontRegistryIndex();
+
+  bool SetDecodedFontCacheDirectory(const wxString& cacheDirectory);
+
   wxPdfFont GetFont(const wxString& fontName, int fontStyle = wxPDF_FONTSTYLE_REGULAR) const;
 
   wxPdfFont GetFont(const wxString& fontName, const wxString& fontStyle) const;
@@ -361,6 +730,14 @@ private:
 
   wxPdfFontData* LoadFontFromXML(const wxString& fontFileName);
 
+  wxPdfFontData* LoadFontFromBinary(const wxString& fontFileName, bool silent = false);
+
+#if wxUSE_UNICODE
+  wxPdfFontData* IdentifyTrueTypeFont(const wxString& fontFileName, int fontIndex);
+
+  int GetCollectionFontCount(const wxString& fontCollectionFileName);
+#endif
+
   bool IsRegistered(wxPdfFontData* fontData);
 
   bool AddFont(wxPdfFontData* fontData);
@@ -379,12 +756,15 @@ private:
 
   wxPdfEncodingMap*        m_encodingMap;
   wxPdfEncodingCheckerMap* m_encodingCheckerMap;
+
+  wxPdfFontRegistryIndex*  m_registryIndex;
 };
 
 wxPdfFontManagerBase::wxPdfFontManagerBase()
 {
   m_defaultEmbed = true;
   m_defaultSubset = true;
+  m_registryIndex = NULL;
   {
     // Since InitializeCoreFonts uses locking, too, it is necessary
     // to create a new context, thus locking only the access of the
@@ -436,6 +816,11 @@ wxPdfFontManagerBase::~wxPdfFontManagerBase()
     delete checker->second;
   }
   delete m_encodingCheckerMap;
+
+  if (m_registryIndex != NULL)
+  {
+    delete m_registryIndex;
+  }
 }
 
 void
@@ -557,8 +942,7 @@ wxPdfFontManagerBase::RegisterFont(const wxString& fontFileName, const wxString&
     {
 #if wxUSE_UNICODE
       // TrueType font, OpenType font, or TrueType collection
-      wxPdfFontParserTrueType fontParser;
-      wxPdfFontData* fontData = fontParser.IdentifyFont(fileName.GetFullPath(), fontIndex);
+      wxPdfFontData* fontData = IdentifyTrueTypeFont(fileName.GetFullPath(), fontIndex);
       if (fontData != NULL)
       {
         fontData->SetAlias(aliasName);
@@ -597,10 +981,24 @@ wxPdfFontManagerBase::RegisterFont(const wxString& fontFileName, const wxString&
                  wxString::Format(_("Format of font file '%s' not supported."), fontFileName.c_str()));
 #endif
     }
-    else if (ext.IsSameAs(wxS("xml")))
+    else if (ext.IsSameAs(wxS("xml")) || ext.IsSameAs(wxS("wfm")))
     {
       // wxPdfDocument font description file
-      wxPdfFontData* fontData = LoadFontFromXML(fullFontFileName);
+      // A binary font metrics file is preferred if it is not older than the XML file
+      wxPdfFontData* fontData = NULL;
+      wxFileName binaryFileName(fullFontFileName);
+      binaryFileName.SetExt(wxS("wfm"));
+      if (ext.IsSameAs(wxS("wfm")) ||
+          (binaryFileName.IsFileReadable() &&
+           binaryFileName.GetModificationTime() >= fileName.GetModificationTime()))
+      {
+        // An outdated or invalid sibling file is silently ignored in favour of the XML file
+        fontData = LoadFontFromBinary(binaryFileName.GetFullPath(), !ext.IsSameAs(wxS("wfm")));
+      }
+      if (fontData == NULL && ext.IsSameAs(wxS("xml")))
+      {
+        fontData = LoadFontFromXML(fullFontFileName);
+      }
       if (fontData != NULL)
       {
         fontData->SetAlias(aliasName);
@@ -844,8 +1242,7 @@ wxPdfFontManagerBase::RegisterFontCollection(const wxString& fontCollectionFileN
     wxFileName fileName(fullFontCollectionFileName);
     if (fileName.IsOk() && fileName.GetExt().Lower().IsSameAs(wxS("ttc")))
     {
-      wxPdfFontParserTrueType fontParser;
-      int fontCount = fontParser.GetCollectionFontCount(fullFontCollectionFileName);
+      int fontCount = GetCollectionFontCount(fullFontCollectionFileName);
       int j;
       for (j = 0; j < fontCount; ++j)
       {
@@ -1023,6 +1420,7 @@ wxPdfFontManagerBase::RegisterSystemFonts()
   wxLogWarning(wxString(wxS("wxPdfFontManagerBase::RegisterSystemFonts: ")) +
                wxString(_("Method is not available for your platform.")));
 #endif
+  SaveFontRegistryIndex();
   return count;
 }
 
@@ -1094,9 +1492,158 @@ wxPdfFontManagerBase::RegisterFontDirectory(const wxString& directory, bool recu
     wxLogWarning(wxString(wxS("wxPdfFontManagerBase::RegisterFontDirectory: ")) +
                  wxString::Format(_("Directory '%s' does not exist."),directory.c_str()));
   }
+  SaveFontRegistryIndex();
   return count;
 }
+
+wxPdfFontData*
+wxPdfFontManagerBase::IdentifyTrueTypeFont(const wxString& fontFileName, int fontIndex)
+{
+  wxPdfFontData* fontData = NULL;
+  bool found = false;
+  {
+#if wxUSE_THREADS
+    wxCriticalSectionLocker locker(gs_csFontManager);
 #endif
+    if (m_registryIndex != NULL)
+    {
+      const wxPdfFontRegistryEntry* entry = m_registryIndex->FindFont(fontFileName, fontIndex);
+      if (entry != NULL)
+      {
+        found = true;
+        if (entry->m_type.IsSameAs(wxS("OpenTypeUnicode")))
+        {
+          wxPdfFontDataOpenTypeUnicode* otfFontData = new wxPdfFontDataOpenTypeUnicode();
+          otfFontData->SetCffOffset(entry->m_cffOffset);
+          otfFontData->SetCffLength(entry->m_cffLength);
+          fontData = otfFontData;
+        }
+        else if (entry->m_type.IsSameAs(wxS("TrueTypeUnicode")))
+        {
+          fontData = new wxPdfFontDataTrueTypeUnicode();
+        }
+        if (fontData != NULL)
+        {
+          fontData->SetName(entry->m_name);
+          fontData->SetFamily(entry->m_family);
+          fontData->SetFullNames(entry->m_fullNames);
+          fontData->SetStyle(entry->m_style);
+          fontData->SetEmbedSupported(entry->m_embedSupported);
+          fontData->SetSubsetSupported(entry->m_subsetSupported);
+          fontData->SetFontFileName(fontFileName);
+          fontData->SetFontIndex(fontIndex);
+        }
+        else
+        {
+          wxLogDebug(wxString(wxS("wxPdfFontManagerBase::IdentifyTrueTypeFont: ")) +
+                     wxString::Format(_("Font file '%s' is registered as not identifiable in the font registry index."), fontFileName.c_str()));
+        }
+      }
+    }
+  }
+
+  if (!found)
+  {
+    wxPdfFontParserTrueType fontParser;
+    fontData = fontParser.IdentifyFont(fontFileName, fontIndex);
+#if wxUSE_THREADS
+    wxCriticalSectionLocker locker(gs_csFontManager);
+#endif
+    if (m_registryIndex != NULL)
+    {
+      m_registryIndex->AddFont(fontFileName, fontIndex, fontData);
+    }
+  }
+  return fontData;
+}
+
+int
+wxPdfFontManagerBase::GetCollectionFontCount(const wxString& fontCollectionFileName)
+{
+  int fontCount = -1;
+  {
+#if wxUSE_THREADS
+    wxCriticalSectionLocker locker(gs_csFontManager);
+#endif
+    if (m_registryIndex != NULL)
+    {
+      fontCount = m_registryIndex->GetFontCount(fontCollectionFileName);
+    }
+  }
+
+  if (fontCount < 0)
+  {
+    wxPdfFontParserTrueType fontParser;
+    fontCount = fontParser.GetCollectionFontCount(fontCollectionFileName);
+#if wxUSE_THREADS
+    wxCriticalSectionLocker locker(gs_csFontManager);
+#endif
+    if (m_registryIndex != NULL)
+    {
+      m_registryIndex->SetFontCount(fontCollectionFileName, fontCount);
+    }
+  }
+  return fontCount;
+}
+#endif
+
+bool
+wxPdfFontManagerBase::SetFontRegistryIndex(const wxString& indexFileName)
+{
+#if wxUSE_THREADS
+  wxCriticalSectionLocker locker(gs_csFontManager);
+#endif
+  bool ok = true;
+  if (m_registryIndex != NULL)
+  {
+    delete m_registryIndex;
+    m_registryIndex = NULL;
+  }
+  if (!indexFileName.IsEmpty())
+  {
+    m_registryIndex = new wxPdfFontRegistryIndex(indexFileName);
+    ok = m_registryIndex->Load();
+    if (!ok)
+    {
+      delete m_registryIndex;
+      m_registryIndex = NULL;
+      wxLogError(wxString(wxS("wxPdfFontManagerBase::SetFontRegistryIndex: ")) +
+                 wxString::Format(_("Font registry index file name '%s' is invalid."), indexFileName.c_str()));
+    }
+  }
+  return ok;
+}
+
+bool
+wxPdfFontManagerBase::SaveFontRegistryIndex()
+{
+#if wxUSE_THREADS
+  wxCriticalSectionLocker locker(gs_csFontManager);
+#endif
+  bool ok = true;
+  if (m_registryIndex != NULL && m_registryIndex->IsModified())
+  {
+    ok = m_registryIndex->Save();
+    if (!ok)
+    {
+      wxLogError(wxString(wxS("wxPdfFontManagerBase::SaveFontRegistryIndex: ")) +
+                 wxString(_("Font registry index could not be saved.")));
+    }
+  }
+  return ok;
+}
+
+bool
+wxPdfFontManagerBase::SetDecodedFontCacheDirectory(const wxString& cacheDirectory)
+{
+  bool ok = WoffFontCache::SetCacheDirectory(cacheDirectory);
+  if (!ok)
+  {
+    wxLogError(wxString(wxS("wxPdfFontManagerBase::SetDecodedFontCacheDirectory: ")) +
+               wxString::Format(_("Cache directory '%s' could not be created."), cacheDirectory.c_str()));
+  }
+  return ok;
+}
 
 wxPdfFont
 wxPdfFontManagerBase::GetFont(const wxString& fontName, int fontStyle) const
@@ -1233,14 +1780,7 @@ wxPdfFontManagerBase::InitializeFontData(const wxPdfFont& font)
   bool ok = false;
   if (font.m_fontData != NULL)
   {
-    ok = font.m_fontData->IsInitialized();
-    if (!ok)
-    {
-#if wxUSE_THREADS
-      wxCriticalSectionLocker locker(gs_csFontManager);
-#endif
-      ok = font.m_fontData->Initialize();
-    }
+    ok = font.m_fontData->InitializeOnce();
   }
   return ok;
 }
@@ -1492,6 +2032,35 @@ wxPdfFontManagerBase::RegisterFontCJK(const wxString& fontFileName, const wxStri
   return ok;
 }
 
+static wxPdfFontData*
+CreateFontDataOfType(const wxString& fontType)
+{
+  wxPdfFontData* fontData = NULL;
+  if (fontType.IsSameAs(wxS("TrueType")))
+  {
+    fontData = new wxPdfFontDataTrueType();
+  }
+  else if (fontType.IsSameAs(wxS("Type1")))
+  {
+    fontData = new wxPdfFontDataType1();
+  }
+#if wxUSE_UNICODE
+  else if (fontType.IsSameAs(wxS("TrueTypeUnicode")))
+  {
+    fontData = new wxPdfFontDataTrueTypeUnicode();
+  }
+  else if (fontType.IsSameAs(wxS("OpenTypeUnicode")))
+  {
+    fontData = new wxPdfFontDataOpenTypeUnicode();
+  }
+  else if (fontType.IsSameAs(wxS("Type0")))
+  {
+    fontData = new wxPdfFontDataType0();
+  }
+#endif
+  return fontData;
+}
+
 wxPdfFontData*
 wxPdfFontManagerBase::LoadFontFromXML(const wxString& fontFileName)
 {
@@ -1515,29 +2084,8 @@ wxPdfFontManagerBase::LoadFontFromXML(const wxString& fontFileName)
         wxXmlNode* root = fontMetrics.GetRoot();
         if (root->GetAttribute(wxS("type"), &fontType))
         {
-          if (fontType.IsSameAs(wxS("TrueType")))
-          {
-            fontData = new wxPdfFontDataTrueType();
-          }
-          else if (fontType.IsSameAs(wxS("Type1")))
-          {
-            fontData = new wxPdfFontDataType1();
-          }
-#if wxUSE_UNICODE
-          else if (fontType.IsSameAs(wxS("TrueTypeUnicode")))
-          {
-            fontData = new wxPdfFontDataTrueTypeUnicode();
-          }
-          else if (fontType.IsSameAs(wxS("OpenTypeUnicode")))
-          {
-            fontData = new wxPdfFontDataOpenTypeUnicode();
-          }
-          else if (fontType.IsSameAs(wxS("Type0")))
-          {
-            fontData = new wxPdfFontDataType0();
-          }
-#endif
-          else
+          fontData = CreateFontDataOfType(fontType);
+          if (fontData == NULL)
           {
             // Unknown font type
             wxLogError(wxString(wxS("wxPdfFontManagerBase::LoadFontFromXML: ")) +
@@ -1585,6 +2133,86 @@ wxPdfFontManagerBase::LoadFontFromXML(const wxString& fontFileName)
   return fontData;
 }
 
+wxPdfFontData*
+wxPdfFontManagerBase::LoadFontFromBinary(const wxString& fontFileName, bool silent)
+{
+  wxPdfFontData* fontData = NULL;
+  wxFileName fileName(fontFileName);
+  wxMemoryBuffer fontMetrics;
+  bool loaded = false;
+  wxString errorMessage;
+
+  // Read the binary font metrics file in one go
+  wxFile fontMetricsFile;
+  bool found = fileName.IsFileReadable() && fontMetricsFile.Open(fileName.GetFullPath());
+  if (found)
+  {
+    wxFileOffset length = fontMetricsFile.Length();
+    if (length > 0)
+    {
+      void* buffer = fontMetrics.GetWriteBuf((size_t) length);
+      loaded = (fontMetricsFile.Read(buffer, (size_t) length) == (ssize_t) length);
+      fontMetrics.UngetWriteBuf(loaded ? (size_t) length : 0);
+    }
+    fontMetricsFile.Close();
+  }
+
+  if (!found)
+  {
+    // Font metrics file not found
+    errorMessage = wxString::Format(_("Font metrics file '%s' not found."), fontFileName.c_str());
+  }
+  else if (loaded)
+  {
+    const unsigned char* data = (const unsigned char*) fontMetrics.GetData();
+    size_t dataLength = fontMetrics.GetDataLen();
+    wxString fontType = wxPdfFontData::GetBinaryFontMetricsType(data, dataLength);
+    if (!fontType.IsEmpty())
+    {
+      fontData = CreateFontDataOfType(fontType);
+      if (fontData != NULL)
+      {
+        fontData->SetFilePath(fileName.GetPath());
+        if (!fontData->LoadBinaryFontMetrics(data, dataLength))
+        {
+          errorMessage = wxString::Format(_("Loading of font metrics failed for font file '%s'."), fontFileName.c_str());
+          delete fontData;
+          fontData = NULL;
+        }
+      }
+      else
+      {
+        // Unknown font type
+        errorMessage = wxString::Format(_("Unknown font type '%s' in font file '%s'."), fontType.c_str(), fontFileName.c_str());
+      }
+    }
+    else
+    {
+      // Not a binary font metrics file or unsupported version
+      errorMessage = wxString::Format(_("Font metrics file '%s' invalid."), fontFileName.c_str());
+    }
+  }
+  else
+  {
+    // Font metrics file loading failed
+    errorMessage = wxString::Format(_("Loading of font metrics file '%s' failed."), fontFileName.c_str());
+  }
+
+  if (!errorMessage.IsEmpty())
+  {
+    // A binary font metrics file used in place of an XML file silently falls back to the XML file
+    if (silent)
+    {
+      wxLogDebug(wxString(wxS("wxPdfFontManagerBase::LoadFontFromBinary: ")) + errorMessage);
+    }
+    else
+    {
+      wxLogError(wxString(wxS("wxPdfFontManagerBase::LoadFontFromBinary: ")) + errorMessage);
+    }
+  }
+  return fontData;
+}
+
 bool
 wxPdfFontManagerBase::IsRegistered(wxPdfFontData* fontData)
 {
@@ -1800,6 +2428,24 @@ wxPdfFontManager::RegisterFontDirectory(const wxString& directory, bool recursiv
 #endif
 }
 
+bool
+wxPdfFontManager::SetFontRegistryIndex(const wxString& indexFileName)
+{
+  return m_fontManagerBase->SetFontRegistryIndex(indexFileName);
+}
+
+bool
+wxPdfFontManager::SaveFontRegistryIndex()
+{
+  return m_fontManagerBase->SaveFontRegistryIndex();
+}
+
+bool
+wxPdfFontManager::SetDecodedFontCacheDirectory(const wxString& cacheDirectory)
+{
+  return m_fontManagerBase->SetDecodedFontCacheDirectory(cacheDirectory);
+}
+
 wxPdfFont
 wxPdfFontManager::GetFont(const wxString& fontName, int fontStyle) const
 {
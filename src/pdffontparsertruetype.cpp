@@ -606,15 +606,11 @@ wxPdfFontParserTrueType::IdentifyFont(const wxString& fontFileName, int fontInde
       wxMemoryInputStream* fontStream = nullptr;
       m_directoryOffset = 0;
       fontIndex = 0;
-      if (fileName.GetExt().Lower().IsSameAs(wxS("woff")))
+      if (fileName.GetExt().Lower().IsSameAs(wxS("woff")) ||
+          fileName.GetExt().Lower().IsSameAs(wxS("woff2")))
       {
         isWoff = true;
-        fontStream = WoffConverter::Convert(m_inFont);
-      }
-      else if (fileName.GetExt().Lower().IsSameAs(wxS("woff2")))
-      {
-        isWoff = true;
-        fontStream = Woff2Converter::Convert(m_inFont);
+        fontStream = WoffFontCache::GetDecodedFont(fileName.GetFullPath(), m_inFont);
       }
       if (isWoff)
       {
@@ -822,13 +818,10 @@ wxPdfFontParserTrueType::LoadFontData(wxPdfFontData* fontData)
       if (fontFile)
       {
         m_inFont = fontFile->GetStream();
-        if (fileName.GetExt().Lower().IsSameAs(wxS("woff")))
-        {
-          fontStream = WoffConverter::Convert(m_inFont);
-        }
-        else if (fileName.GetExt().Lower().IsSameAs(wxS("woff2")))
+        if (fileName.GetExt().Lower().IsSameAs(wxS("woff")) ||
+            fileName.GetExt().Lower().IsSameAs(wxS("woff2")))
         {
-          fontStream = Woff2Converter::Convert(m_inFont);
+          fontStream = WoffFontCache::GetDecodedFont(fileName.GetFullPath(), m_inFont);
         }
         if (fontStream)
         {
@@ -1215,6 +1208,145 @@ wxPdfFontParserTrueType::GetBaseFont()
 
 bool
 wxPdfFontParserTrueType::ReadMaps()
+{
+  int unitsPerEm;
+  int numberOfHMetrics;
+  if (!ReadFontDescription(unitsPerEm, numberOfHMetrics))
+  {
+    return false;
+  }
+
+  ReadGlyphWidths(numberOfHMetrics, unitsPerEm);
+  ReadKerning(unitsPerEm);
+  m_fd.SetMissingWidth(GetGlyphWidth(0));
+
+  wxPdfTableDirectoryEntry* tableLocation;
+  wxPdfTableDirectory::iterator entry = m_tableDirectory->find(wxS("cmap"));
+  if (entry == m_tableDirectory->end())
+  {
+    wxLogError(wxString(wxS("wxPdfFontParser::ReadMaps: ")) +
+               wxString::Format(_("Table 'cmap' does not exist in '%s,%s'."), m_fileName.c_str(), m_style.c_str()));
+    return false;
+  }
+  tableLocation = entry->second;
+  LockTable(wxS("cmap"));
+  m_inFont->SeekI(tableLocation->m_offset);
+  SkipBytes(2);
+  int num_tables = ReadUShort();
+  m_fontSpecific = false;
+  int map10 = 0;
+  int map31 = 0;
+  int map30 = 0;
+  int mapExt = 0;
+  int k;
+  for (k = 0; k < num_tables; ++k)
+  {
+    int platId = ReadUShort();
+    int platSpecId = ReadUShort();
+    int offset = ReadInt();
+    if (platId == 3 && platSpecId == 0)
+    {
+      m_fontSpecific = true;
+      map30 = offset;
+    }
+    else if (platId == 3 && platSpecId == 1)
+    {
+      map31 = offset;
+    }
+    else if (platId == 3 && platSpecId == 10)
+    {
+      mapExt = offset;
+    }
+    else if (platId == 1 && platSpecId == 0)
+    {
+      map10 = offset;
+    }
+    else if (platId == 0) // Apple Unicode
+    {
+      // Formats 0, 2, 4, 6, 8, 10, 12
+      if (platSpecId < 4)
+      {
+        map31 = offset;
+      }
+      else if (platSpecId == 4) // UCS32
+      {
+        mapExt = offset;
+      }
+    }
+  }
+  if (map10 > 0 && map30 <= 0)
+  {
+    m_inFont->SeekI(tableLocation->m_offset + map10);
+    int format = ReadUShort();
+    switch (format)
+    {
+      case 0:
+        m_cmap10 = ReadFormat0();
+        break;
+      case 4:
+        m_cmap10 = ReadFormat4();
+        break;
+      case 6:
+        m_cmap10 = ReadFormat6();
+        break;
+    }
+  }
+  if (map31 > 0)
+  {
+    m_inFont->SeekI(tableLocation->m_offset + map31);
+    int format = ReadUShort();
+    if (format == 4)
+    {
+      m_cmap31 = ReadFormat4();
+    }
+  }
+  if (map30 > 0)
+  {
+    m_inFont->SeekI(tableLocation->m_offset + map30);
+    int format = ReadUShort();
+    if (format == 4)
+    {
+      m_cmap10 = ReadFormat4();
+    }
+  }
+  if (mapExt > 0)
+  {
+    m_inFont->SeekI(tableLocation->m_offset + mapExt);
+    int format = ReadUShort();
+    switch (format)
+    {
+      case 0:
+        m_cmapExt = ReadFormat0();
+        break;
+      case 4:
+        m_cmapExt = ReadFormat4();
+        break;
+      case 6:
+        m_cmapExt = ReadFormat6();
+        break;
+      case 12:
+        m_cmapExt = ReadFormat12();
+        break;
+    }
+  }
+  ReleaseTable();
+
+  int flags = m_fd.GetFlags();
+  flags |= m_fontSpecific ? 4 : 32;
+  m_fd.SetFlags(flags);
+
+  bool ok = m_cmap10 || m_cmap31 || m_cmapExt;
+  if (!ok)
+  {
+    wxLogError(wxString(wxS("wxPdfFontParserTrueType::ReadMaps: ")) +
+               wxString::Format(_("No valid 'cmap' table found for font '%s'."),  m_fontName.c_str()));
+  }
+
+  return ok;
+}
+
+bool
+wxPdfFontParserTrueType::ReadFontDescription(int& unitsPerEm, int& numberOfHMetrics)
 {
   wxPdfFontHeader head;
   wxPdfHorizontalHeader hhea;
@@ -1225,7 +1357,7 @@ wxPdfFontParserTrueType::ReadMaps()
   wxPdfTableDirectory::iterator entry = m_tableDirectory->find(wxS("head"));
   if (entry == m_tableDirectory->end())
   {
-    wxLogError(wxString(wxS("wxPdfFontParser::ReadMaps: ")) +
+    wxLogError(wxString(wxS("wxPdfFontParserTrueType::ReadFontDescription: ")) +
                wxString::Format(_("Table 'head' does not exist in '%s,%s'."), m_fileName.c_str(), m_style.c_str()));
     return false;
   }
@@ -1245,7 +1377,7 @@ wxPdfFontParserTrueType::ReadMaps()
   entry = m_tableDirectory->find(wxS("hhea"));
   if (entry == m_tableDirectory->end())
   {
-    wxLogError(wxString(wxS("wxPdfFontParser::ReadMaps: ")) +
+    wxLogError(wxString(wxS("wxPdfFontParserTrueType::ReadFontDescription: ")) +
                wxString::Format(_("Table 'hhea' does not exist in '%s,%s'."), m_fileName.c_str(), m_style.c_str()));
     return false;
   }
@@ -1375,8 +1507,8 @@ wxPdfFontParserTrueType::ReadMaps()
     ReleaseTable();
   }
 
-  ReadGlyphWidths(hhea.m_numberOfHMetrics, head.m_unitsPerEm);
-  ReadKerning(head.m_unitsPerEm);
+  unitsPerEm = head.m_unitsPerEm;
+  numberOfHMetrics = hhea.m_numberOfHMetrics;
 
   m_fd.SetAscent((int) (os_2.m_sTypoAscender * 1000 / head.m_unitsPerEm));
   m_fd.SetDescent((int) (os_2.m_sTypoDescender * 1000 / head.m_unitsPerEm));
@@ -1386,7 +1518,6 @@ wxPdfFontParserTrueType::ReadMaps()
   m_fd.SetStemV(80);
   m_fd.SetUnderlinePosition((int) (underlinePosition * 1000 / head.m_unitsPerEm));
   m_fd.SetUnderlineThickness((int) (underlineThickness * 1000 / head.m_unitsPerEm));
-  m_fd.SetMissingWidth(GetGlyphWidth(0));
 
 #if 0
   int      m_stemV;                   ///< StemV
@@ -1414,128 +1545,7 @@ wxPdfFontParserTrueType::ReadMaps()
                    (int) (head.m_yMax * 1000 / head.m_unitsPerEm));
   m_fd.SetFontBBox(fbb);
 
-  entry = m_tableDirectory->find(wxS("cmap"));
-  if (entry == m_tableDirectory->end())
-  {
-    wxLogError(wxString(wxS("wxPdfFontParser::ReadMaps: ")) +
-               wxString::Format(_("Table 'cmap' does not exist in '%s,%s'."), m_fileName.c_str(), m_style.c_str()));
-    return false;
-  }
-  tableLocation = entry->second;
-  LockTable(wxS("cmap"));
-  m_inFont->SeekI(tableLocation->m_offset);
-  SkipBytes(2);
-  int num_tables = ReadUShort();
-  m_fontSpecific = false;
-  int map10 = 0;
-  int map31 = 0;
-  int map30 = 0;
-  int mapExt = 0;
-  int k;
-  for (k = 0; k < num_tables; ++k)
-  {
-    int platId = ReadUShort();
-    int platSpecId = ReadUShort();
-    int offset = ReadInt();
-    if (platId == 3 && platSpecId == 0)
-    {
-      m_fontSpecific = true;
-      map30 = offset;
-    }
-    else if (platId == 3 && platSpecId == 1)
-    {
-      map31 = offset;
-    }
-    else if (platId == 3 && platSpecId == 10)
-    {
-      mapExt = offset;
-    }
-    else if (platId == 1 && platSpecId == 0)
-    {
-      map10 = offset;
-    }
-    else if (platId == 0) // Apple Unicode
-    {
-      // Formats 0, 2, 4, 6, 8, 10, 12
-      if (platSpecId < 4)
-      {
-        map31 = offset;
-      }
-      else if (platSpecId == 4) // UCS32
-      {
-        mapExt = offset;
-      }
-    }
-  }
-  if (map10 > 0 && map30 <= 0)
-  {
-    m_inFont->SeekI(tableLocation->m_offset + map10);
-    int format = ReadUShort();
-    switch (format)
-    {
-      case 0:
-        m_cmap10 = ReadFormat0();
-        break;
-      case 4:
-        m_cmap10 = ReadFormat4();
-        break;
-      case 6:
-        m_cmap10 = ReadFormat6();
-        break;
-    }
-  }
-  if (map31 > 0)
-  {
-    m_inFont->SeekI(tableLocation->m_offset + map31);
-    int format = ReadUShort();
-    if (format == 4)
-    {
-      m_cmap31 = ReadFormat4();
-    }
-  }
-  if (map30 > 0)
-  {
-    m_inFont->SeekI(tableLocation->m_offset + map30);
-    int format = ReadUShort();
-    if (format == 4)
-    {
-      m_cmap10 = ReadFormat4();
-    }
-  }
-  if (mapExt > 0)
-  {
-    m_inFont->SeekI(tableLocation->m_offset + mapExt);
-    int format = ReadUShort();
-    switch (format)
-    {
-      case 0:
-        m_cmapExt = ReadFormat0();
-        break;
-      case 4:
-        m_cmapExt = ReadFormat4();
-        break;
-      case 6:
-        m_cmapExt = ReadFormat6();
-        break;
-      case 12:
-        m_cmapExt = ReadFormat12();
-        break;
-    }
-  }
-  ReleaseTable();
-
-  flags = m_fd.GetFlags();
-  flags |= m_fontSpecific ? 4 : 32;
-  m_fd.SetFlags(flags);
-
-  bool ok = m_cmap10 || m_cmap31 || m_cmapExt;
-  if (!ok)
-  {
-    wxLogError(wxString(wxS("wxPdfFontParserTrueType::ReadMaps: ")) +
-               wxString::Format(_("No valid 'cmap' table found for font '%s'."),  m_fontName.c_str()));
-  }
-
-  return ok;
+  return true;
 }
 
 bool
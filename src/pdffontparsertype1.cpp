@@ -29,7 +29,6 @@
 #include "wx/txtstrm.h"
 #include <wx/zstream.h>
 
-#include "wx/pdfcffindex.h"
 #include "wx/pdfcffdecoder.h"
 #include "wx/pdffontdata.h"
 #include "wx/pdffontdatatype1.h"
@@ -52,21 +51,16 @@ wxPdfFontParserType1::wxPdfFontParserType1()
   m_isPFB = false;
   m_privateFound = false;
   m_fontDirAfterPrivate = false;
-  m_privateDict = NULL;
+  m_data = NULL;
+  m_length = 0;
+  m_position = 0;
+  m_eexecPosition = -1;
   m_lenIV = 4;
-  m_charStringsIndex = new wxPdfCffIndexArray();
-  m_subrsIndex = new wxPdfCffIndexArray();
   m_glyphWidthMap = NULL;
 }
 
 wxPdfFontParserType1::~wxPdfFontParserType1()
 {
-  if (m_privateDict != NULL)
-  {
-    delete m_privateDict;
-  }
-  delete m_charStringsIndex;
-  delete m_subrsIndex;
   if (m_glyphWidthMap != NULL)
   {
     delete m_glyphWidthMap;
@@ -1319,6 +1313,23 @@ wxPdfFontParserType1::ReadPFM(wxInputStream& pfmFile)
 
 // -- Parse Postscript font (PFA or PFB plus AFM or PFM) ---
 
+// Maximal size of the leading part of a charstring needed to extract the width
+// (hsbw or sbw) and the composite information (seac)
+static const int gs_charStringPrefix = 64;
+
+static inline bool
+IsPostScriptSpace(unsigned char ch)
+{
+  return (ch == ' ' || ch == '\r' || ch == '\n' || ch == '\t' || ch == '\f' || ch == '\0');
+}
+
+static inline bool
+IsPostScriptDelimiter(unsigned char ch)
+{
+  return (ch == '/' || ch == '(' || ch == ')' || ch == '<' || ch == '>' ||
+          ch == '[' || ch == ']' || ch == '{' || ch == '}' || ch == '%');
+}
+
 bool
 wxPdfFontParserType1::ReadPFX(wxInputStream* pfxFile, bool onlyNames)
 {
@@ -1327,17 +1338,23 @@ wxPdfFontParserType1::ReadPFX(wxInputStream* pfxFile, bool onlyNames)
   bool ok = CheckType1Format(pfxFile, start, length);
   if (ok)
   {
+    // The clear text part of the font is read in one go,
+    // all further parsing is done on the memory buffer
+    unsigned char* buffer = (unsigned char*) m_fontBuffer.GetWriteBuf(length);
+    pfxFile->Read(buffer, length);
+    m_fontBuffer.UngetWriteBuf(pfxFile->LastRead());
+
     m_skipArray = true;
-    ok = ParseDict(pfxFile, start, length, onlyNames);
+    m_eexecPosition = -1;
+    ok = ParseDict((const unsigned char*) m_fontBuffer.GetData(), (int) m_fontBuffer.GetDataLen(), onlyNames);
     if (ok && !onlyNames)
     {
-      start = (m_isPFB) ? start+length : 0;
-      ok = GetPrivateDict(pfxFile, start);
+      ok = GetPrivateDict(pfxFile, start+length);
       if (ok)
       {
         m_glyphWidthMap = new wxPdfFontType1GlyphWidthMap();
         m_skipArray = true;
-        ok = ParseDict(m_privateDict, 0, (int) m_privateDict->GetLength(), false);
+        ok = ParseDict((const unsigned char*) m_privateDict.GetData(), (int) m_privateDict.GetDataLen(), false);
       }
     }
   }
@@ -1382,89 +1399,60 @@ bool
 wxPdfFontParserType1::GetPrivateDict(wxInputStream* stream, int start)
 {
   bool ok = false;
-  wxMemoryOutputStream privateDict;
-  wxMemoryOutputStream* eexecStream = new wxMemoryOutputStream();
-  stream->SeekI(start);
+  unsigned int key = 55665U;
+  int skip = 4;
+  m_privateDict.SetDataLen(0);
   if (m_isPFB)
   {
     // The private dictionary can be made of several segments
-    // All binary segements are read in and concatenated
+    // All binary segments are appended and decrypted in place
     unsigned char blocktype;
     int length;
+    stream->SeekI(start);
     do
     {
       ok = ReadPfbTag(stream, blocktype, length);
       if (ok && blocktype == PFB_BLOCK_BINARY)
       {
-        char* buf = new char[length];
-        stream->Read(buf, length);
-        eexecStream->Write(buf, length);
-        delete [] buf;
+        unsigned char* buffer = (unsigned char*) m_privateDict.GetAppendBuf(length);
+        stream->Read(buffer, length);
+        int decoded = DecodeEExec(buffer, (int) stream->LastRead(), key, skip);
+        m_privateDict.UngetAppendBuf(decoded);
       }
     }
     while (ok && blocktype == PFB_BLOCK_BINARY);
   }
-  else
+  else if (m_eexecPosition >= 0)
   {
-    bool found = false;
-    wxString token = wxEmptyString;
-    int limit = (int) stream->GetSize();
-    while(!found && stream->TellI() < limit)
+    // The position after the keyword 'eexec' was recorded while parsing the clear text part
+    const unsigned char* data = (const unsigned char*) m_fontBuffer.GetData();
+    int limit = (int) m_fontBuffer.GetDataLen();
+    int pos = m_eexecPosition;
+    if (pos < limit && (data[pos] == '\r' || data[pos] == '\n'))
     {
-      token = GetToken(stream);
-      if (token.IsSameAs(wxS("eexec")))
+      if (data[pos] == '\r' && pos+1 < limit && data[pos+1] == '\n')
       {
-        found = true;
+        ++pos;
       }
-      else
+      ++pos;
+      int length = limit - pos;
+      if (length >= 4 &&
+          IsHexDigit(data[pos])   && IsHexDigit(data[pos+1]) &&
+          IsHexDigit(data[pos+2]) && IsHexDigit(data[pos+3]))
       {
-        SkipToNextToken(stream);
-      }
-    }
-    if (found)
-    {
-      char ch = stream->GetC();
-      if (ch == '\r' || ch == '\n')
-      {
-        if (ch == '\r' && stream->Peek() == '\n')
-        {
-          ch = stream->GetC();
-        }
-        int offset = stream->TellI();
-        char prefix[4];
-        stream->Read(prefix,4);
-        if (IsHexDigit(prefix[0]) && IsHexDigit(prefix[1]) &&
-            IsHexDigit(prefix[2]) && IsHexDigit(prefix[3]))
-        {
-          stream->SeekI(offset);
-          DecodeHex(stream, eexecStream);
-        }
-        else
-        {
-          stream->SeekI(offset);
-          eexecStream->Write(*stream);
-        }
-        ok = true;
+        unsigned char* buffer = (unsigned char*) m_privateDict.GetWriteBuf(length / 2 + 1);
+        length = DecodeHex(data + pos, length, buffer);
+        m_privateDict.UngetWriteBuf(DecodeEExec(buffer, length, key, skip));
       }
       else
       {
-        ok = false; // error
+        unsigned char* buffer = (unsigned char*) m_privateDict.GetWriteBuf(length);
+        memcpy(buffer, data + pos, length);
+        m_privateDict.UngetWriteBuf(DecodeEExec(buffer, length, key, skip));
       }
+      ok = true;
     }
   }
-  if (ok && eexecStream->GetSize() > 0)
-  {
-    // decrypt the encoded binary private dictionary
-    DecodeEExec(eexecStream, &privateDict, 55665U, 4);
-    m_privateDict = new wxMemoryInputStream(privateDict);
-    delete eexecStream;
-#if 0
-    wxFileOutputStream pfbPrivateDict(wxS("pfbprivdict.dat"));
-    wxMemoryInputStream tmp(privateDict);
-    pfbPrivateDict.Write(tmp);
-    pfbPrivateDict.Close();
-#endif
-  }
   return ok;
 }
 
@@ -1474,19 +1462,18 @@ wxPdfFontParserType1::IsHexDigit(char digit)
   return ('0' <= digit && digit <= '9') || ('A' <= digit && digit <= 'F') || ('a' <= digit && digit <= 'f');
 }
 
-void
-wxPdfFontParserType1::DecodeHex(wxInputStream* inStream, wxOutputStream* outStream)
+int
+wxPdfFontParserType1::DecodeHex(const unsigned char* data, int length, unsigned char* buffer)
 {
-  char ic, oc;
-  char value = 0;
-  int limit = (int) inStream->GetSize();
-  bool ok = true;
+  int n = 0;
+  unsigned char value;
+  unsigned char oc = 0;
   bool second = false;
-  while (ok && inStream->TellI() < limit)
+  int j;
+  for (j = 0; j < length; ++j)
   {
-    ic = inStream->GetC();
-    if (ic == ' '  || ic == '\r' || ic == '\n' ||
-        ic == '\t' || ic == '\f' || ic == '\0' )
+    unsigned char ic = data[j];
+    if (IsPostScriptSpace(ic))
       continue;
     if      ('0' <= ic && ic <= '9') value = ic - '0';
     else if ('A' <= ic && ic <= 'F') value = ic - 'A' + 10;
@@ -1494,7 +1481,6 @@ wxPdfFontParserType1::DecodeHex(wxInputStream* inStream, wxOutputStream* outStre
     else
     {
       // Invalid character encountered
-      ok = false;
       break;
     }
     if (!second)
@@ -1503,37 +1489,38 @@ wxPdfFontParserType1::DecodeHex(wxInputStream* inStream, wxOutputStream* outStre
     }
     else
     {
-      oc |= (value & 0x0f);
-      outStream->Write(&oc, 1);
+      buffer[n++] = oc | (value & 0x0f);
     }
     second = !second;
   }
-  if (ok && second)
+  if (second)
   {
-    outStream->Write(&oc, 1);
+    buffer[n++] = oc;
   }
+  return n;
 }
 
-void
-wxPdfFontParserType1::DecodeEExec(wxMemoryOutputStream* eexecStream, wxOutputStream* outStream, unsigned short seed, int lenIV)
+int
+wxPdfFontParserType1::DecodeEExec(unsigned char* data, int length, unsigned int& key, int& skip)
 {
-  wxMemoryInputStream inStream(*eexecStream);
-  int limit = (int) inStream.GetSize();
-  unsigned int s = seed;
-  unsigned int val;
-  char b;
+  int n = 0;
   int j;
-  for (j = 0; j < limit; j++)
+  for (j = 0; j < length; ++j)
   {
-    val = (unsigned int) inStream.GetC();
-    b   = (val ^ (s >> 8)) & 0xff;
-    s         = ((val + s)*52845U + 22719) & 0xFFFFU;
-    // ignore the four random bytes at the beginning
-    if (j >= lenIV)
+    unsigned int val = data[j];
+    unsigned char b = (unsigned char) ((val ^ (key >> 8)) & 0xff);
+    key = ((val + key) * 52845U + 22719U) & 0xFFFFU;
+    // ignore the random bytes at the beginning
+    if (skip > 0)
     {
-      outStream->Write(&b, 1);
+      --skip;
+    }
+    else
+    {
+      data[n++] = b;
     }
   }
+  return n;
 }
 
 bool
@@ -1566,52 +1553,47 @@ wxPdfFontParserType1::CheckRestrictions(long fsType)
 }
 
 void
-wxPdfFontParserType1::SkipComment(wxInputStream* stream)
+wxPdfFontParserType1::SkipComment()
 {
-  unsigned char ch = ReadByte(stream);
-  while (!stream->Eof())
+  while (m_position < m_length)
   {
+    unsigned char ch = m_data[m_position++];
     if (ch == '\r' || ch == '\n') break;
-    ch = ReadByte(stream);
   }
 }
 
 void
-wxPdfFontParserType1::SkipSpaces(wxInputStream* stream)
+wxPdfFontParserType1::SkipSpaces()
 {
-  char ch = (char) ReadByte(stream);
-  while (!stream->Eof())
+  while (m_position < m_length)
   {
-    if (!(ch == ' ' || ch == '\r' || ch == '\n' || ch == '\t' || ch == '\f' || ch == '\0'))
+    unsigned char ch = m_data[m_position];
+    if (IsPostScriptSpace(ch))
     {
-      if (ch == '%')
-      {
-        // According to the PLRM, a comment is equal to a space.
-        SkipComment(stream);
-        ch = (char) ReadByte(stream);
-      }
-      else
-      {
-        stream->SeekI(-1, wxFromCurrent);
-        break;
-      }
+      ++m_position;
+    }
+    else if (ch == '%')
+    {
+      // According to the PLRM, a comment is equal to a space.
+      ++m_position;
+      SkipComment();
     }
     else
     {
-      ch = (char) ReadByte(stream);
+      break;
     }
   }
 }
 
 void
-wxPdfFontParserType1::SkipLiteralString(wxInputStream* stream)
+wxPdfFontParserType1::SkipLiteralString()
 {
-  // first character must be `('
+  // the opening `(' has already been consumed
   int embed = 1;
   int j;
-  char ch = (char) ReadByte(stream);
-  while (!stream->Eof())
+  while (m_position < m_length)
   {
+    unsigned char ch = m_data[m_position++];
     if (ch == '\\')
     {
       /* Red Book 3rd ed., section `Literal Text Strings', p. 29:     */
@@ -1621,8 +1603,8 @@ wxPdfFontParserType1::SkipLiteralString(wxInputStream* stream)
       /*   - a one-, two-, or three-digit octal number                */
       /*   - none of the above in which case the backslash is ignored */
 
-      ch = (char) ReadByte(stream);
-      if (stream->Eof()) break;
+      if (m_position >= m_length) break;
+      ch = m_data[m_position];
       switch (ch)
       {
         /* skip `special' escape */
@@ -1634,15 +1616,16 @@ wxPdfFontParserType1::SkipLiteralString(wxInputStream* stream)
         case '\\':
         case '(':
         case ')':
-          ch = (char) ReadByte(stream);
+          ++m_position;
           break;
 
         default:
           /* skip octal escape or ignore backslash */
-          for (j = 0; j < 3 && !stream->Eof(); ++j)
+          for (j = 0; j < 3 && m_position < m_length; ++j)
           {
+            ch = m_data[m_position];
             if (!('0' <= ch && ch <= '7')) break;
-            ch = (char) ReadByte(stream);
+            ++m_position;
           }
           break;
       }
@@ -1650,32 +1633,26 @@ wxPdfFontParserType1::SkipLiteralString(wxInputStream* stream)
     else if (ch == '(')
     {
       embed++;
-      ch = (char) ReadByte(stream);
     }
     else if (ch == ')')
     {
       embed--;
       if (embed == 0) break;
-      ch = (char) ReadByte(stream);
-    }
-    else
-    {
-      ch = (char) ReadByte(stream);
     }
   }
 }
 
 wxString
-wxPdfFontParserType1::GetLiteralString(wxInputStream* stream)
+wxPdfFontParserType1::GetLiteralString()
 {
   wxString literalString;
-  SkipSpaces(stream);
+  SkipSpaces();
   // first character must be `('
   int embed = 0;
   int j;
-  unsigned char ch = ReadByte(stream);
-  while (!stream->Eof())
+  while (m_position < m_length)
   {
+    unsigned char ch = m_data[m_position++];
     if (ch == '\\')
     {
       /* Red Book 3rd ed., section `Literal Text Strings', p. 29:     */
@@ -1685,48 +1662,53 @@ wxPdfFontParserType1::GetLiteralString(wxInputStream* stream)
       /*   - a one-, two-, or three-digit octal number                */
       /*   - none of the above in which case the backslash is ignored */
 
-      ch = ReadByte(stream);
-      if (stream->Eof()) break;
+      if (m_position >= m_length) break;
+      ch = m_data[m_position];
       switch (ch)
       {
-        /* skip `special' escape */
         case 'n':
           literalString.Append(wxS("\n"));
-          ch = ReadByte(stream);
+          ++m_position;
           break;
         case 'r':
           literalString.Append(wxS("\r"));
-          ch = ReadByte(stream);
+          ++m_position;
           break;
         case 't':
           literalString.Append(wxS("\t"));
-          ch = ReadByte(stream);
+          ++m_position;
           break;
         case 'b':
           literalString.Append(wxS("\b"));
-          ch = ReadByte(stream);
+          ++m_position;
           break;
         case 'f':
           literalString.Append(wxS("\f"));
-          ch = ReadByte(stream);
+          ++m_position;
           break;
         case '\\':
         case '(':
         case ')':
           literalString.Append(wxUniChar((unsigned int) ch));
-          ch = ReadByte(stream);
+          ++m_position;
           break;
 
         default:
-          /* skip octal escape or ignore backslash */
-          int value = 0;
-          for (j = 0; j < 3 && !stream->Eof(); ++j)
           {
-            if (!('0' <= ch && ch <= '7')) break;
-            value = value * 8 + (ch - '0');
-            ch = ReadByte(stream);
+            /* octal escape or ignore backslash */
+            int value = 0;
+            for (j = 0; j < 3 && m_position < m_length; ++j)
+            {
+              ch = m_data[m_position];
+              if (!('0' <= ch && ch <= '7')) break;
+              value = value * 8 + (ch - '0');
+              ++m_position;
+            }
+            if (j > 0)
+            {
+              literalString.Append(wxUniChar(value));
+            }
           }
-          literalString.Append(wxUniChar(value));
           break;
       }
     }
@@ -1737,97 +1719,95 @@ wxPdfFontParserType1::GetLiteralString(wxInputStream* stream)
         literalString.Append(wxUniChar((unsigned int) ch));
       }
       embed++;
-      ch = ReadByte(stream);
     }
     else if (ch == ')')
     {
       embed--;
       if (embed == 0) break;
-      ch = ReadByte(stream);
+      literalString.Append(wxUniChar((unsigned int) ch));
     }
     else
     {
       literalString.Append(wxUniChar((unsigned int) ch));
-      ch = ReadByte(stream);
     }
   }
   return literalString;
 }
 
 wxString
-wxPdfFontParserType1::GetArray(wxInputStream* stream)
+wxPdfFontParserType1::GetArray()
 {
   wxString arrayString;
-  SkipSpaces(stream);
-  int embed = 0;
-  unsigned char ch = ReadByte(stream);
-  unsigned char delimBeg = ch;
-  unsigned char delimEnd = (ch == '[') ? ']' : '}';
-  while (!stream->Eof())
+  SkipSpaces();
+  if (m_position >= m_length)
   {
+    return arrayString;
+  }
+  int embed = 1;
+  unsigned char delimBeg = m_data[m_position++];
+  unsigned char delimEnd = (delimBeg == '[') ? ']' : '}';
+  int start = m_position;
+  while (m_position < m_length)
+  {
+    unsigned char ch = m_data[m_position];
     if (ch == delimBeg)
     {
-      if (embed > 0)
-      {
-        arrayString.Append(wxUniChar((unsigned int) ch));
-      }
       embed++;
-      ch = ReadByte(stream);
     }
     else if (ch == delimEnd)
     {
       embed--;
       if (embed == 0) break;
-      arrayString.Append(wxUniChar((unsigned int) ch));
-      ch = ReadByte(stream);
-    }
-    else
-    {
-      arrayString.Append(wxUniChar((unsigned int) ch));
-      ch = ReadByte(stream);
     }
+    ++m_position;
+  }
+  arrayString = wxString((const char*) m_data + start, wxConvISO8859_1, m_position - start);
+  if (m_position < m_length)
+  {
+    // skip the closing delimiter
+    ++m_position;
   }
   return arrayString;
 }
 
 void
-wxPdfFontParserType1::SkipString(wxInputStream* stream)
+wxPdfFontParserType1::SkipString()
 {
-  // first character must be `<'
-  char ch = (char) ReadByte(stream);
-  while (!stream->Eof())
+  // the opening `<' has already been consumed
+  bool endFound = false;
+  while (m_position < m_length)
   {
     // All whitespace characters are ignored.
-    SkipSpaces(stream);
-    if (stream->Eof()) break;
-    ch = (char) ReadByte(stream);
-    if (!((ch >= '0' && ch <= '9') || (ch >='A' && ch <='F') || (ch >= 'a' && ch <= 'f')))
+    SkipSpaces();
+    if (m_position >= m_length) break;
+    unsigned char ch = m_data[m_position++];
+    if (!IsHexDigit(ch))
     {
+      endFound = (ch == '>');
+      if (!endFound)
+      {
+        wxLogError(wxString(wxS("wxPdfFontParserType1::SkipString: ")) +
+                   wxString(_("skip_string: missing closing delimiter `>'")));
+      }
       break;
     }
   }
-  if (!stream->Eof() && ch != '>')
-  {
-    wxLogError(wxString(wxS("wxPdfFontParserType1::SkipString: ")) +
-               wxString(_("skip_string: missing closing delimiter `>'")));
-  }
 }
 
 void
-wxPdfFontParserType1::SkipProcedure(wxInputStream* stream)
+wxPdfFontParserType1::SkipProcedure()
 {
-  /* first character must be the opening brace that */
-  /* starts the procedure                           */
+  /* the opening brace that starts the procedure */
+  /* has already been consumed                   */
 
   /* NB: [ and ] need not match:                    */
   /* `/foo {[} def' is a valid PostScript fragment, */
   /* even within a Type1 font                       */
   bool endFound = false;
   int embed = 1;
-  char ch = (char) ReadByte(stream);
-  while (!endFound && !stream->Eof())
+  while (!endFound && m_position < m_length)
   {
-    switch (ch)
+    switch (m_data[m_position++])
     {
       case '{':
         ++embed;
@@ -1840,19 +1820,15 @@ wxPdfFontParserType1::SkipProcedure(wxInputStream* stream)
         }
         break;
       case '(':
-        SkipLiteralString(stream);
+        SkipLiteralString();
         break;
       case '<':
-        SkipString(stream);
+        SkipString();
         break;
       case '%':
-        SkipComment(stream);
+        SkipComment();
         break;
     }
-    if (!endFound)
-    {
-      ch = (char) ReadByte(stream);
-    }
   }
   if (!endFound)
   {
@@ -1862,20 +1838,15 @@ wxPdfFontParserType1::SkipProcedure(wxInputStream* stream)
 }
 
 void
-wxPdfFontParserType1::SkipArray(wxInputStream* stream)
+wxPdfFontParserType1::SkipArray()
 {
-  /* first character must be the opening brace that */
-  /* starts the procedure                           */
-
-  /* NB: [ and ] need not match:                    */
-  /* `/foo {[} def' is a valid PostScript fragment, */
-  /* even within a Type1 font                       */
+  /* the opening bracket that starts the array */
+  /* has already been consumed                 */
   bool endFound = false;
   int embed = 1;
-  char ch = (char) ReadByte(stream);
-  while (!endFound && !stream->Eof())
+  while (!endFound && m_position < m_length)
   {
-    switch (ch)
+    switch (m_data[m_position++])
     {
       case '[':
         ++embed;
@@ -1888,19 +1859,15 @@ wxPdfFontParserType1::SkipArray(wxInputStream* stream)
         }
         break;
       case '(':
-        SkipLiteralString(stream);
+        SkipLiteralString();
         break;
       case '<':
-        SkipString(stream);
+        SkipString();
         break;
       case '%':
-        SkipComment(stream);
+        SkipComment();
         break;
     }
-    if (!endFound)
-    {
-      ch = (char) ReadByte(stream);
-    }
   }
   if (!endFound)
   {
@@ -1910,96 +1877,84 @@ wxPdfFontParserType1::SkipArray(wxInputStream* stream)
 }
 
 void
-wxPdfFontParserType1::SkipToNextToken(wxInputStream* stream)
+wxPdfFontParserType1::SkipToNextToken()
 {
-  SkipSpaces(stream);
-  if (!stream->Eof())
+  SkipSpaces();
+  if (m_position < m_length)
   {
-    unsigned char ch = ReadByte(stream);
+    unsigned char ch = m_data[m_position++];
 
     if (ch == '[')
     {
-      if (m_skipArray) SkipArray(stream);
+      if (m_skipArray) SkipArray();
     }
     else if (ch == ']')
     {
-      //ch = (char) ReadByte(stream);
     }
     else if (ch == '{')
     {
-      SkipProcedure(stream);
+      SkipProcedure();
     }
     else if (ch == '(')
     {
-      SkipLiteralString(stream);
+      SkipLiteralString();
     }
     else if (ch == '<')
     {
-      ch = stream->Peek();
-      if (!stream->Eof() && ch == '<' )
+      if (m_position < m_length && m_data[m_position] == '<')
       {
-        ch = ReadByte(stream);
+        ++m_position;
       }
       else
       {
-        SkipString(stream);
+        SkipString();
       }
     }
     else if (ch == '>')
     {
-      ch = ReadByte(stream);
-      if (stream->Eof() || ch != '>' )   /* >> */
+      if (m_position >= m_length || m_data[m_position++] != '>')   /* >> */
       {
-//      FT_ERROR(( "ps_parser_skip_PS_token: unexpected closing delimiter `>'\n" ));
         wxLogError(wxString(wxS("wxPdfFontParserType1::SkipToNextToken: ")) +
                    wxString(_("Invalid File Format")));
       }
     }
     else
     {
-      stream->SeekI(-1, wxFromCurrent);
+      --m_position;
     }
   }
 }
 
 wxString
-wxPdfFontParserType1::GetToken(wxInputStream* stream)
+wxPdfFontParserType1::GetToken()
 {
   wxString str = wxEmptyString;
-  SkipSpaces(stream);
-  unsigned char ch = ReadByte(stream);
-  if (ch == '/')
+  SkipSpaces();
+  if (m_position < m_length && m_data[m_position] == '/')
   {
-    str.Append(wxUniChar((unsigned int) ch));
-    ch = ReadByte(stream);
+    str.Append(wxS('/'));
+    ++m_position;
   }
-  while (!stream->Eof())
+  int start = m_position;
+  while (m_position < m_length &&
+         !IsPostScriptSpace(m_data[m_position]) && !IsPostScriptDelimiter(m_data[m_position]))
   {
-    if (ch == ' '  || ch == '\r' || ch == '\n' ||
-        ch == '\t' || ch == '\f' || ch == '\0' ||
-        ch == '/'  || ch == '('  || ch == ')'  ||
-        ch == '<'  || ch == '>'  || ch == '['  ||
-        ch == ']'  || ch == '{'  || ch == '}'  ||
-        ch == '%')
-    {
-      if (str.IsEmpty() && (ch == '[' || ch == ']' /* || ch == '{' || ch == '}' */ ))
-      {
-        str.Append(wxUniChar((unsigned int) ch));
-      }
-      else
-      {
-        stream->SeekI(-1, wxFromCurrent);
-      }
-      break;
-    }
-    str.Append(wxUniChar((unsigned int) ch));
-    ch = ReadByte(stream);
+    ++m_position;
+  }
+  if (m_position > start)
+  {
+    str += wxString((const char*) m_data + start, wxConvISO8859_1, m_position - start);
+  }
+  else if (str.IsEmpty() && m_position < m_length &&
+           (m_data[m_position] == '[' || m_data[m_position] == ']'))
+  {
+    str.Append(wxUniChar((unsigned int) m_data[m_position++]));
   }
   return str;
 }
 
 bool
-wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bool onlyNames)
+wxPdfFontParserType1::ParseDict(const unsigned char* data, int length, bool onlyNames)
 {
 #if 0
   // Currently not used
@@ -2016,15 +1971,20 @@ wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bo
   bool ok = true;
   bool haveInteger = false;
   long intValue = 0;
-  int limit = start + length;
-  stream->SeekI(start);
-  while (!ready && stream->TellI() < limit)
+  m_data = data;
+  m_length = length;
+  m_position = 0;
+  while (!ready && m_position < m_length)
   {
-    wxString token = GetToken(stream);
+    wxString token = GetToken();
     // Check for the keywords 'eexec' or 'closefile',
     // either of those terminates a section
-    if (token.IsSameAs(wxS("eexec")) ||
-        token.IsSameAs(wxS("closefile")))
+    if (token.IsSameAs(wxS("eexec")))
+    {
+      m_eexecPosition = m_position;
+      break;
+    }
+    else if (token.IsSameAs(wxS("closefile")))
     {
       break;
     }
@@ -2045,7 +2005,7 @@ wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bo
     {
       // The keywords 'RD' or '-|' are not encountered directly in valid fonts,
       // since they are handled by one of the methods ParseSubrs and ParseCharStrings
-      stream->SeekI(intValue+1, wxFromCurrent);
+      m_position += (int) intValue + 1;
       haveInteger = false;
     }
     else if (!token.IsEmpty() && token.GetChar(0) == wxS('/'))
@@ -2056,11 +2016,11 @@ wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bo
       {
         if (token.IsSameAs(wxS("/FontMatrix")))
         {
-          ParseFontMatrix(stream);
+          ParseFontMatrix();
         }
         else if (token.IsSameAs(wxS("/Encoding")))
         {
-          ParseEncoding(stream);
+          ParseEncoding();
         }
         else if (token.IsSameAs(wxS("/Private")))
         {
@@ -2069,13 +2029,13 @@ wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bo
         else if (token.IsSameAs(wxS("/FontName")))
         {
           hasFontName = true;
-          param = GetToken(stream);
+          param = GetToken();
           m_fontData->SetName(param.substr(1));
         }
         else if (token.IsSameAs(wxS("/FullName")))
         {
           hasFullName = true;
-          param = GetLiteralString(stream);
+          param = GetLiteralString();
           wxArrayString fullNames;
           fullNames.Add(param);
           m_fontData->SetFullNames(fullNames);
@@ -2083,13 +2043,13 @@ wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bo
         else if (token.IsSameAs(wxS("/FamilyName")))
         {
           hasFamilyName = true;
-          param = GetLiteralString(stream);
+          param = GetLiteralString();
           m_fontData->SetFamily(param);
         }
         else if (token.IsSameAs(wxS("/Weight")))
         {
           hasWeight = true;
-          param = GetLiteralString(stream);
+          param = GetLiteralString();
           m_fontData->SetStyle(param);
         }
 
@@ -2097,7 +2057,7 @@ wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bo
   // For now most parameters are read from the metric file
         else if (token.IsSameAs(wxS("/ItalicAngle")))
         {
-          param = GetToken(stream);
+          param = GetToken();
           double italic = wxPdfUtility::String2Double(param);
           int italicAngle = int(italic);
           m_fontDesc.SetItalicAngle(italicAngle);
@@ -2108,7 +2068,7 @@ wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bo
         }
         else if (token.IsSameAs(wxS("/isFixedPitch")))
         {
-          param = GetToken(stream);
+          param = GetToken();
           if (param.IsSameAs(wxS("true")))
           {
             flags += 1 << 0;
@@ -2116,14 +2076,14 @@ wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bo
         }
         else if (token.IsSameAs(wxS("/UnderlinePosition")))
         {
-          param = GetToken(stream);
+          param = GetToken();
           long nParam;
           param.ToLong(&nParam);
           m_fontDesc.SetUnderlinePosition(nParam);
         }
         else if (token.IsSameAs(wxS("/UnderlineThickness")))
         {
-          param = GetToken(stream);
+          param = GetToken();
           long nParam;
           param.ToLong(&nParam);
           m_fontDesc.SetUnderlineThickness(nParam);
@@ -2132,7 +2092,7 @@ wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bo
         else if (token.IsSameAs(wxS("/FSType")))
         {
           hasFSType = true;
-          param = GetToken(stream);
+          param = GetToken();
           long fsType = 0;
           param.ToLong(&fsType);
           CheckRestrictions(fsType);
@@ -2147,7 +2107,7 @@ wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bo
         {
           if (!hasFontBBox)
           {
-            param = GetArray(stream);
+            param = GetArray();
             if (param.Find(wxS('{')) == wxNOT_FOUND &&
                 param.Find(wxS('[')) == wxNOT_FOUND)
             {
@@ -2157,12 +2117,12 @@ wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bo
           }
           else
           {
-            SkipToNextToken(stream);
+            SkipToNextToken();
           }
         }
         else
         {
-          SkipToNextToken(stream);
+          SkipToNextToken();
         }
       }
       else
@@ -2172,36 +2132,38 @@ wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bo
         // keywords except '/CharStrings' are ignored
         if (token.IsSameAs(wxS("/CharStrings")))
         {
-          ParseCharStrings(stream);
+          ParseCharStrings();
         }
         else if (!m_fontDirAfterPrivate)
         {
           if (token.IsSameAs(wxS("/Subrs")))
           {
-            ParseSubrs(stream);
+            ParseSubrs();
           }
           else if (token.IsSameAs(wxS("/lenIV")))
           {
-            param = GetToken(stream);
-            long lenIV;
-            param.ToLong(&lenIV);
+            param = GetToken();
+            param.ToLong(&m_lenIV);
             // maybe the keyword 'password' should be read. too
           }
           else
           {
-            SkipToNextToken(stream);
+            SkipToNextToken();
           }
         }
         else
         {
-          SkipToNextToken(stream);
+          SkipToNextToken();
         }
       }
       haveInteger = false;
     }
     else
     {
-      SkipToNextToken(stream);
+      int pos = m_position;
+      SkipToNextToken();
+      // Skip a stray delimiter
+      if (m_position == pos) ++m_position;
       haveInteger = false;
     }
     ready = onlyNames && hasFontName && hasFamilyName && hasFullName && hasWeight && hasFSType;
@@ -2215,9 +2177,9 @@ wxPdfFontParserType1::ParseDict(wxInputStream* stream, int start, int length, bo
 }
 
 void
-wxPdfFontParserType1::ParseFontMatrix(wxInputStream* stream)
+wxPdfFontParserType1::ParseFontMatrix()
 {
-  wxString matrix = GetArray(stream);
+  wxString matrix = GetArray();
 #if 0
   // If the font matrix is not [ 0.001 0 0 0.001 0 0]
   // font metrics need to be transformed accordingly
@@ -2242,14 +2204,14 @@ wxPdfFontParserType1::ParseFontMatrix(wxInputStream* stream)
 }
 
 void
-wxPdfFontParserType1::ParseEncoding(wxInputStream* stream)
+wxPdfFontParserType1::ParseEncoding()
 {
   wxString token;
   long count, n, code;
   bool onlyImmediates = false;
 
-  SkipSpaces(stream);
-  char ch = stream->Peek();
+  SkipSpaces();
+  unsigned char ch = (m_position < m_length) ? m_data[m_position] : 0;
   if (('0' <= ch && ch <= '9') || ch == '[')
   {
     // A number or `[' indicates that the encoding is an array
@@ -2258,14 +2220,14 @@ wxPdfFontParserType1::ParseEncoding(wxInputStream* stream)
     {
       count = 256;
       onlyImmediates = true;
-      ch = stream->GetC(); // skip '['
+      ++m_position; // skip '['
     }
     else
     {
-      token = GetToken(stream);
+      token = GetToken();
       token.ToLong(&count);
     }
-    SkipSpaces(stream);
+    SkipSpaces();
     // Allocate table with count entries
     m_encodingVector.Alloc(count);
     m_encodingVector.Insert(wxS(".notdef"), 0, count);
@@ -2275,19 +2237,27 @@ wxPdfFontParserType1::ParseEncoding(wxInputStream* stream)
     // If the array is given in the form '/Encoding [ ... ]' read immediates only.
 
     n = 0;
-    SkipSpaces(stream);
-    while (true)
+    SkipSpaces();
+    while (m_position < m_length)
     {
       // Stop when next token is 'def' or ']'
-      if (stream->Peek() == ']')
+      if (m_data[m_position] == ']')
       {
         break;
       }
-      token = GetToken(stream);
+      int pos = m_position;
+      token = GetToken();
       if (token.IsSameAs(wxS("def")) || token.IsSameAs(wxS("]")))
       {
         break;
       }
+      if (token.IsEmpty())
+      {
+        // Skip a stray delimiter
+        SkipToNextToken();
+        if (m_position == pos) ++m_position;
+        continue;
+      }
       if ((wxS('0') <= token[0] && token[0] <= wxS('9')) || onlyImmediates)
       {
         if (onlyImmediates)
@@ -2297,18 +2267,18 @@ wxPdfFontParserType1::ParseEncoding(wxInputStream* stream)
         else
         {
           token.ToLong(&code);
-          token = GetToken(stream);
+          token = GetToken();
         }
-        if (token[0] == wxS('/') && n < count)
+        if (!token.IsEmpty() && token[0] == wxS('/') && n < count && code >= 0 && code < count)
         {
           m_encodingVector[code] = token;
           n++;
-          SkipToNextToken(stream);
+          SkipToNextToken();
         }
       }
       else
       {
-        SkipToNextToken(stream);
+        SkipToNextToken();
       }
     }
     m_encoding = wxS("ArrayEncoding");
@@ -2317,7 +2287,7 @@ wxPdfFontParserType1::ParseEncoding(wxInputStream* stream)
   }
   else
   {
-    token = GetToken(stream);
+    token = GetToken();
     if (token.IsSameAs(wxS("StandardEncoding"))   ||
         token.IsSameAs(wxS("ExpertEncoding"))     ||
         token.IsSameAs(wxS("ISOLatin1Encoding")))
@@ -2329,30 +2299,33 @@ wxPdfFontParserType1::ParseEncoding(wxInputStream* stream)
 }
 
 void
-wxPdfFontParserType1::ParseSubrs(wxInputStream* stream)
+wxPdfFontParserType1::ParseSubrs()
 {
+  // The subroutines are not needed for extracting the glyph widths,
+  // therefore they are skipped without decrypting them
+
   // test for empty array
-  wxString token = GetToken(stream);
-  if (token[0] == wxS('['))
+  wxString token = GetToken();
+  if (!token.IsEmpty() && token[0] == wxS('['))
   {
-    SkipToNextToken(stream);
-    token = GetToken(stream);
-    if (token[0] != wxS(']'))
+    SkipToNextToken();
+    token = GetToken();
+    if (token.IsEmpty() || token[0] != wxS(']'))
     {
       wxLogError(wxString(wxS("wxPdfFontParserType1::ParseSubrs: ")) +
                  wxString(_("Invalid Type1 format")));
     }
     return;
   }
-  long numSubrs, n, subrno;
+  long numSubrs, n;
   token.ToLong(&numSubrs);
-  token = GetToken(stream); // 'array'
+  token = GetToken(); // 'array'
 
   // the format is simple: 'index' + binary data
 
   for (n = 0; n < numSubrs; n++)
   {
-    token = GetToken(stream);
+    token = GetToken();
     /* If the next token isn't `dup', we are also done.  This */
     /* happens when there are `holes' in the Subrs array.     */
     if (!token.IsSameAs(wxS("dup")))
@@ -2360,80 +2333,60 @@ wxPdfFontParserType1::ParseSubrs(wxInputStream* stream)
       break;
     }
 
-    token = GetToken(stream); // subr index
-    if (token.ToLong(&subrno))
-    token = GetToken(stream); // size
+    token = GetToken(); // subr index
+    token = GetToken(); // size
     long binarySize;
-    token.ToLong(&binarySize);
-    token = GetToken(stream);
-    int binaryStart = stream->TellI() + 1;
-    // Store glyph and charstring
-    wxMemoryOutputStream subr;
-    ReadBinary(*stream, binaryStart, binarySize, subr);
-
-    if (m_lenIV >= 0)
+    if (!token.ToLong(&binarySize) || binarySize < 0)
     {
-      if (binarySize < m_lenIV)
-      {
-        wxLogError(wxString(wxS("wxPdfFontParserType1::ParseSubrs: ")) +
-                   wxString(_("Invalid Type1 file format")));
-        break;
-      }
-      wxMemoryOutputStream subrDecoded;
-      DecodeEExec(&subr, &subrDecoded, 4330, m_lenIV);
-      //binarySize -= m_lenIV;
-      // skip lenIV bytes
-      m_subrsIndex->Add(wxPdfCffIndexElement(subrDecoded));
+      wxLogError(wxString(wxS("wxPdfFontParserType1::ParseSubrs: ")) +
+                 wxString(_("Invalid Type1 file format")));
+      break;
     }
-    else
+    token = GetToken(); // 'RD' or '-|'
+    int binaryStart = m_position + 1;
+    if (binaryStart + binarySize > m_length)
     {
-      m_subrsIndex->Add(wxPdfCffIndexElement(subr));
+      wxLogError(wxString(wxS("wxPdfFontParserType1::ParseSubrs: ")) +
+                 wxString(_("Invalid Type1 file format")));
+      m_position = m_length;
+      break;
     }
+    m_position = binaryStart + (int) binarySize;
 
-    stream->SeekI(binaryStart+binarySize);
     /* The binary string is followed by one token, e.g. `NP' */
     /* (bound to `noaccess put') or by two separate tokens:  */
     /* `noaccess' & `put'.  We position the parser right     */
     /* before the next `dup', if any.                        */
-    token = GetToken(stream); // `NP' or `|' or `noaccess'
+    token = GetToken(); // `NP' or `|' or `noaccess'
     if (token.IsSameAs(wxS("noaccess")))
     {
       // skip 'put'
-      token = GetToken(stream);
+      token = GetToken();
     }
   }
 }
 
 void
-wxPdfFontParserType1::ReadBinary(wxInputStream& inStream, int start, int size, wxOutputStream& outStream)
-{
-  char* buffer = new char[size];
-  inStream.SeekI(start);
-  inStream.Read(buffer, size);
-  outStream.Write(buffer, size);
-  delete [] buffer;
-}
-
-void
-wxPdfFontParserType1::ParseCharStrings(wxInputStream* stream)
+wxPdfFontParserType1::ParseCharStrings()
 {
   long numGlyphs, n;
   wxString token;
 
-  token = GetToken(stream);
+  token = GetToken();
   token.ToLong(&numGlyphs);
   if (numGlyphs == 0) return;
 
   wxPdfCffDecoder decoder;
+  wxMemoryBuffer charstringBuffer;
   n = 0;
   for (;;)
   {
     // Format of charstrings dictionary entries: '/glyphname' + binary data
-    SkipSpaces(stream);
-    if (stream->Eof()) break;
+    SkipSpaces();
+    if (m_position >= m_length) break;
 
     // All charstrings have been read when the keyword `def' or `end' is found
-    token = GetToken(stream);
+    token = GetToken();
     if (token.IsSameAs(wxS("def")))
     {
       // Ignore 'def' if no charstring has been seen yet
@@ -2444,46 +2397,49 @@ wxPdfFontParserType1::ParseCharStrings(wxInputStream* stream)
       break;
     }
 
-    if (token[0] == wxS('/'))
+    if (!token.IsEmpty() && token[0] == wxS('/'))
     {
       wxString glyphName = token.substr(1);
-      token = GetToken(stream);
+      token = GetToken();
       long binarySize;
-      if (token.ToLong(&binarySize))
+      if (token.ToLong(&binarySize) && binarySize >= 0)
       {
-        token = GetToken(stream);
-        int binaryStart = stream->TellI() + 1;
-        // Store glyph and charstring
-        wxMemoryOutputStream charstring;
-        ReadBinary(*stream, binaryStart, binarySize, charstring);
+        token = GetToken();
+        int binaryStart = m_position + 1;
+        if (binaryStart + binarySize > m_length ||
+            (m_lenIV >= 0 && binarySize < m_lenIV))
+        {
+          wxLogError(wxString(wxS("wxPdfFontParserType1::ParseCharStrings: ")) +
+                     wxString(_("Invalid Type1 file format")));
+          break;
+        }
 
+        // Only the leading part of the charstring is needed to get the glyph width,
+        // therefore only that part is decrypted
+        int length = (int) binarySize;
+        const unsigned char* charstring = m_data + binaryStart;
         if (m_lenIV >= 0)
         {
-          if (binarySize < m_lenIV)
-          {
-            wxLogError(wxString(wxS("wxPdfFontParserType1::ParseCharStrings: ")) +
-                       wxString(_("Invalid Type1 file format")));
-            break;
-          }
-          wxMemoryOutputStream charstringDecoded;
-          DecodeEExec(&charstring, &charstringDecoded, 4330, m_lenIV);
-          // skip lenIV bytes
-          // TODO: ?? binarySize -= m_lenIV;
-          m_charStringsIndex->Add(wxPdfCffIndexElement(charstringDecoded));
+          length = wxMin(length, (int) m_lenIV + gs_charStringPrefix);
+          unsigned char* buffer = (unsigned char*) charstringBuffer.GetWriteBuf(length);
+          memcpy(buffer, charstring, length);
+          unsigned int key = 4330U;
+          int skip = (int) m_lenIV;
+          length = DecodeEExec(buffer, length, key, skip);
+          charstring = buffer;
         }
         else
         {
-          m_charStringsIndex->Add(wxPdfCffIndexElement(charstring));
+          length = wxMin(length, gs_charStringPrefix);
         }
-        wxPdfCffIndexElement& element = (*m_charStringsIndex).Last();
         int width, bchar, achar;
         bool isComposite;
-        bool ok = decoder.GetCharWidthAndComposite(element, width, isComposite, bchar, achar);
+        bool ok = decoder.GetCharWidthAndComposite(charstring, length, width, isComposite, bchar, achar);
         if (ok)
         {
           (*m_glyphWidthMap)[glyphName] = (wxUint16) width;
         }
-        stream->SeekI(binaryStart+binarySize);
+        m_position = binaryStart + (int) binarySize;
       }
       else
       {
@@ -2497,10 +2453,13 @@ wxPdfFontParserType1::ParseCharStrings(wxInputStream* stream)
 }
 
 void
-wxPdfFontParserType1::ParsePrivate(wxInputStream* stream)
+wxPdfFontParserType1::ReadBinary(wxInputStream& inStream, int start, int size, wxOutputStream& outStream)
 {
-  wxUnusedVar(stream);
-  m_privateFound = true;
+  char* buffer = new char[size];
+  inStream.SeekI(start);
+  inStream.Read(buffer, size);
+  outStream.Write(buffer, size);
+  delete [] buffer;
 }
 
 // --- Convert Mac format to PFB format
@@ -32,12 +32,6 @@
 #include "wx/pdffontdata.h"
 #include "wx/pdffontsubsetcff.h"
 
-static int
-CompareInts(int n1, int n2)
-{
-  return n1 - n2;
-}
-
 // --- Implementation of OpenType Subset
 
 // CFF Dict Operators
@@ -126,8 +120,13 @@ wxPdfFontSubsetCff::wxPdfFontSubsetCff(const wxString& fileName)
   m_stringsSubsetIndex     = new wxPdfCffIndexArray();
   m_charstringsSubsetIndex = new wxPdfCffIndexArray();
 
-  m_hGlobalSubrsUsed = new wxPdfSortedArrayInt(CompareInts);
-  m_hLocalSubrsUsed = new wxPdfSortedArrayInt(CompareInts);
+  m_cffData = NULL;
+  m_cffLength = 0;
+  m_cffPosition = 0;
+  m_inFont = NULL;
+
+  m_hGlobalSubrsUsed = new wxPdfGlyphSet();
+  m_hLocalSubrsUsed = new wxPdfGlyphSet();
   m_decoder = new wxPdfCffDecoder(m_globalSubrIndex, m_hGlobalSubrsUsed, &m_lGlobalSubrsUsed);
 }
 
@@ -198,12 +197,24 @@ wxPdfFontSubsetCff::~wxPdfFontSubsetCff()
   delete m_hLocalSubrsUsed;
 
   delete m_decoder;
+  delete m_inFont;
 }
 
 wxMemoryOutputStream*
 wxPdfFontSubsetCff::CreateSubset(wxInputStream* inFont, wxPdfChar2GlyphMap* usedGlyphs, bool includeCmap)
 {
-  m_inFont = inFont;
+  // Parse from a contiguous copy of the CFF data, so that the subroutine
+  // scanner does not have to seek in the original stream
+  size_t fontSize = inFont->GetSize();
+  inFont->SeekI(0);
+  inFont->Read(m_cffBuffer.GetWriteBuf(fontSize), fontSize);
+  m_cffBuffer.UngetWriteBuf(inFont->LastRead());
+  m_cffData = (const unsigned char*) m_cffBuffer.GetData();
+  m_cffLength = (int) m_cffBuffer.GetDataLen();
+  m_cffPosition = 0;
+  delete m_inFont;
+  m_inFont = new wxMemoryInputStream(m_cffData, m_cffLength);
+
   m_numGlyphsUsed = (int) usedGlyphs->size();
   m_usedGlyphs.SetCount(m_numGlyphsUsed);
   wxPdfChar2GlyphMap::const_iterator glyphIter;
@@ -579,13 +590,13 @@ wxPdfFontSubsetCff::ReadGlobalSubroutines()
 void
 wxPdfFontSubsetCff::SeekI(int offset)
 {
-  m_inFont->SeekI(offset);
+  m_cffPosition = offset;
 }
 
 int
 wxPdfFontSubsetCff::TellI()
 {
-  return (int) m_inFont->TellI();
+  return m_cffPosition;
 }
 
 void
@@ -603,33 +614,39 @@ wxPdfFontSubsetCff::TellO()
 int
 wxPdfFontSubsetCff::GetSizeI()
 {
-  return (int) m_inFont->GetSize();
+  return m_cffLength;
 }
 
 unsigned char
 wxPdfFontSubsetCff::ReadByte()
 {
-  unsigned char card8;
-  m_inFont->Read(&card8, 1);
+  // Reading beyond the end yields 0, but the position always advances,
+  // so that loops over malformed data terminate
+  unsigned char card8 = (m_cffPosition >= 0 && m_cffPosition < m_cffLength) ? m_cffData[m_cffPosition] : 0;
+  m_cffPosition++;
   return card8;
 }
 
 short
 wxPdfFontSubsetCff::ReadShort()
 {
-  // Read a 2-byte integer from file (big endian)
-  short i16;
-  m_inFont->Read(&i16, 2);
-  return wxINT16_SWAP_ON_LE(i16);
+  // Read a 2-byte integer (big endian)
+  int b0 = ReadByte();
+  int b1 = ReadByte();
+  return (short) ((b0 << 8) | b1);
 }
 
 int
 wxPdfFontSubsetCff::ReadInt()
 {
-  // Read a 4-byte integer from file (big endian)
-  int i32;
-  m_inFont->Read(&i32, 4);
-  return wxINT32_SWAP_ON_LE(i32);
+  // Read a 4-byte integer (big endian)
+  wxUint32 i32 = 0;
+  int j;
+  for (j = 0; j < 4; j++)
+  {
+    i32 = (i32 << 8) | ReadByte();
+  }
+  return (int) (wxInt32) i32;
 }
 
 int
@@ -699,14 +716,11 @@ wxPdfFontSubsetCff::ReadString(int length)
   wxString str = wxEmptyString;
   if (length > 0)
   {
-    char* buffer = new char[length];
-    m_inFont->Read(buffer, length);
     int j;
     for (j = 0; j < length; j++)
     {
-      str.Append(buffer[j]);
+      str.Append((char) ReadByte());
     }
-    delete [] buffer;
   }
   return str;
 }
@@ -1369,7 +1383,7 @@ wxPdfFontSubsetCff::FindLocalAndGlobalSubrsUsed()
     {
       if (fdDictUsed[j])
       {
-        wxPdfSortedArrayInt hSubrsUsed(CompareInts);
+        wxPdfGlyphSet hSubrsUsed;
         wxArrayInt lSubrsUsed;
         //Scans the Charsting data storing the used Local and Global subroutines
         // by the glyphs. Scans the Subrs recursivley.
@@ -1397,42 +1411,30 @@ wxPdfFontSubsetCff::FindLocalAndGlobalSubrsUsed()
 }
 
 void
-wxPdfFontSubsetCff::SubsetSubrs(wxPdfCffIndexArray& subrIndex, wxPdfSortedArrayInt& subrsUsed)
+wxPdfFontSubsetCff::SubsetSubrs(wxPdfCffIndexArray& subrIndex, const wxPdfGlyphSet& subrsUsed)
 {
   size_t nSubrs = subrIndex.GetCount();
   if (nSubrs > 0)
   {
     size_t j;
-    bool* isSubrUsed = new bool[nSubrs];
-    int subr;
-    for (j = 0; j < nSubrs; j++)
-    {
-      isSubrUsed[j] = false;
-    }
-    for (j = 0; j < subrsUsed.GetCount(); j++)
-    {
-      subr = subrsUsed[j];
-      isSubrUsed[subr] = true;
-    }
     wxMemoryOutputStream buffer;
     char subrReturnOp = SUBR_RETURN_OP;
     buffer.Write(&subrReturnOp, 1);
     buffer.Close();
     for (j = 0; j < nSubrs; j++)
     {
-      if (!isSubrUsed[j])
+      if (!subrsUsed.Contains((wxUint32) j))
       {
         wxPdfCffIndexElement& subrElement = subrIndex[j];
         subrElement.SetBuffer(buffer);
       }
     }
-    delete [] isSubrUsed;
   }
 }
 
 void
 wxPdfFontSubsetCff::FindSubrsUsed(int fd, wxPdfCffIndexArray& localSubrIndex,
-                              wxPdfSortedArrayInt& hSubrsUsed, wxArrayInt& lSubrsUsed)
+                              wxPdfGlyphSet& hSubrsUsed, wxArrayInt& lSubrsUsed)
 {
   // Calc the Bias for the subr index
   int nSubrs = (int) localSubrIndex.GetCount();
@@ -1450,7 +1452,7 @@ wxPdfFontSubsetCff::FindSubrsUsed(int fd, wxPdfCffIndexArray& localSubrIndex,
       wxPdfCffIndexElement& charstring = (*m_charstringsIndex)[glyph];
       int beginChar = charstring.GetOffset();
       int endChar = beginChar + charstring.GetLength();
-      m_decoder->ReadASubr(m_inFont, beginChar, endChar, m_globalBias, localBias, hSubrsUsed, lSubrsUsed, localSubrIndex);
+      m_decoder->ReadASubr(m_cffData, beginChar, endChar, m_globalBias, localBias, hSubrsUsed, lSubrsUsed, localSubrIndex);
     }
   }
   // For all Lsubrs used, check recusrivly for Lsubr & Gsubr used
@@ -1465,7 +1467,7 @@ wxPdfFontSubsetCff::FindSubrsUsed(int fd, wxPdfCffIndexArray& localSubrIndex,
       wxPdfCffIndexElement& localSub = localSubrIndex[subr];
       int start = localSub.GetOffset();
       int end = start + localSub.GetLength();
-      m_decoder->ReadASubr(m_inFont, start, end, m_globalBias, localBias, hSubrsUsed, lSubrsUsed, localSubrIndex);
+      m_decoder->ReadASubr(m_cffData, start, end, m_globalBias, localBias, hSubrsUsed, lSubrsUsed, localSubrIndex);
     }
   }
 }
@@ -1500,14 +1502,14 @@ wxPdfFontSubsetCff::FindGlobalSubrsUsed()
       if (m_isCid)
       {
         wxPdfCffIndexArray dummy;
-        m_decoder->ReadASubr(m_inFont, start, end, m_globalBias, 0, *m_hGlobalSubrsUsed, m_lGlobalSubrsUsed, dummy);
+        m_decoder->ReadASubr(m_cffData, start, end, m_globalBias, 0, *m_hGlobalSubrsUsed, m_lGlobalSubrsUsed, dummy);
       }
       else
       {
 #if 0
         wxLogDebug(wxS("Call ReadASubr i=%d subr=%d"), i, subr);
 #endif
-        m_decoder->ReadASubr(m_inFont, start, end, m_globalBias, localBias,
+        m_decoder->ReadASubr(m_cffData, start, end, m_globalBias, localBias,
                              *m_hLocalSubrsUsed, m_lLocalSubrsUsed, *m_localSubrIndex);
         if (sizeOfNonCIDSubrsUsed < m_lLocalSubrsUsed.GetCount())
         {
@@ -1525,7 +1527,7 @@ wxPdfFontSubsetCff::FindGlobalSubrsUsed()
               wxPdfCffIndexElement& localSubr = (*m_localSubrIndex)[lSubr];
               int lStart = localSubr.GetOffset();
               int lEnd = lStart + localSubr.GetLength();
-              m_decoder->ReadASubr(m_inFont, lStart, lEnd, m_globalBias, localBias,
+              m_decoder->ReadASubr(m_cffData, lStart, lEnd, m_globalBias, localBias,
                                    *m_hLocalSubrsUsed, m_lLocalSubrsUsed, *m_localSubrIndex);
             }
           }
@@ -20,9 +20,20 @@
 #include <wx/wx.h>
 #endif
 
+#include <wx/hashmap.h>
 #include <wx/regex.h>
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
+#if wxUSE_THREADS
+#include <wx/thread.h>
+#endif
+
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "wx/pdffontvolt.h"
 
@@ -31,29 +42,294 @@ class wxPdfVoltRule
 public :
   /// Default constructor
   wxPdfVoltRule()
-    : m_repeat(false), m_match(wxS("")), m_replace(wxS(""))
+    : m_repeat(false), m_literal(false), m_match(wxS("")), m_replace(wxS(""))
   {
   }
 
   wxPdfVoltRule(bool repeat, const wxString& match, const wxString& replace)
-    : m_repeat(repeat), m_match(match), m_replace(replace)
+    : m_repeat(repeat), m_literal(false), m_match(match), m_replace(replace)
   {
-    m_re.Compile(m_match);
+    // Rules matching a plain string don't need the regular expression machinery
+    static const wxString metaChars = wxS(".[]()*+?{}|^$\\");
+    static const wxString replaceMetaChars = wxS("\\&");
+    m_literal = !m_match.IsEmpty() &&
+                m_match.find_first_of(metaChars) == wxString::npos &&
+                m_replace.find_first_of(replaceMetaChars) == wxString::npos;
+    if (!m_literal)
+    {
+      m_re.Compile(m_match);
+    }
   }
 
   ~wxPdfVoltRule()
   {
   }
 
+  /// Apply the rule once, returning the number of replacements or -1 on error
+  int Apply(wxString* text)
+  {
+    int count;
+    if (m_literal)
+    {
+      count = (int) text->Replace(m_match, m_replace);
+    }
+    else
+    {
+      count = m_re.Replace(text, m_replace);
+    }
+    return count;
+  }
+
 public:
   bool     m_repeat;
+  bool     m_literal;
   wxString m_match;
   wxString m_replace;
   wxRegEx  m_re;
 };
 
+typedef std::set<wchar_t> wxPdfVoltCharSet;
+
+// Analyzer for the regular expressions of VOLT rules.
+// It determines a set of characters of which at least one has to be contained in a text
+// for the expression to match. If no such set can be determined (i.e. for expressions
+// containing wildcards only, optional parts or unsupported syntax), the rule has to be
+// applied to every text.
+class wxPdfVoltPatternAnalyzer
+{
+public:
+  wxPdfVoltPatternAnalyzer(const wxString& pattern)
+    : m_buffer(pattern.wc_str()), m_supported(true)
+  {
+    m_pos = m_buffer.data();
+    m_end = m_pos + wxWcslen(m_pos);
+  }
+
+  /// Determine the trigger characters of the pattern
+  bool GetTriggerChars(wxPdfVoltCharSet& chars)
+  {
+    bool known = ParseAlternation(chars);
+    return m_supported && m_pos == m_end && known && !chars.empty();
+  }
+
+private:
+  bool ParseAlternation(wxPdfVoltCharSet& chars)
+  {
+    bool known = ParseSequence(chars);
+    while (m_supported && m_pos < m_end && *m_pos == wxS('|'))
+    {
+      ++m_pos;
+      wxPdfVoltCharSet branch;
+      known = ParseSequence(branch) && known;
+      chars.insert(branch.begin(), branch.end());
+    }
+    return known;
+  }
+
+  bool ParseSequence(wxPdfVoltCharSet& chars)
+  {
+    // All items of a sequence are mandatory, the smallest known set is the best choice
+    bool known = false;
+    while (m_supported && m_pos < m_end && *m_pos != wxS('|') && *m_pos != wxS(')'))
+    {
+      wxPdfVoltCharSet item;
+      if (ParseItem(item) && (!known || item.size() < chars.size()))
+      {
+        chars.swap(item);
+        known = true;
+      }
+    }
+    return known;
+  }
+
+  bool ParseItem(wxPdfVoltCharSet& chars)
+  {
+    bool known = ParseAtom(chars);
+    while (m_supported && m_pos < m_end)
+    {
+      wchar_t ch = *m_pos;
+      if (ch == wxS('*') || ch == wxS('?'))
+      {
+        known = false;
+        ++m_pos;
+      }
+      else if (ch == wxS('+'))
+      {
+        ++m_pos;
+      }
+      else if (ch == wxS('{'))
+      {
+        ++m_pos;
+        int minCount = 0;
+        bool hasDigits = false;
+        while (m_pos < m_end && *m_pos >= wxS('0') && *m_pos <= wxS('9'))
+        {
+          minCount = 10 * minCount + (*m_pos - wxS('0'));
+          hasDigits = true;
+          ++m_pos;
+        }
+        while (m_pos < m_end && *m_pos != wxS('}'))
+        {
+          ++m_pos;
+        }
+        if (!hasDigits || m_pos >= m_end)
+        {
+          m_supported = false;
+        }
+        else
+        {
+          ++m_pos;
+          if (minCount == 0)
+          {
+            known = false;
+          }
+        }
+      }
+      else
+      {
+        break;
+      }
+    }
+    return known;
+  }
+
+  bool ParseAtom(wxPdfVoltCharSet& chars)
+  {
+    bool known = false;
+    wchar_t ch = *m_pos++;
+    switch (ch)
+    {
+      case wxS('('):
+        if (m_pos < m_end && *m_pos == wxS('?'))
+        {
+          m_supported = false;
+        }
+        else
+        {
+          known = ParseAlternation(chars);
+          if (m_pos < m_end && *m_pos == wxS(')'))
+          {
+            ++m_pos;
+          }
+          else
+          {
+            m_supported = false;
+          }
+        }
+        break;
+      case wxS('['):
+        known = ParseBracket(chars);
+        break;
+      case wxS('.'):
+      case wxS('^'):
+      case wxS('$'):
+        break;
+      case wxS('\\'):
+        if (m_pos >= m_end)
+        {
+          m_supported = false;
+        }
+        else
+        {
+          // Escaped letters and digits denote classes, back references or code points
+          ch = *m_pos++;
+          if (!wxIsalnum(ch))
+          {
+            chars.insert(ch);
+            known = true;
+          }
+        }
+        break;
+      case wxS('*'):
+      case wxS('+'):
+      case wxS('?'):
+      case wxS('{'):
+        m_supported = false;
+        break;
+      default:
+        chars.insert(ch);
+        known = true;
+        break;
+    }
+    return known;
+  }
+
+  bool ParseBracket(wxPdfVoltCharSet& chars)
+  {
+    // Only simple enumerations of characters are supported
+    bool known = true;
+    if (m_pos < m_end && *m_pos == wxS('^'))
+    {
+      known = false;
+      ++m_pos;
+    }
+    bool first = true;
+    while (m_pos < m_end && (first || *m_pos != wxS(']')))
+    {
+      wchar_t ch = *m_pos++;
+      if (ch == wxS('\\') || (ch == wxS('[') && m_pos < m_end && (*m_pos == wxS(':') || *m_pos == wxS('.') || *m_pos == wxS('='))))
+      {
+        known = false;
+      }
+      else if (ch == wxS('-') && !first && m_pos < m_end && *m_pos != wxS(']'))
+      {
+        known = false;
+      }
+      else
+      {
+        chars.insert(ch);
+      }
+      first = false;
+    }
+    if (m_pos < m_end)
+    {
+      ++m_pos;
+    }
+    else
+    {
+      m_supported = false;
+    }
+    return known;
+  }
+
+  wxWCharBuffer  m_buffer;
+  const wchar_t* m_pos;
+  const wchar_t* m_end;
+  bool           m_supported;
+};
+
+// Recently processed texts and their results, most recently used first
+typedef std::list< std::pair<wxString, wxString> > wxPdfVoltResultList;
+WX_DECLARE_STRING_HASH_MAP(wxPdfVoltResultList::iterator, wxPdfVoltResultCache);
+
+// Character index and result cache of the VOLT rules of a font
+class wxPdfVoltIndex
+{
+public:
+  /// Maximum number of cached results
+  static const size_t ms_maxCacheSize = 1024;
+
+  /// Rules which have to be applied to every text
+  std::vector<bool> m_unconditional;
+
+  /// Rules triggered by a character
+  std::unordered_map< wchar_t, std::vector<size_t> > m_rulesByChar;
+
+  /// Recently processed texts and their results in order of use
+  wxPdfVoltResultList m_results;
+
+  /// Index of the recently processed texts
+  wxPdfVoltResultCache m_cache;
+
+#if wxUSE_THREADS
+  /// Critical section protecting the cache
+  wxCriticalSection m_cs;
+#endif
+};
+
 wxPdfVolt::wxPdfVolt()
 {
+  m_index = new wxPdfVoltIndex();
 }
 
 wxPdfVolt::~wxPdfVolt()
@@ -64,6 +340,7 @@ wxPdfVolt::~wxPdfVolt()
   {
     delete (wxPdfVoltRule*) m_rules.Item(j);
   }
+  delete m_index;
 }
 
 void
@@ -86,7 +363,21 @@ wxPdfVolt::LoadVoltData(wxXmlNode* volt)
           replace = rule->GetAttribute(wxS("replace"), wxS(""));
           doRepeat = repeat.IsSameAs(wxS("true"));
           wxPdfVoltRule* voltRule = new wxPdfVoltRule(doRepeat, match, replace);
+          size_t ruleIndex = m_rules.GetCount();
           m_rules.Add(voltRule);
+
+          wxPdfVoltCharSet triggerChars;
+          wxPdfVoltPatternAnalyzer analyzer(match);
+          bool conditional = analyzer.GetTriggerChars(triggerChars);
+          m_index->m_unconditional.push_back(!conditional);
+          if (conditional)
+          {
+            wxPdfVoltCharSet::const_iterator ch;
+            for (ch = triggerChars.begin(); ch != triggerChars.end(); ++ch)
+            {
+              m_index->m_rulesByChar[*ch].push_back(ruleIndex);
+            }
+          }
         }
         rule = rule->GetNext();
       }
@@ -97,19 +388,95 @@ wxPdfVolt::LoadVoltData(wxXmlNode* volt)
 
 wxString
 wxPdfVolt::ProcessRules(const wxString& text)
+{
+  {
+#if wxUSE_THREADS
+    wxCriticalSectionLocker locker(m_index->m_cs);
+#endif
+    wxPdfVoltResultCache::const_iterator cached = m_index->m_cache.find(text);
+    if (cached != m_index->m_cache.end())
+    {
+      // Mark the result as most recently used
+      m_index->m_results.splice(m_index->m_results.begin(), m_index->m_results, cached->second);
+      return cached->second->second;
+    }
+  }
+
+  wxString processText = ApplyRules(text);
+
+  {
+#if wxUSE_THREADS
+    wxCriticalSectionLocker locker(m_index->m_cs);
+#endif
+    // Another thread may have processed the same text in the meantime
+    if (m_index->m_cache.find(text) == m_index->m_cache.end())
+    {
+      if (m_index->m_results.size() >= wxPdfVoltIndex::ms_maxCacheSize)
+      {
+        // Evict the least recently used result
+        m_index->m_cache.erase(m_index->m_results.back().first);
+        m_index->m_results.pop_back();
+      }
+      m_index->m_results.push_front(std::make_pair(text, processText));
+      m_index->m_cache[text] = m_index->m_results.begin();
+    }
+  }
+  return processText;
+}
+
+// Mark the rules triggered by characters not seen before
+static void
+MarkTriggeredRules(const wxPdfVoltIndex* index, const wxString& text,
+                   std::unordered_set<wchar_t>& seenChars, std::vector<bool>& triggered)
+{
+  wxWCharBuffer buffer = text.wc_str();
+  const wchar_t* ch;
+  for (ch = buffer.data(); *ch != 0; ++ch)
+  {
+    if (seenChars.insert(*ch).second)
+    {
+      std::unordered_map< wchar_t, std::vector<size_t> >::const_iterator rules = index->m_rulesByChar.find(*ch);
+      if (rules != index->m_rulesByChar.end())
+      {
+        size_t k;
+        for (k = 0; k < rules->second.size(); ++k)
+        {
+          triggered[rules->second[k]] = true;
+        }
+      }
+    }
+  }
+}
+
+wxString
+wxPdfVolt::ApplyRules(const wxString& text) const
 {
   wxString processText = text;
   size_t n = m_rules.GetCount();
+  std::vector<bool> triggered(m_index->m_unconditional);
+  std::unordered_set<wchar_t> seenChars;
+  MarkTriggeredRules(m_index, processText, seenChars, triggered);
   size_t j;
   for (j = 0; j < n; ++j)
   {
+    if (!triggered[j])
+    {
+      continue;
+    }
     wxPdfVoltRule* rule = (wxPdfVoltRule*) m_rules.Item(j);
+    bool changed = false;
     int matchCount;
     do
     {
-      matchCount = rule->m_re.Replace(&processText, rule->m_replace);
+      matchCount = rule->Apply(&processText);
+      changed = changed || matchCount > 0;
     }
     while (rule->m_repeat && matchCount > 0);
+    if (changed)
+    {
+      // Replacements may introduce characters triggering subsequent rules
+      MarkTriggeredRules(m_index, processText, seenChars, triggered);
+    }
   }
   return processText;
 }
@@ -20,13 +20,17 @@
 #include <wx/wx.h>
 #endif
 
+#include <wx/filename.h>
 #include <wx/uri.h>
 #include <wx/url.h>
 #include <wx/gifdecod.h>
 #include <wx/wfstream.h>
 #include <wx/zstream.h>
 
+#include <math.h>
+
 #include "wx/pdfdocument.h"
+#include "wx/pdfencrypt.h"
 #include "wx/pdfimage.h"
 #include "wx/pdfutility.h"
 
@@ -70,6 +74,18 @@ wxPdfImage::wxPdfImage(wxPdfDocument* document, int index, const wxString& filen
   m_trns     = NULL;
   m_dataSize = 0;
   m_data     = NULL;
+  m_alphaSize = 0;
+  m_alpha     = NULL;
+  m_alphaBpc  = 8;
+
+  m_placedWidth  = 0;
+  m_placedHeight = 0;
+  m_placementUnknown = false;
+
+  m_pending        = false;
+  m_pendingJpeg    = false;
+  m_pendingChannel = NULL;
+  m_pendingBpc     = 8;
 
   wxString fileURL = m_name;
   wxURI uri(m_name);
@@ -83,6 +99,24 @@ wxPdfImage::wxPdfImage(wxPdfDocument* document, int index, const wxString& filen
     wxString mimeType = m_imageFile->GetMimeType();
     m_type = (mimeType != wxEmptyString) ? mimeType : type.Lower();
     m_imageStream = m_imageFile->GetStream();
+
+    // The image data of local image files are read only on output of the image
+    if (fileURL.StartsWith(wxS("file:")) && fileURL.Find(wxS('#')) == wxNOT_FOUND &&
+        m_imageStream != NULL && m_imageStream->IsSeekable())
+    {
+      wxFileName dataFileName = wxFileSystem::URLToFileName(fileURL);
+      if (dataFileName.FileExists())
+      {
+        // Size and modification time are checked on output to detect changes of the file
+        m_dataFileSize = dataFileName.GetSize();
+        m_dataFileTime = dataFileName.GetModificationTime();
+        if (m_dataFileSize != wxInvalidSize && m_dataFileTime.IsValid())
+        {
+          dataFileName.MakeAbsolute();
+          m_dataFileName = dataFileName.GetFullPath();
+        }
+      }
+    }
   }
   else
   {
@@ -92,7 +126,7 @@ wxPdfImage::wxPdfImage(wxPdfDocument* document, int index, const wxString& filen
 }
 
 wxPdfImage::wxPdfImage(wxPdfDocument* document, int index, const wxString& name, const wxImage& image,
-                       bool jpegFormat)
+                       bool jpegFormat, bool deferred)
 {
   m_document = document;
   m_index    = index;
@@ -114,8 +148,44 @@ wxPdfImage::wxPdfImage(wxPdfDocument* document, int index, const wxString& name,
   m_trns     = NULL;
   m_dataSize = 0;
   m_data     = NULL;
+  m_alphaSize = 0;
+  m_alpha     = NULL;
+  m_alphaBpc  = 8;
 
-  m_validWxImage = ConvertWxImage(image, jpegFormat);
+  m_placedWidth  = 0;
+  m_placedHeight = 0;
+  m_placementUnknown = false;
+
+  m_pending        = false;
+  m_pendingJpeg    = false;
+  m_pendingChannel = NULL;
+  m_pendingBpc     = 8;
+
+  if (deferred)
+  {
+    // Only the image size is determined now, the image is converted by Prepare
+#if wxUSE_LIBJPEG
+    if (jpegFormat && wxImage::FindHandler(wxBITMAP_TYPE_JPEG) == NULL)
+    {
+      wxImage::AddHandler(new wxJPEGHandler());
+    }
+    m_validWxImage = image.IsOk();
+#else
+    m_validWxImage = image.IsOk() && !jpegFormat;
+#endif // wxUSE_LIBJPEG
+    if (m_validWxImage)
+    {
+      m_pendingImage = image.Copy();
+      m_pendingJpeg = jpegFormat;
+      m_pending = true;
+      m_width  = image.GetWidth();
+      m_height = image.GetHeight();
+    }
+  }
+  else
+  {
+    m_validWxImage = ConvertWxImage(image, jpegFormat);
+  }
 
   m_imageFile = NULL;
   m_imageStream = NULL;
@@ -144,17 +214,127 @@ wxPdfImage::wxPdfImage(wxPdfDocument* document, int index, const wxString& name,
   m_trns     = NULL;
   m_dataSize = 0;
   m_data     = NULL;
+  m_alphaSize = 0;
+  m_alpha     = NULL;
+  m_alphaBpc  = 8;
+
+  m_placedWidth  = 0;
+  m_placedHeight = 0;
+  m_placementUnknown = false;
+
+  m_pending        = false;
+  m_pendingJpeg    = false;
+  m_pendingChannel = NULL;
+  m_pendingBpc     = 8;
 
   m_imageFile = NULL;
   m_type = mimeType;
   m_imageStream = &stream;
 }
 
+wxPdfImage::wxPdfImage(wxPdfDocument* document, int index, const wxString& name,
+                       const unsigned char* channel, int width, int height, int bitsPerComponent,
+                       bool deferred)
+{
+  m_document = document;
+  m_index    = index;
+  m_name     = name;
+  m_maskImage = 0;
+  m_isFormObj = false;
+  m_fromWxImage = true;
+
+  m_width    = 0;
+  m_height   = 0;
+  m_cs       = wxS("");
+  m_bpc      = '\0';
+  m_f        = wxS("");
+  m_parms    = wxS("");
+
+  m_palSize  = 0;
+  m_pal      = NULL;
+  m_trnsSize = 0;
+  m_trns     = NULL;
+  m_dataSize = 0;
+  m_data     = NULL;
+  m_alphaSize = 0;
+  m_alpha     = NULL;
+  m_alphaBpc  = 8;
+
+  m_placedWidth  = 0;
+  m_placedHeight = 0;
+  m_placementUnknown = false;
+
+  m_pending        = false;
+  m_pendingJpeg    = false;
+  m_pendingChannel = NULL;
+  m_pendingBpc     = 8;
+
+  m_type = wxS("png");
+  int pixelSize = (bitsPerComponent == 16) ? 2 : 1;
+  if (deferred)
+  {
+    // Only the image size is determined now, the channel is converted by Prepare
+    m_validWxImage = (channel != NULL) && width > 0 && height > 0;
+    if (m_validWxImage)
+    {
+      size_t channelSize = (size_t) width * height * pixelSize;
+      m_pendingChannel = new unsigned char[channelSize];
+      memcpy(m_pendingChannel, channel, channelSize);
+      m_pendingBpc = 8 * pixelSize;
+      m_pending = true;
+      m_width  = width;
+      m_height = height;
+    }
+  }
+  else
+  {
+    m_validWxImage = (channel != NULL) && ConvertPixels(channel, width, height, 1, pixelSize, 8 * pixelSize);
+  }
+
+  m_imageFile = NULL;
+  m_imageStream = NULL;
+}
+
 wxPdfImage::~wxPdfImage()
 {
   if (m_pal  != NULL) delete [] m_pal;
   if (m_trns != NULL) delete [] m_trns;
   if (m_data != NULL) delete [] m_data;
+  if (m_pendingChannel != NULL) delete [] m_pendingChannel;
+  FreeAlphaChannel();
+}
+
+bool
+wxPdfImage::Prepare()
+{
+  if (m_pending)
+  {
+    if (m_pendingChannel != NULL)
+    {
+      int pixelSize = m_pendingBpc / 8;
+      m_validWxImage = ConvertPixels(m_pendingChannel, m_width, m_height, 1, pixelSize, m_pendingBpc);
+      delete [] m_pendingChannel;
+      m_pendingChannel = NULL;
+    }
+    else
+    {
+      m_validWxImage = ConvertWxImage(m_pendingImage, m_pendingJpeg);
+      m_pendingImage.Destroy();
+    }
+    m_pending = false;
+  }
+  return m_validWxImage;
+}
+
+void
+wxPdfImage::FreeAlphaChannel()
+{
+  if (m_alpha != NULL)
+  {
+    delete [] m_alpha;
+    m_alpha = NULL;
+  }
+  m_alphaSize = 0;
 }
 
 bool
@@ -168,39 +348,635 @@ wxPdfImage::ConvertWxImage(const wxImage& image, bool jpegFormat)
 #endif // wxUSE_LIBJPEG
 
   bool isValid = false;
+  if (!jpegFormat)
+  {
+    // The pixel data are compressed directly instead of encoding and reparsing a PNG image
+    const unsigned char* pixels = image.GetData();
+    int w = image.GetWidth();
+    int h = image.GetHeight();
+    if (pixels == NULL)
+    {
+      return false;
+    }
+    m_type = wxS("png");
+    int pngFormat = (image.HasOption(wxIMAGE_OPTION_PNG_FORMAT)) ? image.GetOptionInt(wxIMAGE_OPTION_PNG_FORMAT) : wxPNG_TYPE_COLOUR;
+    if (pngFormat == wxPNG_TYPE_GREY_RED)
+    {
+      isValid = ConvertPixels(pixels, w, h, 1, 3);
+    }
+    else if (pngFormat == wxPNG_TYPE_GREY)
+    {
+      size_t numPixels = (size_t) w * (size_t) h;
+      unsigned char* grey = new unsigned char[numPixels];
+      size_t j;
+      for (j = 0; j < numPixels; ++j)
+      {
+        const unsigned char* rgb = pixels + 3 * j;
+        grey[j] = (unsigned char) ((rgb[0] * 299 + rgb[1] * 587 + rgb[2] * 114) / 1000);
+      }
+      isValid = ConvertPixels(grey, w, h, 1, 1);
+      delete [] grey;
+    }
+    else if (!IsBilevel(pixels, w, h, 3, 3) && ConvertIndexed(pixels, w, h))
+    {
+      // Images with few colours are embedded with a palette
+      isValid = true;
+    }
+    else
+    {
+      isValid = ConvertPixels(pixels, w, h, 3, 3);
+    }
+    return isValid;
+  }
+
   wxBitmapType bitmapType = (jpegFormat) ? wxBITMAP_TYPE_JPEG : wxBITMAP_TYPE_PNG;
   if (wxImage::FindHandler(bitmapType) == NULL)
   {
-#if wxUSE_LIBJPEG
-    if (jpegFormat)
-    {
-      wxImage::AddHandler(new wxJPEGHandler());
-    }
-    else
-#endif // wxUSE_LIBJPEG
+#if wxUSE_LIBJPEG
+    if (jpegFormat)
+    {
+      wxImage::AddHandler(new wxJPEGHandler());
+    }
+    else
+#endif // wxUSE_LIBJPEG
+    {
+      wxImage::AddHandler(new wxPNGHandler());
+    }
+  }
+  wxMemoryOutputStream os;
+  isValid = image.SaveFile(os, bitmapType);
+  if (isValid)
+  {
+    wxMemoryInputStream is(os);
+#if wxUSE_LIBJPEG
+    if (jpegFormat)
+    {
+      m_type = wxS("jpeg");
+      isValid = ParseJPG(&is);
+    }
+    else
+#endif // wxUSE_LIBJPEG
+    {
+      m_type = wxS("png");
+      isValid = ParsePNG(&is);
+    }
+  }
+  return isValid;
+}
+
+// Apply a PNG filter to a row of pixel data; the filter type is stored in the first output byte
+static void
+FilterPngRow(int type, const unsigned char* row, const unsigned char* prior, size_t rowBytes, size_t bpp, unsigned char* out)
+{
+  *out++ = (unsigned char) type;
+  size_t j;
+  switch (type)
+  {
+    case 1: // Sub
+      for (j = 0; j < rowBytes; ++j)
+      {
+        out[j] = row[j] - ((j >= bpp) ? row[j-bpp] : 0);
+      }
+      break;
+    case 2: // Up
+      for (j = 0; j < rowBytes; ++j)
+      {
+        out[j] = row[j] - prior[j];
+      }
+      break;
+    case 3: // Average
+      for (j = 0; j < rowBytes; ++j)
+      {
+        int left = (j >= bpp) ? row[j-bpp] : 0;
+        out[j] = row[j] - (unsigned char) ((left + prior[j]) >> 1);
+      }
+      break;
+    case 4: // Paeth
+      for (j = 0; j < rowBytes; ++j)
+      {
+        int a = (j >= bpp) ? row[j-bpp] : 0;
+        int b = prior[j];
+        int c = (j >= bpp) ? prior[j-bpp] : 0;
+        int p = a + b - c;
+        int pa = abs(p - a);
+        int pb = abs(p - b);
+        int pc = abs(p - c);
+        int predicted = (pa <= pb && pa <= pc) ? a : ((pb <= pc) ? b : c);
+        out[j] = row[j] - (unsigned char) predicted;
+      }
+      break;
+    default: // None
+      memcpy(out, row, rowBytes);
+      break;
+  }
+}
+
+// Estimate the compressibility of a filtered row (sum of absolute differences, as used by libpng)
+static unsigned long
+GetPngRowCost(const unsigned char* out, size_t rowBytes)
+{
+  unsigned long cost = 0;
+  size_t j;
+  for (j = 1; j <= rowBytes; ++j)
+  {
+    cost += (out[j] < 128) ? out[j] : 256 - out[j];
+  }
+  return cost;
+}
+
+// --- CCITT Group 4 encoding of bilevel images ---
+
+/// Code of the CCITT modified Huffman tables
+struct wxPdfCcittCode
+{
+  unsigned short code; ///< Code bits (right aligned)
+  unsigned char  bits; ///< Code length in bits
+};
+
+// White run length terminating codes (0..63)
+static const wxPdfCcittCode gs_whiteTermCodes[] =
+{
+  { 0x035,  8 }, { 0x007,  6 }, { 0x007,  4 }, { 0x008,  4 }, { 0x00b,  4 }, { 0x00c,  4 },
+  { 0x00e,  4 }, { 0x00f,  4 }, { 0x013,  5 }, { 0x014,  5 }, { 0x007,  5 }, { 0x008,  5 },
+  { 0x008,  6 }, { 0x003,  6 }, { 0x034,  6 }, { 0x035,  6 }, { 0x02a,  6 }, { 0x02b,  6 },
+  { 0x027,  7 }, { 0x00c,  7 }, { 0x008,  7 }, { 0x017,  7 }, { 0x003,  7 }, { 0x004,  7 },
+  { 0x028,  7 }, { 0x02b,  7 }, { 0x013,  7 }, { 0x024,  7 }, { 0x018,  7 }, { 0x002,  8 },
+  { 0x003,  8 }, { 0x01a,  8 }, { 0x01b,  8 }, { 0x012,  8 }, { 0x013,  8 }, { 0x014,  8 },
+  { 0x015,  8 }, { 0x016,  8 }, { 0x017,  8 }, { 0x028,  8 }, { 0x029,  8 }, { 0x02a,  8 },
+  { 0x02b,  8 }, { 0x02c,  8 }, { 0x02d,  8 }, { 0x004,  8 }, { 0x005,  8 }, { 0x00a,  8 },
+  { 0x00b,  8 }, { 0x052,  8 }, { 0x053,  8 }, { 0x054,  8 }, { 0x055,  8 }, { 0x024,  8 },
+  { 0x025,  8 }, { 0x058,  8 }, { 0x059,  8 }, { 0x05a,  8 }, { 0x05b,  8 }, { 0x04a,  8 },
+  { 0x04b,  8 }, { 0x032,  8 }, { 0x033,  8 }, { 0x034,  8 }
+};
+
+// White run length make-up codes (64..1728)
+static const wxPdfCcittCode gs_whiteMakeupCodes[] =
+{
+  { 0x01b,  5 }, { 0x012,  5 }, { 0x017,  6 }, { 0x037,  7 }, { 0x036,  8 }, { 0x037,  8 },
+  { 0x064,  8 }, { 0x065,  8 }, { 0x068,  8 }, { 0x067,  8 }, { 0x0cc,  9 }, { 0x0cd,  9 },
+  { 0x0d2,  9 }, { 0x0d3,  9 }, { 0x0d4,  9 }, { 0x0d5,  9 }, { 0x0d6,  9 }, { 0x0d7,  9 },
+  { 0x0d8,  9 }, { 0x0d9,  9 }, { 0x0da,  9 }, { 0x0db,  9 }, { 0x098,  9 }, { 0x099,  9 },
+  { 0x09a,  9 }, { 0x018,  6 }, { 0x09b,  9 }
+};
+
+// Black run length terminating codes (0..63)
+static const wxPdfCcittCode gs_blackTermCodes[] =
+{
+  { 0x037, 10 }, { 0x002,  3 }, { 0x003,  2 }, { 0x002,  2 }, { 0x003,  3 }, { 0x003,  4 },
+  { 0x002,  4 }, { 0x003,  5 }, { 0x005,  6 }, { 0x004,  6 }, { 0x004,  7 }, { 0x005,  7 },
+  { 0x007,  7 }, { 0x004,  8 }, { 0x007,  8 }, { 0x018,  9 }, { 0x017, 10 }, { 0x018, 10 },
+  { 0x008, 10 }, { 0x067, 11 }, { 0x068, 11 }, { 0x06c, 11 }, { 0x037, 11 }, { 0x028, 11 },
+  { 0x017, 11 }, { 0x018, 11 }, { 0x0ca, 12 }, { 0x0cb, 12 }, { 0x0cc, 12 }, { 0x0cd, 12 },
+  { 0x068, 12 }, { 0x069, 12 }, { 0x06a, 12 }, { 0x06b, 12 }, { 0x0d2, 12 }, { 0x0d3, 12 },
+  { 0x0d4, 12 }, { 0x0d5, 12 }, { 0x0d6, 12 }, { 0x0d7, 12 }, { 0x06c, 12 }, { 0x06d, 12 },
+  { 0x0da, 12 }, { 0x0db, 12 }, { 0x054, 12 }, { 0x055, 12 }, { 0x056, 12 }, { 0x057, 12 },
+  { 0x064, 12 }, { 0x065, 12 }, { 0x052, 12 }, { 0x053, 12 }, { 0x024, 12 }, { 0x037, 12 },
+  { 0x038, 12 }, { 0x027, 12 }, { 0x028, 12 }, { 0x058, 12 }, { 0x059, 12 }, { 0x02b, 12 },
+  { 0x02c, 12 }, { 0x05a, 12 }, { 0x066, 12 }, { 0x067, 12 }
+};
+
+// Black run length make-up codes (64..1728)
+static const wxPdfCcittCode gs_blackMakeupCodes[] =
+{
+  { 0x00f, 10 }, { 0x0c8, 12 }, { 0x0c9, 12 }, { 0x05b, 12 }, { 0x033, 12 }, { 0x034, 12 },
+  { 0x035, 12 }, { 0x06c, 13 }, { 0x06d, 13 }, { 0x04a, 13 }, { 0x04b, 13 }, { 0x04c, 13 },
+  { 0x04d, 13 }, { 0x072, 13 }, { 0x073, 13 }, { 0x074, 13 }, { 0x075, 13 }, { 0x076, 13 },
+  { 0x077, 13 }, { 0x052, 13 }, { 0x053, 13 }, { 0x054, 13 }, { 0x055, 13 }, { 0x05a, 13 },
+  { 0x05b, 13 }, { 0x064, 13 }, { 0x065, 13 }
+};
+
+// Extended make-up codes for both colours (1792..2560)
+static const wxPdfCcittCode gs_extMakeupCodes[] =
+{
+  { 0x008, 11 }, { 0x00c, 11 }, { 0x00d, 11 }, { 0x012, 12 }, { 0x013, 12 }, { 0x014, 12 },
+  { 0x015, 12 }, { 0x016, 12 }, { 0x017, 12 }, { 0x01c, 12 }, { 0x01d, 12 }, { 0x01e, 12 },
+  { 0x01f, 12 }
+};
+
+// Vertical mode codes for a1-b1 = -3..3
+static const wxPdfCcittCode gs_verticalCodes[] =
+{
+  { 0x002,  7 }, { 0x002,  6 }, { 0x002,  3 }, { 0x001,  1 }, { 0x003,  3 }, { 0x003,  6 }, { 0x003,  7 }
+};
+
+// Bit writer for CCITT encoded data
+class wxPdfCcittWriter
+{
+public:
+  wxPdfCcittWriter(std::vector<unsigned char>& data)
+    : m_data(data), m_bitBuffer(0), m_bitCount(0)
+  {
+  }
+
+  void PutBits(unsigned int code, int bits)
+  {
+    m_bitBuffer = (m_bitBuffer << bits) | code;
+    m_bitCount += bits;
+    while (m_bitCount >= 8)
+    {
+      m_bitCount -= 8;
+      m_data.push_back((unsigned char) (m_bitBuffer >> m_bitCount));
+    }
+    m_bitBuffer &= (1u << m_bitCount) - 1;
+  }
+
+  void PutCode(const wxPdfCcittCode& code)
+  {
+    PutBits(code.code, code.bits);
+  }
+
+  void PutRun(int length, bool black)
+  {
+    while (length >= 2560)
+    {
+      PutCode(gs_extMakeupCodes[12]);
+      length -= 2560;
+    }
+    if (length >= 64)
+    {
+      int makeup = length / 64;
+      if (makeup <= 27)
+      {
+        PutCode((black) ? gs_blackMakeupCodes[makeup-1] : gs_whiteMakeupCodes[makeup-1]);
+      }
+      else
+      {
+        PutCode(gs_extMakeupCodes[makeup-28]);
+      }
+      length -= makeup * 64;
+    }
+    PutCode((black) ? gs_blackTermCodes[length] : gs_whiteTermCodes[length]);
+  }
+
+  void Flush()
+  {
+    if (m_bitCount > 0)
+    {
+      m_data.push_back((unsigned char) (m_bitBuffer << (8 - m_bitCount)));
+      m_bitBuffer = 0;
+      m_bitCount = 0;
+    }
+  }
+
+private:
+  std::vector<unsigned char>& m_data; ///< Encoded data
+  unsigned int m_bitBuffer;           ///< Pending bits
+  int          m_bitCount;            ///< Number of pending bits
+};
+
+// Find the next changing element after position pos (pixels: 0 = white, 1 = black)
+static int
+NextChangingElement(const unsigned char* line, int width, int pos)
+{
+  int p = pos + 1;
+  if (p >= width)
+  {
+    return width;
+  }
+  unsigned char colour = (p > 0) ? line[p-1] : 0;
+  while (p < width && line[p] == colour)
+  {
+    ++p;
+  }
+  return p;
+}
+
+// Encode packed bilevel rows (most significant bit first, 1 = white) in CCITT Group 4 format
+static void
+EncodeCcittG4(const unsigned char* bits, size_t rowBytes, int width, int height, std::vector<unsigned char>& data)
+{
+  wxPdfCcittWriter writer(data);
+  std::vector<unsigned char> lines(2 * (size_t) width, 0);
+  unsigned char* ref = &lines[0];
+  unsigned char* cur = &lines[width];
+  int x, y;
+  for (y = 0; y < height; ++y)
+  {
+    const unsigned char* row = bits + y * rowBytes;
+    for (x = 0; x < width; ++x)
+    {
+      cur[x] = ((row[x >> 3] >> (7 - (x & 7))) & 1) ? 0 : 1;
+    }
+
+    int a0 = -1;
+    unsigned char colour = 0;
+    while (a0 < width)
+    {
+      int a1 = NextChangingElement(cur, width, a0);
+      int b1 = NextChangingElement(ref, width, a0);
+      if (b1 < width && ref[b1] == colour)
+      {
+        b1 = NextChangingElement(ref, width, b1);
+      }
+      int b2 = NextChangingElement(ref, width, b1);
+      if (b2 < a1)
+      {
+        // Pass mode
+        writer.PutBits(0x1, 4);
+        a0 = b2;
+      }
+      else if (a1 - b1 >= -3 && a1 - b1 <= 3)
+      {
+        // Vertical mode
+        writer.PutCode(gs_verticalCodes[a1 - b1 + 3]);
+        a0 = a1;
+        colour ^= 1;
+      }
+      else
+      {
+        // Horizontal mode
+        int a2 = NextChangingElement(cur, width, a1);
+        writer.PutBits(0x1, 3);
+        writer.PutRun(a1 - ((a0 < 0) ? 0 : a0), colour != 0);
+        writer.PutRun(a2 - a1, colour == 0);
+        a0 = a2;
+      }
+    }
+    unsigned char* swap = ref;
+    ref = cur;
+    cur = swap;
+  }
+  // End of facsimile block
+  writer.PutBits(0x1, 12);
+  writer.PutBits(0x1, 12);
+  writer.Flush();
+}
+
+// Check whether 8-bit pixel data contain only black and white pixels
+static bool
+IsBilevel(const unsigned char* pixels, int width, int height, int colours, int pixelSize)
+{
+  size_t numPixels = (size_t) width * height;
+  size_t j;
+  for (j = 0; j < numPixels; ++j, pixels += pixelSize)
+  {
+    unsigned char value = pixels[0];
+    if (value != 0 && value != 255)
+    {
+      return false;
+    }
+    int k;
+    for (k = 1; k < colours; ++k)
+    {
+      if (pixels[k] != value)
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool
+wxPdfImage::ConvertPixels(const unsigned char* pixels, int width, int height, int colours, int pixelSize,
+                          int bitsPerComponent)
+{
+  if (pixels == NULL || width <= 0 || height <= 0)
+  {
+    return false;
+  }
+  if (bitsPerComponent == 8 && IsBilevel(pixels, width, height, colours, pixelSize))
+  {
+    return ConvertBilevel(pixels, width, height, pixelSize);
+  }
+  bool predictor = (m_document != NULL) ? m_document->GetImagePredictor() : true;
+  int pixelBytes = colours * (bitsPerComponent / 8);
+  size_t rowBytes = (size_t) width * pixelBytes;
+  size_t rowStride = (size_t) width * pixelSize;
+
+  wxMemoryOutputStream compressed;
+  {
+    wxZlibOutputStream zout(compressed);
+    if (!predictor && pixelSize == pixelBytes)
+    {
+      zout.Write(pixels, rowBytes * height);
+    }
+    else
+    {
+      // Rows are extracted if necessary and filtered one at a time;
+      // for each row the PNG filter giving the best compressibility estimate is used
+      size_t rowSize = rowBytes + 1;
+      unsigned char* buffer = new unsigned char[3 * rowBytes + 5 * rowSize];
+      unsigned char* zeroRow = buffer;
+      unsigned char* rowBuffer[2] = { buffer + rowBytes, buffer + 2 * rowBytes };
+      unsigned char* filtered = buffer + 3 * rowBytes;
+      memset(zeroRow, 0, rowBytes);
+      const unsigned char* prior = zeroRow;
+      int y;
+      for (y = 0; y < height; ++y)
+      {
+        const unsigned char* src = pixels + y * rowStride;
+        const unsigned char* row = src;
+        if (pixelSize != pixelBytes)
+        {
+          unsigned char* dst = rowBuffer[y & 1];
+          int x, k;
+          for (x = 0; x < width; ++x, src += pixelSize)
+          {
+            for (k = 0; k < pixelBytes; ++k)
+            {
+              *dst++ = src[k];
+            }
+          }
+          row = rowBuffer[y & 1];
+        }
+        if (predictor)
+        {
+          int best = 0;
+          unsigned long bestCost = 0;
+          int type;
+          for (type = 0; type < 5; ++type)
+          {
+            FilterPngRow(type, row, prior, rowBytes, pixelBytes, filtered + type * rowSize);
+            unsigned long cost = GetPngRowCost(filtered + type * rowSize, rowBytes);
+            if (type == 0 || cost < bestCost)
+            {
+              best = type;
+              bestCost = cost;
+            }
+          }
+          zout.Write(filtered + best * rowSize, rowSize);
+        }
+        else
+        {
+          zout.Write(row, rowBytes);
+        }
+        prior = row;
+      }
+      delete [] buffer;
+    }
+    zout.Close();
+  }
+
+  m_dataSize = (unsigned int) compressed.GetLength();
+  m_data = new char[m_dataSize];
+  compressed.CopyTo(m_data, m_dataSize);
+
+  m_width  = width;
+  m_height = height;
+  m_cs     = (colours == 3) ? wxS("DeviceRGB") : wxS("DeviceGray");
+  m_bpc    = (char) bitsPerComponent;
+  m_f      = wxS("FlateDecode");
+  m_parms  = (predictor) ? wxString::Format(wxS("/DecodeParms <</Predictor 15 /Colors %d /BitsPerComponent %d /Columns %d>>"), colours, bitsPerComponent, width)
+                         : wxString(wxEmptyString);
+  return true;
+}
+
+bool
+wxPdfImage::ConvertIndexed(const unsigned char* pixels, int width, int height)
+{
+  if (pixels == NULL || width <= 0 || height <= 0)
+  {
+    return false;
+  }
+
+  // Collect the distinct colours in a small open addressing hash table,
+  // giving up as soon as there are more colours than a palette can hold
+  const int maxColours = 256;
+  const unsigned int tableSize = 1024;
+  const wxUint32 used = 0x01000000;
+  wxUint32 keys[tableSize];
+  unsigned char slots[tableSize];
+  unsigned char palette[3 * maxColours];
+  memset(keys, 0, sizeof(keys));
+  int numColours = 0;
+
+  size_t numPixels = (size_t) width * height;
+  unsigned char* indices = new unsigned char[numPixels];
+  wxUint32 lastKey = 0;
+  unsigned char lastIndex = 0;
+  size_t j;
+  for (j = 0; j < numPixels; ++j, pixels += 3)
+  {
+    wxUint32 key = used | ((wxUint32) pixels[0] << 16) | ((wxUint32) pixels[1] << 8) | pixels[2];
+    if (key != lastKey)
+    {
+      unsigned int slot = ((key * 2654435761u) >> 22) & (tableSize - 1);
+      while (keys[slot] != 0 && keys[slot] != key)
+      {
+        slot = (slot + 1) & (tableSize - 1);
+      }
+      if (keys[slot] == 0)
+      {
+        if (numColours == maxColours)
+        {
+          delete [] indices;
+          return false;
+        }
+        keys[slot] = key;
+        slots[slot] = (unsigned char) numColours;
+        memcpy(palette + 3 * numColours, pixels, 3);
+        ++numColours;
+      }
+      lastKey = key;
+      lastIndex = slots[slot];
+    }
+    indices[j] = lastIndex;
+  }
+
+  // Pack the palette indices with the smallest possible bit depth
+  int bits = (numColours <= 2) ? 1 : (numColours <= 4) ? 2 : (numColours <= 16) ? 4 : 8;
+  size_t rowBytes = ((size_t) width * bits + 7) / 8;
+  unsigned char* packed = new unsigned char[rowBytes * height];
+  memset(packed, 0, rowBytes * height);
+  const unsigned char* index = indices;
+  int x, y;
+  for (y = 0; y < height; ++y)
+  {
+    unsigned char* row = packed + y * rowBytes;
+    for (x = 0; x < width; ++x)
+    {
+      size_t bitPos = (size_t) x * bits;
+      row[bitPos >> 3] |= (unsigned char) (*index++ << (8 - bits - (bitPos & 7)));
+    }
+  }
+  delete [] indices;
+
+  wxMemoryOutputStream compressed;
+  {
+    wxZlibOutputStream zout(compressed);
+    zout.Write(packed, rowBytes * height);
+    zout.Close();
+  }
+  delete [] packed;
+  m_dataSize = (unsigned int) compressed.GetLength();
+  m_data = new char[m_dataSize];
+  compressed.CopyTo(m_data, m_dataSize);
+
+  m_palSize = 3 * numColours;
+  m_pal = new char[m_palSize];
+  memcpy(m_pal, palette, m_palSize);
+
+  m_width  = width;
+  m_height = height;
+  m_cs     = wxS("Indexed");
+  m_bpc    = (char) bits;
+  m_f      = wxS("FlateDecode");
+  m_parms  = wxEmptyString;
+  return true;
+}
+
+bool
+wxPdfImage::ConvertBilevel(const unsigned char* pixels, int width, int height, int pixelSize)
+{
+  // Pack the pixels into 1-bit rows, white pixels are represented by 1 bits
+  size_t rowBytes = ((size_t) width + 7) / 8;
+  unsigned char* packed = new unsigned char[rowBytes * height];
+  memset(packed, 0, rowBytes * height);
+  int x, y;
+  for (y = 0; y < height; ++y)
+  {
+    unsigned char* row = packed + y * rowBytes;
+    for (x = 0; x < width; ++x, pixels += pixelSize)
     {
-      wxImage::AddHandler(new wxPNGHandler());
+      if (pixels[0] != 0)
+      {
+        row[x >> 3] |= (unsigned char) (0x80 >> (x & 7));
+      }
     }
   }
-  wxMemoryOutputStream os;
-  isValid = image.SaveFile(os, bitmapType);
-  if (isValid)
+
+  wxMemoryOutputStream compressed;
   {
-    wxMemoryInputStream is(os);
-#if wxUSE_LIBJPEG
-    if (jpegFormat)
-    {
-      m_type = wxS("jpeg");
-      isValid = ParseJPG(&is);
-    }
-    else
-#endif // wxUSE_LIBJPEG
+    wxZlibOutputStream zout(compressed);
+    zout.Write(packed, rowBytes * height);
+    zout.Close();
+  }
+  m_dataSize = (unsigned int) compressed.GetLength();
+  m_data = new char[m_dataSize];
+  compressed.CopyTo(m_data, m_dataSize);
+
+  m_width  = width;
+  m_height = height;
+  m_cs     = wxS("DeviceGray");
+  m_bpc    = 1;
+  m_f      = wxS("FlateDecode");
+  m_parms  = wxEmptyString;
+
+  ApplyCcittG4(packed, rowBytes, width, height);
+  delete [] packed;
+  return true;
+}
+
+bool
+wxPdfImage::ApplyCcittG4(const unsigned char* packed, size_t rowBytes, int width, int height)
+{
+  std::vector<unsigned char> ccitt;
+  EncodeCcittG4(packed, rowBytes, width, height, ccitt);
+  bool smaller = ccitt.size() < m_dataSize;
+  if (smaller)
+  {
+    if (m_data != NULL)
     {
-      m_type = wxS("png");
-      isValid = ParsePNG(&is);
+      delete [] m_data;
     }
+    m_dataSize = (unsigned int) ccitt.size();
+    m_data = new char[m_dataSize];
+    memcpy(m_data, &ccitt[0], m_dataSize);
+    m_f     = wxS("CCITTFaxDecode");
+    m_parms = wxString::Format(wxS("/DecodeParms <</K -1 /Columns %d /Rows %d>>"), width, height);
   }
-  return isValid;
+  return smaller;
 }
 
 bool
@@ -239,6 +1015,13 @@ wxPdfImage::Parse()
         isValid = ParseWMF(m_imageStream);
       }
     }
+    if (!isValid || m_dataOffsets.empty())
+    {
+      // The image data were read (or are not available)
+      m_dataFileName = wxEmptyString;
+      m_dataOffsets.clear();
+      m_dataLengths.clear();
+    }
     if (m_imageFile != NULL)
     {
       delete m_imageFile;
@@ -248,6 +1031,214 @@ wxPdfImage::Parse()
   return isValid;
 }
 
+// Read image data from a stream and append the MD5 digests of the data blocks
+static void
+AppendDataDigests(wxInputStream* stream, size_t length, std::string& digests)
+{
+  char buffer[16384];
+  unsigned char md5[16];
+  while (length > 0)
+  {
+    size_t count = (length < sizeof(buffer)) ? length : sizeof(buffer);
+    stream->Read(buffer, count);
+    count = stream->LastRead();
+    if (count == 0)
+    {
+      break;
+    }
+    wxPdfEncrypt::GetMD5Binary((const unsigned char*) buffer, (unsigned int) count, md5);
+    digests.append((const char*) md5, 16);
+    length -= count;
+  }
+}
+
+// Get the digest of the image data from the digests of the data blocks
+static wxString
+GetDataDigestString(const std::string& digests)
+{
+  unsigned char md5[16];
+  wxPdfEncrypt::GetMD5Binary((const unsigned char*) digests.data(), (unsigned int) digests.length(), md5);
+  wxString digest;
+  int j;
+  for (j = 0; j < 16; ++j)
+  {
+    digest += wxString::Format(wxS("%02x"), md5[j]);
+  }
+  return digest;
+}
+
+bool
+wxPdfImage::IsDataFileUnchanged()
+{
+  bool ok = true;
+  if (!m_dataFileName.IsEmpty())
+  {
+    wxFileName fileName(m_dataFileName);
+    ok = fileName.FileExists() &&
+         fileName.GetSize() == m_dataFileSize &&
+         fileName.GetModificationTime() == m_dataFileTime;
+  }
+  return ok;
+}
+
+bool
+wxPdfImage::WriteData(wxOutputStream& stream)
+{
+  if (m_dataFileName.IsEmpty())
+  {
+    if (m_dataSize > 0)
+    {
+      stream.Write(m_data, m_dataSize);
+    }
+    return true;
+  }
+
+  // The image data must not be taken from a file that was changed after parsing
+  bool changed = !IsDataFileUnchanged();
+  bool ok = !changed;
+  wxFileInputStream dataFile(m_dataFileName);
+  char buffer[16384];
+  size_t segment;
+  for (segment = 0; segment < m_dataOffsets.size(); ++segment)
+  {
+    size_t remaining = m_dataLengths[segment];
+    if (ok)
+    {
+      ok = dataFile.IsOk() && dataFile.SeekI(m_dataOffsets[segment]) != wxInvalidOffset;
+    }
+    while (ok && remaining > 0)
+    {
+      size_t count = (remaining < sizeof(buffer)) ? remaining : sizeof(buffer);
+      dataFile.Read(buffer, count);
+      count = dataFile.LastRead();
+      if (count == 0)
+      {
+        ok = false;
+      }
+      else
+      {
+        stream.Write(buffer, count);
+        remaining -= count;
+      }
+    }
+    if (remaining > 0)
+    {
+      // Keep the announced stream length, the image will not be usable anyway
+      memset(buffer, 0, sizeof(buffer));
+      while (remaining > 0)
+      {
+        size_t count = (remaining < sizeof(buffer)) ? remaining : sizeof(buffer);
+        stream.Write(buffer, count);
+        remaining -= count;
+      }
+    }
+  }
+  if (changed)
+  {
+    wxLogError(wxString(wxS("wxPdfImage::WriteData: ")) +
+               wxString::Format(_("Image file '%s' of image '%s' was changed after the image was added."),
+                                m_dataFileName.c_str(), m_name.c_str()));
+  }
+  else if (!ok)
+  {
+    wxLogError(wxString(wxS("wxPdfImage::WriteData: ")) +
+               wxString::Format(_("Image data of '%s' could not be read from file '%s'."),
+                                m_name.c_str(), m_dataFileName.c_str()));
+  }
+  return ok;
+}
+
+// Reverse a PNG filter on a row of pixel data in place
+static bool
+UnfilterPngRow(int type, unsigned char* row, const unsigned char* prior, size_t rowBytes, size_t bpp)
+{
+  size_t j;
+  switch (type)
+  {
+    case 0: // None
+      break;
+    case 1: // Sub
+      for (j = bpp; j < rowBytes; ++j)
+      {
+        row[j] += row[j-bpp];
+      }
+      break;
+    case 2: // Up
+      for (j = 0; j < rowBytes; ++j)
+      {
+        row[j] += prior[j];
+      }
+      break;
+    case 3: // Average
+      for (j = 0; j < rowBytes; ++j)
+      {
+        int left = (j >= bpp) ? row[j-bpp] : 0;
+        row[j] += (unsigned char) ((left + prior[j]) >> 1);
+      }
+      break;
+    case 4: // Paeth
+      for (j = 0; j < rowBytes; ++j)
+      {
+        int a = (j >= bpp) ? row[j-bpp] : 0;
+        int b = prior[j];
+        int c = (j >= bpp) ? prior[j-bpp] : 0;
+        int p = a + b - c;
+        int pa = abs(p - a);
+        int pb = abs(p - b);
+        int pc = abs(p - c);
+        row[j] += (unsigned char) ((pa <= pb && pa <= pc) ? a : ((pb <= pc) ? b : c));
+      }
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+// Inflate image data compressed with or without PNG row filters;
+// the rows of the returned pixel data are not padded
+static unsigned char*
+InflatePixelRows(const char* data, size_t dataSize, size_t rowBytes, int height, size_t bpp, bool filtered)
+{
+  size_t rowSize = (filtered) ? rowBytes + 1 : rowBytes;
+  size_t rawSize = rowSize * height;
+  unsigned char* raw = new unsigned char[rawSize];
+  {
+    wxMemoryInputStream compressed(data, dataSize);
+    wxZlibInputStream zin(compressed);
+    zin.Read(raw, rawSize);
+    if (zin.LastRead() != rawSize)
+    {
+      delete [] raw;
+      return NULL;
+    }
+  }
+
+  if (filtered)
+  {
+    // Undo the row filters, moving each row to its final position
+    unsigned char* zeroRow = new unsigned char[rowBytes];
+    memset(zeroRow, 0, rowBytes);
+    const unsigned char* prior = zeroRow;
+    bool ok = true;
+    int y;
+    for (y = 0; ok && y < height; ++y)
+    {
+      unsigned char* row = raw + y * rowSize;
+      ok = UnfilterPngRow(row[0], row + 1, prior, rowBytes, bpp);
+      memmove(raw + y * rowBytes, row + 1, rowBytes);
+      prior = raw + y * rowBytes;
+    }
+    delete [] zeroRow;
+    if (!ok)
+    {
+      delete [] raw;
+      raw = NULL;
+    }
+  }
+  return raw;
+}
+
 // --- Parse PNG image file ---
 
 bool
@@ -282,22 +1273,15 @@ wxPdfImage::ParsePNG(wxInputStream* imageStream)
 
   imageStream->Read(buffer,1);
   char bpc = buffer[0];
-  if (bpc > 8)
-  {
-    // 16-bit depth not supported
-    wxLogDebug(wxString(wxS("wxPdfImage::ParsePNG: ")) +
-               wxString::Format(_("16-bit depth not supported: '%s'."), m_name.c_str()));
-    return false;
-  }
 
   wxString colspace = wxEmptyString;
   imageStream->Read(buffer,1);
   char ct = buffer[0];
-  if (ct == 0)
+  if (ct == 0 || ct == 4)
   {
     colspace = wxS("DeviceGray");
   }
-  else if (ct == 2)
+  else if (ct == 2 || ct == 6)
   {
     colspace = wxS("DeviceRGB");
   }
@@ -312,6 +1296,25 @@ wxPdfImage::ParsePNG(wxInputStream* imageStream)
                wxString::Format(_("Unknown colour type: '%s'."), m_name.c_str()));
     return false;
   }
+  bool hasAlpha = (ct == 4 || ct == 6);
+  if ((bpc > 8 && (bpc != 16 || ct == 3)) || (hasAlpha && bpc < 8))
+  {
+    // Bit depth not supported
+    wxLogDebug(wxString(wxS("wxPdfImage::ParsePNG: ")) +
+               wxString::Format(_("Bit depth %d not supported: '%s'."), (int) bpc, m_name.c_str()));
+    return false;
+  }
+
+  // Images with alpha channel and 16-bit images to be reduced to 8-bit depth
+  // have to be decoded, all others are embedded as is
+  bool reduceDepth = bpc == 16 && m_document != NULL && m_document->GetImageDepthReduction();
+  bool decode = hasAlpha || reduceDepth;
+  // Bilevel images are recompressed with CCITT Group 4 encoding if that is smaller
+  bool bilevel = (ct == 0 && bpc == 1);
+  if (decode || bilevel)
+  {
+    m_dataFileName = wxEmptyString;
+  }
 
   imageStream->Read(buffer,3);
   if (buffer[0] != 0)
@@ -346,6 +1349,7 @@ wxPdfImage::ParsePNG(wxInputStream* imageStream)
   m_trns     = NULL;
   m_dataSize = 0;
   m_data     = NULL;
+  std::string dataDigests;
   int n;
   do
   {
@@ -364,7 +1368,16 @@ wxPdfImage::ParsePNG(wxInputStream* imageStream)
       // Read transparency info
       char* t = new char[n];
       imageStream->Read(t,n);
-      if (ct == 0)
+      if (bpc == 16)
+      {
+        // 16-bit colour keys can't be represented, the image is rejected
+        // instead of silently losing its transparency
+        delete [] t;
+        wxLogDebug(wxString(wxS("wxPdfImage::ParsePNG: ")) +
+                   wxString::Format(_("Transparency info of 16-bit image not supported: '%s'."), m_name.c_str()));
+        return false;
+      }
+      else if (ct == 0)
       {
         m_trnsSize = 1;
         m_trns = new char[1];
@@ -394,6 +1407,16 @@ wxPdfImage::ParsePNG(wxInputStream* imageStream)
       imageStream->Read(buffer,4);
       delete [] t;
     }
+    else if (strncmp(buffer,"IDAT",4) == 0 && !m_dataFileName.IsEmpty())
+    {
+      // Remember the location of the image data block, it is read on output.
+      // Only the digest of the data is kept to identify the image content.
+      m_dataOffsets.push_back(imageStream->TellI());
+      m_dataLengths.push_back((unsigned int) n);
+      m_dataSize += n;
+      AppendDataDigests(imageStream, n, dataDigests);
+      imageStream->Read(buffer,4);
+    }
     else if (strncmp(buffer,"IDAT",4) == 0)
     {
       // Read image data block
@@ -423,6 +1446,11 @@ wxPdfImage::ParsePNG(wxInputStream* imageStream)
   }
   while (n);
 
+  if (!m_dataOffsets.empty())
+  {
+    m_dataDigest = GetDataDigestString(dataDigests);
+  }
+
   if (colspace == wxS("Indexed") && m_pal == NULL)
   {
     if (m_pal  != NULL) delete [] m_pal;
@@ -434,16 +1462,289 @@ wxPdfImage::ParsePNG(wxInputStream* imageStream)
     return false;
   }
 
+  if (decode)
+  {
+    isValid = DecodePNG(w, h, bpc, (ct == 2 || ct == 6) ? 3 : 1, hasAlpha, reduceDepth);
+    if (!isValid)
+    {
+      wxLogDebug(wxString(wxS("wxPdfImage::ParsePNG: ")) +
+                 wxString::Format(_("Invalid image data: '%s'."), m_name.c_str()));
+    }
+    return isValid;
+  }
+
   m_width  = w;
   m_height = h;
   m_cs     = colspace;
   m_bpc    = bpc;
   m_f      = wxS("FlateDecode");
 
+  if (bilevel && m_data != NULL && w > 0 && h > 0)
+  {
+    size_t rowBytes = ((size_t) w + 7) / 8;
+    unsigned char* packed = InflatePixelRows(m_data, m_dataSize, rowBytes, h, 1, true);
+    if (packed != NULL)
+    {
+      ApplyCcittG4(packed, rowBytes, w, h);
+      delete [] packed;
+    }
+  }
+
   isValid = true;
   return isValid;
 }
 
+bool
+wxPdfImage::DecodePNG(int width, int height, int bpc, int colours, bool hasAlpha, bool reduceDepth)
+{
+  if (width <= 0 || height <= 0 || m_data == NULL)
+  {
+    return false;
+  }
+
+  // Inflate the image data and undo the row filters
+  int componentSize = bpc / 8;
+  int channels = (hasAlpha) ? colours + 1 : colours;
+  size_t bpp = (size_t) channels * componentSize;
+  size_t rowBytes = (size_t) width * bpp;
+  unsigned char* raw = InflatePixelRows(m_data, m_dataSize, rowBytes, height, bpp, true);
+  delete [] m_data;
+  m_data = NULL;
+  m_dataSize = 0;
+  if (raw == NULL)
+  {
+    return false;
+  }
+
+  // Split the pixels into a colour plane and an alpha plane;
+  // on depth reduction only the high order byte of each component is kept
+  int outComponentSize = (reduceDepth) ? 1 : componentSize;
+  int step = (reduceDepth) ? 2 : 1;
+  size_t colourBytes = (size_t) colours * outComponentSize;
+  size_t numPixels = (size_t) width * height;
+  unsigned char* colour = new unsigned char[numPixels * colourBytes];
+  unsigned char* alpha = (hasAlpha) ? new unsigned char[numPixels * outComponentSize] : NULL;
+  unsigned char* colourOut = colour;
+  unsigned char* alphaOut = alpha;
+  size_t colourIn = (size_t) colours * componentSize;
+  int y;
+  for (y = 0; y < height; ++y)
+  {
+    const unsigned char* src = raw + y * rowBytes;
+    int x;
+    if (!hasAlpha)
+    {
+      for (x = 0; x < width; ++x, src += bpp)
+      {
+        size_t k;
+        for (k = 0; k < colourIn; k += step)
+        {
+          *colourOut++ = src[k];
+        }
+      }
+    }
+    else if (componentSize == 1)
+    {
+      if (colours == 3)
+      {
+        for (x = 0; x < width; ++x, src += 4)
+        {
+          colourOut[0] = src[0];
+          colourOut[1] = src[1];
+          colourOut[2] = src[2];
+          colourOut += 3;
+          *alphaOut++ = src[3];
+        }
+      }
+      else
+      {
+        for (x = 0; x < width; ++x, src += 2)
+        {
+          *colourOut++ = src[0];
+          *alphaOut++ = src[1];
+        }
+      }
+    }
+    else
+    {
+      for (x = 0; x < width; ++x, src += bpp)
+      {
+        size_t k;
+        for (k = 0; k < colourIn; k += step)
+        {
+          *colourOut++ = src[k];
+        }
+        for (k = colourIn; k < bpp; k += step)
+        {
+          *alphaOut++ = src[k];
+        }
+      }
+    }
+  }
+  delete [] raw;
+
+  bool ok = ConvertPixels(colour, width, height, colours, (int) colourBytes, 8 * outComponentSize);
+  delete [] colour;
+  if (ok && hasAlpha)
+  {
+    m_alpha = alpha;
+    m_alphaSize = numPixels * outComponentSize;
+    m_alphaBpc = 8 * outComponentSize;
+  }
+  else if (alpha != NULL)
+  {
+    delete [] alpha;
+  }
+  return ok;
+}
+
+void
+wxPdfImage::AddPlacement(double width, double height)
+{
+  if (width > m_placedWidth)
+  {
+    m_placedWidth = width;
+  }
+  if (height > m_placedHeight)
+  {
+    m_placedHeight = height;
+  }
+}
+
+size_t
+wxPdfImage::Resample(double maxResolution, wxImageResizeQuality quality, int jpegQuality)
+{
+  // Only images with known placement and 8-bit gray scale or RGB pixel data are resampled
+  bool isJpeg = m_f == wxS("DCTDecode");
+  if (maxResolution <= 0 || m_placementUnknown || m_placedWidth <= 0 || m_placedHeight <= 0 ||
+      m_isFormObj || m_palSize > 0 || m_trnsSize > 0 || m_bpc != 8 ||
+      (m_cs != wxS("DeviceRGB") && m_cs != wxS("DeviceGray")) ||
+      (!isJpeg && m_f != wxS("FlateDecode")))
+  {
+    return 0;
+  }
+  int width  = (int) ceil(m_placedWidth / 72.0 * maxResolution);
+  int height = (int) ceil(m_placedHeight / 72.0 * maxResolution);
+  if (width >= m_width && height >= m_height)
+  {
+    return 0;
+  }
+  if (width > m_width) width = m_width;
+  if (height > m_height) height = m_height;
+  if (width < 1) width = 1;
+  if (height < 1) height = 1;
+
+  bool isGray = m_cs == wxS("DeviceGray");
+  bool filtered = m_parms.Find(wxS("/Predictor 15")) != wxNOT_FOUND;
+  if (!isJpeg && !filtered && !m_parms.IsEmpty())
+  {
+    return 0;
+  }
+
+  // Decode the image data
+  wxMemoryOutputStream data;
+  if (!WriteData(data))
+  {
+    return 0;
+  }
+  wxImage image;
+  if (isJpeg)
+  {
+    if (wxImage::FindHandler(wxBITMAP_TYPE_JPEG) == NULL)
+    {
+      return 0;
+    }
+    wxMemoryInputStream jpegData(data);
+    if (!image.LoadFile(jpegData, wxBITMAP_TYPE_JPEG))
+    {
+      return 0;
+    }
+  }
+  else
+  {
+    size_t colours = (isGray) ? 1 : 3;
+    size_t rowBytes = colours * m_width;
+    wxStreamBuffer* buffer = data.GetOutputStreamBuffer();
+    unsigned char* pixels = InflatePixelRows((const char*) buffer->GetBufferStart(), buffer->GetBufferSize(),
+                                             rowBytes, m_height, colours, filtered);
+    if (pixels == NULL)
+    {
+      return 0;
+    }
+    image.Create(m_width, m_height, false);
+    unsigned char* rgb = image.GetData();
+    size_t numPixels = (size_t) m_width * m_height;
+    if (isGray)
+    {
+      size_t j;
+      for (j = 0; j < numPixels; ++j, rgb += 3)
+      {
+        rgb[0] = rgb[1] = rgb[2] = pixels[j];
+      }
+    }
+    else
+    {
+      memcpy(rgb, pixels, 3 * numPixels);
+    }
+    delete [] pixels;
+  }
+  image.Rescale(width, height, quality);
+
+  // The current image data are kept until the resampled image data turn out to be smaller
+  char*    prevData = m_data;
+  unsigned int prevDataSize = m_dataSize;
+  int      prevWidth = m_width;
+  int      prevHeight = m_height;
+  wxString prevCs = m_cs;
+  char     prevBpc = m_bpc;
+  wxString prevF = m_f;
+  wxString prevParms = m_parms;
+  wxString prevDataFileName = m_dataFileName;
+  m_data = NULL;
+  m_dataSize = 0;
+  m_dataFileName = wxEmptyString;
+
+  bool ok;
+  if (isJpeg && jpegQuality > 0)
+  {
+    image.SetOption(wxIMAGE_OPTION_QUALITY, jpegQuality);
+    ok = ConvertWxImage(image, true);
+  }
+  else
+  {
+    ok = ConvertPixels(image.GetData(), width, height, (isGray) ? 1 : 3, 3);
+  }
+
+  size_t savedBytes = 0;
+  if (ok && m_dataSize < prevDataSize)
+  {
+    savedBytes = prevDataSize - m_dataSize;
+    if (prevData != NULL)
+    {
+      delete [] prevData;
+    }
+    m_dataOffsets.clear();
+    m_dataLengths.clear();
+  }
+  else
+  {
+    if (m_data != NULL)
+    {
+      delete [] m_data;
+    }
+    m_data = prevData;
+    m_dataSize = prevDataSize;
+    m_width = prevWidth;
+    m_height = prevHeight;
+    m_cs = prevCs;
+    m_bpc = prevBpc;
+    m_f = prevF;
+    m_parms = prevParms;
+    m_dataFileName = prevDataFileName;
+  }
+  return savedBytes;
+}
+
 //--- Parse JPEG image file
 
 // some defines for the different JPEG block types
@@ -628,11 +1929,24 @@ wxPdfImage::ParseJPG(wxInputStream* imageStream)
     }
     m_bpc = bits;
 
-    //Read whole file
-    imageStream->SeekI(0);
     m_dataSize = imageStream->GetLength();
-    m_data = new char[m_dataSize];
-    imageStream->Read(m_data,m_dataSize);
+    if (!m_dataFileName.IsEmpty())
+    {
+      // The whole file is copied on output, only the digest of the data is kept
+      m_dataOffsets.push_back(0);
+      m_dataLengths.push_back(m_dataSize);
+      std::string dataDigests;
+      imageStream->SeekI(0);
+      AppendDataDigests(imageStream, m_dataSize, dataDigests);
+      m_dataDigest = GetDataDigestString(dataDigests);
+    }
+    else
+    {
+      //Read whole file
+      imageStream->SeekI(0);
+      m_data = new char[m_dataSize];
+      imageStream->Read(m_data,m_dataSize);
+    }
 
     m_width  = width;
     m_height = height;
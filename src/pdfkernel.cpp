@@ -25,6 +25,9 @@
 #include <wx/wfstream.h>
 #include <wx/zstream.h>
 
+#include <string>
+#include <vector>
+
 #include "wx/pdfannotation.h"
 #include "wx/pdfbookmark.h"
 #include "wx/pdfdocument.h"
@@ -41,8 +44,6 @@
 #include "wx/pdftemplate.h"
 #include "wx/pdfutility.h"
 
-#include "pdfcorefontdata.inc"
-
 class wxPdfGraphicState
 {
 public:
@@ -1285,6 +1286,35 @@ wxPdfDocument::PutFonts()
   wxString type;
   wxString name;
   wxPdfFontHashMap::iterator fontIter = m_fonts->begin();
+
+  // Subsetting, compression and the creation of the mapping streams are
+  // independent for each font, so they are done in parallel in advance.
+  // Fonts sharing the same font file are handled by the same task.
+  wxArrayString fontGroupNames;
+  std::vector< std::vector<wxPdfFontDetails*> > fontGroups;
+  for (fontIter = m_fonts->begin(); fontIter != m_fonts->end(); fontIter++)
+  {
+    wxPdfFontDetails* font = fontIter->second;
+    wxString groupName = font->GetType() + wxS(":") + font->GetOriginalName();
+    int group = fontGroupNames.Index(groupName);
+    if (group == wxNOT_FOUND)
+    {
+      group = (int) fontGroupNames.GetCount();
+      fontGroupNames.Add(groupName);
+      fontGroups.push_back(std::vector<wxPdfFontDetails*>());
+    }
+    fontGroups[group].push_back(font);
+  }
+  wxPdfUtility::RunParallel(fontGroups.size(),
+                            [&fontGroups](size_t group)
+                            {
+                              size_t k;
+                              for (k = 0; k < fontGroups[group].size(); ++k)
+                              {
+                                fontGroups[group][k]->PrepareFontData();
+                              }
+                            });
+
   for (fontIter = m_fonts->begin(); fontIter != m_fonts->end(); fontIter++)
   {
     wxPdfFontDetails* font = fontIter->second;
@@ -1630,10 +1660,102 @@ wxPdfDocument::PutFonts()
   }
 }
 
+void
+wxPdfDocument::PrepareImages()
+{
+  // Deferred images are converted independently of each other;
+  // the order of the image objects does not depend on the order of completion
+  std::vector<wxPdfImage*> images;
+  wxPdfImageHashMap::iterator image;
+  for (image = m_images->begin(); image != m_images->end(); image++)
+  {
+    if (image->second->IsPending())
+    {
+      images.push_back(image->second);
+    }
+  }
+  if (images.empty())
+  {
+    return;
+  }
+
+  std::vector<char> valid(images.size(), 0);
+  wxPdfUtility::RunParallel(images.size(),
+                            [&](size_t k)
+                            {
+                              valid[k] = images[k]->Prepare() ? 1 : 0;
+                            });
+  size_t k;
+  for (k = 0; k < images.size(); ++k)
+  {
+    if (!valid[k])
+    {
+      // The image object is written without valid image data, thus the document is in error
+      m_imageDataError = true;
+      wxLogError(wxString(wxS("wxPdfDocument::PrepareImages: ")) +
+                 wxString::Format(_("Image '%s' could not be converted."), images[k]->GetName().c_str()));
+    }
+  }
+}
+
+void
+wxPdfDocument::ResampleImages()
+{
+  // Image masks are placed together with the images they belong to
+  std::vector<wxPdfImage*> images;
+  wxPdfImageHashMap::iterator image;
+  for (image = m_images->begin(); image != m_images->end(); image++)
+  {
+    wxPdfImage* currentImage = image->second;
+    images.push_back(currentImage);
+    int maskImage = currentImage->GetMaskImage();
+    if (maskImage > 0)
+    {
+      wxPdfImageHashMap::iterator mask;
+      for (mask = m_images->begin(); mask != m_images->end(); mask++)
+      {
+        if (mask->second->GetIndex() == maskImage)
+        {
+          mask->second->AddPlacement(currentImage->GetPlacedWidth(), currentImage->GetPlacedHeight());
+          if (currentImage->IsPlacementUnknown())
+          {
+            mask->second->SetPlacementUnknown();
+          }
+        }
+      }
+    }
+  }
+
+#if wxUSE_LIBJPEG
+  if (wxImage::FindHandler(wxBITMAP_TYPE_JPEG) == NULL)
+  {
+    wxImage::AddHandler(new wxJPEGHandler());
+  }
+#endif // wxUSE_LIBJPEG
+
+  // Images are resampled independently of each other
+  std::vector<size_t> savedBytes(images.size(), 0);
+  wxPdfUtility::RunParallel(images.size(),
+                            [&](size_t k)
+                            {
+                              savedBytes[k] = images[k]->Resample(m_imageMaxResolution, m_imageResizeQuality, m_imageJpegQuality);
+                            });
+  size_t k;
+  for (k = 0; k < savedBytes.size(); ++k)
+  {
+    m_imageBytesSaved += savedBytes[k];
+  }
+}
+
 void
 wxPdfDocument::PutImages()
 {
   wxString filter = (m_compress) ? wxS("/Filter /FlateDecode ") : wxS("");
+  PrepareImages();
+  if (m_imageMaxResolution > 0)
+  {
+    ResampleImages();
+  }
   int iter;
   for (iter = 0; iter < 2; iter++)
   {
@@ -1752,9 +1874,26 @@ wxPdfDocument::PutImages()
 
         OutAscii(wxString::Format(wxS("/Length %lu>>"), (unsigned long) CalculateStreamLength(currentImage->GetDataSize())));
 
-        wxMemoryOutputStream mos;
-        mos.Write(currentImage->GetData(),currentImage->GetDataSize());
-        PutStream(mos);
+        if (currentImage->IsDataDeferred() && !m_encrypted)
+        {
+          // Copy the image data from the image file directly to the output
+          Out("stream");
+          if (!currentImage->WriteData(*m_buffer))
+          {
+            m_imageDataError = true;
+          }
+          Out("");
+          Out("endstream");
+        }
+        else
+        {
+          wxMemoryOutputStream mos;
+          if (!currentImage->WriteData(mos))
+          {
+            m_imageDataError = true;
+          }
+          PutStream(mos);
+        }
         Out("endobj");
 
         // Palette
@@ -1794,7 +1933,22 @@ wxPdfDocument::PutTemplates()
     NewObj();
     currentTemplate->SetObjIndex(m_n);
 
-    OutAscii(wxString(wxS("<<")) + filter + wxString(wxS("/Type /XObject")));
+    if (currentTemplate->GetContentFilter() != NULL)
+    {
+      // Imported page content is written with its original encoding
+      Out("<</Filter ", false);
+      WriteObjectValue(currentTemplate->GetContentFilter());
+      if (currentTemplate->GetContentDecodeParms() != NULL)
+      {
+        Out("/DecodeParms ", false);
+        WriteObjectValue(currentTemplate->GetContentDecodeParms());
+      }
+      Out("/Type /XObject");
+    }
+    else
+    {
+      OutAscii(wxString(wxS("<<")) + filter + wxString(wxS("/Type /XObject")));
+    }
     Out("/Subtype /Form");
     Out("/FormType 1");
 
@@ -1869,7 +2023,7 @@ wxPdfDocument::PutTemplates()
 
     // Template data
     wxMemoryOutputStream mos, *p;
-    if (m_compress)
+    if (m_compress && currentTemplate->GetContentFilter() == NULL)
     {
       p = &mos;
       wxZlibOutputStream q(mos);
@@ -1911,7 +2065,12 @@ wxPdfDocument::PutImportedObjects()
         NewObj(entry->GetActualObjectId());
         WriteObjectValue(resolvedObject);
         Out("endobj");
-        entry->SetObject(resolvedObject);
+        // The queue entry keeps only the reference, so that the memory
+        // of the written object can be released immediately
+        if (resolvedObject->IsCreatedIndirect())
+        {
+          delete resolvedObject;
+        }
       }
     }
   }
@@ -2690,6 +2849,93 @@ wxPdfDocument::ShowGlyph(wxUint32 glyph)
   }
 }
 
+double
+wxPdfDocument::ShowGlyphRun(size_t count, const wxUint32* glyphs, const wxUint32* cids,
+                            const double* advances, const double* offsets)
+{
+  // All positions are relative to the start of the run, measured in user units.
+  // Horizontal deviations from the natural glyph positions are expressed as
+  // positioning adjustments within a TJ array; vertical offsets require to
+  // start a new text line.
+  double ySign = (m_yAxisOriginTop) ? -1 : 1;
+  double penX  = 0;
+  double lineX = 0;
+  double lineY = 0;
+  double textX = 0;
+  bool inArray = false;
+  std::string glyphString;
+  size_t j;
+  for (j = 0; j < count; ++j)
+  {
+    double glyphX = penX;
+    double glyphY = 0;
+    if (offsets != NULL)
+    {
+      glyphX += offsets[2*j];
+      glyphY  = offsets[2*j+1];
+    }
+    double glyphWidth = m_currentFont->GetGlyphWidth(glyphs[j]) * m_fontSize / 1000.;
+
+    if (glyphY != lineY)
+    {
+      if (inArray)
+      {
+        if (!glyphString.empty())
+        {
+          Out("(", false);
+          OutEscape(glyphString);
+          Out(")", false);
+          glyphString.clear();
+        }
+        Out("] TJ ", false);
+        inArray = false;
+      }
+      OutAscii(wxPdfUtility::Double2String((glyphX - lineX) * m_k, 2) + wxString(wxS(" ")) +
+               wxPdfUtility::Double2String(ySign * (glyphY - lineY) * m_k, 2) + wxString(wxS(" Td ")), false);
+      lineX = glyphX;
+      lineY = glyphY;
+      textX = glyphX;
+    }
+
+    if (!inArray)
+    {
+      Out("[", false);
+      inArray = true;
+    }
+    double adjust = (textX - glyphX) * 1000. / m_fontSize;
+    if (adjust >= 0.005 || adjust <= -0.005)
+    {
+      if (!glyphString.empty())
+      {
+        Out("(", false);
+        OutEscape(glyphString);
+        Out(")", false);
+        glyphString.clear();
+      }
+      OutAscii(wxPdfUtility::Double2String(adjust, 2), false);
+    }
+
+    // Character ids are always written as 2-byte codes (Identity-H encoding)
+    glyphString += (char) ((cids[j] >> 8) & 0xff);
+    glyphString += (char) (cids[j] & 0xff);
+
+    textX = glyphX + glyphWidth;
+    penX += (advances != NULL) ? advances[j] : glyphWidth;
+  }
+
+  if (inArray)
+  {
+    if (!glyphString.empty())
+    {
+      Out("(", false);
+      OutEscape(glyphString);
+      Out(")", false);
+    }
+    Out("] TJ", false);
+  }
+  return penX;
+}
+
 void
 wxPdfDocument::ShowText(const wxString& txt)
 {
@@ -3171,6 +3417,16 @@ wxPdfDocument::OutImage(wxPdfImage* currentImage,
   {
     h = (w * currentImage->GetHeight()) / currentImage->GetWidth();
   }
+  if (m_inTemplate || m_inTransform > 0)
+  {
+    // The template may be scaled on use, and a transformation
+    // (also one set up by wxPdfDC) may scale the image
+    currentImage->SetPlacementUnknown();
+  }
+  else
+  {
+    currentImage->AddPlacement(w * m_k, h * m_k);
+  }
 
   double sw, sh, sx, sy;
   if (currentImage->IsFormObject())
@@ -74,6 +74,9 @@ wxPdfParser::wxPdfParser(const wxString& filename, const wxString& password)
   m_objectQueueLast = m_objectQueue;
   m_objectMap       = new wxPdfObjectMap();
   m_objStmCache     = new wxPdfObjStmMap();
+  m_objStmCacheSize = 0;
+  m_currentPage     = 0;
+  m_currentPageDict = NULL;
   m_tokens  = NULL;
   m_trailer = NULL;
   m_root    = NULL;
@@ -107,7 +110,7 @@ wxPdfParser::~wxPdfParser()
   while (entry != NULL)
   {
     wxPdfObject* object = entry->GetObject();
-    if (object != NULL && object->IsCreatedIndirect())
+    if (object != NULL)
     {
       delete object;
     }
@@ -134,6 +137,10 @@ wxPdfParser::~wxPdfParser()
     delete obj;
   }
   m_pages.Clear();
+  if (m_currentPageDict != NULL)
+  {
+    delete m_currentPageDict;
+  }
 
   if (m_trailer != NULL)
   {
@@ -165,7 +172,10 @@ wxPdfParser::IsOk() const
 void
 wxPdfParser::AppendObject(int originalObjectId, int actualObjectId, wxPdfObject* obj)
 {
-  wxPdfObjectQueue* newEntry = new wxPdfObjectQueue(originalObjectId, actualObjectId, obj);
+  // Keep only a reference to the object, since the object containing the
+  // reference may be released before the queue is processed
+  wxPdfObject* objRef = new wxPdfIndirectReference(originalObjectId, obj->GetGeneration());
+  wxPdfObjectQueue* newEntry = new wxPdfObjectQueue(originalObjectId, actualObjectId, objRef);
   m_objectQueueLast->SetNext(newEntry);
   m_objectQueueLast = newEntry;
   (*m_objectMap)[originalObjectId] = newEntry;
@@ -516,7 +526,8 @@ wxPdfParser::ParsePageTree(wxPdfDictionary* pages)
     ok = true;
     for (j = 0; j < nKids; j++)
     {
-      wxPdfDictionary* page = (wxPdfDictionary*) ResolveObject(kids->Get(j));
+      wxPdfObject* kid = kids->Get(j);
+      wxPdfDictionary* page = (wxPdfDictionary*) ResolveObject(kid);
       wxPdfName* type = (wxPdfName*) page->Get(wxS("Type"));
       if (type->GetName() == wxS("Pages"))
       {
@@ -525,6 +536,13 @@ wxPdfParser::ParsePageTree(wxPdfDictionary* pages)
         ok = ok && ParsePageTree(page);
         delete page;
       }
+      else if (kid->GetType() == OBJTYPE_INDIRECT)
+      {
+        // Keep only a reference to the page,
+        // the page dictionary is resolved again on demand
+        m_pages.Add(new wxPdfIndirectReference(kid->GetNumber(), kid->GetGeneration()));
+        delete page;
+      }
       else
       {
         m_pages.Add(page);
@@ -543,21 +561,50 @@ wxPdfParser::ParsePageTree(wxPdfDictionary* pages)
   return ok;
 }
 
+wxPdfDictionary*
+wxPdfParser::GetPage(unsigned int pageno)
+{
+  wxPdfObject* page = (wxPdfObject*) m_pages[pageno];
+  if (page->GetType() != OBJTYPE_INDIRECT)
+  {
+    return (wxPdfDictionary*) page;
+  }
+  if (m_currentPageDict == NULL || m_currentPage != pageno)
+  {
+    if (m_currentPageDict != NULL)
+    {
+      delete m_currentPageDict;
+    }
+    m_currentPageDict = (wxPdfDictionary*) ResolveObject(page);
+    m_currentPage = pageno;
+  }
+  return m_currentPageDict;
+}
+
 wxPdfObject*
 wxPdfParser::GetPageResources(unsigned int pageno)
 {
   wxPdfObject* resources = NULL;
   if (pageno < GetPageCount())
   {
-    resources = GetPageResources((wxPdfObject*) m_pages[pageno]);
+    bool detached = false;
+    resources = GetPageResources(GetPage(pageno), detached);
+    if (detached && m_currentPageDict != NULL)
+    {
+      // The resources were detached from the page dictionary,
+      // therefore the page dictionary has to be resolved again on next use
+      delete m_currentPageDict;
+      m_currentPageDict = NULL;
+    }
   }
   return resources;
 }
 
 wxPdfObject*
-wxPdfParser::GetPageResources(wxPdfObject* page)
+wxPdfParser::GetPageResources(wxPdfObject* page, bool& detached)
 {
   wxPdfObject* resources = NULL;
+  detached = false;
   wxPdfDictionary* dic = (wxPdfDictionary*) ResolveObject(page);
 
   // If the current object has a resources dictionary associated with it,
@@ -566,13 +613,23 @@ wxPdfParser::GetPageResources(wxPdfObject* page)
   if (resourceRef != NULL)
   {
     resources = ResolveObject(resourceRef);
+    if (!resources->IsCreatedIndirect() && dic->IsCreatedIndirect())
+    {
+      // Detach direct resources from the page dictionary,
+      // since the page dictionary may be released before the resources
+      dic->GetHashMap()->erase(wxS("Resources"));
+      resources->SetCreatedIndirect(true);
+      detached = true;
+    }
   }
   else
   {
     wxPdfObject* parent = ResolveObject(dic->Get(wxS("Parent")));
     if (parent != NULL)
     {
-      resources = GetPageResources(parent);
+      // The parent dictionary is released anyway
+      bool parentDetached;
+      resources = GetPageResources(parent, parentDetached);
       delete parent;
     }
   }
@@ -584,7 +641,7 @@ wxPdfParser::GetContent(unsigned int pageno, wxArrayPtrVoid& contents)
 {
   if (pageno < GetPageCount())
   {
-    wxPdfObject* content = ((wxPdfDictionary*) m_pages[pageno])->Get(wxS("Contents"));
+    wxPdfObject* content = GetPage(pageno)->Get(wxS("Contents"));
     if (content != NULL)
     {
       GetPageContent(content, contents);
@@ -624,17 +681,17 @@ wxPdfParser::GetPageContent(wxPdfObject* contentRef, wxArrayPtrVoid& contents)
 wxPdfArrayDouble*
 wxPdfParser::GetPageMediaBox(unsigned int pageno)
 {
-  wxPdfArrayDouble* box = GetPageBox((wxPdfDictionary*) m_pages[pageno], wxS("MediaBox"));
+  wxPdfArrayDouble* box = GetPageBox(GetPage(pageno), wxS("MediaBox"));
   return box;
 }
 
 wxPdfArrayDouble*
 wxPdfParser::GetPageCropBox(unsigned int pageno)
 {
-  wxPdfArrayDouble* box = GetPageBox((wxPdfDictionary*) m_pages[pageno], wxS("CropBox"));
+  wxPdfArrayDouble* box = GetPageBox(GetPage(pageno), wxS("CropBox"));
   if (box == NULL)
   {
-    box = GetPageBox((wxPdfDictionary*) m_pages[pageno], wxS("MediaBox"));
+    box = GetPageBox(GetPage(pageno), wxS("MediaBox"));
   }
   return box;
 }
@@ -642,7 +699,7 @@ wxPdfParser::GetPageCropBox(unsigned int pageno)
 wxPdfArrayDouble*
 wxPdfParser::GetPageBleedBox(unsigned int pageno)
 {
-  wxPdfArrayDouble* box = GetPageBox((wxPdfDictionary*) m_pages[pageno], wxS("BleedBox"));
+  wxPdfArrayDouble* box = GetPageBox(GetPage(pageno), wxS("BleedBox"));
   if (box == NULL)
   {
     box = GetPageCropBox(pageno);
@@ -653,7 +710,7 @@ wxPdfParser::GetPageBleedBox(unsigned int pageno)
 wxPdfArrayDouble*
 wxPdfParser::GetPageTrimBox(unsigned int pageno)
 {
-  wxPdfArrayDouble* box = GetPageBox((wxPdfDictionary*) m_pages[pageno], wxS("TrimBox"));
+  wxPdfArrayDouble* box = GetPageBox(GetPage(pageno), wxS("TrimBox"));
   if (box == NULL)
   {
     box = GetPageCropBox(pageno);
@@ -664,7 +721,7 @@ wxPdfParser::GetPageTrimBox(unsigned int pageno)
 wxPdfArrayDouble*
 wxPdfParser::GetPageArtBox(unsigned int pageno)
 {
-  wxPdfArrayDouble* box = GetPageBox((wxPdfDictionary*) m_pages[pageno], wxS("ArtBox"));
+  wxPdfArrayDouble* box = GetPageBox(GetPage(pageno), wxS("ArtBox"));
   if (box == NULL)
   {
     box = GetPageCropBox(pageno);
@@ -702,7 +759,7 @@ wxPdfParser::GetPageBox(wxPdfDictionary* page, const wxString& boxIndex)
 int
 wxPdfParser::GetPageRotation(unsigned int pageno)
 {
-  return GetPageRotation((wxPdfDictionary*) m_pages[pageno]);
+  return GetPageRotation(GetPage(pageno));
 }
 
 int
@@ -1234,6 +1291,9 @@ wxPdfParser::ParseDirectObject(int k)
     {
       obj = objStm->second;
       isCached = true;
+      // Mark the object stream as most recently used
+      m_objStmCacheLru.Remove(objIndex);
+      m_objStmCacheLru.Add(objIndex);
     }
     else
     {
@@ -1282,7 +1342,7 @@ wxPdfParser::ParseDirectObject(int k)
     {
       if (!isCached)
       {
-        (*m_objStmCache)[objIndex] = objStream;
+        CacheObjectStream(objIndex, objStream);
       }
     }
     else
@@ -1302,6 +1362,36 @@ wxPdfParser::ParseDirectObject(int k)
   return obj;
 }
 
+void
+wxPdfParser::CacheObjectStream(int objIndex, wxPdfStream* objStm)
+{
+  (*m_objStmCache)[objIndex] = objStm;
+  m_objStmCacheLru.Add(objIndex);
+  if (objStm->GetBuffer() != NULL)
+  {
+    m_objStmCacheSize += (size_t) objStm->GetBuffer()->GetLength();
+  }
+
+  // Remove the least recently used object streams, but keep at least the new one
+  while (m_objStmCacheSize > WXPDF_OBJSTM_CACHE_SIZE && m_objStmCacheLru.GetCount() > 1)
+  {
+    int lruIndex = m_objStmCacheLru[0];
+    m_objStmCacheLru.RemoveAt(0);
+    wxPdfObjStmMap::iterator lruEntry = m_objStmCache->find(lruIndex);
+    if (lruEntry != m_objStmCache->end())
+    {
+      wxPdfStream* lruStream = (wxPdfStream*) lruEntry->second;
+      if (lruStream->GetBuffer() != NULL)
+      {
+        size_t lruSize = (size_t) lruStream->GetBuffer()->GetLength();
+        m_objStmCacheSize = (lruSize < m_objStmCacheSize) ? m_objStmCacheSize - lruSize : 0;
+      }
+      delete lruStream;
+      m_objStmCache->erase(lruEntry);
+    }
+  }
+}
+
 wxPdfObject*
 wxPdfParser::ParseObjectStream(wxPdfStream* objStm, int idx)
 {
@@ -1320,8 +1410,7 @@ wxPdfParser::ParseObjectStream(wxPdfStream* objStm, int idx)
   bool saveEncrypted = m_encrypted;
   m_encrypted = false;
   wxPdfTokenizer* saveTokens = m_tokens;
-  wxMemoryInputStream objStream(*(objStm->GetBuffer()));
-  m_tokens = new wxPdfTokenizer(&objStream);
+  m_tokens = new wxPdfTokenizer(objStm->GetBuffer());
 
   int address = 0;
   bool ok = true;
@@ -1401,110 +1490,26 @@ wxPdfParser::GetStreamBytes(wxPdfStream* stream)
   // Do not decode the content of resource object streams
   if (m_useRawStream) return;
 
+  DecodeStreamBytes(stream);
+}
+
+void
+wxPdfParser::DecodeStreamBytes(wxPdfStream* stream)
+{
   // Check whether the stream buffer is empty
   wxMemoryOutputStream* osIn = stream->GetBuffer();
   if (osIn->GetLength() == 0) return;
 
-  size_t j;
-  wxArrayPtrVoid filters;
-  wxPdfObject* filter = ResolveObject(stream->Get(wxS("Filter")));
-  if (filter != NULL)
+  // Decode all filters in a single pass through the filter stream chain
+  wxInputStream* decoded = GetDecodedStream(stream);
+  if (decoded != NULL)
   {
-    int type = filter->GetType();
-    if (type == OBJTYPE_NAME)
-    {
-      filters.Add(filter);
-    }
-    else if (type == OBJTYPE_ARRAY)
-    {
-      wxPdfArray* filterArray = (wxPdfArray*) filter;
-      size_t size = filterArray->GetSize();
-      for (j = 0; j < size; j++)
-      {
-        filters.Add(filterArray->Get(j));
-      }
-    }
-
-    // Read decode parameters if available
-    wxArrayPtrVoid dp;
-    wxPdfObject* dpo = ResolveObject(stream->Get(wxS("DecodeParms")));
-    if (dpo == NULL || (dpo->GetType() != OBJTYPE_DICTIONARY && dpo->GetType() != OBJTYPE_ARRAY))
-    {
-      dpo = ResolveObject(stream->Get(wxS("DP")));
-    }
-    if (dpo != NULL)
-    {
-      if (dpo->GetType() == OBJTYPE_DICTIONARY)
-      {
-        dp.Add(dpo);
-      }
-      else if (dpo->GetType() == OBJTYPE_ARRAY)
-      {
-        wxPdfArray* dpArray = (wxPdfArray*) dpo;
-        size_t size = dpArray->GetSize();
-        for (j = 0; j < size; j++)
-        {
-          dp.Add(dpArray->Get(j));
-        }
-      }
-    }
-
-    wxPdfObject* dicParam = NULL;
-    wxMemoryOutputStream* osOut = NULL;
-    for (j = 0; j < filters.GetCount(); j++)
-    {
-      osIn = stream->GetBuffer();
-      wxPdfName* name = (wxPdfName*) filters[j];
-      if (name->GetName() == wxS("FlateDecode") || name->GetName() == wxS("Fl"))
-      {
-        osOut = FlateDecode(osIn);
-        if (j < dp.GetCount())
-        {
-          wxMemoryOutputStream* osIn2 = osOut;
-          dicParam = (wxPdfObject*) dp[j];
-          osOut = DecodePredictor(osIn2, dicParam);
-          if (osOut != osIn2)
-          {
-            delete osIn2;
-          }
-        }
-      }
-      else if(name->GetName() == wxS("ASCIIHexDecode") || name->GetName() == wxS("AHx"))
-      {
-        osOut = ASCIIHexDecode(osIn);
-      }
-      else if(name->GetName() == wxS("ASCII85Decode") || name->GetName() == wxS("A85"))
-      {
-        osOut = ASCII85Decode(osIn);
-      }
-      else if(name->GetName() == wxS("LZWDecode"))
-      {
-        osOut = LZWDecode(osIn);
-        if (j < dp.GetCount())
-        {
-          wxMemoryOutputStream* osIn2 = osOut;
-          dicParam = (wxPdfObject*) dp[j];
-          osOut = DecodePredictor(osIn2, dicParam);
-          if (osOut != osIn2)
-          {
-            delete osIn2;
-          }
-        }
-      }
-      else
-      {
-        wxLogError(wxString(wxS("wxPdfParser::GetStreamBytes: ")) +
-                   wxString::Format(_("Filter '%s' not supported."), name->GetName().c_str()));
-      }
-      if (osOut != NULL)
-      {
-        stream->SetBuffer(osOut);
-        if (osIn != osOut)
-        {
-          delete osIn;
-        }
-      }
-    }
+    wxMemoryOutputStream* osOut = new wxMemoryOutputStream();
+    osOut->Write(*decoded);
+    osOut->Close();
+    delete decoded;
+    stream->SetBuffer(osOut);
+    delete osIn;
   }
 }
 
@@ -1547,24 +1552,119 @@ wxPdfParser::GetStreamBytesRaw(wxPdfStream* stream)
 
 // --- Tokenizer
 
+// Size of the window of document data held in memory by the tokenizer
+static const size_t gs_tokenizerWindowSize = 65536;
+
 wxPdfTokenizer::wxPdfTokenizer(wxInputStream* inputStream)
 {
   m_inputStream = inputStream;
+  m_buffered = false;
+  m_data = NULL;
+  m_windowBuffer = NULL;
+  m_windowSize = 0;
+  m_windowStart = 0;
+  m_windowLength = 0;
+  m_length = 0;
+  m_position = 0;
+
+  // Scan the document data through a window of bounded size, if the stream size is known,
+  // to avoid the overhead of reading the stream byte by byte
+  wxFileOffset length = m_inputStream->GetLength();
+  if (length > 0 && (wxFileOffset) (size_t) length == length && m_inputStream->IsSeekable())
+  {
+    m_length = (size_t) length;
+    m_windowSize = (m_length < gs_tokenizerWindowSize) ? m_length : gs_tokenizerWindowSize;
+    m_windowBuffer = new unsigned char[m_windowSize];
+    m_data = m_windowBuffer;
+    m_buffered = LoadWindow(0);
+    if (!m_buffered)
+    {
+      delete [] m_windowBuffer;
+      m_windowBuffer = NULL;
+      m_data = NULL;
+      m_windowSize = 0;
+      m_windowLength = 0;
+      m_length = 0;
+      m_inputStream->SeekI(0);
+    }
+  }
+}
+
+wxPdfTokenizer::wxPdfTokenizer(wxMemoryOutputStream* memoryStream)
+{
+  // The window covers the complete data of the memory stream
+  m_inputStream = NULL;
+  m_buffered = true;
+  wxStreamBuffer* buffer = memoryStream->GetOutputStreamBuffer();
+  m_data = (const unsigned char*) buffer->GetBufferStart();
+  m_windowBuffer = NULL;
+  m_length = (size_t) memoryStream->GetLength();
+  m_windowSize = m_length;
+  m_windowStart = 0;
+  m_windowLength = m_length;
+  m_position = 0;
 }
 
 wxPdfTokenizer::~wxPdfTokenizer()
 {
+  if (m_windowBuffer != NULL)
+  {
+    delete [] m_windowBuffer;
+  }
+}
+
+bool
+wxPdfTokenizer::FillWindow(size_t pos)
+{
+  if (pos >= m_windowStart && pos < m_windowStart + m_windowLength)
+  {
+    return true;
+  }
+  return (m_inputStream != NULL && pos < m_length) ? LoadWindow(pos) : false;
+}
+
+bool
+wxPdfTokenizer::LoadWindow(size_t pos)
+{
+  if (m_inputStream == NULL)
+  {
+    // The window of a memory stream covers all data
+    return pos < m_length;
+  }
+  if (pos >= m_length)
+  {
+    return false;
+  }
+  size_t size = (m_windowSize < m_length - pos) ? m_windowSize : m_length - pos;
+  m_windowStart = pos;
+  m_windowLength = 0;
+  if (m_inputStream->SeekI((wxFileOffset) pos) != wxInvalidOffset)
+  {
+    m_inputStream->Read(m_windowBuffer, size);
+    m_windowLength = m_inputStream->LastRead();
+  }
+  return size > 0 && m_windowLength == size;
 }
 
 off_t
 wxPdfTokenizer::Seek(off_t pos)
 {
+  if (m_buffered)
+  {
+    // The window is refilled lazily on the next read access
+    m_position = (pos < 0) ? 0 : ((size_t) pos < m_length) ? (size_t) pos : m_length;
+    return (off_t) m_position;
+  }
   return m_inputStream->SeekI(pos);
 }
 
 off_t
 wxPdfTokenizer::Tell()
 {
+  if (m_buffered)
+  {
+    return (off_t) m_position;
+  }
   return m_inputStream->TellI();
 }
 
@@ -1573,21 +1673,42 @@ wxPdfTokenizer::BackOnePosition(int ch)
 {
   if (ch != -1)
   {
-    off_t pos = Tell();
-    if (pos > 0) pos--;
-    Seek(pos);
+    if (m_buffered)
+    {
+      if (m_position > 0) m_position--;
+    }
+    else
+    {
+      off_t pos = Tell();
+      if (pos > 0) pos--;
+      Seek(pos);
+    }
   }
 }
 
 off_t
 wxPdfTokenizer::GetLength()
 {
+  if (m_buffered)
+  {
+    return (off_t) m_length;
+  }
   return m_inputStream->GetLength();
 }
 
 int
 wxPdfTokenizer::ReadChar()
 {
+  if (m_buffered)
+  {
+    if (!FillWindow(m_position))
+    {
+      return -1;
+    }
+    int readChar = m_data[m_position - m_windowStart];
+    ++m_position;
+    return readChar;
+  }
   int readChar;
   char ch = m_inputStream->GetC();
   readChar = (m_inputStream->LastRead() > 0) ? (unsigned char) ch : -1;
@@ -1600,13 +1721,32 @@ wxPdfTokenizer::ReadBuffer(size_t size)
   wxMemoryOutputStream* memoryBuffer = new wxMemoryOutputStream();
   if (size > 0)
   {
-    char* buffer = new char[size];
-    m_inputStream->Read(buffer, size);
-    if (m_inputStream->LastRead() == size)
+    if (m_buffered)
+    {
+      // Copy the stream data from the window, refilling it as needed
+      if (size <= m_length - m_position)
+      {
+        size_t done = 0;
+        while (done < size && FillWindow(m_position + done))
+        {
+          size_t offset = m_position + done - m_windowStart;
+          size_t count = (size - done < m_windowLength - offset) ? size - done : m_windowLength - offset;
+          memoryBuffer->Write(m_data + offset, count);
+          done += count;
+        }
+      }
+      m_position = (size <= m_length - m_position) ? m_position + size : m_length;
+    }
+    else
     {
-      memoryBuffer->Write(buffer, size);
+      char* buffer = new char[size];
+      m_inputStream->Read(buffer, size);
+      if (m_inputStream->LastRead() == size)
+      {
+        memoryBuffer->Write(buffer, size);
+      }
+      delete [] buffer;
     }
-    delete [] buffer;
   }
   memoryBuffer->Close();
   return memoryBuffer;
@@ -1615,6 +1755,34 @@ wxPdfTokenizer::ReadBuffer(size_t size)
 off_t
 wxPdfTokenizer::GetStartXRef()
 {
+  if (m_buffered)
+  {
+    // Search backwards window by window for the last occurrence of the tag
+    size_t end = m_length;
+    while (end >= 9 && LoadWindow((end > m_windowSize) ? end - m_windowSize : 0))
+    {
+      size_t idx = end - 9 + 1;
+      while (idx > m_windowStart)
+      {
+        --idx;
+        const unsigned char* tag = m_data + (idx - m_windowStart);
+        if (*tag == 's' && memcmp(tag, "startxref", 9) == 0)
+        {
+          return (off_t) idx;
+        }
+      }
+      if (m_windowStart == 0)
+      {
+        break;
+      }
+      // Let the windows overlap for a tag crossing the window start
+      end = m_windowStart + 8;
+    }
+    wxLogError(wxString(wxS("wxPdfTokenizer::GetStartXRef: ")) +
+               wxString(_("PDF startxref not found.")));
+    return 0;
+  }
+
   char buffer[1024];
   int idx, found;
   off_t size = GetLength();
@@ -1647,21 +1815,82 @@ wxPdfTokenizer::GetStartXRef()
   return pos;
 }
 
+wxString
+wxPdfTokenizer::ScanBufferToken(size_t start, bool isNumber)
+{
+  // The scan continues from the current position
+  FillWindow(start);
+  while (true)
+  {
+    size_t windowEnd = m_windowStart + m_windowLength;
+    while (m_position < windowEnd)
+    {
+      unsigned char ch = m_data[m_position - m_windowStart];
+      if (isNumber ? !((ch >= '0' && ch <= '9') || ch == '.') : IsDelimiterOrWhitespace(ch))
+      {
+        break;
+      }
+      ++m_position;
+    }
+    if (m_position < windowEnd || windowEnd >= m_length || m_inputStream == NULL)
+    {
+      break;
+    }
+    // The token continues beyond the window: reload the window from the start of the token,
+    // enlarging it for tokens longer than the window
+    if (start == m_windowStart)
+    {
+      size_t windowSize = (m_windowSize < m_length / 2) ? 2 * m_windowSize : m_length;
+      delete [] m_windowBuffer;
+      m_windowBuffer = new unsigned char[windowSize];
+      m_data = m_windowBuffer;
+      m_windowSize = windowSize;
+    }
+    if (!LoadWindow(start))
+    {
+      break;
+    }
+  }
+  wxString token = GetBufferString(start, m_position);
+  if (m_inputStream != NULL && m_windowSize > gs_tokenizerWindowSize)
+  {
+    // Restore the default window size after a long token,
+    // the window is refilled lazily on the next read access
+    delete [] m_windowBuffer;
+    m_windowSize = gs_tokenizerWindowSize;
+    m_windowBuffer = new unsigned char[m_windowSize];
+    m_data = m_windowBuffer;
+    m_windowLength = 0;
+  }
+  return token;
+}
+
+wxString
+wxPdfTokenizer::GetBufferString(size_t start, size_t end) const
+{
+  wxString str;
+  if (end > start && start >= m_windowStart && end <= m_windowStart + m_windowLength)
+  {
+    str = wxString((const char*) (m_data + (start - m_windowStart)), wxConvISO8859_1, end - start);
+  }
+  return str;
+}
+
 wxString
 wxPdfTokenizer::CheckPdfHeader()
 {
   wxString version = wxEmptyString;
-  m_inputStream->SeekI(0);
+  Seek(0);
   wxString str = ReadString(1024);
   int idx = str.Find(wxS("%PDF-"));
   if (idx >= 0)
   {
-    m_inputStream->SeekI(idx);
+    Seek(idx);
     version = str.Mid(idx + 5, 3);
   }
   else
   {
-    m_inputStream->SeekI(0);
+    Seek(0);
     wxLogError(wxString(wxS("wxPdfTokenizer::GetStartXref: ")) +
                wxString(_("PDF header signature not found.")));
   }
@@ -1712,6 +1941,12 @@ wxPdfTokenizer::NextToken()
       m_type = TOKEN_NAME;
       // The slash is not part of the name
       // buffer += ch;
+      if (m_buffered)
+      {
+        // Scan the name in place and convert it at once
+        buffer = ScanBufferToken(m_position, false);
+        break;
+      }
       while (true)
       {
         ch = ReadChar();
@@ -1897,7 +2132,15 @@ wxPdfTokenizer::NextToken()
     }
     default:
     {
-      if (ch == '-' || ch == '+' || ch == '.' || (ch >= '0' && ch <= '9'))
+      bool isNumber = (ch == '-' || ch == '+' || ch == '.' || (ch >= '0' && ch <= '9'));
+      if (m_buffered)
+      {
+        // Scan the token in place and convert it at once
+        m_type = (isNumber) ? TOKEN_NUMBER : TOKEN_OTHER;
+        buffer = ScanBufferToken(m_position - 1, isNumber);
+        break;
+      }
+      if (isNumber)
       {
         m_type = TOKEN_NUMBER;
         do
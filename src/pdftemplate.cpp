@@ -39,6 +39,8 @@ wxPdfTemplate::wxPdfTemplate(int templateId)
 
   m_parser    = NULL;
   m_resources = NULL;
+  m_contentFilter = NULL;
+  m_contentParms  = NULL;
   m_used = false;
 }
 
@@ -57,6 +59,106 @@ wxPdfTemplate::~wxPdfTemplate()
       delete m_resources;
     }
   }
+  if (m_contentFilter != NULL)
+  {
+    delete m_contentFilter;
+  }
+  if (m_contentParms != NULL)
+  {
+    delete m_contentParms;
+  }
+}
+
+void
+wxPdfTemplate::SetContentFilter(wxPdfObject* filter, wxPdfObject* decodeParms)
+{
+  if (m_contentFilter != NULL)
+  {
+    delete m_contentFilter;
+  }
+  if (m_contentParms != NULL)
+  {
+    delete m_contentParms;
+  }
+  m_contentFilter = filter;
+  m_contentParms = decodeParms;
+}
+
+// Check whether an object and all its elements are direct objects
+static bool
+IsDirectObject(wxPdfObject* obj)
+{
+  bool isDirect = true;
+  switch (obj->GetType())
+  {
+    case OBJTYPE_INDIRECT:
+    case OBJTYPE_STREAM:
+      isDirect = false;
+      break;
+    case OBJTYPE_ARRAY:
+      {
+        wxPdfArray* array = (wxPdfArray*) obj;
+        size_t j;
+        for (j = 0; isDirect && j < array->GetSize(); j++)
+        {
+          isDirect = IsDirectObject(array->Get(j));
+        }
+      }
+      break;
+    case OBJTYPE_DICTIONARY:
+      {
+        wxPdfDictionaryMap* dictionaryMap = ((wxPdfDictionary*) obj)->GetHashMap();
+        wxPdfDictionaryMap::iterator entry;
+        for (entry = dictionaryMap->begin(); isDirect && entry != dictionaryMap->end(); entry++)
+        {
+          isDirect = IsDirectObject(entry->second);
+        }
+      }
+      break;
+    default:
+      break;
+  }
+  return isDirect;
+}
+
+// Check whether the encoded data of a stream can be copied verbatim
+static bool
+IsPassThroughStream(wxPdfStream* stream)
+{
+  static const wxStringCharType* passThroughFilters[] = {
+    wxS("FlateDecode"), wxS("LZWDecode"), wxS("ASCIIHexDecode"), wxS("ASCII85Decode"), wxS("RunLengthDecode"),
+    NULL
+  };
+  wxPdfObject* filter = stream->Get(wxS("Filter"));
+  wxPdfObject* decodeParms = stream->Get(wxS("DecodeParms"));
+  if (filter == NULL || stream->Get(wxS("F")) != NULL || stream->Get(wxS("DP")) != NULL ||
+      !IsDirectObject(filter) || (decodeParms != NULL && !IsDirectObject(decodeParms)))
+  {
+    return false;
+  }
+
+  size_t count = 1;
+  if (filter->GetType() == OBJTYPE_ARRAY)
+  {
+    count = ((wxPdfArray*) filter)->GetSize();
+  }
+  bool ok = (count > 0);
+  size_t j, k;
+  for (j = 0; ok && j < count; j++)
+  {
+    wxPdfObject* item = (filter->GetType() == OBJTYPE_ARRAY) ? ((wxPdfArray*) filter)->Get(j) : filter;
+    ok = (item->GetType() == OBJTYPE_NAME);
+    if (ok)
+    {
+      wxString name = ((wxPdfName*) item)->GetName();
+      ok = false;
+      for (k = 0; !ok && passThroughFilters[k] != NULL; k++)
+      {
+        ok = (name == passThroughFilters[k]);
+      }
+    }
+  }
+  return ok;
 }
 
 int
@@ -453,12 +555,36 @@ wxPdfDocument::ImportPage(unsigned int pageno, wxPdfPageBox pageBox)
         pageTemplate->m_buffer.Write((const char*) strRotation.ToAscii(), strRotation.Length());
       }
 
+      // Read the content streams without decoding them
       wxArrayPtrVoid contents;
+      bool saveUseRawStream = m_currentParser->GetUseRawStream();
+      m_currentParser->SetUseRawStream(true);
       m_currentParser->GetContent(pageno-1, contents);
+      m_currentParser->SetUseRawStream(saveUseRawStream);
+
+      // The encoded data of a single content stream are copied verbatim,
+      // unless the content has to be rewritten
+      bool passThrough = rotationAngle == 0 && contents.GetCount() == 1 &&
+                         IsPassThroughStream((wxPdfStream*) contents[0]);
       size_t j;
       for (j = 0; j < contents.GetCount(); j++)
       {
         wxPdfStream* pageContent = (wxPdfStream*) contents[j];
+        if (passThrough)
+        {
+          wxPdfDictionaryMap* dictionaryMap = pageContent->GetDictionary()->GetHashMap();
+          wxPdfObject* decodeParms = pageContent->Get(wxS("DecodeParms"));
+          pageTemplate->SetContentFilter(pageContent->Get(wxS("Filter")), decodeParms);
+          dictionaryMap->erase(wxS("Filter"));
+          if (decodeParms != NULL)
+          {
+            dictionaryMap->erase(wxS("DecodeParms"));
+          }
+        }
+        else
+        {
+          m_currentParser->DecodeStreamBytes(pageContent);
+        }
         wxMemoryOutputStream* os = pageContent->GetBuffer();
         if (os->TellO() > 0)
         {
@@ -22,6 +22,11 @@
 
 // includes
 #include "wx/intl.h"
+#if wxUSE_THREADS
+#include "wx/thread.h"
+#endif
+
+#include <vector>
 
 #include "wx/pdfutility.h"
 
@@ -184,3 +189,109 @@ wxPdfUtility::RGB2String(const wxColour& colour)
                  Double2String(b/255.,3);
   return rgb;
 }
+
+#if wxUSE_THREADS
+
+// Queue of task indices shared by the threads of wxPdfUtility::RunParallel
+class wxPdfParallelTaskQueue
+{
+public:
+  wxPdfParallelTaskQueue(size_t count, const std::function<void(size_t)>& task)
+    : m_count(count), m_next(0), m_task(task)
+  {
+  }
+
+  void Process()
+  {
+    size_t index;
+    while (NextTask(index))
+    {
+      m_task(index);
+    }
+  }
+
+private:
+  bool NextTask(size_t& index)
+  {
+    wxCriticalSectionLocker locker(m_cs);
+    bool ok = (m_next < m_count);
+    if (ok)
+    {
+      index = m_next++;
+    }
+    return ok;
+  }
+
+  size_t                             m_count;
+  size_t                             m_next;
+  const std::function<void(size_t)>& m_task;
+  wxCriticalSection                  m_cs;
+};
+
+// Worker thread of wxPdfUtility::RunParallel
+class wxPdfParallelTaskThread : public wxThread
+{
+public:
+  wxPdfParallelTaskThread(wxPdfParallelTaskQueue& queue)
+    : wxThread(wxTHREAD_JOINABLE), m_queue(queue)
+  {
+  }
+
+protected:
+  virtual ExitCode Entry()
+  {
+    m_queue.Process();
+    return 0;
+  }
+
+private:
+  wxPdfParallelTaskQueue& m_queue;
+};
+
+#endif
+
+void
+wxPdfUtility::RunParallel(size_t count, const std::function<void(size_t)>& task, int maxThreads)
+{
+#if wxUSE_THREADS
+  int numThreads = (maxThreads > 0) ? maxThreads : wxThread::GetCPUCount();
+  if (numThreads > 1 && count > 1)
+  {
+    if ((size_t) numThreads > count)
+    {
+      numThreads = (int) count;
+    }
+    wxPdfParallelTaskQueue queue(count, task);
+    std::vector<wxPdfParallelTaskThread*> threads;
+    int j;
+    // The calling thread processes tasks, too
+    for (j = 1; j < numThreads; ++j)
+    {
+      wxPdfParallelTaskThread* thread = new wxPdfParallelTaskThread(queue);
+      if (thread->Run() == wxTHREAD_NO_ERROR)
+      {
+        threads.push_back(thread);
+      }
+      else
+      {
+        delete thread;
+      }
+    }
+    queue.Process();
+    size_t k;
+    for (k = 0; k < threads.size(); ++k)
+    {
+      threads[k]->Wait();
+      delete threads[k];
+    }
+    return;
+  }
+#else
+  wxUnusedVar(maxThreads);
+#endif
+  size_t index;
+  for (index = 0; index < count; ++index)
+  {
+    task(index);
+  }
+}
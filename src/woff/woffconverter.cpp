@@ -21,11 +21,20 @@
 #include <wx/wx.h>
 #endif
 
+#include <wx/file.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/thread.h>
 #include <wx/zstream.h>
 
 #include "woffconverter.h"
+#include "woff2converter.h"
 
 #include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace
@@ -270,3 +279,199 @@ wxMemoryInputStream* WoffConverter::Convert(wxInputStream* fontStream)
   wxMemoryInputStream* finalStream = new wxMemoryInputStream(otfStream);
   return finalStream;
 }
+
+namespace
+{
+  typedef std::shared_ptr<const std::vector<uint8_t>> DecodedFontData;
+
+  // Entry of the cache of decoded fonts
+  struct DecodedFontEntry
+  {
+    DecodedFontData                m_data;  // Decoded font data
+    std::list<wxString>::iterator m_usage; // Position in the usage list
+  };
+
+  // The cache of decoded fonts is bounded in size; the least recently used fonts
+  // are evicted first. Streams handed out by GetDecodedFont share the ownership
+  // of the font data, so that evicting a font does not invalidate them.
+  static const size_t gs_decodedFontsMaxSize = 64 * 1024 * 1024;
+  static std::map<wxString, DecodedFontEntry> gs_decodedFonts;
+  static std::list<wxString> gs_decodedFontsUsage; // Most recently used first
+  static size_t gs_decodedFontsSize = 0;
+  static wxString gs_decodedFontDirectory;
+
+  // Memory input stream keeping the decoded font data alive while it is in use
+  class DecodedFontStream : public wxMemoryInputStream
+  {
+  public:
+    DecodedFontStream(const DecodedFontData& data)
+      : wxMemoryInputStream(data->data(), data->size()), m_data(data)
+    {
+    }
+
+  private:
+    DecodedFontData m_data;
+  };
+
+  static void EvictDecodedFonts()
+  {
+    // The most recently used font is kept, even if it exceeds the size limit alone
+    while (gs_decodedFontsSize > gs_decodedFontsMaxSize && gs_decodedFontsUsage.size() > 1)
+    {
+      std::map<wxString, DecodedFontEntry>::iterator entry = gs_decodedFonts.find(gs_decodedFontsUsage.back());
+      gs_decodedFontsSize -= entry->second.m_data->size();
+      gs_decodedFonts.erase(entry);
+      gs_decodedFontsUsage.pop_back();
+    }
+  }
+
+#if wxUSE_THREADS
+  static wxCriticalSection gs_csDecodedFonts;
+#endif
+
+  static wxString GetCacheFileName(const wxString& cacheDirectory, const wxFileName& fileName, const wxString& key)
+  {
+    // FNV-1a hash of the cache key
+    uint32_t hash = 2166136261ul;
+    const wxScopedCharBuffer keyBuffer = key.utf8_str();
+    size_t j;
+    for (j = 0; j < keyBuffer.length(); ++j)
+    {
+      hash = (hash ^ (uint8_t) keyBuffer[j]) * 16777619ul;
+    }
+    wxFileName cacheFileName(cacheDirectory, fileName.GetName() + wxString::Format(wxS("-%08x.sfnt"), (unsigned int) hash));
+    return cacheFileName.GetFullPath();
+  }
+
+  static bool ReadCacheFile(const wxString& cacheFileName, std::vector<uint8_t>& fontData)
+  {
+    bool ok = false;
+    wxFile cacheFile;
+    if (wxFileExists(cacheFileName) && cacheFile.Open(cacheFileName))
+    {
+      wxFileOffset length = cacheFile.Length();
+      if (length > 0)
+      {
+        fontData.resize((size_t) length);
+        ok = cacheFile.Read(fontData.data(), fontData.size()) == (ssize_t) length;
+      }
+    }
+    return ok;
+  }
+
+  static void WriteCacheFile(const wxString& cacheFileName, const std::vector<uint8_t>& fontData)
+  {
+    // Write to a temporary file first, so that other processes never see a partial file
+    wxString tempFileName = cacheFileName + wxString::Format(wxS(".%lu"), wxGetProcessId());
+    wxFile cacheFile;
+    if (cacheFile.Create(tempFileName, true))
+    {
+      bool ok = cacheFile.Write(fontData.data(), fontData.size()) == fontData.size();
+      cacheFile.Close();
+      if (!ok || !wxRenameFile(tempFileName, cacheFileName, true))
+      {
+        wxRemoveFile(tempFileName);
+      }
+    }
+  }
+}
+
+/* static */
+wxMemoryInputStream* WoffFontCache::GetDecodedFont(const wxString& fontFileName, wxInputStream* fontStream)
+{
+  wxFileName fileName(fontFileName);
+  wxString ext = fileName.GetExt().Lower();
+  bool isWoff2 = ext.IsSameAs(wxS("woff2"));
+  if (!isWoff2 && !ext.IsSameAs(wxS("woff")))
+  {
+    return nullptr;
+  }
+
+  // The cache key includes size and modification time to detect changed font files
+  wxString key = fileName.GetFullPath();
+  if (fileName.FileExists())
+  {
+    key += wxS("|") + fileName.GetSize().ToString() +
+           wxS("|") + fileName.GetModificationTime().GetValue().ToString();
+  }
+
+  wxString cacheDirectory;
+  {
+#if wxUSE_THREADS
+    wxCriticalSectionLocker locker(gs_csDecodedFonts);
+#endif
+    std::map<wxString, DecodedFontEntry>::iterator decodedFont = gs_decodedFonts.find(key);
+    if (decodedFont != gs_decodedFonts.end())
+    {
+      // Mark the font as most recently used
+      gs_decodedFontsUsage.splice(gs_decodedFontsUsage.begin(), gs_decodedFontsUsage, decodedFont->second.m_usage);
+      return new DecodedFontStream(decodedFont->second.m_data);
+    }
+    cacheDirectory = gs_decodedFontDirectory;
+  }
+
+  // Decoding is done without holding the lock; if another thread decodes
+  // the same font concurrently, the first result stored is used
+  std::vector<uint8_t> fontData;
+  wxString cacheFileName;
+  bool ok = false;
+  if (!cacheDirectory.IsEmpty())
+  {
+    cacheFileName = GetCacheFileName(cacheDirectory, fileName, key);
+    ok = ReadCacheFile(cacheFileName, fontData);
+  }
+  if (!ok)
+  {
+    wxMemoryInputStream* decodedStream = (isWoff2) ? Woff2Converter::Convert(fontStream) : WoffConverter::Convert(fontStream);
+    if (decodedStream != nullptr)
+    {
+      fontData.resize(decodedStream->GetLength());
+      decodedStream->Read(fontData.data(), fontData.size());
+      ok = decodedStream->LastRead() == fontData.size() && !fontData.empty();
+      delete decodedStream;
+      if (ok && !cacheFileName.IsEmpty())
+      {
+        WriteCacheFile(cacheFileName, fontData);
+      }
+    }
+  }
+
+  wxMemoryInputStream* result = nullptr;
+  if (ok)
+  {
+#if wxUSE_THREADS
+    wxCriticalSectionLocker locker(gs_csDecodedFonts);
+#endif
+    std::map<wxString, DecodedFontEntry>::iterator decodedFont = gs_decodedFonts.find(key);
+    if (decodedFont == gs_decodedFonts.end())
+    {
+      DecodedFontEntry& entry = gs_decodedFonts[key];
+      entry.m_data = std::make_shared<const std::vector<uint8_t>>(std::move(fontData));
+      entry.m_usage = gs_decodedFontsUsage.insert(gs_decodedFontsUsage.begin(), key);
+      gs_decodedFontsSize += entry.m_data->size();
+      result = new DecodedFontStream(entry.m_data);
+      EvictDecodedFonts();
+    }
+    else
+    {
+      gs_decodedFontsUsage.splice(gs_decodedFontsUsage.begin(), gs_decodedFontsUsage, decodedFont->second.m_usage);
+      result = new DecodedFontStream(decodedFont->second.m_data);
+    }
+  }
+  return result;
+}
+
+/* static */
+bool WoffFontCache::SetCacheDirectory(const wxString& cacheDirectory)
+{
+  bool ok = cacheDirectory.IsEmpty() || wxDirExists(cacheDirectory) ||
+            wxFileName::Mkdir(cacheDirectory, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+  if (ok)
+  {
+#if wxUSE_THREADS
+    wxCriticalSectionLocker locker(gs_csDecodedFonts);
+#endif
+    gs_decodedFontDirectory = cacheDirectory;
+  }
+  return ok;
+}
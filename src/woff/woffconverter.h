@@ -23,4 +23,31 @@ public:
   static wxMemoryInputStream* Convert(wxInputStream* fontStream);
 };
 
+/// Cache of decoded WOFF and WOFF2 fonts
+/**
+* Each WOFF/WOFF2 font file is decoded only once per process as long as its decoded sfnt
+* data stay in memory. The in-memory cache is bounded in size (64 MiB); the least recently
+* used fonts are evicted first. If a cache directory is set, the decoded data are stored
+* on disk as well, so that later processes and evicted fonts can skip decoding, too.
+*/
+class WoffFontCache
+{
+public:
+  /// Get the decoded sfnt data of a WOFF or WOFF2 font file
+  /**
+  * \param fontFileName the full path of the font file, its extension determines the format
+  * \param fontStream the stream of the font file, only read if the font is not yet cached
+  * \return a stream with the decoded font data (to be deleted by the caller; it stays valid
+  * even if the font is evicted from the cache), or nullptr if the font could not be decoded
+  */
+  static wxMemoryInputStream* GetDecodedFont(const wxString& fontFileName, wxInputStream* fontStream);
+
+  /// Set the directory for storing decoded fonts on disk
+  /**
+  * \param cacheDirectory the cache directory, an empty string disables the disk cache
+  * \return TRUE if the directory exists or could be created, FALSE otherwise
+  */
+  static bool SetCacheDirectory(const wxString& cacheDirectory);
+};
+
 #endif //